@@ -77,6 +77,20 @@ public:
         TERM_VECTOR_WITH_POSITIONS_OFFSETS
     };
 
+    /// Specifies whether and how the value of a field should be written to a per-document column.
+    enum DocValues {
+        /// Do not write the value to a column.
+        DOC_VALUES_NO,
+
+        /// Write the value as a 64 bit integer, parsed from the string value of the field.  Documents
+        /// without a value read 0.
+        DOC_VALUES_NUMERIC,
+
+        /// Write the string value.  Each segment stores its distinct values once, in sorted order, and each
+        /// document the ordinal of its value.  Documents without a value read the empty string.
+        DOC_VALUES_SORTED
+    };
+
 public:
     virtual ~AbstractField();
 
@@ -97,6 +111,7 @@ protected:
     bool _isBinary;
     bool lazy;
     bool omitTermFreqAndPositions;
+    int32_t docValuesType;
     double boost;
 
     // the data object for all different kind of field values
@@ -202,6 +217,13 @@ public:
     /// to find results.
     virtual void setOmitTermFreqAndPositions(bool omitTermFreqAndPositions);
 
+    /// @see #setDocValuesType
+    virtual int32_t getDocValuesType();
+
+    /// Sets whether the value of this field is also written to a per-document column, one of {@link
+    /// DocValues}.  Column values are read by the FieldCache without un-inverting the field.
+    virtual void setDocValuesType(int32_t docValuesType);
+
     /// Indicates whether a Field is Lazy or not.  The semantics of Lazy loading are such that if a Field
     /// is lazily loaded, retrieving it's values via {@link #stringValue()} or {@link #getBinaryValue()}
     /// is only valid as long as the {@link IndexReader} that retrieved the {@link Document} is still open.
@@ -0,0 +1,91 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef AUTOMATON_H
+#define AUTOMATON_H
+
+#include "LuceneObject.h"
+
+namespace Lucene {
+
+/// A finite state automaton over characters, used to describe the set of terms matched by a pattern so
+/// that the pattern can be intersected with the sorted term dictionary (see {@link AutomatonTermEnum}).
+///
+/// States are numbered from 0 in order of creation, state 0 being the initial state.  Transitions are
+/// labelled with inclusive character ranges.  An automaton is built by adding states, transitions and
+/// epsilon (empty) transitions, and then converted by {@link #determinize} into the deterministic form
+/// required by {@link #step}, {@link #run} and {@link #nextLabel}.
+class LPPAPI Automaton : public LuceneObject {
+public:
+    Automaton();
+    virtual ~Automaton();
+
+    LUCENE_CLASS(Automaton);
+
+public:
+    /// Largest character value of a transition label.
+    static const int32_t MAX_CHAR;
+
+    struct Transition {
+        int32_t min;
+        int32_t max;
+        int32_t to;
+
+        bool operator< (const Transition& other) const {
+            return min < other.min;
+        }
+    };
+
+protected:
+    Collection< Collection<Transition> > transitions;
+    Collection< Collection<int32_t> > epsilons;
+    HashSet<int32_t> acceptStates;
+    bool deterministic;
+
+public:
+    /// Adds a new state and returns its number.
+    int32_t createState();
+
+    /// Returns the number of states.
+    int32_t getNumStates();
+
+    void setAccept(int32_t state, bool accept);
+    bool isAccept(int32_t state);
+
+    /// Adds a transition from one state to another on any character in the range [min, max].
+    void addTransition(int32_t from, int32_t min, int32_t max, int32_t to);
+
+    /// Adds a transition from one state to another that consumes no character.
+    void addEpsilon(int32_t from, int32_t to);
+
+    /// Returns true if this automaton is deterministic, ie. was returned by {@link #determinize}.
+    bool isDeterministic();
+
+    /// Returns an equivalent deterministic automaton without dead states, that is states from which no
+    /// accepting state can be reached.
+    AutomatonPtr determinize();
+
+    /// Returns the state reached from state on character c, or -1 if there is none.
+    int32_t step(int32_t state, int32_t c);
+
+    /// Returns true if the automaton accepts text.
+    bool run(const String& text);
+
+    /// Finds the smallest character not less than minChar with a transition from state.
+    /// @return false if there is no such character.
+    bool nextLabel(int32_t state, int32_t minChar, int32_t& label);
+
+    /// Returns the longest string that prefixes every string accepted by this automaton.
+    String getCommonPrefix();
+
+protected:
+    /// Adds the states reachable from state through epsilon transitions to closure.
+    void addClosure(int32_t state, Collection<int32_t> closure);
+};
+
+}
+
+#endif
@@ -0,0 +1,85 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef AUTOMATONTERMENUM_H
+#define AUTOMATONTERMENUM_H
+
+#include "FilteredTermEnum.h"
+
+namespace Lucene {
+
+/// Subclass of FilteredTermEnum for enumerating the terms of a field that are accepted by an {@link Automaton}.
+///
+/// The automaton is intersected with the sorted term dictionary: when a term is rejected, the smallest string
+/// greater than it that could still be accepted is computed, and if enough terms lie before that string the
+/// enumeration seeks to it through the terms index instead of testing each of them.
+///
+/// Term enumerations are always ordered by Term.compareTo().  Each term in the enumeration is greater than
+/// all that precede it.
+class LPPAPI AutomatonTermEnum : public FilteredTermEnum {
+public:
+    /// After calling the constructor the enumeration is already pointing to the first valid term if such a
+    /// term exists.
+    /// @param reader Delivers terms.
+    /// @param field Field of the terms to enumerate.
+    /// @param automaton Deterministic automaton the terms must be accepted by.
+    AutomatonTermEnum(const IndexReaderPtr& reader, const String& field, const AutomatonPtr& automaton);
+
+    virtual ~AutomatonTermEnum();
+
+protected:
+    /// For subclasses that build their automaton in the constructor; they must call {@link #ConstructTermEnum}.
+    AutomatonTermEnum();
+
+public:
+
+    LUCENE_CLASS(AutomatonTermEnum);
+
+protected:
+    IndexReaderPtr reader;
+    String field;
+    AutomatonPtr automaton;
+    bool _endEnum;
+
+    /// Smallest string that could be accepted after the last rejected term.
+    String seekText;
+    bool seekPending;
+
+    /// Number of terms skipped since seekText was computed.
+    int32_t skipped;
+
+    /// States visited while running the automaton over the last rejected term.
+    Collection<int32_t> states;
+
+    /// Number of terms to step over linearly before seeking ahead through the terms index.
+    static const int32_t SEEK_THRESHOLD;
+
+public:
+    virtual double difference();
+
+    /// Increments the enumeration to the next element, seeking past runs of terms the automaton
+    /// cannot accept.
+    virtual bool next();
+
+protected:
+    void ConstructTermEnum(const IndexReaderPtr& reader, const String& field, const AutomatonPtr& automaton);
+
+    virtual bool termCompare(const TermPtr& term);
+    virtual bool endEnum();
+
+    /// Runs the automaton over text, recording the states visited.  Returns the number of characters
+    /// consumed before the automaton rejected text.
+    int32_t runStates(const String& text);
+
+    /// Computes the smallest string greater than text that is a prefix of a string accepted by the
+    /// automaton, using the states recorded by {@link #runStates}.
+    /// @return false if no string greater than text is accepted.
+    bool nextString(const String& text, int32_t consumed, String& next);
+};
+
+}
+
+#endif
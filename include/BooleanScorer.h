@@ -44,7 +44,7 @@ protected:
     int32_t nextMask;
     int32_t minNrShouldMatch;
     int32_t end;
-    BucketPtr current;
+    int32_t current; // index of current bucket, -1 if none
     int32_t doc;
 
 protected:
@@ -68,9 +68,9 @@ public:
     LUCENE_CLASS(BooleanScorerCollector);
 
 protected:
-    BucketTableWeakPtr _bucketTable;
+    BucketTablePtr bucketTable;
     int32_t mask;
-    ScorerWeakPtr _scorer;
+    ScorerPtr scorer;
 
 public:
     virtual void collect(int32_t doc);
@@ -100,22 +100,9 @@ public:
     virtual double score();
 };
 
-class Bucket : public LuceneObject {
-public:
-    Bucket();
-    virtual ~Bucket();
-
-    LUCENE_CLASS(Bucket);
-
-public:
-    int32_t doc; // tells if bucket is valid
-    double score; // incremental score
-    int32_t bits; // used for bool constraints
-    int32_t coord; // count of terms in score
-    BucketWeakPtr _next; // next valid bucket
-};
-
-/// A simple hash table of document scores within a range.
+/// A simple hash table of document scores within a range.  Buckets are stored as parallel arrays indexed by
+/// doc & MASK and valid buckets are chained through the next array, so the table is allocated once and reused
+/// for every window.
 class BucketTable : public LuceneObject {
 public:
     BucketTable();
@@ -127,8 +114,12 @@ public:
     static const int32_t SIZE;
     static const int32_t MASK;
 
-    Collection<BucketPtr> buckets;
-    BucketPtr first; // head of valid list
+    IntArray docs; // tells if bucket is valid
+    DoubleArray scores; // incremental score
+    IntArray bits; // used for bool constraints
+    IntArray coords; // count of terms in score
+    IntArray next; // next valid bucket, -1 for end of list
+    int32_t first; // head of valid list, -1 if empty
 
 public:
     CollectorPtr newCollector(int32_t mask);
@@ -62,6 +62,12 @@ public:
     /// @see #readInternal(uint8_t*, int32_t, int32_t)
     virtual void readBytes(uint8_t* b, int32_t offset, int32_t length, bool useBuffer);
 
+    /// Returns the unread part of the buffer, refilling it first if it is empty.
+    virtual const uint8_t* bufferedBytes(int32_t& available);
+
+    /// Advances the current position within the buffer.
+    virtual void skipBufferedBytes(int32_t count);
+
     /// Closes the stream to further operations.
     virtual void close();
 
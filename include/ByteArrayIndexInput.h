@@ -0,0 +1,66 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef BYTEARRAYINDEXINPUT_H
+#define BYTEARRAYINDEXINPUT_H
+
+#include "IndexInput.h"
+
+namespace Lucene {
+
+/// An {@link IndexInput} that reads from the first length bytes of a byte array held in memory.
+class LPPAPI ByteArrayIndexInput : public IndexInput {
+public:
+    ByteArrayIndexInput(ByteArray bytes);
+    ByteArrayIndexInput(ByteArray bytes, int32_t length);
+    virtual ~ByteArrayIndexInput();
+
+    LUCENE_CLASS(ByteArrayIndexInput);
+
+protected:
+    ByteArray bytes;
+    int32_t _length;
+    int32_t position;
+
+public:
+    /// Reads and returns a single byte.
+    /// @see IndexOutput#writeByte(uint8_t)
+    virtual uint8_t readByte();
+
+    /// Reads a specified number of bytes into an array at the specified offset.
+    /// @param b the array to read bytes into.
+    /// @param offset the offset in the array to start storing bytes.
+    /// @param length the number of bytes to read.
+    /// @see IndexOutput#writeBytes(const uint8_t*,int)
+    virtual void readBytes(uint8_t* b, int32_t offset, int32_t length);
+
+    /// Returns the unread part of the array.
+    virtual const uint8_t* bufferedBytes(int32_t& available);
+
+    /// Advances the current position within the array.
+    virtual void skipBufferedBytes(int32_t count);
+
+    /// Closes the stream to further operations.
+    virtual void close();
+
+    /// Returns the current position in this file, where the next read will occur.
+    /// @see #seek(int64_t)
+    virtual int64_t getFilePointer();
+
+    /// Sets current position in this file, where the next read will occur.
+    /// @see #getFilePointer()
+    virtual void seek(int64_t pos);
+
+    /// The number of bytes in the file.
+    virtual int64_t length();
+
+    /// Returns a clone of this stream.
+    virtual LuceneObjectPtr clone(const LuceneObjectPtr& other = LuceneObjectPtr());
+};
+
+}
+
+#endif
@@ -16,6 +16,11 @@ namespace Lucene {
 /// the thread(s) that are updating the index will pause until one or more merges completes.
 /// This is a simple way to use concurrency in the indexing process without having to create
 /// and manage application level threads.
+///
+/// Merge writes can be limited to a number of MB per second, so that merges do not starve searches of
+/// IO.  The limit is either fixed ({@link #setIORateLimitMBPerSec}) or tuned automatically ({@link
+/// #enableAutoIOThrottle}).  Each merge's throughput and the time it was throttled are recorded on its
+/// {@link OneMerge} and, when the writer has an infoStream, reported there as each merge finishes.
 class LPPAPI ConcurrentMergeScheduler : public MergeScheduler {
 public:
     ConcurrentMergeScheduler();
@@ -33,6 +38,9 @@ protected:
 
     DirectoryPtr dir;
 
+    /// Optional thread pool that merges are run on
+    ThreadPoolPtr threadPool;
+
     bool closed;
     IndexWriterWeakPtr _writer;
 
@@ -41,6 +49,35 @@ protected:
     bool suppressExceptions;
     static bool anyExceptions;
 
+    /// Current IO rate limit of each merge, in MB per second
+    double targetMBPerSec;
+
+    /// IO rate limit of merges run by optimize, in MB per second
+    double forceMergeMBPerSec;
+
+    /// True if the rate limit is tuned automatically
+    bool doAutoIOThrottle;
+
+    /// Number of searches in progress, as reported through {@link #searchStarted}
+    int32_t activeSearches;
+
+public:
+    /// Initial rate limit when auto IO throttling is enabled.
+    static const double START_MB_PER_SEC;
+
+    /// Lowest rate limit auto IO throttling will set.
+    static const double MIN_MERGE_MB_PER_SEC;
+
+    /// Highest rate limit auto IO throttling will set.
+    static const double MAX_MERGE_MB_PER_SEC;
+
+    /// With auto IO throttling, merges estimated to write less than this are not throttled, and do
+    /// not influence the rate limit.
+    static const double MIN_BIG_MERGE_MB;
+
+    /// With auto IO throttling, the fraction of the rate limit merges get while searches are running.
+    static const double SEARCH_BACKOFF_RATIO;
+
 public:
     virtual void initialize();
 
@@ -59,6 +96,51 @@ public:
     /// Set the priority that merge threads run at.
     virtual void setMergeThreadPriority(int32_t pri);
 
+    /// Run merges as tasks of the given thread pool, rather than starting a new thread for each merge.
+    /// {@link #setMaxThreadCount} still limits the number of merges running at once.  Merge thread
+    /// priority is ignored for pooled merges.  Pass a null pool to go back to dedicated merge threads.
+    virtual void setThreadPool(const ThreadPoolPtr& threadPool);
+
+    /// Return the thread pool merges are run on, or null if each merge runs in its own thread.
+    virtual ThreadPoolPtr getThreadPool();
+
+    /// Limits the rate at which each merge writes to the given number of MB per second.  Pass infinity
+    /// (the default) for no limit.  When auto IO throttling is enabled, this resets the rate it tunes.
+    virtual void setIORateLimitMBPerSec(double mbPerSec);
+
+    /// Returns the rate limit each merge currently writes at, in MB per second.  Merges run by optimize
+    /// use {@link #getForceMergeMBPerSec} instead.
+    virtual double getIORateLimitMBPerSec();
+
+    /// Turns on auto IO throttling.  The rate limit starts at {@link #START_MB_PER_SEC}.  Each time a
+    /// big merge is scheduled while the scheduler is falling behind (all merge threads are busy, or a
+    /// merge of similar size has been running for a while), the limit goes up by 20%; otherwise it
+    /// goes down by 10%.  While searches are running (see {@link #searchStarted}) merges get only
+    /// {@link #SEARCH_BACKOFF_RATIO} of the limit.  Small merges are never throttled.
+    virtual void enableAutoIOThrottle();
+
+    /// Turns off auto IO throttling, and removes the rate limit.
+    virtual void disableAutoIOThrottle();
+
+    /// Returns true if auto IO throttling is enabled.
+    virtual bool getAutoIOThrottle();
+
+    /// Limits the rate at which merges run by optimize write, in MB per second.  Default is no limit.
+    virtual void setForceMergeMBPerSec(double mbPerSec);
+
+    /// @see #setForceMergeMBPerSec
+    virtual double getForceMergeMBPerSec();
+
+    /// Tells the scheduler a search has started.  With auto IO throttling, running merges back off
+    /// until every started search has been matched by a call to {@link #searchFinished}.
+    virtual void searchStarted();
+
+    /// Tells the scheduler a search started with {@link #searchStarted} has finished.
+    virtual void searchFinished();
+
+    /// Returns the rate limit, in MB per second, that applies to the given merge right now.
+    virtual double getMergeMBPerSec(const OneMergePtr& merge);
+
     virtual void close();
 
     virtual void sync();
@@ -82,9 +164,23 @@ protected:
     virtual void initMergeThreadPriority();
     virtual int32_t mergeThreadCount();
 
-    /// Does the actual merge, by calling {@link IndexWriter#merge}
+    /// Does the actual merge, by calling {@link IndexWriter#merge}, with the merge's writes going
+    /// through a rate limiter
     virtual void doMerge(const OneMergePtr& merge);
 
+    /// Estimates the number of bytes the merge will write, from the sizes of its segments less their
+    /// deleted documents.
+    virtual void estimateMergeBytes(const IndexWriterPtr& writer, const OneMergePtr& merge);
+
+    /// Adjusts the auto IO throttle for a newly scheduled merge.
+    virtual void updateIOThrottle(const OneMergePtr& merge);
+
+    /// Returns true if a merge of similar size to the given one has been running for a while.
+    virtual bool isBacklog(int64_t now, const OneMergePtr& merge);
+
+    /// Pushes the current rate limits to all running merges.
+    virtual void updateMergeThreads();
+
     virtual MergeThreadPtr getMergeThread(const IndexWriterPtr& writer, const OneMergePtr& merge);
 
     /// Called when an exception is hit in a background merge thread
@@ -37,6 +37,9 @@ public:
     /// Called when DocumentsWriter decides to close the doc stores
     virtual void closeDocStore(const SegmentWriteStatePtr& state);
 
+    /// Called when an aborting exception is hit
+    virtual void abort();
+
     /// Called when DocumentsWriter is using too much RAM.
     virtual bool freeRAM();
 
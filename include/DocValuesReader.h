@@ -0,0 +1,49 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef DOCVALUESREADER_H
+#define DOCVALUESREADER_H
+
+#include "LuceneObject.h"
+
+namespace Lucene {
+
+/// Reads the per-document values of a segment written by {@link DocValuesWriter}.
+///
+/// Only the directory of the file is read when opened.  The values of a field are loaded in one sequential
+/// pass the first time they are asked for and shared from then on.
+class DocValuesReader : public LuceneObject {
+public:
+    DocValuesReader(const DirectoryPtr& d, const String& segment, int32_t readBufferSize);
+    virtual ~DocValuesReader();
+
+    LUCENE_CLASS(DocValuesReader);
+
+protected:
+    IndexInputPtr input;
+    MapStringInt fieldTypes;
+    MapStringLong fieldPointers;
+    MapStringLuceneObject loaded;
+
+public:
+    /// Returns the values of a numeric field, or null if the field has no numeric values.
+    PackedIntsPtr getNumeric(const String& field);
+
+    /// Returns the values of a sorted field, or null if the field has no sorted values.
+    StringIndexPtr getSorted(const String& field);
+
+    /// Returns the type of the values of a field, {@link AbstractField#DOC_VALUES_NO} if it has none.
+    int32_t getType(const String& field);
+
+    void close();
+
+protected:
+    LuceneObjectPtr load(const String& field, int32_t type);
+};
+
+}
+
+#endif
@@ -0,0 +1,61 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef DOCVALUESWRITER_H
+#define DOCVALUESWRITER_H
+
+#include "DocFieldConsumer.h"
+
+namespace Lucene {
+
+/// Writes per-document values.  Each thread X field buffers the values of the documents it saw, then the flush
+/// method below merges all of these together into a single _X.dv file.
+///
+/// The file starts with its format, followed by the number of fields and, for each field, its name, its
+/// {@link AbstractField#DocValues} type and its values.  Numeric values are written as {@link PackedInts}.
+/// Sorted values are written as the UTF-8 encoded distinct values of the segment in sorted order, preceded by
+/// their packed offsets and followed by the packed ordinal of the value of each document.
+class DocValuesWriter : public DocFieldConsumer {
+public:
+    DocValuesWriter();
+    virtual ~DocValuesWriter();
+
+    LUCENE_CLASS(DocValuesWriter);
+
+public:
+    static const int32_t FORMAT_START;
+    static const int32_t FORMAT_CURRENT;
+
+protected:
+    /// The type of each field that had values so far
+    MapStringInt fieldTypes;
+
+public:
+    /// Produce _X.dv if any document had a field with values
+    virtual void flush(MapDocFieldConsumerPerThreadCollectionDocFieldConsumerPerField threadsAndFields, const SegmentWriteStatePtr& state);
+    virtual void closeDocStore(const SegmentWriteStatePtr& state);
+    virtual void abort();
+    virtual DocFieldConsumerPerThreadPtr addThread(const DocFieldProcessorPerThreadPtr& docFieldProcessorPerThread);
+    virtual bool freeRAM();
+
+    /// Checks that a field always has the same type of values.
+    void checkType(const String& field, int32_t docValuesType);
+
+    /// Writes the header of a values file.
+    static void writeHeader(const IndexOutputPtr& output, int32_t numFields);
+
+    /// Writes the numeric values of a field.
+    static void writeNumeric(const IndexOutputPtr& output, const String& field, const PackedIntsPtr& values);
+
+    /// Writes the sorted values of a field.
+    /// @param terms The distinct values in sorted order, starting with the empty value.
+    /// @param ords For each document, the index of its value in terms.
+    static void writeSorted(const IndexOutputPtr& output, const String& field, Collection<String> terms, Collection<int32_t> ords);
+};
+
+}
+
+#endif
@@ -0,0 +1,44 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef DOCVALUESWRITERPERFIELD_H
+#define DOCVALUESWRITERPERFIELD_H
+
+#include "DocFieldConsumerPerField.h"
+
+namespace Lucene {
+
+/// Buffers the docID/value pairs of a field until the next flush.
+class DocValuesWriterPerField : public DocFieldConsumerPerField {
+public:
+    DocValuesWriterPerField(const DocValuesWriterPerThreadPtr& perThread, const FieldInfoPtr& fieldInfo);
+    virtual ~DocValuesWriterPerField();
+
+    LUCENE_CLASS(DocValuesWriterPerField);
+
+public:
+    DocValuesWriterPerThreadWeakPtr _perThread;
+    FieldInfoPtr fieldInfo;
+    DocStatePtr docState;
+
+    // The type of the values, once the field had any
+    int32_t docValuesType;
+
+    // Holds all docID/value pairs we've seen
+    Collection<int32_t> docIDs;
+    Collection<int64_t> numericValues;
+    Collection<String> sortedValues;
+    int32_t upto;
+
+public:
+    void reset();
+    virtual void abort();
+    virtual void processFields(Collection<FieldablePtr> fields, int32_t count);
+};
+
+}
+
+#endif
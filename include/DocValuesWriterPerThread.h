@@ -0,0 +1,34 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef DOCVALUESWRITERPERTHREAD_H
+#define DOCVALUESWRITERPERTHREAD_H
+
+#include "DocFieldConsumerPerThread.h"
+
+namespace Lucene {
+
+class DocValuesWriterPerThread : public DocFieldConsumerPerThread {
+public:
+    DocValuesWriterPerThread(const DocFieldProcessorPerThreadPtr& docFieldProcessorPerThread, const DocValuesWriterPtr& docValuesWriter);
+    virtual ~DocValuesWriterPerThread();
+
+    LUCENE_CLASS(DocValuesWriterPerThread);
+
+public:
+    DocValuesWriterWeakPtr _docValuesWriter;
+    DocStatePtr docState;
+
+public:
+    virtual void startDocument();
+    virtual DocWriterPtr finishDocument();
+    virtual DocFieldConsumerPerFieldPtr addField(const FieldInfoPtr& fi);
+    virtual void abort();
+};
+
+}
+
+#endif
@@ -39,6 +39,12 @@ namespace Lucene {
 /// This means you can call flush with a given thread even while other threads are actively adding/deleting
 /// documents.
 ///
+/// When a flush is triggered by the RAM buffer or doc count filling up, the threads are only idled long enough
+/// to freeze the buffered docs, their ThreadStates and deletes into a {@link PendingFlush}.  The other threads
+/// then carry on indexing into fresh ThreadStates while the frozen segment is written.  Pending flushes are
+/// written one at a time, in the order they were frozen, and IndexWriter publishes them in that order so
+/// docIDs stay consistent with buffered deletes.
+///
 /// Exceptions:
 /// Because this class directly updates in-memory posting lists, and flushes stored fields and term vectors
 /// directly to files in the directory, there are certain limited times when an exception can corrupt this state.
@@ -66,10 +72,22 @@ protected:
     int32_t numDocsInRAM; // # docs buffered in RAM
 
     /// Max # ThreadState instances; if there are more threads than this they share ThreadStates
-    static const int32_t MAX_THREAD_STATE;
+    int32_t maxThreadStates;
     Collection<DocumentsWriterThreadStatePtr> threadStates;
     MapThreadDocumentsWriterThreadState threadBindings;
 
+    /// ThreadStates returned by written pending flushes, ready for reuse
+    Collection<DocumentsWriterThreadStatePtr> freeThreadStates;
+
+    /// Frozen segments not yet published, oldest first
+    Collection<PendingFlushPtr> pendingFlushes;
+
+    /// Max # frozen segments waiting to be written before indexing threads are held back; 0 means flush synchronously
+    int32_t maxPendingFlushes;
+
+    int32_t numPendingDocs; // # docs in pending flushes
+    int64_t numPendingBytes; // postings RAM held by pending flushes
+
     int32_t pauseThreads; // Non-zero when we need all threads to pause (eg to flush)
     bool aborting; // True if an abort is pending
 
@@ -165,6 +183,7 @@ INTERNAL:
     InfoStreamPtr infoStream;
     int32_t maxFieldLength;
     SimilarityPtr similarity;
+    int32_t storedFieldsCompression;
 
     DocConsumerPtr consumer;
 
@@ -212,10 +231,25 @@ public:
     void setMaxBufferedDocs(int32_t count);
     int32_t getMaxBufferedDocs();
 
+    /// Set the max number of ThreadStates; threads beyond this share ThreadStates.
+    void setMaxThreadStates(int32_t maxThreadStates);
+    int32_t getMaxThreadStates();
+
+    /// Set the max number of frozen segments that may be waiting to be written while indexing continues.
+    void setMaxPendingFlushes(int32_t maxPendingFlushes);
+
+    /// Returns the max number of pending flushes, which is always 0 (flush synchronously) for an indexing
+    /// chain that does not start with a {@link DocFieldProcessor}.
+    int32_t getMaxPendingFlushes();
+
+    /// Set the compression mode of stored fields blocks, taking effect with the next doc store.
+    void setStoredFieldsCompression(int32_t mode);
+    int32_t getStoredFieldsCompression();
+
     /// Get current segment name we are writing.
     String getSegment();
 
-    /// Returns how many docs are currently buffered in RAM.
+    /// Returns how many docs are currently buffered in RAM, including those in pending flushes.
     int32_t getNumDocsInRAM();
 
     /// Returns the current doc store segment we are writing to.
@@ -260,6 +294,23 @@ public:
 
     /// Build compound file for the segment we just flushed
     void createCompoundFile(const String& segment);
+    void createCompoundFile(const String& segment, HashSet<String> files);
+
+    /// Idle all threads just long enough to move the buffered docs, their ThreadStates and deletes into a new
+    /// pending flush.  Returns null if there are no buffered docs or we are aborting.
+    PendingFlushPtr freezeBufferedDocs();
+
+    /// Write a frozen segment to the directory, after any older pending flushes.  This is called without
+    /// holding the IndexWriter lock so other threads keep indexing meanwhile.
+    void writePendingFlush(const PendingFlushPtr& pendingFlush);
+
+    /// Removes and returns the oldest pending flush if it has been written, else returns null.
+    PendingFlushPtr nextWrittenFlush();
+
+    int32_t numPendingFlushes();
+
+    /// Wait until the oldest pending flush has been written (or discarded by abort).
+    void waitForPendingFlush();
 
     /// Set flushPending if it is not already set and returns whether it was set. This is used by IndexWriter
     /// to trigger a single flush even when multiple threads are trying to do so.
@@ -267,6 +318,7 @@ public:
     void clearFlushPending();
 
     void pushDeletes();
+    void pushDeletes(const BufferedDeletesPtr& deletes);
 
     void close();
 
@@ -331,6 +383,11 @@ protected:
     /// Reset after a flush
     void doAfterFlush();
 
+    /// Returns a reused or new ThreadState for a thread
+    DocumentsWriterThreadStatePtr newThreadState();
+
+    bool pendingFlushWriting();
+
     bool allThreadsIdle();
 
     void waitReady(const DocumentsWriterThreadStatePtr& state);
@@ -494,6 +551,33 @@ protected:
     void writeDocument(const DocWriterPtr& doc);
 };
 
+/// A segment's worth of buffered docs that has been frozen for flushing, along with the ThreadStates
+/// holding its postings and the deletes buffered against it.
+class PendingFlush : public LuceneObject {
+public:
+    PendingFlush(const SegmentWriteStatePtr& flushState, Collection<DocumentsWriterThreadStatePtr> threadStates,
+                 const BufferedDeletesPtr& deletes, int32_t docStoreOffset, int64_t bytesUsed);
+    virtual ~PendingFlush();
+
+    LUCENE_CLASS(PendingFlush);
+
+public:
+    SegmentWriteStatePtr flushState;
+    Collection<DocumentsWriterThreadStatePtr> threadStates;
+    BufferedDeletesPtr deletes;
+    int32_t docStoreOffset;
+    int64_t bytesUsed; // postings RAM held until the segment is written
+
+    /// Set by IndexWriter before the segment is written
+    SegmentInfoPtr segmentInfo;
+    bool useCompoundFile;
+    bool flushDeletes;
+
+    bool writing;
+    bool written;
+    bool aborted;
+};
+
 class ByteBlockAllocator : public ByteBlockPoolAllocatorBase {
 public:
     ByteBlockAllocator(const DocumentsWriterPtr& docWriter, int32_t blockSize);
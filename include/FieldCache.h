@@ -9,6 +9,7 @@
 
 #include <boost/any.hpp>
 #include "LuceneObject.h"
+#include "PackedInts.h"
 
 namespace Lucene {
 
@@ -27,7 +28,9 @@ public:
         CACHE_LONG,
         CACHE_DOUBLE,
         CACHE_STRING,
-        CACHE_STRING_INDEX
+        CACHE_STRING_INDEX,
+        CACHE_PACKED_INT,
+        CACHE_PACKED_LONG
     };
 
     /// Indicator for StringIndex values in the cache.
@@ -146,6 +149,40 @@ public:
     /// @return Array of terms and index into the array for each document.
     virtual StringIndexPtr getStringIndex(const IndexReaderPtr& reader, const String& field);
 
+    /// Checks the internal cache for an appropriate entry, and if none are found, reads the terms in
+    /// field as integers and returns the value each document has in the given field, packed using as few
+    /// bits per value as the range of the values requires.  Documents without a value get 0.
+    /// @param reader Used to get field values.
+    /// @param field Which field contains the integers.
+    /// @return The values in the given field for each document.
+    virtual PackedIntsPtr getPackedInts(const IndexReaderPtr& reader, const String& field);
+
+    /// Checks the internal cache for an appropriate entry, and if none are found, reads the terms in
+    /// field as integers and returns the value each document has in the given field, packed using as few
+    /// bits per value as the range of the values requires.  Documents without a value get 0.
+    /// @param reader Used to get field values.
+    /// @param field Which field contains the integers.
+    /// @param parser Computes integer for string values.
+    /// @return The values in the given field for each document.
+    virtual PackedIntsPtr getPackedInts(const IndexReaderPtr& reader, const String& field, const IntParserPtr& parser);
+
+    /// Checks the internal cache for an appropriate entry, and if none are found, reads the terms in
+    /// field as longs and returns the value each document has in the given field, packed using as few
+    /// bits per value as the range of the values requires.  Documents without a value get 0.
+    /// @param reader Used to get field values.
+    /// @param field Which field contains the longs.
+    /// @return The values in the given field for each document.
+    virtual PackedIntsPtr getPackedLongs(const IndexReaderPtr& reader, const String& field);
+
+    /// Checks the internal cache for an appropriate entry, and if none are found, reads the terms in
+    /// field as longs and returns the value each document has in the given field, packed using as few
+    /// bits per value as the range of the values requires.  Documents without a value get 0.
+    /// @param reader Used to get field values.
+    /// @param field Which field contains the longs.
+    /// @param parser Computes long for string values.
+    /// @return The values in the given field for each document.
+    virtual PackedIntsPtr getPackedLongs(const IndexReaderPtr& reader, const String& field, const LongParserPtr& parser);
+
     /// Generates an array of CacheEntry objects representing all items currently in the FieldCache.
     virtual Collection<FieldCacheEntryPtr> getCacheEntries() = 0;
 
@@ -165,6 +202,18 @@ public:
 
     /// @see #setInfoStream
     virtual InfoStreamPtr getInfoStream();
+
+    /// Returns the number of bytes of memory used by the values currently in the cache.
+    virtual int64_t ramBytesUsed();
+
+    /// Sets a limit on the memory used by the values in the cache.  Whenever a new entry takes the cache
+    /// over the limit, the least recently used entries are dropped until it fits again.  Values that were
+    /// dropped stay valid for whoever still holds them, but are created again when next requested.
+    /// @param maxRamBytes The limit in bytes; 0 or less (the default) disables the limit.
+    virtual void setMaxRamBytes(int64_t maxRamBytes);
+
+    /// @see #setMaxRamBytes
+    virtual int64_t getMaxRamBytes();
 };
 
 class LPPAPI CreationPlaceholder : public LuceneObject {
@@ -177,22 +226,54 @@ public:
 };
 
 /// Stores term text values and document ordering data.
+///
+/// The ordinal of each document is packed using as few bits as the number of term values requires, and
+/// each term value is stored once, UTF-8 encoded, in a shared block of bytes.
 class LPPAPI StringIndex : public LuceneObject {
 public:
+    /// @param values For each document, an index into lookup.
+    /// @param lookup All the term values, in natural order.
     StringIndex(Collection<int32_t> values, Collection<String> lookup);
+
+    /// @param order For each document, the ordinal of its term value.
+    /// @param termBytes All the term values, in natural order, UTF-8 encoded.
+    /// @param termOffsets The start of each term value in termBytes, followed by the end of the last one.
+    StringIndex(const PackedIntsPtr& order, ByteArray termBytes, const PackedIntsPtr& termOffsets);
+
     virtual ~StringIndex();
 
     LUCENE_CLASS(StringIndex);
 
+protected:
+    PackedIntsPtr order;
+    ByteArray termBytes;
+    PackedIntsPtr termOffsets;
+
 public:
-    /// All the term values, in natural order.
-    Collection<String> lookup;
+    /// Returns the ordinal of the term value of a document, 0 if the document has no value.
+    inline int32_t getOrd(int32_t doc) const {
+        return (int32_t)order->get(doc);
+    }
 
-    /// For each document, an index into the lookup array.
-    Collection<int32_t> order;
+    /// Returns the number of documents.
+    int32_t size();
 
-public:
+    /// Returns the number of term values, including the empty value at ordinal 0.
+    int32_t numOrd();
+
+    /// Returns the term value with the given ordinal.
+    String lookup(int32_t ord);
+
+    /// Searches the term values for key.
+    /// @return The ordinal of key if it is a term value; otherwise (-(insertion point) - 1).
     int32_t binarySearchLookup(const String& key);
+
+    /// Searches the term values with ordinals between low and high inclusive for key.
+    /// @return The ordinal of key if it is a term value; otherwise (-(insertion point) - 1).
+    int32_t binarySearchLookup(const String& key, int32_t low, int32_t high);
+
+    /// Returns the number of bytes of memory used by this index.
+    int64_t ramBytesUsed();
 };
 
 /// Marker interface as super-interface to all parsers.  It is used to specify a custom parser to {@link
@@ -264,7 +345,13 @@ public:
     virtual boost::any getCustom() = 0;
     virtual boost::any getValue() = 0;
 
+    /// Returns an estimate of the number of bytes of memory used by the cached value.
+    virtual int64_t ramBytesUsed();
+
     virtual String toString();
+
+    /// Returns an estimate of the number of bytes of memory used by a value held in a {@link FieldCache}.
+    static int64_t ramBytesUsed(const boost::any& value);
 };
 
 }
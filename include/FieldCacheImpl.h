@@ -23,6 +23,12 @@ protected:
     MapStringCache caches;
     InfoStreamPtr infoStream;
 
+    /// Limit on the memory used by the cached values, disabled if 0 or less.
+    int64_t maxRamBytes;
+
+    /// Incremented on every cache lookup, to find the least recently used entries.
+    int64_t accessClock;
+
 public:
     virtual void initialize();
     virtual void purgeAllCaches();
@@ -44,8 +50,25 @@ public:
     virtual Collection<String> getStrings(const IndexReaderPtr& reader, const String& field);
     virtual StringIndexPtr getStringIndex(const IndexReaderPtr& reader, const String& field);
 
+    virtual PackedIntsPtr getPackedInts(const IndexReaderPtr& reader, const String& field);
+    virtual PackedIntsPtr getPackedInts(const IndexReaderPtr& reader, const String& field, const IntParserPtr& parser);
+
+    virtual PackedIntsPtr getPackedLongs(const IndexReaderPtr& reader, const String& field);
+    virtual PackedIntsPtr getPackedLongs(const IndexReaderPtr& reader, const String& field, const LongParserPtr& parser);
+
     virtual void setInfoStream(const InfoStreamPtr& stream);
     virtual InfoStreamPtr getInfoStream();
+
+    virtual int64_t ramBytesUsed();
+    virtual void setMaxRamBytes(int64_t maxRamBytes);
+    virtual int64_t getMaxRamBytes();
+
+    /// Returns the next value of the access clock.
+    int64_t nextAccess();
+
+    /// Drops the least recently used entries while the cache uses more memory than allowed.  The most
+    /// recently used entry is always kept.
+    void enforceRamBudget();
 };
 
 class Entry : public LuceneObject {
@@ -60,6 +83,9 @@ public:
     String field; // which Fieldable
     boost::any custom; // which custom comparator or parser
 
+    int64_t ramBytes; // memory used by the value, once created
+    int64_t lastAccess; // access clock value of the last lookup
+
 public:
     /// Two of these are equal if they reference the same field and type.
     virtual bool equals(const LuceneObjectPtr& other);
@@ -157,6 +183,28 @@ protected:
     virtual boost::any createValue(const IndexReaderPtr& reader, const EntryPtr& key);
 };
 
+class PackedIntCache : public Cache {
+public:
+    PackedIntCache(const FieldCachePtr& wrapper = FieldCachePtr());
+    virtual ~PackedIntCache();
+
+    LUCENE_CLASS(PackedIntCache);
+
+protected:
+    virtual boost::any createValue(const IndexReaderPtr& reader, const EntryPtr& key);
+};
+
+class PackedLongCache : public Cache {
+public:
+    PackedLongCache(const FieldCachePtr& wrapper = FieldCachePtr());
+    virtual ~PackedLongCache();
+
+    LUCENE_CLASS(PackedLongCache);
+
+protected:
+    virtual boost::any createValue(const IndexReaderPtr& reader, const EntryPtr& key);
+};
+
 class FieldCacheEntryImpl : public FieldCacheEntry {
 public:
     FieldCacheEntryImpl(const LuceneObjectPtr& readerKey, const String& fieldName, int32_t cacheType, const boost::any& custom, const boost::any& value);
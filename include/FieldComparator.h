@@ -276,12 +276,12 @@ protected:
     Collection<int32_t> readerGen;
 
     int32_t currentReaderGen;
-    Collection<String> lookup;
-    Collection<int32_t> order;
+    StringIndexPtr currentIndex;
     String field;
 
     int32_t bottomSlot;
     int32_t bottomOrd;
+    bool bottomExact; // whether the bottom value is a term of the current reader
     String bottomValue;
     bool reversed;
     int32_t sortPos;
@@ -299,7 +299,6 @@ public:
 
 protected:
     void convert(int32_t slot);
-    int32_t binarySearch(Collection<String> lookup, const String& key, int32_t low, int32_t high);
 };
 
 /// Sorts by field's natural String sort order.  All comparisons are done using String.compare, which is
@@ -145,6 +145,13 @@ public:
     /// positional information, such as {@link PhraseQuery} or {@link SpanQuery} subclasses will silently fail
     /// to find results.
     virtual void setOmitTermFreqAndPositions(bool omitTermFreqAndPositions) = 0;
+
+    /// @see #setDocValuesType
+    virtual int32_t getDocValuesType() = 0;
+
+    /// Sets whether the value of this field is also written to a per-document column, one of {@link
+    /// AbstractField#DocValues}.  Column values are read by the FieldCache without un-inverting the field.
+    virtual void setDocValuesType(int32_t docValuesType) = 0;
 };
 
 }
@@ -49,6 +49,14 @@ protected:
     CloseableThreadLocal<IndexInput> fieldsStreamTL;
     bool isOriginal;
 
+    // The most recently decompressed block, for stores written in compressed blocks
+    int64_t blockPointer;
+    int32_t blockDocBase;
+    Collection<int32_t> blockOffsets;
+    ByteArray blockBytes;
+    IndexInputPtr blockStream;
+    ByteArray compressedBytes;
+
 public:
     /// Returns a cloned FieldsReader that shares open IndexInputs with the original one.  It is the caller's job not to
     /// close the original FieldsReader until all clones are called (eg, currently SegmentReader manages this logic).
@@ -62,12 +70,25 @@ public:
 
     bool canReadRawDocs();
 
+    /// Returns true if documents are stored in compressed blocks that can be copied without decompressing them.
+    bool canReadRawBlocks();
+
     DocumentPtr doc(int32_t n, const FieldSelectorPtr& fieldSelector);
 
     /// Returns the length in bytes of each raw document in a contiguous range of length numDocs starting with startDocID.
     /// Returns the IndexInput (the fieldStream), already seeked to the starting point for startDocID.
     IndexInputPtr rawDocs(Collection<int32_t> lengths, int32_t startDocID, int32_t numDocs);
 
+    /// Returns the number of documents in the compressed block holding document n, and sets firstDocID to the
+    /// number of the block's first document.  firstDocID is negative if the block starts before this segment's
+    /// documents in a shared doc store, and the block may also end after them.
+    int32_t blockDocs(int32_t n, int32_t& firstDocID);
+
+    /// Returns the fields stream positioned within the compressed block that starts with document n, just past
+    /// the number of its first document, and sets length to the number of bytes left in the block.
+    /// @see FieldsWriter#addRawBlock(const IndexInputPtr&, int32_t, int64_t)
+    IndexInputPtr rawBlock(int32_t n, int64_t& length);
+
 protected:
     void ConstructReader(const DirectoryPtr& d, const String& segment, const FieldInfosPtr& fn, int32_t readBufferSize, int32_t docStoreOffset, int32_t size);
 
@@ -75,18 +96,24 @@ protected:
 
     void seekIndex(int32_t docID);
 
+    /// Decompresses the block at the given position in the fields stream, unless it is already loaded.
+    void readBlock(int64_t pointer);
+
+    /// Returns the decompressed block holding document n, positioned at the start of the document.
+    IndexInputPtr seekBlock(int64_t pointer, int32_t n);
+
     /// Skip the field.  We still have to read some of the information about the field, but can skip past the actual content.
     /// This will have the most payoff on large fields.
-    void skipField(bool binary, bool compressed);
-    void skipField(bool binary, bool compressed, int32_t toRead);
+    void skipField(const IndexInputPtr& input, bool binary, bool compressed);
+    void skipField(const IndexInputPtr& input, bool binary, bool compressed, int32_t toRead);
 
-    void addFieldLazy(const DocumentPtr& doc, const FieldInfoPtr& fi, bool binary, bool compressed, bool tokenize);
-    void addField(const DocumentPtr& doc, const FieldInfoPtr& fi, bool binary, bool compressed, bool tokenize);
+    void addFieldLazy(const IndexInputPtr& input, const DocumentPtr& doc, const FieldInfoPtr& fi, bool binary, bool compressed, bool tokenize);
+    void addField(const IndexInputPtr& input, const DocumentPtr& doc, const FieldInfoPtr& fi, bool binary, bool compressed, bool tokenize);
 
     /// Add the size of field as a byte[] containing the 4 bytes of the integer byte size (high order byte first; char = 2 bytes).
     /// Read just the size - caller must skip the field content to continue reading fields.  Return the size in bytes or chars,
     /// depending on field type.
-    int32_t addFieldSize(const DocumentPtr& doc, const FieldInfoPtr& fi, bool binary, bool compressed);
+    int32_t addFieldSize(const IndexInputPtr& input, const DocumentPtr& doc, const FieldInfoPtr& fi, bool binary, bool compressed);
 
     ByteArray uncompress(ByteArray b);
     String uncompressString(ByteArray b);
@@ -110,6 +137,11 @@ protected:
     /// @deprecated Only kept for backward-compatibility with <3.0 indexes.
     bool isCompressed;
 
+    /// The decompressed block holding the field, in which case pointer is relative to the block.
+    ByteArray block;
+
+    friend class FieldsReader;
+
 public:
     /// The value of the field as a Reader, or null.  If null, the String value, binary value, or TokenStream value is used.
     /// Exactly one of stringValue(), readerValue(), getBinaryValue(), and tokenStreamValue() must be set.
@@ -25,6 +25,19 @@ protected:
     IndexOutputPtr indexStream;
     bool doClose;
 
+    int32_t compressionMode;
+
+    // Documents buffered for the next block, and the length of each one
+    RAMOutputStreamPtr blockStream;
+    Collection<int32_t> blockLengths;
+    int32_t blockDocs;
+
+    // Number of documents written to the fields stream in earlier blocks
+    int32_t numDocsInStore;
+
+    ByteArray blockBytes;
+    ByteArray compressedBytes;
+
 public:
     static const uint8_t FIELD_IS_TOKENIZED;
     static const uint8_t FIELD_IS_BINARY;
@@ -33,14 +46,33 @@ public:
     static const int32_t FORMAT; // Original format
     static const int32_t FORMAT_VERSION_UTF8_LENGTH_IN_BYTES; // Changed strings to UTF8
     static const int32_t FORMAT_LUCENE_3_0_NO_COMPRESSED_FIELDS; // Lucene 3.0: Removal of compressed fields
+    static const int32_t FORMAT_LUCENE_3_0_COMPRESSED_BLOCKS; // Documents compressed together in blocks
 
     // NOTE: if you introduce a new format, make it 1 higher than the current one, and always change this
     // if you switch to a new format!
     static const int32_t FORMAT_CURRENT;
 
+    /// Documents are buffered until they take up at least this many bytes, then compressed and written as
+    /// one block.
+    static const int32_t BLOCK_SIZE;
+
+    /// Blocks are written uncompressed.
+    static const int32_t COMPRESSION_NONE;
+
+    /// Blocks are compressed with {@link LZ4}, which is fast to both compress and decompress.  This is the default.
+    static const int32_t COMPRESSION_FAST;
+
+    /// Blocks are compressed with zlib through {@link CompressionTools}, which is slower but gives smaller files.
+    static const int32_t COMPRESSION_HIGH;
+
 public:
     void setFieldsStream(const IndexOutputPtr& stream);
 
+    /// Sets how blocks of documents are compressed; one of {@link #COMPRESSION_NONE}, {@link #COMPRESSION_FAST}
+    /// or {@link #COMPRESSION_HIGH}.  A block that does not get smaller is written uncompressed.
+    void setCompressionMode(int32_t mode);
+    int32_t getCompressionMode();
+
     /// Writes the contents of buffer into the fields stream and adds a new entry for this document into the index
     /// stream.  This assumes the buffer was already written in the correct fields format.
     void flushDocument(int32_t numStoredFields, const RAMOutputStreamPtr& buffer);
@@ -54,7 +86,21 @@ public:
     /// The stream IndexInput is the fieldsStream from which we should bulk-copy all bytes.
     void addRawDocuments(const IndexInputPtr& stream, Collection<int32_t> lengths, int32_t numDocs);
 
+    /// Bulk write a whole block of numDocs documents without decompressing it.  The stream is positioned and
+    /// length set by {@link FieldsReader#rawBlock(int32_t, int64_t&)}.
+    void addRawBlock(const IndexInputPtr& stream, int32_t numDocs, int64_t length);
+
     void addDocument(const DocumentPtr& doc);
+
+protected:
+    void writeField(const IndexOutputPtr& output, const FieldInfoPtr& fi, const FieldablePtr& field);
+
+    /// Adds the index entry for a document just appended to the block, starting at the given block position,
+    /// and writes out the block once it is full.
+    void finishDocument(int64_t start);
+
+    /// Compresses and writes out the buffered documents.
+    void flushBlock();
 };
 
 }
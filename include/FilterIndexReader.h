@@ -48,6 +48,8 @@ public:
     virtual bool hasNorms(const String& field);
     virtual ByteArray norms(const String& field);
     virtual void norms(const String& field, ByteArray norms, int32_t offset);
+    virtual PackedIntsPtr getNumericDocValues(const String& field);
+    virtual StringIndexPtr getSortedDocValues(const String& field);
     virtual TermEnumPtr terms();
     virtual TermEnumPtr terms(const TermPtr& t);
     virtual int32_t docFreq(const TermPtr& t);
@@ -30,7 +30,7 @@ public:
 
     /// Walk through all unique text tokens (Posting instances) found in this field and serialize them
     /// into a single RAM segment.
-    void appendPostings(Collection<FreqProxTermsWriterPerFieldPtr> fields, const FormatPostingsFieldsConsumerPtr& consumer);
+    void appendPostings(const FieldInfoPtr& fieldInfo, Collection<FreqProxTermsWriterPerFieldPtr> fields, const FormatPostingsFieldsConsumerPtr& consumer);
 
     virtual int32_t bytesPerPosting();
 
@@ -14,8 +14,9 @@ namespace Lucene {
 /// Implements the fuzzy search query.  The similarity measurement is based on the Levenshtein (edit
 /// distance) algorithm.
 ///
-/// Warning: this query is not very scalable with its default prefix length of 0 - in this case, *every*
-/// term will be enumerated and cause an edit score calculation.
+/// Matching terms are enumerated with a Levenshtein automaton when the minimum similarity allows at most
+/// two edits (see {@link FuzzyTermEnum}).  Otherwise this query is not very scalable with its default prefix
+/// length of 0 - in this case, *every* term will be enumerated and cause an edit score calculation.
 class LPPAPI FuzzyQuery : public MultiTermQuery {
 public:
     /// Create a new FuzzyQuery that will match terms with a similarity of at least minimumSimilarity
@@ -26,6 +27,8 @@ public:
     /// length as the query term is considered similar to the query term if the edit distance between
     /// both terms is less than length(term) * 0.5
     /// @param prefixLength Length of common (non-fuzzy) prefix
+    /// @param transpositions Whether swapping two adjacent characters counts as a single edit
+    FuzzyQuery(const TermPtr& term, double minimumSimilarity, int32_t prefixLength, bool transpositions);
     FuzzyQuery(const TermPtr& term, double minimumSimilarity, int32_t prefixLength);
     FuzzyQuery(const TermPtr& term, double minimumSimilarity);
     FuzzyQuery(const TermPtr& term);
@@ -37,6 +40,7 @@ public:
 protected:
     double minimumSimilarity;
     int32_t prefixLength;
+    bool transpositions;
     bool termLongEnough;
 
     TermPtr term;
@@ -56,6 +60,9 @@ public:
     /// must be identical (not fuzzy) to the query term if the query is to match that term.
     int32_t getPrefixLength();
 
+    /// Returns true if swapping two adjacent characters counts as a single edit.
+    bool getTranspositions();
+
     /// Returns the pattern term.
     TermPtr getTerm();
 
@@ -68,7 +75,7 @@ public:
     virtual bool equals(const LuceneObjectPtr& other);
 
 protected:
-    void ConstructQuery(const TermPtr& term, double minimumSimilarity, int32_t prefixLength);
+    void ConstructQuery(const TermPtr& term, double minimumSimilarity, int32_t prefixLength, bool transpositions);
 
     virtual FilteredTermEnumPtr getEnum(const IndexReaderPtr& reader);
 };
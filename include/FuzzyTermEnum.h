@@ -7,15 +7,19 @@
 #ifndef FUZZYTERMENUM_H
 #define FUZZYTERMENUM_H
 
-#include "FilteredTermEnum.h"
+#include "AutomatonTermEnum.h"
 
 namespace Lucene {
 
 /// Subclass of FilteredTermEnum for enumerating all terms that are similar to the specified filter term.
 ///
+/// When the similarity threshold allows at most {@link #MAX_AUTOMATON_EDITS} edits, the terms are found by
+/// intersecting a Levenshtein automaton with the term dictionary, so only terms within that many edits are
+/// visited and scored.  Otherwise every term sharing the prefix is scored.
+///
 /// Term enumerations are always ordered by Term.compareTo().  Each term in the enumeration is greater
 /// than all that precede it.
-class LPPAPI FuzzyTermEnum : public FilteredTermEnum {
+class LPPAPI FuzzyTermEnum : public AutomatonTermEnum {
 public:
     /// Constructor for enumeration of all terms from specified reader which share a prefix of length
     /// prefixLength with term and which have a fuzzy similarity > minSimilarity.
@@ -26,6 +30,9 @@ public:
     /// @param term Pattern term.
     /// @param minSimilarity Minimum required similarity for terms from the reader. Default value is 0.5.
     /// @param prefixLength Length of required common prefix. Default value is 0.
+    /// @param transpositions Whether swapping two adjacent characters counts as a single edit. Default
+    /// value is false.
+    FuzzyTermEnum(const IndexReaderPtr& reader, const TermPtr& term, double minSimilarity, int32_t prefixLength, bool transpositions);
     FuzzyTermEnum(const IndexReaderPtr& reader, const TermPtr& term, double minSimilarity, int32_t prefixLength);
     FuzzyTermEnum(const IndexReaderPtr& reader, const TermPtr& term, double minSimilarity);
     FuzzyTermEnum(const IndexReaderPtr& reader, const TermPtr& term);
@@ -39,27 +46,37 @@ protected:
     Collection<int32_t> p;
     Collection<int32_t> d;
 
+    /// Row before p, needed for transpositions.
+    Collection<int32_t> pp;
+
     double _similarity;
-    bool _endEnum;
 
     TermPtr searchTerm;
-    String field;
     String text;
     String prefix;
 
     double minimumSimilarity;
     double scale_factor;
+    bool transpositions;
+
+public:
+    /// Largest edit distance for which terms are enumerated with a Levenshtein automaton.
+    static const int32_t MAX_AUTOMATON_EDITS;
 
 public:
     virtual double difference();
-    virtual bool endEnum();
     virtual void close();
 
+    /// Builds the deterministic automaton accepting prefix followed by any string within maxEdits edits
+    /// of text.
+    /// @param transpositions Whether swapping two adjacent characters counts as a single edit.
+    static AutomatonPtr toAutomaton(const String& prefix, const String& text, int32_t maxEdits, bool transpositions);
+
 protected:
-    void ConstructTermEnum(const IndexReaderPtr& reader, const TermPtr& term, double minSimilarity, int32_t prefixLength);
+    void ConstructTermEnum(const IndexReaderPtr& reader, const TermPtr& term, double minSimilarity, int32_t prefixLength, bool transpositions);
 
     /// The termCompare method in FuzzyTermEnum uses Levenshtein distance to calculate the distance between
-    /// the given term and the comparing term.
+    /// the given term and the comparing term, for the terms accepted by the automaton.
     virtual bool termCompare(const TermPtr& term);
 
     ///
@@ -82,6 +99,9 @@ protected:
     /// differs from the standard Levenshtein distance algorithm in that it is aborted if it is discovered that
     /// the minimum distance between the words is greater than some threshold.
     ///
+    /// If transpositions are enabled, swapping two adjacent characters counts as a single edit (optimal
+    /// string alignment distance).
+    ///
     /// To calculate the maximum distance threshold we use the following formula:
     /// <pre>
     /// (1 - minimumSimilarity) * length
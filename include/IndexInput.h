@@ -47,6 +47,16 @@ public:
     /// @see IndexOutput#writeBytes(const uint8_t*,int)
     virtual void readBytes(uint8_t* b, int32_t offset, int32_t length, bool useBuffer);
 
+    /// Returns a pointer to the bytes that follow the current position and are already in memory, so that
+    /// callers can decode a block of values in place instead of reading them one byte at a time.  The number
+    /// of bytes available is stored in available; it is 0 (and NULL is returned) if the input has no such
+    /// bytes or does not support direct access.  The pointer is only valid until the next read or seek.
+    /// @see #skipBufferedBytes(int32_t)
+    virtual const uint8_t* bufferedBytes(int32_t& available);
+
+    /// Advances the current position past count bytes previously returned by {@link #bufferedBytes(int32_t&)}.
+    virtual void skipBufferedBytes(int32_t count);
+
     /// Reads four bytes and returns an int.
     /// @see IndexOutput#writeInt(int32_t)
     virtual int32_t readInt();
@@ -380,6 +380,16 @@ public:
     /// @see Field#setBoost(double)
     virtual void norms(const String& field, ByteArray norms, int32_t offset) = 0;
 
+    /// Returns the numeric per-document values of the named field, indexed by document number, or null if
+    /// the field has none.  Only readers of a single segment hold values; composite readers return null.
+    /// @see AbstractField#setDocValuesType(int32_t)
+    virtual PackedIntsPtr getNumericDocValues(const String& field);
+
+    /// Returns the sorted per-document values of the named field, or null if the field has none.  Only
+    /// readers of a single segment hold values; composite readers return null.
+    /// @see AbstractField#setDocValuesType(int32_t)
+    virtual StringIndexPtr getSortedDocValues(const String& field);
+
     /// Resets the normalization factor for the named field of the named  document.  The norm represents
     /// the product of the field's {@link Fieldable#setBoost(double) boost} and its {@link
     /// Similarity#lengthNorm(String, int) length normalization}.  Thus, to preserve the length normalization
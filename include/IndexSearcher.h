@@ -35,6 +35,14 @@ public:
     /// Directly specify the reader, subReaders and their docID starts.
     IndexSearcher(const IndexReaderPtr& reader, Collection<IndexReaderPtr> subReaders, Collection<int32_t> docStarts);
 
+    /// Creates a searcher searching the provided index, scoring each sub-reader (segment) concurrently
+    /// using the given {@link ThreadPool} when searching for top hits.  Hits from each segment are merged
+    /// into a single priority queue once all segments have been searched.
+    ///
+    /// NOTE: searches that pass a custom {@link Collector} are still executed on the calling thread, since
+    /// collectors are not required to be thread safe.
+    IndexSearcher(const IndexReaderPtr& reader, const ThreadPoolPtr& executor);
+
     virtual ~IndexSearcher();
 
     LUCENE_CLASS(IndexSearcher);
@@ -48,6 +56,9 @@ protected:
     Collection<IndexReaderPtr> subReaders;
     Collection<int32_t> docStarts;
 
+    ThreadPoolPtr executor;
+    Collection<IndexSearcherPtr> subSearchers;
+
     bool fieldSortDoTrackScores;
     bool fieldSortDoMaxScore;
 
@@ -92,9 +103,12 @@ public:
     virtual void setDefaultFieldSortScoring(bool doTrackScores, bool doMaxScore);
 
 protected:
-    void ConstructSearcher(const IndexReaderPtr& reader, bool closeReader);
+    void ConstructSearcher(const IndexReaderPtr& reader, bool closeReader, const ThreadPoolPtr& executor = ThreadPoolPtr());
     void gatherSubReaders(Collection<IndexReaderPtr> allSubReaders, const IndexReaderPtr& reader);
     void searchWithFilter(const IndexReaderPtr& reader, const WeightPtr& weight, const FilterPtr& filter, const CollectorPtr& collector);
+
+    /// Return true if top hits searches should be split across the sub-searchers using the executor.
+    bool searchConcurrently();
 };
 
 }
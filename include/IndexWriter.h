@@ -144,6 +144,7 @@ protected:
     LockPtr writeLock;
 
     int32_t termIndexInterval;
+    int32_t storedFieldsCompression;
 
     bool closed;
     bool closing;
@@ -221,6 +222,14 @@ public:
     /// Change using {@link #setRAMBufferSizeMB}.
     static const double DEFAULT_RAM_BUFFER_SIZE_MB;
 
+    /// Default value for the maximum number of thread states (5).
+    /// Change using {@link #setMaxThreadStates}.
+    static const int32_t DEFAULT_MAX_THREAD_STATES;
+
+    /// Default value for the maximum number of segments being written while indexing continues (1).
+    /// Change using {@link #setMaxPendingFlushes}.
+    static const int32_t DEFAULT_MAX_PENDING_FLUSHES;
+
     /// Disabled by default (because IndexWriter flushes by RAM usage by default). Change using
     /// {@link #setMaxBufferedDeleteTerms(int32_t)}.
     static const int32_t DEFAULT_MAX_BUFFERED_DELETE_TERMS;
@@ -299,6 +308,10 @@ public:
     /// the segmentInfo's delCount is returned.
     virtual int32_t numDeletedDocs(const SegmentInfoPtr& info);
 
+    /// Returns a copy of the segments currently registered for merging.  Merge policies use this to
+    /// avoid selecting segments that are already being merged.
+    virtual SetSegmentInfo getMergingSegments();
+
     virtual void acquireWrite();
     virtual void releaseWrite();
     virtual void acquireRead();
@@ -358,6 +371,17 @@ public:
     /// @see #setTermIndexInterval(int32_t)
     virtual int32_t getTermIndexInterval();
 
+    /// Set how stored fields are compressed.  Documents are compressed together in blocks of about
+    /// {@link FieldsWriter#BLOCK_SIZE} bytes, either with {@link FieldsWriter#COMPRESSION_FAST} (the default),
+    /// which costs little at both index and search time, or with {@link FieldsWriter#COMPRESSION_HIGH}, which
+    /// gives smaller files but is slower to decompress.  {@link FieldsWriter#COMPRESSION_NONE} writes the blocks
+    /// uncompressed.  The setting applies to newly flushed and merged segments.
+    virtual void setStoredFieldsCompression(int32_t mode);
+
+    /// Return how stored fields are compressed.
+    /// @see #setStoredFieldsCompression(int32_t)
+    virtual int32_t getStoredFieldsCompression();
+
     /// Set the merge policy used by this writer.
     virtual void setMergePolicy(const MergePolicyPtr& mp);
 
@@ -437,6 +461,32 @@ public:
     /// @see #setMaxBufferedDocs
     virtual int32_t getMaxBufferedDocs();
 
+    /// Determines the maximum number of thread states, ie. the number of threads that can index documents
+    /// concurrently, each into its own private in-memory buffers.  Threads beyond this share thread states
+    /// and wait for each other.  Set this to the number of indexing threads on machines with many cores.
+    ///
+    /// The default value is {@link #DEFAULT_MAX_THREAD_STATES}.
+    virtual void setMaxThreadStates(int32_t maxThreadStates);
+
+    /// Returns the maximum number of thread states.
+    /// @see #setMaxThreadStates
+    virtual int32_t getMaxThreadStates();
+
+    /// Determines how many automatically flushed segments may be waiting to be written to the Directory while
+    /// other threads carry on indexing into fresh buffers.  When a flush is triggered the buffered documents
+    /// are frozen into a pending segment and written by the triggering thread without holding up the others.
+    /// If this many pending segments are already waiting, the triggering thread (and so indexing) is held back
+    /// until the oldest has been written.  Each pending segment holds up to a full RAM buffer, so RAM use may
+    /// reach (1 + maxPendingFlushes) times {@link #getRAMBufferSizeMB}.  0 flushes synchronously, stalling all
+    /// indexing threads while the segment is written.
+    ///
+    /// The default value is {@link #DEFAULT_MAX_PENDING_FLUSHES}.
+    virtual void setMaxPendingFlushes(int32_t maxPendingFlushes);
+
+    /// Returns the maximum number of pending flushes.
+    /// @see #setMaxPendingFlushes
+    virtual int32_t getMaxPendingFlushes();
+
     /// Determines the amount of RAM that may be used for buffering added documents and deletions
     /// before they are flushed to the Directory.  Generally for faster indexing performance it's
     /// best to flush by RAM usage instead of document count and use as large a RAM buffer as you can.
@@ -1045,7 +1095,14 @@ protected:
     virtual bool doFlush(bool flushDocStores, bool flushDeletes);
     virtual bool doFlushInternal(bool flushDocStores, bool flushDeletes);
 
-    virtual int32_t ensureContiguousMerge(const OneMergePtr& merge);
+    /// Flush the buffered documents triggered by an add or update, freezing them into a pending segment that
+    /// is written without holding up other indexing threads.
+    virtual void flushBufferedDocs();
+
+    /// Add the pending segments that have been written to the index, in the order they were frozen.
+    virtual void publishFlushedSegments();
+
+    virtual void ensureValidMerge(const OneMergePtr& merge);
 
     /// Carefully merges deletes for the segments we just merged.  This is tricky because, although merging
     /// will clear all deletes (compacts the documents), new deletes may have been flushed to the segments
@@ -0,0 +1,49 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef LZ4_H
+#define LZ4_H
+
+#include "Lucene.h"
+
+namespace Lucene {
+
+/// A fast LZ77 compressor that writes the LZ4 block format.
+///
+/// A compressed block is a series of sequences, each made of a token byte (the number of literals in the
+/// high 4 bits and the match length minus 4 in the low 4 bits), any extra literal length bytes, the literals,
+/// a 2 byte little-endian match offset and any extra match length bytes.  The last sequence holds literals
+/// only.  Matches are found through a single-entry hash table, which trades compression ratio for speed;
+/// use {@link CompressionTools} where a higher ratio matters more.
+class LPPAPI LZ4 {
+public:
+    /// Returns the largest number of bytes that compressing length bytes may produce.
+    static int32_t maxCompressedLength(int32_t length);
+
+    /// Compresses length bytes of src into dest, which must hold at least {@link #maxCompressedLength(int32_t)}
+    /// bytes, and returns the number of bytes written.
+    static int32_t compress(const uint8_t* src, int32_t length, uint8_t* dest);
+
+    /// Decompresses length bytes of src into dest, which holds destLength bytes, and returns the number of
+    /// bytes written.  Throws {@link CompressionException} if src is not a valid compressed block or if it
+    /// decompresses to more than destLength bytes.
+    static int32_t decompress(const uint8_t* src, int32_t length, uint8_t* dest, int32_t destLength);
+
+protected:
+    static const int32_t MIN_MATCH;
+    static const int32_t LAST_LITERALS;
+    static const int32_t MATCH_FIND_LIMIT;
+    static const int32_t MAX_DISTANCE;
+    static const int32_t HASH_LOG;
+    static const int32_t SKIP_TRIGGER;
+
+    static int32_t writeLength(uint8_t* dest, int32_t op, int32_t length);
+    static int32_t readLength(const uint8_t* src, int32_t& ip, int32_t end, int32_t limit);
+};
+
+}
+
+#endif
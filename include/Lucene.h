@@ -169,6 +169,8 @@ typedef HashMap< wchar_t, NormalizeCharMapPtr > MapCharNormalizeCharMap;
 typedef HashMap< String, AnalyzerPtr > MapStringAnalyzer;
 typedef HashMap< String, ByteArray > MapStringByteArray;
 typedef HashMap< String, int32_t > MapStringInt;
+typedef HashMap< String, int64_t > MapStringLong;
+typedef HashMap< String, LuceneObjectPtr > MapStringLuceneObject;
 typedef HashMap< String, FieldInfoPtr > MapStringFieldInfo;
 typedef HashMap< String, Collection<TermVectorEntryPtr> > MapStringCollectionTermVectorEntry;
 typedef HashMap< String, RefCountPtr > MapStringRefCount;
@@ -120,6 +120,10 @@ DECLARE_SHARED_PTR(DocInverter)
 DECLARE_SHARED_PTR(DocInverterPerField)
 DECLARE_SHARED_PTR(DocInverterPerThread)
 DECLARE_SHARED_PTR(DocState)
+DECLARE_SHARED_PTR(DocValuesReader)
+DECLARE_SHARED_PTR(DocValuesWriter)
+DECLARE_SHARED_PTR(DocValuesWriterPerField)
+DECLARE_SHARED_PTR(DocValuesWriterPerThread)
 DECLARE_SHARED_PTR(DocumentsWriter)
 DECLARE_SHARED_PTR(DocumentsWriterThreadState)
 DECLARE_SHARED_PTR(DocWriter)
@@ -167,6 +171,7 @@ DECLARE_SHARED_PTR(InvertedDocEndConsumer)
 DECLARE_SHARED_PTR(InvertedDocEndConsumerPerField)
 DECLARE_SHARED_PTR(InvertedDocEndConsumerPerThread)
 DECLARE_SHARED_PTR(KeepOnlyLastCommitDeletionPolicy)
+DECLARE_SHARED_PTR(LazyField)
 DECLARE_SHARED_PTR(LogByteSizeMergePolicy)
 DECLARE_SHARED_PTR(LogDocMergePolicy)
 DECLARE_SHARED_PTR(LogMergePolicy)
@@ -196,6 +201,7 @@ DECLARE_SHARED_PTR(ParallelTermEnum)
 DECLARE_SHARED_PTR(ParallelTermDocs)
 DECLARE_SHARED_PTR(ParallelTermPositions)
 DECLARE_SHARED_PTR(Payload)
+DECLARE_SHARED_PTR(PendingFlush)
 DECLARE_SHARED_PTR(PerDocBuffer)
 DECLARE_SHARED_PTR(PositionBasedTermVectorMapper)
 DECLARE_SHARED_PTR(RawPostingList)
@@ -238,6 +244,7 @@ DECLARE_SHARED_PTR(TermFreqVector)
 DECLARE_SHARED_PTR(TermIndexStatus)
 DECLARE_SHARED_PTR(TermInfo)
 DECLARE_SHARED_PTR(TermInfosReader)
+DECLARE_SHARED_PTR(TermInfosReaderIndex)
 DECLARE_SHARED_PTR(TermInfosReaderThreadResources)
 DECLARE_SHARED_PTR(TermInfosWriter)
 DECLARE_SHARED_PTR(TermPositions)
@@ -262,6 +269,7 @@ DECLARE_SHARED_PTR(TermVectorsTermsWriterPerThread)
 DECLARE_SHARED_PTR(TermVectorsTermsWriterPostingList)
 DECLARE_SHARED_PTR(TermVectorsWriter)
 DECLARE_SHARED_PTR(TermVectorsPositionInfo)
+DECLARE_SHARED_PTR(TieredMergePolicy)
 DECLARE_SHARED_PTR(WaitQueue)
 
 // query parser
@@ -274,6 +282,7 @@ DECLARE_SHARED_PTR(QueryParserToken)
 DECLARE_SHARED_PTR(QueryParserTokenManager)
 
 // search
+DECLARE_SHARED_PTR(AutomatonTermEnum)
 DECLARE_SHARED_PTR(AveragePayloadFunction)
 DECLARE_SHARED_PTR(BooleanClause)
 DECLARE_SHARED_PTR(BooleanQuery)
@@ -281,7 +290,6 @@ DECLARE_SHARED_PTR(BooleanScorer)
 DECLARE_SHARED_PTR(BooleanScorerCollector)
 DECLARE_SHARED_PTR(BooleanScorer2)
 DECLARE_SHARED_PTR(BooleanWeight)
-DECLARE_SHARED_PTR(Bucket)
 DECLARE_SHARED_PTR(BucketScorer)
 DECLARE_SHARED_PTR(BucketTable)
 DECLARE_SHARED_PTR(ByteCache)
@@ -397,6 +405,8 @@ DECLARE_SHARED_PTR(NumericUtilsIntParser)
 DECLARE_SHARED_PTR(NumericUtilsLongParser)
 DECLARE_SHARED_PTR(OneComparatorFieldValueHitQueue)
 DECLARE_SHARED_PTR(OrdFieldSource)
+DECLARE_SHARED_PTR(PackedIntCache)
+DECLARE_SHARED_PTR(PackedLongCache)
 DECLARE_SHARED_PTR(ParallelMultiSearcher)
 DECLARE_SHARED_PTR(Parser)
 DECLARE_SHARED_PTR(PayloadFunction)
@@ -484,6 +494,7 @@ DECLARE_SHARED_PTR(WildcardTermEnum)
 // store
 DECLARE_SHARED_PTR(BufferedIndexInput)
 DECLARE_SHARED_PTR(BufferedIndexOutput)
+DECLARE_SHARED_PTR(ByteArrayIndexInput)
 DECLARE_SHARED_PTR(ChecksumIndexInput)
 DECLARE_SHARED_PTR(ChecksumIndexOutput)
 DECLARE_SHARED_PTR(Directory)
@@ -502,6 +513,9 @@ DECLARE_SHARED_PTR(NativeFSLockFactory)
 DECLARE_SHARED_PTR(NoLock)
 DECLARE_SHARED_PTR(NoLockFactory)
 DECLARE_SHARED_PTR(OutputFile)
+DECLARE_SHARED_PTR(RateLimitedDirectoryWrapper)
+DECLARE_SHARED_PTR(RateLimitedIndexOutput)
+DECLARE_SHARED_PTR(RateLimiter)
 DECLARE_SHARED_PTR(RAMDirectory)
 DECLARE_SHARED_PTR(RAMFile)
 DECLARE_SHARED_PTR(RAMInputStream)
@@ -519,6 +533,7 @@ DECLARE_SHARED_PTR(Attribute)
 DECLARE_SHARED_PTR(AttributeFactory)
 DECLARE_SHARED_PTR(AttributeSource)
 DECLARE_SHARED_PTR(AttributeSourceState)
+DECLARE_SHARED_PTR(Automaton)
 DECLARE_SHARED_PTR(BitSet)
 DECLARE_SHARED_PTR(BitVector)
 DECLARE_SHARED_PTR(BufferedReader)
@@ -543,6 +558,7 @@ DECLARE_SHARED_PTR(NumericUtils)
 DECLARE_SHARED_PTR(OpenBitSet)
 DECLARE_SHARED_PTR(OpenBitSetDISI)
 DECLARE_SHARED_PTR(OpenBitSetIterator)
+DECLARE_SHARED_PTR(PackedInts)
 DECLARE_SHARED_PTR(Random)
 DECLARE_SHARED_PTR(Reader)
 DECLARE_SHARED_PTR(ReaderField)
@@ -13,6 +13,8 @@ namespace Lucene {
 
 /// File-based {@link Directory} implementation that uses mmap for reading, and {@link SimpleFSIndexOutput} for writing.
 ///
+/// Files are mapped in chunks of at most {@link #getMaxChunkSize()} bytes, so files larger than 2 GB can be read.
+///
 /// NOTE: memory mapping uses up a portion of the virtual memory address space in your process equal to the size of the
 /// file being mapped.  Before using this class, be sure your have plenty of virtual address space.
 ///
@@ -30,9 +32,47 @@ public:
 
     LUCENE_CLASS(MMapDirectory);
 
+public:
+    /// Access patterns that can be passed to the operating system for mapped files (see madvise).
+    enum AccessHint {
+        /// No particular access pattern.
+        ACCESS_NORMAL,
+
+        /// Pages are accessed in random order, so read-ahead is of little use.
+        ACCESS_RANDOM,
+
+        /// Pages are accessed sequentially and can be read ahead aggressively.
+        ACCESS_SEQUENTIAL,
+
+        /// Pages will be needed soon and should be read ahead now.
+        ACCESS_WILLNEED
+    };
+
+    /// Default maximum chunk size: 1 GB on 64 bit platforms, 256 MB on 32 bit platforms.
+    static const int32_t DEFAULT_MAX_CHUNK_SIZE;
+
+protected:
+    int32_t chunkSizePower;
+    MapStringInt accessHints;
+
 public:
     using FSDirectory::openInput;
 
+    /// Sets the maximum size of a single mapping.  Files larger than this are mapped in several chunks.  The value
+    /// is rounded down to a power of two, and must be at least the page size of the operating system.  This only
+    /// affects inputs opened after the call.
+    void setMaxChunkSize(int32_t maxChunkSize);
+
+    /// Returns the maximum size of a single mapping.
+    int32_t getMaxChunkSize();
+
+    /// Sets the access hint given to the operating system for files with the given extension (eg. "frq").  Files
+    /// without a hint use {@link #ACCESS_NORMAL}.
+    void setAccessHint(const String& extension, AccessHint hint);
+
+    /// Returns the access hint used for the given file name.
+    AccessHint getAccessHint(const String& name);
+
     /// Creates an IndexInput for the file with the given name.
     virtual IndexInputPtr openInput(const String& name, int32_t bufferSize);
 
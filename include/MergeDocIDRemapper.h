@@ -13,7 +13,8 @@ namespace Lucene {
 
 /// Remaps docIDs after a merge has completed, where the merged segments had at least one deletion.
 /// This is used to renumber the buffered deletes in IndexWriter when a merge of segments with deletions
-/// commits.
+/// commits.  The merged segments need not be adjacent: the merged segment takes the place of the first
+/// of them, and any segments in between move up behind it.
 class MergeDocIDRemapper : public LuceneObject {
 public:
     MergeDocIDRemapper(const SegmentInfosPtr& infos, Collection< Collection<int32_t> > docMaps, Collection<int32_t> delCounts, const OneMergePtr& merge, int32_t mergedDocCount);
@@ -22,9 +23,9 @@ public:
     LUCENE_CLASS(MergeDocIDRemapper);
 
 public:
-    Collection<int32_t> starts; // used for binary search of mapped docID
-    Collection<int32_t> newStarts; // starts, minus the deletes
-    Collection< Collection<int32_t> > docMaps; // maps docIDs in the merged set
+    Collection<int32_t> starts; // used for binary search of mapped docID, one per segment from the first to the last merged segment
+    Collection<int32_t> newStarts; // where each of those segments starts after the merge
+    Collection< Collection<int32_t> > docMaps; // maps docIDs of each merged segment into the merged set
     int32_t minDocID; // minimum docID that needs renumbering
     int32_t maxDocID; // 1+ the max docID that needs renumbering
     int32_t docShift; // total # deleted docs that were compacted by this merge
@@ -90,6 +90,10 @@ public:
     int32_t maxNumSegmentsOptimize; // used by IndexWriter
     Collection<SegmentReaderPtr> readers; // used by IndexWriter
     Collection<SegmentReaderPtr> readersClone; // used by IndexWriter
+    int64_t estimatedMergeBytes; // used by ConcurrentMergeScheduler
+    RateLimiterPtr rateLimiter; // used by ConcurrentMergeScheduler
+    int64_t mergeStartTime; // used by ConcurrentMergeScheduler
+    int64_t mergeEndTime; // used by ConcurrentMergeScheduler
 
     SegmentInfosPtr segments;
     bool useCompoundFile;
@@ -111,6 +115,19 @@ public:
 
     void checkAborted(const DirectoryPtr& dir);
 
+    /// Returns the number of bytes this merge has written, as counted by its rate limiter.  Only
+    /// merges run by {@link ConcurrentMergeScheduler} are counted; other merges report 0.
+    int64_t getTotalBytesWritten();
+
+    /// Returns the time this merge spent paused to stay under its IO rate limit, in milliseconds.
+    int64_t getTotalThrottledMillis();
+
+    /// Returns how long this merge ran, or has been running so far, in milliseconds.
+    int64_t getElapsedMillis();
+
+    /// Returns the average rate at which this merge wrote, in MB per second.
+    double getMBPerSec();
+
     String segString(const DirectoryPtr& dir);
 };
 
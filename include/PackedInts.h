@@ -0,0 +1,85 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef PACKEDINTS_H
+#define PACKEDINTS_H
+
+#include "LuceneObject.h"
+
+namespace Lucene {
+
+/// Stores a fixed number of integers in RAM, each using the same number of bits.
+///
+/// Values are stored as their difference to a minimum value, so a range of values [minValue, minValue +
+/// 2^bitsPerValue) can be stored.  Values are packed contiguously in 64 bit blocks, and a value may span
+/// two blocks.  All values are initially minValue.
+class LPPAPI PackedInts : public LuceneObject {
+public:
+    /// @param valueCount The number of values.
+    /// @param bitsPerValue The number of bits used by each value, between 0 and 64.
+    /// @param minValue The smallest value that can be stored.
+    PackedInts(int32_t valueCount, int32_t bitsPerValue, int64_t minValue = 0);
+
+    virtual ~PackedInts();
+
+    LUCENE_CLASS(PackedInts);
+
+protected:
+    LongArray blocks;
+    int32_t valueCount;
+    int32_t bitsPerValue;
+    uint64_t mask;
+    int64_t minValue;
+
+public:
+    /// Returns the number of bits needed to store values between 0 and maxValue.
+    static int32_t bitsRequired(uint64_t maxValue);
+
+    /// Creates a PackedInts using as few bits as possible to store any value between minValue and maxValue.
+    static PackedIntsPtr forRange(int32_t valueCount, int64_t minValue, int64_t maxValue);
+
+    /// Returns the value at the given index.
+    inline int64_t get(int32_t index) const {
+        if (bitsPerValue == 0) {
+            return minValue;
+        }
+        uint64_t bitPos = (uint64_t)index * (uint64_t)bitsPerValue;
+        int32_t block = (int32_t)(bitPos >> 6);
+        int32_t shift = (int32_t)(bitPos & 63);
+        const int64_t* data = blocks.get();
+        uint64_t value = (uint64_t)data[block] >> shift;
+        if (shift + bitsPerValue > 64) {
+            value |= (uint64_t)data[block + 1] << (64 - shift);
+        }
+        return minValue + (int64_t)(value & mask);
+    }
+
+    /// Sets the value at the given index.  The value must be between the minimum value and the minimum
+    /// value plus 2^bitsPerValue - 1.
+    void set(int32_t index, int64_t value);
+
+    /// Returns the number of values.
+    int32_t size();
+
+    int32_t getBitsPerValue();
+    int64_t getMinValue();
+
+    /// Returns the number of bytes of memory used by the values.
+    int64_t ramBytesUsed();
+
+    /// Writes the values to the given output.
+    void write(const IndexOutputPtr& output);
+
+    /// Reads values written by {@link #write}.
+    static PackedIntsPtr read(const IndexInputPtr& input);
+
+    /// Skips over values written by {@link #write}.
+    static void skip(const IndexInputPtr& input);
+};
+
+}
+
+#endif
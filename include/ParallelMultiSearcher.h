@@ -19,10 +19,16 @@ class LPPAPI ParallelMultiSearcher : public MultiSearcher {
 public:
     /// Creates a {@link Searchable} which searches searchables.
     ParallelMultiSearcher(Collection<SearchablePtr> searchables);
+
+    /// Creates a {@link Searchable} which searches searchables using the threads of the given pool.
+    ParallelMultiSearcher(Collection<SearchablePtr> searchables, const ThreadPoolPtr& threadPool);
     virtual ~ParallelMultiSearcher();
 
     LUCENE_CLASS(ParallelMultiSearcher);
 
+protected:
+    ThreadPoolPtr threadPool;
+
 public:
     /// Executes each {@link Searchable}'s docFreq() in its own thread and waits for each search to
     /// complete and merge the results back together.
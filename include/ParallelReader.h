@@ -107,6 +107,12 @@ public:
     /// Reads the byte-encoded normalization factor for the named field of every document.
     virtual void norms(const String& field, ByteArray norms, int32_t offset);
 
+    /// Returns the numeric per-document values of the named field, or null if the field has none.
+    virtual PackedIntsPtr getNumericDocValues(const String& field);
+
+    /// Returns the sorted per-document values of the named field, or null if the field has none.
+    virtual StringIndexPtr getSortedDocValues(const String& field);
+
     /// Returns an enumeration of all the terms in the index. The enumeration is ordered by
     /// Term::compareTo(). Each term is greater than all that precede it in the enumeration.
     /// Note that after calling terms(), {@link TermEnum#next()} must be called on the resulting
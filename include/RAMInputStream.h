@@ -50,6 +50,12 @@ public:
     /// @see IndexOutput#writeBytes(const uint8_t*,int)
     virtual void readBytes(uint8_t* b, int32_t offset, int32_t length);
 
+    /// Returns the unread part of the current buffer.
+    virtual const uint8_t* bufferedBytes(int32_t& available);
+
+    /// Advances the current position within the current buffer.
+    virtual void skipBufferedBytes(int32_t count);
+
     /// Returns the current position in this file, where the next read will occur.
     /// @see #seek(int64_t)
     virtual int64_t getFilePointer();
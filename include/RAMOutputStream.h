@@ -36,6 +36,10 @@ public:
     /// Copy the current contents of this buffer to the named output.
     void writeTo(const IndexOutputPtr& out);
 
+    /// Copy the current contents of this buffer to the given array, starting at offset.  The array must have
+    /// room for {@link #length()} bytes.
+    void writeTo(uint8_t* bytes, int32_t offset);
+
     /// Resets this to an empty file.
     void reset();
 
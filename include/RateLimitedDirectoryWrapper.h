@@ -0,0 +1,54 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef RATELIMITEDDIRECTORYWRAPPER_H
+#define RATELIMITEDDIRECTORYWRAPPER_H
+
+#include "Directory.h"
+
+namespace Lucene {
+
+/// A Directory that forwards all operations to another Directory, wrapping the outputs it creates
+/// in {@link RateLimitedIndexOutput}s that share one {@link RateLimiter}.  Reads are not limited.
+///
+/// Closing the wrapper does not close the wrapped directory.
+class LPPAPI RateLimitedDirectoryWrapper : public Directory {
+public:
+    RateLimitedDirectoryWrapper(const DirectoryPtr& dir, const RateLimiterPtr& rateLimiter);
+    virtual ~RateLimitedDirectoryWrapper();
+
+    LUCENE_CLASS(RateLimitedDirectoryWrapper);
+
+protected:
+    DirectoryPtr dir;
+    RateLimiterPtr rateLimiter;
+
+public:
+    /// Return the wrapped directory.
+    DirectoryPtr getDelegate();
+
+    /// Return the rate limiter applied to created outputs.
+    RateLimiterPtr getRateLimiter();
+
+    virtual HashSet<String> listAll();
+    virtual bool fileExists(const String& name);
+    virtual uint64_t fileModified(const String& name);
+    virtual void touchFile(const String& name);
+    virtual void deleteFile(const String& name);
+    virtual int64_t fileLength(const String& name);
+    virtual IndexOutputPtr createOutput(const String& name);
+    virtual IndexInputPtr openInput(const String& name);
+    virtual IndexInputPtr openInput(const String& name, int32_t bufferSize);
+    virtual void close();
+    virtual void sync(const String& name);
+    virtual LockPtr makeLock(const String& name);
+    virtual String getLockID();
+    virtual String toString();
+};
+
+}
+
+#endif
@@ -0,0 +1,67 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef RATELIMITER_H
+#define RATELIMITER_H
+
+#include "LuceneObject.h"
+
+namespace Lucene {
+
+/// Limits the rate at which bytes are written, by pausing the writing thread whenever it gets ahead of
+/// the target rate.  Writers call {@link #pause} every {@link #getMinPauseCheckBytes} bytes or so.  The
+/// rate may be changed at any time from another thread; it takes effect with the next call to pause.
+///
+/// The limiter also keeps track of how many bytes went through it and how long it paused, which is
+/// how {@link ConcurrentMergeScheduler} reports per-merge throughput.
+class LPPAPI RateLimiter : public LuceneObject {
+public:
+    /// @param mbPerSec the target rate in MB per second, or infinity for no limit.
+    RateLimiter(double mbPerSec);
+    virtual ~RateLimiter();
+
+    LUCENE_CLASS(RateLimiter);
+
+public:
+    /// How often, in milliseconds of writing at the target rate, writers should check for a pause.
+    static const int32_t MIN_PAUSE_CHECK_MSEC;
+
+protected:
+    double mbPerSec;
+    double bytesPerMilli;
+    int64_t minPauseCheckBytes;
+
+    /// Time (in fractional milliseconds) by which the bytes paid for so far may have been written.
+    double lastTime;
+
+    int64_t totalBytes;
+    int64_t totalPausedMillis;
+
+public:
+    /// Sets the target rate in MB per second; infinity disables the limit.
+    void setMbPerSec(double mbPerSec);
+
+    /// Returns the target rate in MB per second.
+    double getMbPerSec();
+
+    /// Returns the number of bytes writers may write between calls to {@link #pause}.
+    int64_t getMinPauseCheckBytes();
+
+    /// Pauses, if necessary, to keep the average rate since the last pause at or below the target rate.
+    /// @param bytes the number of bytes written since the last call.
+    /// @return the time paused, in milliseconds.
+    int64_t pause(int64_t bytes);
+
+    /// Returns the total number of bytes passed to {@link #pause}.
+    int64_t getTotalBytes();
+
+    /// Returns the total time spent paused, in milliseconds.
+    int64_t getTotalPausedMillis();
+};
+
+}
+
+#endif
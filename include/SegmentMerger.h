@@ -29,6 +29,7 @@ protected:
     DirectoryPtr directory;
     String segment;
     int32_t termIndexInterval;
+    int32_t storedFieldsCompression;
 
     Collection<IndexReaderPtr> readers;
     FieldInfosPtr fieldInfos;
@@ -54,6 +55,9 @@ protected:
     Collection< Collection<int32_t> > docMaps;
     Collection<int32_t> delCounts;
 
+    /// Whether any of the merged fields has per-document values
+    bool hasDocValues;
+
 public:
     /// norms header placeholder
     static const uint8_t NORMS_HEADER[];
@@ -99,6 +103,10 @@ protected:
     int32_t copyFieldsWithDeletions(const FieldsWriterPtr& fieldsWriter, const IndexReaderPtr& reader, const FieldsReaderPtr& matchingFieldsReader);
     int32_t copyFieldsNoDeletions(const FieldsWriterPtr& fieldsWriter, const IndexReaderPtr& reader, const FieldsReaderPtr& matchingFieldsReader);
 
+    /// Copies stored fields written in compressed blocks.  Blocks whose documents are all live are copied
+    /// without being decompressed; the live documents of other blocks are copied one by one.
+    int32_t copyFieldBlocks(const FieldsWriterPtr& fieldsWriter, const IndexReaderPtr& reader, const FieldsReaderPtr& matchingFieldsReader);
+
     /// Merge the TermVectors from each of the segments into the new one.
     void mergeVectors();
 
@@ -117,6 +125,10 @@ protected:
     int32_t appendPostings(const FormatPostingsTermsConsumerPtr& termsConsumer, Collection<SegmentMergeInfoPtr> smis, int32_t n);
 
     void mergeNorms();
+
+    /// Merge the per-document values of each field into a single _X.dv file.  Sorted values are given
+    /// new ordinals in the union of the values of the live documents.
+    void mergeDocValues();
 };
 
 class CheckAbort : public LuceneObject {
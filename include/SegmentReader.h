@@ -122,6 +122,12 @@ public:
     /// Read norms into a pre-allocated array.
     virtual void norms(const String& field, ByteArray norms, int32_t offset);
 
+    /// Returns the numeric per-document values of the named field, or null if the field has none.
+    virtual PackedIntsPtr getNumericDocValues(const String& field);
+
+    /// Returns the sorted per-document values of the named field, or null if the field has none.
+    virtual StringIndexPtr getSortedDocValues(const String& field);
+
     bool termsIndexLoaded();
 
     /// NOTE: only called from IndexWriter when a near real-time reader is opened, or applyDeletes is run, sharing a
@@ -174,6 +180,9 @@ public:
 
     virtual int32_t getTermInfosIndexDivisor();
 
+    /// Returns the number of bytes of memory used by the terms index of this segment, or 0 if it is not loaded.
+    int64_t getTermInfosIndexBytesUsed();
+
 protected:
     bool checkDeletedCounts();
     void loadDeletedDocs();
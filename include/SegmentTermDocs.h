@@ -40,6 +40,9 @@ protected:
     bool currentFieldStoresPayloads;
     bool currentFieldOmitTermFreqAndPositions;
 
+    static const int32_t MAX_VINT_BYTES;
+    static const int32_t MAX_PAIR_BYTES;
+
 public:
     /// Sets this to the data for a term.
     virtual void seek(const TermPtr& term);
@@ -60,7 +63,8 @@ public:
     /// Moves to the next pair in the enumeration.
     virtual bool next();
 
-    /// Optimized implementation.
+    /// Optimized implementation.  Whole blocks of postings are decoded in place from the buffer of the
+    /// freq stream when it supports {@link IndexInput#bufferedBytes(int32_t&)}.
     virtual int32_t read(Collection<int32_t> docs, Collection<int32_t> freqs);
 
     /// Optimized implementation.
@@ -74,6 +78,13 @@ protected:
     virtual void skippingDoc();
     virtual int32_t readNoTf(Collection<int32_t> docs, Collection<int32_t> freqs, int32_t length);
 
+    /// Turns the doc deltas decoded into docs[start, end) into doc numbers and removes deleted documents.
+    /// Returns the new end of the block.
+    int32_t accumulateDocs(int32_t* docs, int32_t* freqs, int32_t start, int32_t end);
+
+    /// Decodes a VInt from bytes, advancing position past it.
+    static int32_t decodeVInt(const uint8_t* bytes, int32_t& position);
+
     /// Overridden by SegmentTermPositions to skip in prox stream.
     virtual void skipProx(int64_t proxPointer, int32_t payloadLength);
 };
@@ -30,6 +30,10 @@ public:
     int32_t numDocsInStore;
     HashSet<String> flushedFiles;
 
+    /// Snapshot of the field infos taken when the flush was started, so the segment can be written while
+    /// other threads keep adding fields to the shared field infos
+    FieldInfosPtr fieldInfos;
+
 public:
     String segmentFileName(const String& ext);
 };
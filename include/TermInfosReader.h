@@ -29,9 +29,7 @@ protected:
     SegmentTermEnumPtr origEnum;
     int64_t _size;
 
-    Collection<TermPtr> indexTerms;
-    Collection<TermInfoPtr> indexInfos;
-    Collection<int64_t> indexPointers;
+    TermInfosReaderIndexPtr index;
 
     int32_t totalIndexInterval;
 
@@ -45,6 +43,9 @@ public:
     /// Returns the number of term/value pairs in the set.
     int64_t size();
 
+    /// Returns the number of bytes of memory used by the terms index, or 0 if it is not loaded.
+    int64_t ramBytesUsed();
+
     /// Returns the TermInfo for a Term in the set, or null.
     TermInfoPtr get(const TermPtr& term);
 
@@ -0,0 +1,72 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef TERMINFOSREADERINDEX_H
+#define TERMINFOSREADERINDEX_H
+
+#include "LuceneObject.h"
+
+namespace Lucene {
+
+/// The in-memory terms index of a {@link TermInfosReader}.
+///
+/// Instead of one Term and one TermInfo object per index entry, the index terms are stored UTF-8 encoded in a
+/// single byte arena addressed through an offset array, their fields in a table of field runs (index terms are
+/// sorted by field, so each field occupies one contiguous run of entries), and the TermInfo values and .tis
+/// pointers in parallel primitive arrays.
+class TermInfosReaderIndex : public LuceneObject {
+public:
+    /// Loads every indexDivisor'th entry of the given terms index enumeration.
+    TermInfosReaderIndex(const SegmentTermEnumPtr& indexEnum, int32_t indexDivisor);
+    virtual ~TermInfosReaderIndex();
+
+    LUCENE_CLASS(TermInfosReaderIndex);
+
+protected:
+    int32_t indexSize;
+
+    ByteArray termBytes; // UTF-8 text of all index terms
+    IntArray termOffsets; // start of each term in termBytes, followed by the end of the last term
+
+    Collection<String> fields; // field of each run of entries
+    Collection<int32_t> fieldStarts; // first entry of each field run, followed by indexSize
+
+    IntArray docFreqs;
+    LongArray freqPointers;
+    LongArray proxPointers;
+    IntArray skipOffsets;
+    LongArray indexPointers;
+
+public:
+    /// Returns the number of index entries.
+    int32_t size();
+
+    /// Returns the offset of the greatest index entry which is less than or equal to term, or -1 if there is none.
+    int32_t getIndexOffset(const TermPtr& term);
+
+    /// Compares term with the index entry at indexOffset, using the ordering of {@link Term#compareTo}.
+    int32_t compareTo(const TermPtr& term, int32_t indexOffset);
+
+    /// Returns the term of the index entry at indexOffset, or null for the unset term of the first entry.
+    TermPtr getTerm(int32_t indexOffset);
+
+    /// Positions enumerator at the index entry at indexOffset, which is the given position in the term dictionary.
+    void seekEnum(const SegmentTermEnumPtr& enumerator, int32_t indexOffset, int64_t position);
+
+    /// Returns the number of bytes of memory used by this index.
+    int64_t ramBytesUsed();
+
+protected:
+    /// Returns the field run containing the entry at indexOffset.
+    int32_t getFieldRun(int32_t indexOffset);
+
+    /// Compares text with the text of the entry at indexOffset, using the ordering of String::compare.
+    int32_t compareText(const String& text, int32_t indexOffset);
+};
+
+}
+
+#endif
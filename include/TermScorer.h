@@ -37,6 +37,9 @@ protected:
     int32_t pointer;
     int32_t pointerMax;
 
+    /// Number of postings decoded per {@link TermDocs#read} call.
+    static const int32_t BUFFER_SIZE;
+
     static const int32_t SCORE_CACHE_SIZE;
     Collection<double> scoreCache;
 
@@ -7,73 +7,118 @@
 #ifndef THREADPOOL_H
 #define THREADPOOL_H
 
-#include <boost/asio.hpp>
 #include <boost/any.hpp>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
 #include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include "LuceneObject.h"
+#include "StringUtils.h"
 
 namespace Lucene {
 
-typedef boost::shared_ptr<boost::asio::io_service::work> workPtr;
-
 /// A Future represents the result of an asynchronous computation. Methods are provided to check if the computation
 /// is complete, to wait for its completion, and to retrieve the result of the computation. The result can only be
 /// retrieved using method get when the computation has completed, blocking if necessary until it is ready.
-class Future : public LuceneObject {
+///
+/// If the computation threw an exception then it is rethrown by get.
+class LPPAPI Future : public LuceneObject {
 public:
+    Future();
     virtual ~Future();
 
+    LUCENE_CLASS(Future);
+
 protected:
+    boost::mutex futureMutex;
+    boost::condition_variable futureCondition;
     boost::any value;
+    LuceneException exception;
+    bool done;
 
 public:
-    void set(const boost::any& value) {
-        SyncLock syncLock(this);
-        this->value = value;
-    }
+    /// Set the result of the computation and wake up all waiting threads.
+    void set(const boost::any& value);
+
+    /// Set the exception thrown by the computation and wake up all waiting threads.
+    void setException(const LuceneException& exception);
+
+    /// Returns true if the computation has completed, either normally or with an exception.
+    bool isDone();
 
     template <typename TYPE>
     TYPE get() {
-        SyncLock syncLock(this);
-        while (value.empty()) {
-            wait(10);
+        waitDone();
+        if (!exception.isNull()) {
+            exception.throwException();
         }
         return value.empty() ? TYPE() : boost::any_cast<TYPE>(value);
     }
+
+protected:
+    /// Block until the computation has completed.  When called from one of the threads of a {@link ThreadPool},
+    /// pending tasks are executed while waiting, so that tasks may safely wait for other tasks on the same pool.
+    void waitDone();
 };
 
+/// Pending tasks of a {@link ThreadPool}, shared with the pool threads so that a pool may be released from
+/// within one of its own tasks.
+class ThreadPoolQueues;
+
 /// Utility class to handle a pool of threads.
-class ThreadPool : public LuceneObject {
+///
+/// Each thread owns a queue of tasks.  Tasks scheduled from outside the pool are distributed over the queues
+/// in turn, tasks scheduled from one of the pool threads go to that thread's queue.  Idle threads steal the
+/// oldest tasks from the other queues.
+class LPPAPI ThreadPool : public LuceneObject {
 public:
-    ThreadPool();
+    /// Create a thread pool with the given number of threads.  If threadCount is 0 then the number of
+    /// hardware threads is used.
+    ThreadPool(int32_t threadCount = 0);
     virtual ~ThreadPool();
 
     LUCENE_CLASS(ThreadPool);
 
+public:
+    typedef boost::function<void()> Task;
+
 protected:
-    boost::asio::io_service io_service;
-    workPtr work;
-    boost::thread_group threadGroup;
+    boost::shared_ptr<ThreadPoolQueues> queues;
+    Collection<threadPtr> threads;
 
+    /// Default number of threads if the number of hardware threads is not known.
     static const int32_t THREADPOOL_SIZE;
 
 public:
     /// Get singleton thread pool instance.
     static ThreadPoolPtr getInstance();
 
+    /// Return the number of threads in this pool.
+    int32_t getThreadCount();
+
     template <typename FUNC>
     FuturePtr scheduleTask(FUNC func) {
         FuturePtr future(newInstance<Future>());
-        io_service.post(boost::bind(&ThreadPool::execute<FUNC>, this, func, future));
+        schedule(boost::bind(&ThreadPool::execute<FUNC>, func, future));
         return future;
     }
 
 protected:
+    void schedule(const Task& task);
+
     // this will be executed when one of the threads is available
     template <typename FUNC>
-    void execute(FUNC func, const FuturePtr& future) {
-        future->set(func());
-        future->notifyAll();
+    static void execute(FUNC func, const FuturePtr& future) {
+        try {
+            future->set(func());
+        } catch (LuceneException& e) {
+            future->setException(e);
+        } catch (std::exception& e) {
+            future->setException(RuntimeException(StringUtils::toUnicode(e.what())));
+        } catch (...) {
+            future->setException(RuntimeException(L"Unknown exception in thread pool task"));
+        }
     }
 };
 
@@ -0,0 +1,207 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef TIEREDMERGEPOLICY_H
+#define TIEREDMERGEPOLICY_H
+
+#include "MergePolicy.h"
+
+namespace Lucene {
+
+/// Merges segments of approximately equal size, subject to an allowed number of segments per tier.  This
+/// is similar to {@link LogByteSizeMergePolicy}, except this merge policy is able to merge non-adjacent
+/// segments, and separates how many segments are merged at once ({@link #setMaxMergeAtOnce}) from how many
+/// segments are allowed per tier ({@link #setSegmentsPerTier}).  This merge policy also does not over-merge
+/// (ie, cascade merges).
+///
+/// For normal merging, this policy first computes a "budget" of how many segments are allowed to be in the
+/// index.  If the index is over-budget, then the policy sorts segments by decreasing size (pro-rating by
+/// percent deletes), and then finds the least-cost merge.  Merge cost is measured by a combination of the
+/// "skew" of the merge (size of largest segment divided by smallest segment), total merge size and percent
+/// deletes reclaimed, so that merges with lower skew, smaller size and those reclaiming more deletes are
+/// favored.
+///
+/// If a merge will produce a segment that's larger than {@link #setMaxMergedSegmentMB}, then the policy will
+/// merge fewer segments (down to 1 at once, if that one has deletions) to keep the segment size under budget.
+///
+/// NOTE: this policy freely merges non-adjacent segments; if your application relies on the relative order
+/// of documents in different segments, use {@link LogMergePolicy} instead.
+///
+/// NOTE: This API is new and still experimental (subject to change suddenly in the next release)
+class LPPAPI TieredMergePolicy : public MergePolicy {
+public:
+    TieredMergePolicy(const IndexWriterPtr& writer);
+    virtual ~TieredMergePolicy();
+
+    LUCENE_CLASS(TieredMergePolicy);
+
+public:
+    /// Default maximum number of segments merged at once during normal merging.
+    static const int32_t DEFAULT_MAX_MERGE_AT_ONCE;
+
+    /// Default maximum number of segments merged at once by optimize or expungeDeletes.
+    static const int32_t DEFAULT_MAX_MERGE_AT_ONCE_EXPLICIT;
+
+    /// Default maximum size of a merged segment during normal merging.
+    static const double DEFAULT_MAX_MERGED_SEGMENT_MB;
+
+    /// Default size below which segments are rounded up when choosing merges.
+    static const double DEFAULT_FLOOR_SEGMENT_MB;
+
+    /// Default number of segments allowed per tier.
+    static const double DEFAULT_SEGMENTS_PER_TIER;
+
+    /// Default percentage of deleted documents a segment may have before expungeDeletes merges it.
+    static const double DEFAULT_EXPUNGE_DELETES_PCT_ALLOWED;
+
+    /// Default weight given to reclaiming deletes when scoring merges.
+    static const double DEFAULT_RECLAIM_DELETES_WEIGHT;
+
+    /// Default noCFSRatio.  If a merge's size is >= 10% of the index, then we disable compound file for it.
+    static const double DEFAULT_NO_CFS_RATIO;
+
+protected:
+    int32_t maxMergeAtOnce;
+    int32_t maxMergeAtOnceExplicit;
+    int64_t maxMergedSegmentBytes;
+    int64_t floorSegmentBytes;
+    double segsPerTier;
+    double expungeDeletesPctAllowed;
+    double reclaimDeletesWeight;
+    double noCFSRatio;
+    bool _useCompoundFile;
+    bool _useCompoundDocStore;
+
+public:
+    /// Sets the maximum number of segments to be merged at a time during "normal" merging.  For explicit
+    /// merging (eg, optimize or expungeDeletes was called), see {@link #setMaxMergeAtOnceExplicit}.
+    /// Default is 10.
+    void setMaxMergeAtOnce(int32_t maxMergeAtOnce);
+
+    /// @see #setMaxMergeAtOnce
+    int32_t getMaxMergeAtOnce();
+
+    /// Sets the maximum number of segments to be merged at a time, during optimize or expungeDeletes.
+    /// This bounds the cost of each explicit merge; optimize down to one segment takes as many rounds
+    /// of merging as needed.  Default is 30.
+    void setMaxMergeAtOnceExplicit(int32_t maxMergeAtOnceExplicit);
+
+    /// @see #setMaxMergeAtOnceExplicit
+    int32_t getMaxMergeAtOnceExplicit();
+
+    /// Sets the maximum sized segment to produce during normal merging.  This setting is approximate: the
+    /// estimate of the merged segment size is made by summing sizes of to-be-merged segments (compensating
+    /// for percent deleted docs).  Default is 5 GB.
+    void setMaxMergedSegmentMB(double mb);
+
+    /// @see #setMaxMergedSegmentMB
+    double getMaxMergedSegmentMB();
+
+    /// Controls how aggressively merges that reclaim more deletions are favored.  Higher values favor
+    /// selecting merges that reclaim deletions.  A value of 0.0 means deletions don't impact merge
+    /// selection.  Default is 2.0.
+    void setReclaimDeletesWeight(double weight);
+
+    /// @see #setReclaimDeletesWeight
+    double getReclaimDeletesWeight();
+
+    /// Segments smaller than this are "rounded up" to this size, ie treated as equal (floor) size for merge
+    /// selection.  This is to prevent frequent flushing of tiny segments from allowing a long tail in the
+    /// index.  Default is 2 MB.
+    void setFloorSegmentMB(double mb);
+
+    /// @see #setFloorSegmentMB
+    double getFloorSegmentMB();
+
+    /// When expungeDeletes is called, we only merge away a segment if its delete percentage is over this
+    /// threshold.  Default is 10%.
+    void setExpungeDeletesPctAllowed(double pct);
+
+    /// @see #setExpungeDeletesPctAllowed
+    double getExpungeDeletesPctAllowed();
+
+    /// Sets the allowed number of segments per tier.  Smaller values mean more merging but fewer segments.
+    /// This should be >= {@link #getMaxMergeAtOnce} otherwise you'll force too much merging to occur.
+    /// Default is 10.0.
+    void setSegmentsPerTier(double segsPerTier);
+
+    /// @see #setSegmentsPerTier
+    double getSegmentsPerTier();
+
+    /// Sets whether compound file format should be used for newly flushed and newly merged segments.
+    /// Default true.
+    void setUseCompoundFile(bool useCompoundFile);
+
+    /// @see #setUseCompoundFile
+    bool getUseCompoundFile();
+
+    /// Sets whether compound file format should be used for newly flushed and newly merged doc store
+    /// segment files (term vectors and stored fields).  Default true.
+    void setUseCompoundDocStore(bool useCompoundDocStore);
+
+    /// @see #setUseCompoundDocStore
+    bool getUseCompoundDocStore();
+
+    /// If a merged segment will be more than this percentage of the total size of the index, leave the
+    /// segment as non-compound file even if compound file is enabled.  Set to 1.0 to always use CFS
+    /// regardless of merge size.  Default is 0.1.
+    void setNoCFSRatio(double noCFSRatio);
+
+    /// @see #setNoCFSRatio
+    double getNoCFSRatio();
+
+    /// Finds the least-cost merges needed to bring the index back under its segment budget.
+    virtual MergeSpecificationPtr findMerges(const SegmentInfosPtr& segmentInfos);
+
+    /// Returns the merges necessary to leave at most maxSegmentCount segments, merging at most {@link
+    /// #setMaxMergeAtOnceExplicit} segments at a time and preferring the smallest segments.
+    virtual MergeSpecificationPtr findMergesForOptimize(const SegmentInfosPtr& segmentInfos, int32_t maxSegmentCount, SetSegmentInfo segmentsToOptimize);
+
+    /// Merges away segments whose percentage of deleted documents is above {@link
+    /// #setExpungeDeletesPctAllowed}, at most {@link #setMaxMergeAtOnceExplicit} segments at a time.
+    virtual MergeSpecificationPtr findMergesToExpungeDeletes(const SegmentInfosPtr& segmentInfos);
+
+    /// Returns true if a newly flushed (not from merge) segment should use the compound file format.
+    virtual bool useCompoundFile(const SegmentInfosPtr& segments, const SegmentInfoPtr& newSegment);
+
+    /// Returns true if the doc store files should use the compound file format.
+    virtual bool useCompoundDocStore(const SegmentInfosPtr& segments);
+
+    /// Release all resources for the policy.
+    virtual void close();
+
+protected:
+    bool verbose();
+    void message(const String& message);
+
+    /// Returns the byte size of the segment, pro-rated by its percentage of deleted documents.
+    int64_t size(const SegmentInfoPtr& info);
+
+    /// Rounds sizes below the floor segment size up to it.
+    int64_t floorSize(int64_t bytes);
+
+    /// Scores a candidate merge, given in order of decreasing size; lower scores are better.
+    /// @param hitTooLarge true if segments were left out of the candidate to keep it under the
+    /// maximum merged segment size.
+    virtual double score(Collection<SegmentInfoPtr> candidate, bool hitTooLarge);
+
+    /// Returns true if this single info is optimized (has no pending norms or deletes, is in the same
+    /// dir as the writer, and matches the current compound file setting).
+    bool isOptimized(const SegmentInfoPtr& info);
+
+    /// Sorts segments by decreasing size, keeping index order between segments of equal size.
+    void sortBySizeDescending(Collection<SegmentInfoPtr> segments);
+
+    /// Creates a merge of the given segments, listed in index order so the merged segment keeps the
+    /// relative order of their documents.
+    OneMergePtr makeOneMerge(const SegmentInfosPtr& infos, Collection<SegmentInfoPtr> segments);
+
+    String segString(Collection<SegmentInfoPtr> segments);
+};
+
+}
+
+#endif
@@ -7,15 +7,18 @@
 #ifndef WILDCARDTERMENUM_H
 #define WILDCARDTERMENUM_H
 
-#include "FilteredTermEnum.h"
+#include "AutomatonTermEnum.h"
 
 namespace Lucene {
 
 /// Subclass of FilteredTermEnum for enumerating all terms that match the specified wildcard filter term.
 ///
+/// The wildcard pattern is compiled to an {@link Automaton}, so that runs of terms that cannot match are
+/// skipped by seeking through the terms index rather than compared one by one.
+///
 /// Term enumerations are always ordered by Term.compareTo().  Each term in the enumeration is greater than
 /// all that precede it.
-class LPPAPI WildcardTermEnum : public FilteredTermEnum {
+class LPPAPI WildcardTermEnum : public AutomatonTermEnum {
 public:
     /// Creates a new WildcardTermEnum.
     ///
@@ -32,21 +35,13 @@ public:
     static const wchar_t WILDCARD_CHAR;
 
     TermPtr searchTerm;
-    String field;
-    String text;
-    String pre;
-    int32_t preLen;
-    bool _endEnum;
 
 public:
-    virtual double difference();
+    /// Builds the deterministic automaton accepting the strings matched by a wildcard pattern.
+    static AutomatonPtr toAutomaton(const String& pattern);
 
     /// Determines if a word matches a wildcard pattern.
     static bool wildcardEquals(const String& pattern, int32_t patternIdx, const String& string, int32_t stringIdx);
-
-protected:
-    virtual bool termCompare(const TermPtr& term);
-    virtual bool endEnum();
 };
 
 }
@@ -25,6 +25,7 @@ AbstractField::AbstractField() {
 
     this->lazy = false;
     this->omitTermFreqAndPositions = false;
+    this->docValuesType = DOC_VALUES_NO;
     this->boost = 1.0;
     this->fieldsData = VariantUtils::null();
 
@@ -42,6 +43,7 @@ AbstractField::AbstractField(const String& name, Field::Store store, Field::Inde
 
     this->lazy = false;
     this->omitTermFreqAndPositions = false;
+    this->docValuesType = DOC_VALUES_NO;
     this->boost = 1.0;
     this->fieldsData = VariantUtils::null();
 
@@ -136,6 +138,14 @@ void AbstractField::setOmitTermFreqAndPositions(bool omitTermFreqAndPositions) {
     this->omitTermFreqAndPositions = omitTermFreqAndPositions;
 }
 
+int32_t AbstractField::getDocValuesType() {
+    return docValuesType;
+}
+
+void AbstractField::setDocValuesType(int32_t docValuesType) {
+    this->docValuesType = docValuesType;
+}
+
 bool AbstractField::isLazy() {
     return lazy;
 }
@@ -187,6 +197,11 @@ String AbstractField::toString() {
     if (omitTermFreqAndPositions) {
         result << L",omitTermFreqAndPositions";
     }
+    if (docValuesType == DOC_VALUES_NUMERIC) {
+        result << L",numericDocValues";
+    } else if (docValuesType == DOC_VALUES_SORTED) {
+        result << L",sortedDocValues";
+    }
     if (lazy) {
         result << L",lazy";
     }
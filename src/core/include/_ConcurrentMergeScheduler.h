@@ -23,12 +23,23 @@ protected:
     IndexWriterWeakPtr _writer;
     OneMergePtr startMerge;
     OneMergePtr runningMerge;
+    FuturePtr pooledRun;
 
 public:
     void setRunningMerge(const OneMergePtr& merge);
     OneMergePtr getRunningMerge();
     void setThreadPriority(int32_t pri);
     virtual void run();
+
+    using LuceneThread::start;
+
+    /// Run this merge as a task of the given thread pool instead of starting a new thread.
+    void start(const ThreadPoolPtr& threadPool);
+
+    virtual bool isAlive();
+
+protected:
+    bool runPooled();
 };
 
 }
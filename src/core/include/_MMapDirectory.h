@@ -14,16 +14,25 @@ namespace Lucene {
 
 class MMapIndexInput : public IndexInput {
 public:
-    MMapIndexInput(const String& path = L"");
+    /// Map the file at the given path in chunks of 2^chunkSizePower bytes.
+    /// @param accessHint one of the {@link MMapDirectory#AccessHint} values.
+    MMapIndexInput(const String& path = L"", int32_t chunkSizePower = 0, int32_t accessHint = 0);
     virtual ~MMapIndexInput();
 
     LUCENE_CLASS(MMapIndexInput);
 
 protected:
-    int32_t _length;
+    typedef boost::iostreams::mapped_file_source MappedChunk;
+
+    int64_t _length;
     bool isClone;
-    boost::iostreams::mapped_file_source file;
-    int32_t bufferPosition; // next byte to read
+    int32_t chunkSizePower;
+    Collection<MappedChunk> chunks; // shared with clones, null once closed
+
+    int32_t chunkIndex; // chunk holding the current position
+    const uint8_t* chunk;
+    int32_t chunkLength;
+    int32_t chunkPosition; // next byte to read in the current chunk
 
 public:
     /// Reads and returns a single byte.
@@ -37,6 +46,12 @@ public:
     /// @see IndexOutput#writeBytes(const uint8_t*,int)
     virtual void readBytes(uint8_t* b, int32_t offset, int32_t length);
 
+    /// Returns the mapped bytes from the current position to the end of the current chunk, without copying.
+    virtual const uint8_t* bufferedBytes(int32_t& available);
+
+    /// Advances the current position within the current chunk.
+    virtual void skipBufferedBytes(int32_t count);
+
     /// Returns the current position in this file, where the next read will occur.
     /// @see #seek(int64_t)
     virtual int64_t getFilePointer();
@@ -53,6 +68,10 @@ public:
 
     /// Returns a clone of this stream.
     virtual LuceneObjectPtr clone(const LuceneObjectPtr& other = LuceneObjectPtr());
+
+protected:
+    void setChunk(int32_t index);
+    void nextChunk();
 };
 
 }
@@ -13,20 +13,19 @@ namespace Lucene {
 
 class LPPAPI OrdDocValues : public DocValues {
 public:
-    OrdDocValues(const OrdFieldSourcePtr& source, Collection<int32_t> arr);
+    OrdDocValues(const OrdFieldSourcePtr& source, const StringIndexPtr& sindex);
     virtual ~OrdDocValues();
 
     LUCENE_CLASS(OrdDocValues);
 
 protected:
     OrdFieldSourceWeakPtr _source;
-    Collection<int32_t> arr;
+    StringIndexPtr sindex;
 
 public:
     virtual double doubleVal(int32_t doc);
     virtual String strVal(int32_t doc);
     virtual String toString(int32_t doc);
-    virtual CollectionValue getInnerArray();
 };
 
 }
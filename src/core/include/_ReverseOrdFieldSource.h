@@ -13,14 +13,14 @@ namespace Lucene {
 
 class ReverseOrdDocValues : public DocValues {
 public:
-    ReverseOrdDocValues(const ReverseOrdFieldSourcePtr& source, Collection<int32_t> arr, int32_t end);
+    ReverseOrdDocValues(const ReverseOrdFieldSourcePtr& source, const StringIndexPtr& sindex, int32_t end);
     virtual ~ReverseOrdDocValues();
 
     LUCENE_CLASS(ReverseOrdDocValues);
 
 protected:
     ReverseOrdFieldSourceWeakPtr _source;
-    Collection<int32_t> arr;
+    StringIndexPtr sindex;
     int32_t end;
 
 public:
@@ -28,7 +28,6 @@ public:
     virtual int32_t intVal(int32_t doc);
     virtual String strVal(int32_t doc);
     virtual String toString(int32_t doc);
-    virtual CollectionValue getInnerArray();
 };
 
 }
@@ -33,6 +33,7 @@ public:
     IndexInputPtr freqStream;
     IndexInputPtr proxStream;
     TermInfosReaderPtr tisNoIndex;
+    DocValuesReaderPtr docValuesReader;
 
     DirectoryPtr dir;
     DirectoryPtr cfsDir;
@@ -5,23 +5,40 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include "LuceneInc.h"
+#include <boost/bind.hpp>
+#include <boost/bind/protect.hpp>
 #include "ConcurrentMergeScheduler.h"
 #include "_ConcurrentMergeScheduler.h"
 #include "IndexWriter.h"
 #include "TestPoint.h"
 #include "StringUtils.h"
+#include "ThreadPool.h"
+#include "RateLimiter.h"
+#include "SegmentInfos.h"
+#include "SegmentInfo.h"
+#include "MiscUtils.h"
 
 namespace Lucene {
 
 Collection<ConcurrentMergeSchedulerPtr> ConcurrentMergeScheduler::allInstances;
 bool ConcurrentMergeScheduler::anyExceptions = false;
 
+const double ConcurrentMergeScheduler::START_MB_PER_SEC = 20.0;
+const double ConcurrentMergeScheduler::MIN_MERGE_MB_PER_SEC = 5.0;
+const double ConcurrentMergeScheduler::MAX_MERGE_MB_PER_SEC = 10240.0;
+const double ConcurrentMergeScheduler::MIN_BIG_MERGE_MB = 50.0;
+const double ConcurrentMergeScheduler::SEARCH_BACKOFF_RATIO = 0.5;
+
 ConcurrentMergeScheduler::ConcurrentMergeScheduler() {
     mergeThreadPriority = -1;
     mergeThreads = SetMergeThread::newInstance();
     maxThreadCount = 1;
     suppressExceptions = false;
     closed = false;
+    targetMBPerSec = std::numeric_limits<double>::infinity();
+    forceMergeMBPerSec = std::numeric_limits<double>::infinity();
+    doAutoIOThrottle = false;
+    activeSearches = 0;
 }
 
 ConcurrentMergeScheduler::~ConcurrentMergeScheduler() {
@@ -64,6 +81,182 @@ void ConcurrentMergeScheduler::setMergeThreadPriority(int32_t pri) {
     }
 }
 
+void ConcurrentMergeScheduler::setThreadPool(const ThreadPoolPtr& threadPool) {
+    SyncLock syncLock(this);
+    this->threadPool = threadPool;
+}
+
+ThreadPoolPtr ConcurrentMergeScheduler::getThreadPool() {
+    SyncLock syncLock(this);
+    return threadPool;
+}
+
+void ConcurrentMergeScheduler::setIORateLimitMBPerSec(double mbPerSec) {
+    if (mbPerSec <= 0.0) {
+        boost::throw_exception(IllegalArgumentException(L"mbPerSec must be positive"));
+    }
+    SyncLock syncLock(this);
+    targetMBPerSec = mbPerSec;
+    updateMergeThreads();
+}
+
+double ConcurrentMergeScheduler::getIORateLimitMBPerSec() {
+    SyncLock syncLock(this);
+    return targetMBPerSec;
+}
+
+void ConcurrentMergeScheduler::enableAutoIOThrottle() {
+    SyncLock syncLock(this);
+    doAutoIOThrottle = true;
+    targetMBPerSec = START_MB_PER_SEC;
+    updateMergeThreads();
+}
+
+void ConcurrentMergeScheduler::disableAutoIOThrottle() {
+    SyncLock syncLock(this);
+    doAutoIOThrottle = false;
+    targetMBPerSec = std::numeric_limits<double>::infinity();
+    updateMergeThreads();
+}
+
+bool ConcurrentMergeScheduler::getAutoIOThrottle() {
+    SyncLock syncLock(this);
+    return doAutoIOThrottle;
+}
+
+void ConcurrentMergeScheduler::setForceMergeMBPerSec(double mbPerSec) {
+    if (mbPerSec <= 0.0) {
+        boost::throw_exception(IllegalArgumentException(L"mbPerSec must be positive"));
+    }
+    SyncLock syncLock(this);
+    forceMergeMBPerSec = mbPerSec;
+    updateMergeThreads();
+}
+
+double ConcurrentMergeScheduler::getForceMergeMBPerSec() {
+    SyncLock syncLock(this);
+    return forceMergeMBPerSec;
+}
+
+void ConcurrentMergeScheduler::searchStarted() {
+    SyncLock syncLock(this);
+    if (++activeSearches == 1 && doAutoIOThrottle) {
+        updateMergeThreads();
+    }
+}
+
+void ConcurrentMergeScheduler::searchFinished() {
+    SyncLock syncLock(this);
+    if (activeSearches == 0) {
+        boost::throw_exception(IllegalStateException(L"searchFinished called without a matching searchStarted"));
+    }
+    if (--activeSearches == 0 && doAutoIOThrottle) {
+        updateMergeThreads();
+    }
+}
+
+double ConcurrentMergeScheduler::getMergeMBPerSec(const OneMergePtr& merge) {
+    SyncLock syncLock(this);
+    if (merge->optimize) {
+        return forceMergeMBPerSec;
+    }
+    if (!doAutoIOThrottle) {
+        return targetMBPerSec;
+    }
+    if ((double)merge->estimatedMergeBytes / 1024.0 / 1024.0 < MIN_BIG_MERGE_MB) {
+        return std::numeric_limits<double>::infinity();
+    }
+    if (activeSearches > 0) {
+        return std::max(MIN_MERGE_MB_PER_SEC, targetMBPerSec * SEARCH_BACKOFF_RATIO);
+    }
+    return targetMBPerSec;
+}
+
+void ConcurrentMergeScheduler::estimateMergeBytes(const IndexWriterPtr& writer, const OneMergePtr& merge) {
+    int64_t totalBytes = 0;
+    try {
+        int32_t numSegments = merge->segments->size();
+        for (int32_t i = 0; i < numSegments; ++i) {
+            SegmentInfoPtr info(merge->segments->info(i));
+            int64_t byteSize = info->sizeInBytes();
+            double delRatio = info->docCount <= 0 ? 0.0 : (double)writer->numDeletedDocs(info) / (double)info->docCount;
+            totalBytes += (int64_t)((double)byteSize * (1.0 - delRatio));
+        }
+    } catch (IOException&) {
+        // the estimate only steers IO throttling; a merge we cannot size is treated as small
+        totalBytes = 0;
+    }
+    merge->estimatedMergeBytes = totalBytes;
+}
+
+void ConcurrentMergeScheduler::updateIOThrottle(const OneMergePtr& merge) {
+    SyncLock syncLock(this);
+    if (!doAutoIOThrottle) {
+        return;
+    }
+
+    // Only non-trivial merges steer the throttle
+    double mergeMB = (double)merge->estimatedMergeBytes / 1024.0 / 1024.0;
+    if (mergeMB < MIN_BIG_MERGE_MB) {
+        return;
+    }
+
+    // Simple closed-loop feedback: if this merge has to wait for a merge thread, or a merge of similar
+    // size is still running, we are falling behind and raise the limit, else we lower it
+    int64_t now = (int64_t)MiscUtils::currentTimeMillis();
+    bool newBacklog = (mergeThreadCount() >= maxThreadCount || isBacklog(now, merge));
+    bool curBacklog = false;
+    if (!newBacklog) {
+        for (SetMergeThread::iterator mergeThread = mergeThreads.begin(); mergeThread != mergeThreads.end(); ++mergeThread) {
+            OneMergePtr runningMerge((*mergeThread)->getRunningMerge());
+            if ((*mergeThread)->isAlive() && runningMerge && isBacklog(now, runningMerge)) {
+                curBacklog = true;
+                break;
+            }
+        }
+    }
+
+    double curMBPerSec = targetMBPerSec;
+    if (newBacklog) {
+        targetMBPerSec = std::min(MAX_MERGE_MB_PER_SEC, targetMBPerSec * 1.2);
+    } else if (!curBacklog) {
+        targetMBPerSec = std::max(MIN_MERGE_MB_PER_SEC, targetMBPerSec / 1.1);
+    }
+    if (targetMBPerSec != curMBPerSec) {
+        message(L"io throttle: " + String(newBacklog ? L"raise" : L"lower") + L" rate limit to " + StringUtils::toString(targetMBPerSec) + L" MB/sec");
+        updateMergeThreads();
+    }
+}
+
+bool ConcurrentMergeScheduler::isBacklog(int64_t now, const OneMergePtr& merge) {
+    SyncLock syncLock(this);
+    double mergeMB = (double)merge->estimatedMergeBytes / 1024.0 / 1024.0;
+    for (SetMergeThread::iterator mergeThread = mergeThreads.begin(); mergeThread != mergeThreads.end(); ++mergeThread) {
+        OneMergePtr otherMerge((*mergeThread)->getRunningMerge());
+        if (!otherMerge || otherMerge == merge || otherMerge->mergeStartTime == 0 || !(*mergeThread)->isAlive()) {
+            continue;
+        }
+        double otherMergeMB = (double)otherMerge->estimatedMergeBytes / 1024.0 / 1024.0;
+        if (otherMergeMB >= MIN_BIG_MERGE_MB && now - otherMerge->mergeStartTime > 3000) {
+            double ratio = otherMergeMB / mergeMB;
+            if (ratio > 0.3 && ratio < 3.0) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ConcurrentMergeScheduler::updateMergeThreads() {
+    SyncLock syncLock(this);
+    for (SetMergeThread::iterator mergeThread = mergeThreads.begin(); mergeThread != mergeThreads.end(); ++mergeThread) {
+        OneMergePtr runningMerge((*mergeThread)->getRunningMerge());
+        if (runningMerge && runningMerge->rateLimiter) {
+            runningMerge->rateLimiter->setMbPerSec(getMergeMBPerSec(runningMerge));
+        }
+    }
+}
+
 bool ConcurrentMergeScheduler::verbose() {
     return (!_writer.expired() && IndexWriterPtr(_writer)->verbose());
 }
@@ -136,8 +329,11 @@ void ConcurrentMergeScheduler::merge(const IndexWriterPtr& writer) {
         bool success = false;
         LuceneException finally;
         try {
+            estimateMergeBytes(writer, merge);
+
             SyncLock syncLock(this);
             MergeThreadPtr merger;
+            updateIOThrottle(merge);
             while (mergeThreadCount() >= maxThreadCount) {
                 message(L"    too many merge threads running; stalling...");
                 wait(1000);
@@ -150,9 +346,14 @@ void ConcurrentMergeScheduler::merge(const IndexWriterPtr& writer) {
             // OK to spawn a new merge thread to handle this merge
             merger = getMergeThread(writer, merge);
             mergeThreads.add(merger);
-            message(L"    launch new thread");
 
-            merger->start();
+            if (threadPool) {
+                message(L"    schedule merge on thread pool");
+                merger->start(threadPool);
+            } else {
+                message(L"    launch new thread");
+                merger->start();
+            }
             success = true;
         } catch (LuceneException& e) {
             finally = e;
@@ -166,7 +367,29 @@ void ConcurrentMergeScheduler::merge(const IndexWriterPtr& writer) {
 
 void ConcurrentMergeScheduler::doMerge(const OneMergePtr& merge) {
     TestScope testScope(L"ConcurrentMergeScheduler", L"doMerge");
-    IndexWriterPtr(_writer)->merge(merge);
+    {
+        SyncLock syncLock(this);
+        SyncLock mergeLock(merge);
+        merge->rateLimiter = newLucene<RateLimiter>(getMergeMBPerSec(merge));
+        merge->mergeStartTime = (int64_t)MiscUtils::currentTimeMillis();
+        merge->mergeEndTime = 0;
+    }
+    LuceneException finally;
+    try {
+        IndexWriterPtr(_writer)->merge(merge);
+    } catch (LuceneException& e) {
+        finally = e;
+    }
+    {
+        SyncLock mergeLock(merge);
+        merge->mergeEndTime = (int64_t)MiscUtils::currentTimeMillis();
+    }
+    if (verbose()) {
+        message(L"merge " + merge->segString(dir) + L": wrote " + StringUtils::toString((double)merge->getTotalBytesWritten() / 1024.0 / 1024.0) +
+                L" MB in " + StringUtils::toString((double)merge->getElapsedMillis() / 1000.0) + L" sec (" + StringUtils::toString(merge->getMBPerSec()) +
+                L" MB/sec), throttled " + StringUtils::toString((double)merge->getTotalThrottledMillis() / 1000.0) + L" sec");
+    }
+    finally.throwException();
 }
 
 MergeThreadPtr ConcurrentMergeScheduler::getMergeThread(const IndexWriterPtr& writer, const OneMergePtr& merge) {
@@ -258,6 +481,25 @@ void MergeThread::setThreadPriority(int32_t pri) {
     }
 }
 
+void MergeThread::start(const ThreadPoolPtr& threadPool) {
+    pooledRun = threadPool->scheduleTask(boost::protect(boost::bind<bool>(boost::mem_fn(&MergeThread::runPooled), shared_from_this())));
+}
+
+bool MergeThread::isAlive() {
+    if (pooledRun) {
+        return !pooledRun->isDone();
+    }
+    return LuceneThread::isAlive();
+}
+
+bool MergeThread::runPooled() {
+    try {
+        run();
+    } catch (...) {
+    }
+    return true;
+}
+
 void MergeThread::run() {
     // First time through the while loop we do the merge that we were started with
     OneMergePtr merge(this->startMerge);
@@ -276,6 +518,7 @@ void MergeThread::run() {
             merge = writer->getNextMerge();
             if (merge) {
                 writer->mergeInit(merge);
+                merger->estimateMergeBytes(writer, merge);
                 merger->message(L"  merge thread: do another merge " + merge->segString(merger->dir));
             } else {
                 break;
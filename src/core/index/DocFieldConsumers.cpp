@@ -44,7 +44,7 @@ void DocFieldConsumers::flush(MapDocFieldConsumerPerThreadCollectionDocFieldCons
         }
 
         oneThreadsAndFields.put(boost::static_pointer_cast<DocFieldConsumersPerThread>(entry->first)->one, oneFields);
-        twoThreadsAndFields.put(boost::static_pointer_cast<DocFieldConsumersPerThread>(entry->first)->two, oneFields);
+        twoThreadsAndFields.put(boost::static_pointer_cast<DocFieldConsumersPerThread>(entry->first)->two, twoFields);
     }
 
     one->flush(oneThreadsAndFields, state);
@@ -66,6 +66,21 @@ void DocFieldConsumers::closeDocStore(const SegmentWriteStatePtr& state) {
     finally.throwException();
 }
 
+void DocFieldConsumers::abort() {
+    LuceneException finally;
+    try {
+        one->abort();
+    } catch (LuceneException& e) {
+        finally = e;
+    }
+    try {
+        two->abort();
+    } catch (LuceneException& e) {
+        finally = e;
+    }
+    finally.throwException();
+}
+
 bool DocFieldConsumers::freeRAM() {
     return (one->freeRAM() || two->freeRAM());
 }
@@ -48,7 +48,7 @@ void DocFieldProcessor::flush(Collection<DocConsumerPerThreadPtr> threads, const
     // Important to save after asking consumer to flush so consumer can alter the FieldInfo* if necessary.
     // eg FreqProxTermsWriter does this with FieldInfo.storePayload.
     String fileName(state->segmentFileName(IndexFileNames::FIELD_INFOS_EXTENSION()));
-    fieldInfos->write(state->directory, fileName);
+    state->fieldInfos->write(state->directory, fileName);
     state->flushedFiles.add(fileName);
 }
 
@@ -217,6 +217,9 @@ DocWriterPtr DocFieldProcessorPerThread::processDocument() {
 
     for (int32_t i = 0; i < fieldCount; ++i) {
         _fields[i]->consumer->processFields(_fields[i]->fields, _fields[i]->fieldCount);
+
+        // don't hang onto the fields, once every consumer has seen them
+        MiscUtils::arrayFill(_fields[i]->fields.begin(), 0, _fields[i]->fieldCount, FieldablePtr());
     }
 
     if (!docState->maxTermPrefix.empty() && docState->infoStream) {
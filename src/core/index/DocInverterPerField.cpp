@@ -192,9 +192,6 @@ void DocInverterPerField::processFields(Collection<FieldablePtr> fields, int32_t
             }
             fieldState->boost *= field->getBoost();
         }
-
-        // don't hang onto the field
-        fields[i].reset();
     }
 
     consumer->finish();
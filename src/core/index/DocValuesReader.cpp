@@ -0,0 +1,118 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "LuceneInc.h"
+#include "DocValuesReader.h"
+#include "DocValuesWriter.h"
+#include "AbstractField.h"
+#include "IndexFileNames.h"
+#include "IndexInput.h"
+#include "Directory.h"
+#include "FieldCache.h"
+#include "PackedInts.h"
+#include "StringUtils.h"
+
+namespace Lucene {
+
+DocValuesReader::DocValuesReader(const DirectoryPtr& d, const String& segment, int32_t readBufferSize) {
+    fieldTypes = MapStringInt::newInstance();
+    fieldPointers = MapStringLong::newInstance();
+    loaded = MapStringLuceneObject::newInstance();
+
+    input = d->openInput(segment + L"." + IndexFileNames::DOC_VALUES_EXTENSION(), readBufferSize);
+
+    bool success = false;
+    LuceneException finally;
+    try {
+        int32_t format = input->readInt();
+        if (format < DocValuesWriter::FORMAT_CURRENT) {
+            boost::throw_exception(CorruptIndexException(L"Unknown format version:" + StringUtils::toString(format)));
+        }
+
+        // read the directory of fields, skipping over their values
+        int32_t numFields = input->readVInt();
+        for (int32_t i = 0; i < numFields; ++i) {
+            String field(input->readString());
+            int32_t type = input->readByte();
+            fieldTypes.put(field, type);
+            fieldPointers.put(field, input->getFilePointer());
+            if (type == AbstractField::DOC_VALUES_NUMERIC) {
+                PackedInts::skip(input);
+            } else if (type == AbstractField::DOC_VALUES_SORTED) {
+                PackedInts::skip(input);
+                int32_t numBytes = input->readVInt();
+                input->seek(input->getFilePointer() + numBytes);
+                PackedInts::skip(input);
+            } else {
+                boost::throw_exception(CorruptIndexException(L"Unknown doc values type:" + StringUtils::toString(type)));
+            }
+        }
+        success = true;
+    } catch (LuceneException& e) {
+        finally = e;
+    }
+    if (!success) {
+        close();
+    }
+    finally.throwException();
+}
+
+DocValuesReader::~DocValuesReader() {
+}
+
+int32_t DocValuesReader::getType(const String& field) {
+    MapStringInt::iterator type = fieldTypes.find(field);
+    return type == fieldTypes.end() ? AbstractField::DOC_VALUES_NO : type->second;
+}
+
+PackedIntsPtr DocValuesReader::getNumeric(const String& field) {
+    if (getType(field) != AbstractField::DOC_VALUES_NUMERIC) {
+        return PackedIntsPtr();
+    }
+    return boost::static_pointer_cast<PackedInts>(load(field, AbstractField::DOC_VALUES_NUMERIC));
+}
+
+StringIndexPtr DocValuesReader::getSorted(const String& field) {
+    if (getType(field) != AbstractField::DOC_VALUES_SORTED) {
+        return StringIndexPtr();
+    }
+    return boost::static_pointer_cast<StringIndex>(load(field, AbstractField::DOC_VALUES_SORTED));
+}
+
+LuceneObjectPtr DocValuesReader::load(const String& field, int32_t type) {
+    SyncLock syncLock(this);
+    LuceneObjectPtr values(loaded.get(field));
+    if (values) {
+        return values;
+    }
+    if (!input) {
+        boost::throw_exception(AlreadyClosedException(L"this DocValuesReader is closed"));
+    }
+
+    input->seek(fieldPointers.get(field));
+    if (type == AbstractField::DOC_VALUES_NUMERIC) {
+        values = PackedInts::read(input);
+    } else {
+        PackedIntsPtr termOffsets(PackedInts::read(input));
+        int32_t numBytes = input->readVInt();
+        ByteArray termBytes(ByteArray::newInstance(std::max(numBytes, 1)));
+        input->readBytes(termBytes.get(), 0, numBytes);
+        PackedIntsPtr order(PackedInts::read(input));
+        values = newLucene<StringIndex>(order, termBytes, termOffsets);
+    }
+    loaded.put(field, values);
+    return values;
+}
+
+void DocValuesReader::close() {
+    SyncLock syncLock(this);
+    if (input) {
+        input->close();
+        input.reset();
+    }
+}
+
+}
@@ -0,0 +1,205 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "LuceneInc.h"
+#include "DocValuesWriter.h"
+#include "DocValuesWriterPerThread.h"
+#include "DocValuesWriterPerField.h"
+#include "AbstractField.h"
+#include "IndexFileNames.h"
+#include "IndexOutput.h"
+#include "SegmentWriteState.h"
+#include "FieldInfos.h"
+#include "FieldInfo.h"
+#include "Directory.h"
+#include "PackedInts.h"
+#include "MiscUtils.h"
+#include "StringUtils.h"
+#include "UnicodeUtils.h"
+
+namespace Lucene {
+
+const int32_t DocValuesWriter::FORMAT_START = -1;
+const int32_t DocValuesWriter::FORMAT_CURRENT = DocValuesWriter::FORMAT_START;
+
+DocValuesWriter::DocValuesWriter() {
+    fieldTypes = MapStringInt::newInstance();
+}
+
+DocValuesWriter::~DocValuesWriter() {
+}
+
+DocFieldConsumerPerThreadPtr DocValuesWriter::addThread(const DocFieldProcessorPerThreadPtr& docFieldProcessorPerThread) {
+    return newLucene<DocValuesWriterPerThread>(docFieldProcessorPerThread, shared_from_this());
+}
+
+void DocValuesWriter::abort() {
+}
+
+bool DocValuesWriter::freeRAM() {
+    return false;
+}
+
+void DocValuesWriter::closeDocStore(const SegmentWriteStatePtr& state) {
+}
+
+void DocValuesWriter::checkType(const String& field, int32_t docValuesType) {
+    SyncLock syncLock(this);
+    MapStringInt::iterator type = fieldTypes.find(field);
+    if (type == fieldTypes.end()) {
+        fieldTypes.put(field, docValuesType);
+    } else if (type->second != docValuesType) {
+        boost::throw_exception(IllegalArgumentException(L"field \"" + field + L"\" cannot change the type of its doc values"));
+    }
+}
+
+void DocValuesWriter::flush(MapDocFieldConsumerPerThreadCollectionDocFieldConsumerPerField threadsAndFields, const SegmentWriteStatePtr& state) {
+    Collection<DocValuesWriterPerFieldPtr> allFields(Collection<DocValuesWriterPerFieldPtr>::newInstance());
+
+    for (MapDocFieldConsumerPerThreadCollectionDocFieldConsumerPerField::iterator entry = threadsAndFields.begin(); entry != threadsAndFields.end(); ++entry) {
+        for (Collection<DocFieldConsumerPerFieldPtr>::iterator perField = entry->second.begin(); perField != entry->second.end(); ++perField) {
+            DocValuesWriterPerFieldPtr valuesPerField(boost::static_pointer_cast<DocValuesWriterPerField>(*perField));
+            if (valuesPerField->upto > 0) {
+                allFields.add(valuesPerField);
+            }
+        }
+    }
+
+    if (allFields.empty()) {
+        return;
+    }
+
+    // Collate by field, ie all per-thread field instances that correspond to the same FieldInfo
+    Collection< Collection<DocValuesWriterPerFieldPtr> > byField(Collection< Collection<DocValuesWriterPerFieldPtr> >::newInstance());
+    int32_t numField = state->fieldInfos->size();
+    for (int32_t fieldNumber = 0; fieldNumber < numField; ++fieldNumber) {
+        String name(state->fieldInfos->fieldInfo(fieldNumber)->name);
+        Collection<DocValuesWriterPerFieldPtr> toMerge(Collection<DocValuesWriterPerFieldPtr>::newInstance());
+        for (Collection<DocValuesWriterPerFieldPtr>::iterator perField = allFields.begin(); perField != allFields.end(); ++perField) {
+            if ((*perField)->fieldInfo->name == name) {
+                toMerge.add(*perField);
+            }
+        }
+        if (!toMerge.empty()) {
+            byField.add(toMerge);
+        }
+    }
+
+    String valuesFileName(state->segmentName + L"." + IndexFileNames::DOC_VALUES_EXTENSION());
+    state->flushedFiles.add(valuesFileName);
+    IndexOutputPtr valuesOut(state->directory->createOutput(valuesFileName));
+
+    LuceneException finally;
+    try {
+        writeHeader(valuesOut, byField.size());
+
+        for (Collection< Collection<DocValuesWriterPerFieldPtr> >::iterator toMerge = byField.begin(); toMerge != byField.end(); ++toMerge) {
+            String name((*toMerge)[0]->fieldInfo->name);
+            int32_t numValues = 0;
+
+            if ((*toMerge)[0]->docValuesType == AbstractField::DOC_VALUES_NUMERIC) {
+                Collection<int64_t> values(Collection<int64_t>::newInstance(state->numDocs));
+                int64_t minValue = std::numeric_limits<int64_t>::max();
+                int64_t maxValue = std::numeric_limits<int64_t>::min();
+                for (Collection<DocValuesWriterPerFieldPtr>::iterator perField = toMerge->begin(); perField != toMerge->end(); ++perField) {
+                    for (int32_t i = 0; i < (*perField)->upto; ++i) {
+                        int64_t value = (*perField)->numericValues[i];
+                        values[(*perField)->docIDs[i]] = value;
+                        minValue = std::min(minValue, value);
+                        maxValue = std::max(maxValue, value);
+                    }
+                    numValues += (*perField)->upto;
+                    (*perField)->reset();
+                }
+
+                // Documents without a value read 0
+                if (numValues < state->numDocs) {
+                    minValue = std::min(minValue, (int64_t)0);
+                    maxValue = std::max(maxValue, (int64_t)0);
+                }
+
+                PackedIntsPtr packed(PackedInts::forRange(state->numDocs, minValue, maxValue));
+                for (int32_t doc = 0; doc < state->numDocs; ++doc) {
+                    packed->set(doc, values[doc]);
+                }
+                writeNumeric(valuesOut, name, packed);
+            } else {
+                Collection<String> values(Collection<String>::newInstance(state->numDocs));
+                Collection<String> terms(Collection<String>::newInstance());
+                terms.add(L"");
+                for (Collection<DocValuesWriterPerFieldPtr>::iterator perField = toMerge->begin(); perField != toMerge->end(); ++perField) {
+                    for (int32_t i = 0; i < (*perField)->upto; ++i) {
+                        values[(*perField)->docIDs[i]] = (*perField)->sortedValues[i];
+                        terms.add((*perField)->sortedValues[i]);
+                    }
+                    (*perField)->reset();
+                }
+
+                std::sort(terms.begin(), terms.end());
+                terms.resize(std::unique(terms.begin(), terms.end()) - terms.begin());
+
+                Collection<int32_t> ords(Collection<int32_t>::newInstance(state->numDocs));
+                for (int32_t doc = 0; doc < state->numDocs; ++doc) {
+                    ords[doc] = (int32_t)(std::lower_bound(terms.begin(), terms.end(), values[doc]) - terms.begin());
+                }
+                writeSorted(valuesOut, name, terms, ords);
+            }
+        }
+    } catch (LuceneException& e) {
+        finally = e;
+    }
+
+    valuesOut->close();
+
+    finally.throwException();
+}
+
+void DocValuesWriter::writeHeader(const IndexOutputPtr& output, int32_t numFields) {
+    output->writeInt(FORMAT_CURRENT);
+    output->writeVInt(numFields);
+}
+
+void DocValuesWriter::writeNumeric(const IndexOutputPtr& output, const String& field, const PackedIntsPtr& values) {
+    output->writeString(field);
+    output->writeByte((uint8_t)AbstractField::DOC_VALUES_NUMERIC);
+    values->write(output);
+}
+
+void DocValuesWriter::writeSorted(const IndexOutputPtr& output, const String& field, Collection<String> terms, Collection<int32_t> ords) {
+    output->writeString(field);
+    output->writeByte((uint8_t)AbstractField::DOC_VALUES_SORTED);
+
+    ByteArray termBytes(ByteArray::newInstance(16));
+    IntArray offsets(IntArray::newInstance(terms.size() + 1));
+    UTF8ResultPtr utf8(newLucene<UTF8Result>());
+    int32_t upto = 0;
+    for (int32_t ord = 0; ord < terms.size(); ++ord) {
+        StringUtils::toUTF8(terms[ord].c_str(), terms[ord].length(), utf8);
+        if (upto + utf8->length > termBytes.size()) {
+            termBytes.resize(MiscUtils::getNextSize(upto + utf8->length));
+        }
+        MiscUtils::arrayCopy(utf8->result.get(), 0, termBytes.get(), upto, utf8->length);
+        offsets[ord] = upto;
+        upto += utf8->length;
+    }
+    offsets[terms.size()] = upto;
+
+    PackedIntsPtr termOffsets(PackedInts::forRange(terms.size() + 1, 0, upto));
+    for (int32_t ord = 0; ord <= terms.size(); ++ord) {
+        termOffsets->set(ord, offsets[ord]);
+    }
+    termOffsets->write(output);
+    output->writeVInt(upto);
+    output->writeBytes(termBytes.get(), upto);
+
+    PackedIntsPtr order(PackedInts::forRange(ords.size(), 0, terms.size() - 1));
+    for (int32_t doc = 0; doc < ords.size(); ++doc) {
+        order->set(doc, ords[doc]);
+    }
+    order->write(output);
+}
+
+}
@@ -0,0 +1,91 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "LuceneInc.h"
+#include "DocValuesWriterPerField.h"
+#include "DocValuesWriterPerThread.h"
+#include "DocValuesWriter.h"
+#include "DocumentsWriter.h"
+#include "AbstractField.h"
+#include "FieldInfo.h"
+#include "MiscUtils.h"
+#include "StringUtils.h"
+
+namespace Lucene {
+
+DocValuesWriterPerField::DocValuesWriterPerField(const DocValuesWriterPerThreadPtr& perThread, const FieldInfoPtr& fieldInfo) {
+    docValuesType = AbstractField::DOC_VALUES_NO;
+    docIDs = Collection<int32_t>::newInstance(1);
+    upto = 0;
+
+    this->_perThread = perThread;
+    this->fieldInfo = fieldInfo;
+    docState = perThread->docState;
+}
+
+DocValuesWriterPerField::~DocValuesWriterPerField() {
+}
+
+void DocValuesWriterPerField::reset() {
+    // Shrink back if we are over allocated now
+    int32_t size = MiscUtils::getShrinkSize(docIDs.size(), upto);
+    docIDs.resize(size);
+    if (numericValues) {
+        numericValues.resize(size);
+    }
+    if (sortedValues) {
+        sortedValues.clear();
+        sortedValues.resize(size);
+    }
+    upto = 0;
+}
+
+void DocValuesWriterPerField::abort() {
+    upto = 0;
+}
+
+void DocValuesWriterPerField::processFields(Collection<FieldablePtr> fields, int32_t count) {
+    // Only the first instance of the field in a document that has values counts
+    FieldablePtr field;
+    for (int32_t i = 0; i < count; ++i) {
+        if (fields[i]->getDocValuesType() != AbstractField::DOC_VALUES_NO) {
+            field = fields[i];
+            break;
+        }
+    }
+    if (!field) {
+        return;
+    }
+
+    if (field->getDocValuesType() != docValuesType) {
+        DocValuesWriterPtr(DocValuesWriterPerThreadPtr(_perThread)->_docValuesWriter)->checkType(fieldInfo->name, field->getDocValuesType());
+        docValuesType = field->getDocValuesType();
+    }
+
+    if (docIDs.size() <= upto) {
+        BOOST_ASSERT(docIDs.size() == upto);
+        docIDs.resize(MiscUtils::getNextSize(1 + upto));
+    }
+    if (docValuesType == AbstractField::DOC_VALUES_NUMERIC) {
+        if (!numericValues) {
+            numericValues = Collection<int64_t>::newInstance(docIDs.size());
+        } else if (numericValues.size() < docIDs.size()) {
+            numericValues.resize(docIDs.size());
+        }
+        numericValues[upto] = StringUtils::toLong(field->stringValue());
+    } else {
+        if (!sortedValues) {
+            sortedValues = Collection<String>::newInstance(docIDs.size());
+        } else if (sortedValues.size() < docIDs.size()) {
+            sortedValues.resize(docIDs.size());
+        }
+        sortedValues[upto] = field->stringValue();
+    }
+    docIDs[upto] = docState->docID;
+    ++upto;
+}
+
+}
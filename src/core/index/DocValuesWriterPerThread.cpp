@@ -0,0 +1,36 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "LuceneInc.h"
+#include "DocValuesWriterPerThread.h"
+#include "DocValuesWriterPerField.h"
+#include "DocFieldProcessorPerThread.h"
+
+namespace Lucene {
+
+DocValuesWriterPerThread::DocValuesWriterPerThread(const DocFieldProcessorPerThreadPtr& docFieldProcessorPerThread, const DocValuesWriterPtr& docValuesWriter) {
+    this->_docValuesWriter = docValuesWriter;
+    docState = docFieldProcessorPerThread->docState;
+}
+
+DocValuesWriterPerThread::~DocValuesWriterPerThread() {
+}
+
+void DocValuesWriterPerThread::startDocument() {
+}
+
+DocWriterPtr DocValuesWriterPerThread::finishDocument() {
+    return DocWriterPtr();
+}
+
+DocFieldConsumerPerFieldPtr DocValuesWriterPerThread::addField(const FieldInfoPtr& fi) {
+    return newLucene<DocValuesWriterPerField>(shared_from_this(), fi);
+}
+
+void DocValuesWriterPerThread::abort() {
+}
+
+}
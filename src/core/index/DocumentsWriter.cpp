@@ -10,6 +10,7 @@
 #include "LuceneThread.h"
 #include "IndexWriter.h"
 #include "_IndexWriter.h"
+#include "FieldsWriter.h"
 #include "IndexReader.h"
 #include "IndexSearcher.h"
 #include "DocFieldProcessor.h"
@@ -22,6 +23,8 @@
 #include "TermsHash.h"
 #include "DocInverter.h"
 #include "NormsWriter.h"
+#include "DocFieldConsumers.h"
+#include "DocValuesWriter.h"
 #include "BufferedDeletes.h"
 #include "FieldInfos.h"
 #include "InfoStream.h"
@@ -42,9 +45,6 @@
 
 namespace Lucene {
 
-/// Max # ThreadState instances; if there are more threads than this they share ThreadStates
-const int32_t DocumentsWriter::MAX_THREAD_STATE = 5;
-
 /// Coarse estimates used to measure RAM usage of buffered deletes
 const int32_t DocumentsWriter::OBJECT_HEADER_BYTES = 8;
 #ifdef LPP_BUILD_64
@@ -104,6 +104,8 @@ const int32_t DocumentsWriter::PER_DOC_BLOCK_SIZE = 1024;
 DocumentsWriter::DocumentsWriter(const DirectoryPtr& directory,  const IndexWriterPtr& writer, const IndexingChainPtr& indexingChain) {
     this->threadStates = Collection<DocumentsWriterThreadStatePtr>::newInstance();
     this->threadBindings = MapThreadDocumentsWriterThreadState::newInstance();
+    this->freeThreadStates = Collection<DocumentsWriterThreadStatePtr>::newInstance();
+    this->pendingFlushes = Collection<PendingFlushPtr>::newInstance();
     this->_openFiles = HashSet<String>::newInstance();
     this->_closedFiles = HashSet<String>::newInstance();
     this->freeIntBlocks = Collection<IntArray>::newInstance();
@@ -127,6 +129,7 @@ void DocumentsWriter::initialize() {
     bufferIsFull = false;
     aborting = false;
     maxFieldLength = IndexWriter::DEFAULT_MAX_FIELD_LENGTH;
+    storedFieldsCompression = FieldsWriter::COMPRESSION_FAST;
     deletesInRAM = newLucene<BufferedDeletes>(false);
     deletesFlushed = newLucene<BufferedDeletes>(true);
     maxBufferedDeleteTerms = IndexWriter::DEFAULT_MAX_BUFFERED_DELETE_TERMS;
@@ -136,6 +139,10 @@ void DocumentsWriter::initialize() {
     freeTrigger = (int64_t)(IndexWriter::DEFAULT_RAM_BUFFER_SIZE_MB * 1024.0 * 1024.0 * 1.05);
     freeLevel = (int64_t)(IndexWriter::DEFAULT_RAM_BUFFER_SIZE_MB * 1024.0 * 1024.0 * 0.95);
     maxBufferedDocs = IndexWriter::DEFAULT_MAX_BUFFERED_DOCS;
+    maxThreadStates = IndexWriter::DEFAULT_MAX_THREAD_STATES;
+    maxPendingFlushes = IndexWriter::DEFAULT_MAX_PENDING_FLUSHES;
+    numPendingDocs = 0;
+    numPendingBytes = 0;
     flushedDocCount = 0;
     closed = false;
     waitQueue = newLucene<WaitQueue>(shared_from_this());
@@ -241,12 +248,42 @@ int32_t DocumentsWriter::getMaxBufferedDocs() {
     return maxBufferedDocs;
 }
 
+void DocumentsWriter::setMaxThreadStates(int32_t maxThreadStates) {
+    SyncLock syncLock(this);
+    this->maxThreadStates = maxThreadStates;
+}
+
+int32_t DocumentsWriter::getMaxThreadStates() {
+    SyncLock syncLock(this);
+    return maxThreadStates;
+}
+
+void DocumentsWriter::setMaxPendingFlushes(int32_t maxPendingFlushes) {
+    SyncLock syncLock(this);
+    this->maxPendingFlushes = maxPendingFlushes;
+}
+
+int32_t DocumentsWriter::getMaxPendingFlushes() {
+    SyncLock syncLock(this);
+    // Only the consumers under DocFieldProcessor are known to write a frozen segment safely while
+    // other threads keep indexing
+    return docFieldProcessor ? maxPendingFlushes : 0;
+}
+
+void DocumentsWriter::setStoredFieldsCompression(int32_t mode) {
+    storedFieldsCompression = mode;
+}
+
+int32_t DocumentsWriter::getStoredFieldsCompression() {
+    return storedFieldsCompression;
+}
+
 String DocumentsWriter::getSegment() {
     return segment;
 }
 
 int32_t DocumentsWriter::getNumDocsInRAM() {
-    return numDocsInRAM;
+    return numDocsInRAM + numPendingDocs;
 }
 
 String DocumentsWriter::getDocStoreSegment() {
@@ -357,6 +394,30 @@ void DocumentsWriter::abort() {
                 _abortedFiles.reset();
             }
 
+            // Let a pending flush that is being written finish, then discard all pending flushes
+            while (pendingFlushWriting()) {
+                wait(1000);
+            }
+            for (Collection<PendingFlushPtr>::iterator pendingFlush = pendingFlushes.begin(); pendingFlush != pendingFlushes.end(); ++pendingFlush) {
+                for (Collection<DocumentsWriterThreadStatePtr>::iterator threadState = (*pendingFlush)->threadStates.begin(); threadState != (*pendingFlush)->threadStates.end(); ++threadState) {
+                    try {
+                        (*threadState)->consumer->abort();
+                    } catch (...) {
+                    }
+                    (*threadState)->doAfterFlush();
+                    freeThreadStates.add(*threadState);
+                }
+                (*pendingFlush)->threadStates.clear();
+                if (_abortedFiles) {
+                    _abortedFiles.addAll((*pendingFlush)->flushState->flushedFiles.begin(), (*pendingFlush)->flushState->flushedFiles.end());
+                }
+                flushedDocCount -= (*pendingFlush)->flushState->numDocs;
+                (*pendingFlush)->aborted = true;
+            }
+            pendingFlushes.clear();
+            numPendingDocs = 0;
+            numPendingBytes = 0;
+
             deletesInRAM->clear();
             deletesFlushed->clear();
             _openFiles.clear();
@@ -412,6 +473,28 @@ void DocumentsWriter::doAfterFlush() {
     numBytesUsed = 0;
 }
 
+DocumentsWriterThreadStatePtr DocumentsWriter::newThreadState() {
+    if (freeThreadStates.empty()) {
+        return newLucene<DocumentsWriterThreadState>(shared_from_this());
+    }
+    DocumentsWriterThreadStatePtr state(freeThreadStates.removeLast());
+    state->numThreads = 1;
+    state->docState->maxFieldLength = maxFieldLength;
+    state->docState->infoStream = infoStream;
+    state->docState->similarity = similarity;
+    return state;
+}
+
+bool DocumentsWriter::pendingFlushWriting() {
+    SyncLock syncLock(this);
+    for (Collection<PendingFlushPtr>::iterator pendingFlush = pendingFlushes.begin(); pendingFlush != pendingFlushes.end(); ++pendingFlush) {
+        if ((*pendingFlush)->writing && !(*pendingFlush)->written) {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool DocumentsWriter::pauseAllThreads() {
     SyncLock syncLock(this);
     ++pauseThreads;
@@ -442,13 +525,16 @@ bool DocumentsWriter::allThreadsIdle() {
 
 bool DocumentsWriter::anyChanges() {
     SyncLock syncLock(this);
-    return (numDocsInRAM != 0 || deletesInRAM->numTerms != 0 || !deletesInRAM->docIDs.empty() || !deletesInRAM->queries.empty());
+    return (numDocsInRAM != 0 || !pendingFlushes.empty() || deletesInRAM->numTerms != 0 || !deletesInRAM->docIDs.empty() || !deletesInRAM->queries.empty());
 }
 
 void DocumentsWriter::initFlushState(bool onlyDocStore) {
     SyncLock syncLock(this);
     initSegmentName(onlyDocStore);
     flushState = newLucene<SegmentWriteState>(shared_from_this(), directory, segment, docStoreSegment, numDocsInRAM, numDocsInStore, IndexWriterPtr(_writer)->getTermIndexInterval());
+    if (docFieldProcessor) {
+        flushState->fieldInfos = boost::dynamic_pointer_cast<FieldInfos>(docFieldProcessor->fieldInfos->clone());
+    }
 }
 
 int32_t DocumentsWriter::flush(bool _closeDocStore) {
@@ -456,6 +542,7 @@ int32_t DocumentsWriter::flush(bool _closeDocStore) {
     BOOST_ASSERT(allThreadsIdle());
 
     BOOST_ASSERT(numDocsInRAM > 0);
+    BOOST_ASSERT(pendingFlushes.empty());
 
     BOOST_ASSERT(nextDocID == numDocsInRAM);
     BOOST_ASSERT(waitQueue->numWaiting == 0);
@@ -516,13 +603,165 @@ int32_t DocumentsWriter::flush(bool _closeDocStore) {
     return flushState->numDocs;
 }
 
+PendingFlushPtr DocumentsWriter::freezeBufferedDocs() {
+    SyncLock syncLock(this);
+    if (pauseAllThreads()) {
+        resumeAllThreads();
+        return PendingFlushPtr();
+    }
+
+    PendingFlushPtr pendingFlush;
+    LuceneException finally;
+    try {
+        if (numDocsInRAM > 0) {
+            BOOST_ASSERT(nextDocID == numDocsInRAM);
+            BOOST_ASSERT(waitQueue->numWaiting == 0);
+            BOOST_ASSERT(waitQueue->waitingBytes == 0);
+
+            initFlushState(false);
+
+            // The doc stores stay open, shared with the segments that follow, so there is nothing to fill in them
+            flushState->numDocsInStore = 0;
+
+            if (infoStream) {
+                message(L"freeze postings as segment " + flushState->segmentName + L" numDocs=" + StringUtils::toString(numDocsInRAM));
+            }
+
+            pendingFlush = newLucene<PendingFlush>(flushState, threadStates, deletesInRAM, docStoreOffset, numBytesUsed);
+            pendingFlushes.add(pendingFlush);
+            numPendingDocs += numDocsInRAM;
+            numPendingBytes += pendingFlush->bytesUsed;
+
+            docStoreOffset = numDocsInStore;
+            flushedDocCount += numDocsInRAM;
+
+            // Start a new segment with fresh ThreadStates and deletes
+            threadStates = Collection<DocumentsWriterThreadStatePtr>::newInstance();
+            deletesInRAM = newLucene<BufferedDeletes>(false);
+            threadBindings.clear();
+            waitQueue->reset();
+            segment.clear();
+            numDocsInRAM = 0;
+            nextDocID = 0;
+            bufferIsFull = false;
+            flushPending = false;
+            numBytesUsed = 0;
+        }
+    } catch (LuceneException& e) {
+        finally = e;
+    }
+    resumeAllThreads();
+    finally.throwException();
+    return pendingFlush;
+}
+
+void DocumentsWriter::writePendingFlush(const PendingFlushPtr& pendingFlush) {
+    {
+        SyncLock syncLock(this);
+        // Segments are written in the order they were frozen, one at a time
+        bool ready = false;
+        while (!pendingFlush->aborted && !ready) {
+            ready = true;
+            for (Collection<PendingFlushPtr>::iterator older = pendingFlushes.begin(); older != pendingFlushes.end() && *older != pendingFlush; ++older) {
+                if (!(*older)->written) {
+                    ready = false;
+                    wait(1000);
+                    break;
+                }
+            }
+        }
+        if (pendingFlush->aborted) {
+            return;
+        }
+        pendingFlush->writing = true;
+    }
+
+    SegmentWriteStatePtr state(pendingFlush->flushState);
+
+    if (infoStream) {
+        message(L"flush postings as segment " + state->segmentName + L" numDocs=" + StringUtils::toString(state->numDocs));
+    }
+
+    bool success = false;
+    LuceneException finally;
+    try {
+        Collection<DocConsumerPerThreadPtr> threads(Collection<DocConsumerPerThreadPtr>::newInstance());
+        for (Collection<DocumentsWriterThreadStatePtr>::iterator threadState = pendingFlush->threadStates.begin(); threadState != pendingFlush->threadStates.end(); ++threadState) {
+            threads.add((*threadState)->consumer);
+        }
+        consumer->flush(threads, state);
+
+        if (pendingFlush->useCompoundFile) {
+            createCompoundFile(state->segmentName, state->flushedFiles);
+        }
+
+        if (infoStream) {
+            int64_t newSegmentSize = newLucene<SegmentInfo>(state->segmentName, state->numDocs, directory)->sizeInBytes();
+            message(L"  oldRAMSize=" + StringUtils::toString(pendingFlush->bytesUsed) + L" newFlushedSize=" +
+                    StringUtils::toString(newSegmentSize) + L" docs/MB=" +
+                    StringUtils::toString((double)state->numDocs / ((double)newSegmentSize / 1024.0 / 1024.0)) +
+                    L" new/old=" + StringUtils::toString(100.0 * (double)newSegmentSize / (double)pendingFlush->bytesUsed) + L"%");
+        }
+
+        success = true;
+    } catch (LuceneException& e) {
+        finally = e;
+    }
+
+    {
+        SyncLock syncLock(this);
+        if (success) {
+            // The ThreadStates have been reset by the flush, so they can take new docs
+            for (Collection<DocumentsWriterThreadStatePtr>::iterator threadState = pendingFlush->threadStates.begin(); threadState != pendingFlush->threadStates.end(); ++threadState) {
+                (*threadState)->doAfterFlush();
+                freeThreadStates.add(*threadState);
+            }
+            pendingFlush->threadStates.clear();
+        }
+        pendingFlush->written = true;
+        notifyAll();
+    }
+
+    if (!success) {
+        abort();
+    }
+    finally.throwException();
+}
+
+PendingFlushPtr DocumentsWriter::nextWrittenFlush() {
+    SyncLock syncLock(this);
+    if (pendingFlushes.empty() || !pendingFlushes[0]->written) {
+        return PendingFlushPtr();
+    }
+    PendingFlushPtr pendingFlush(pendingFlushes.removeFirst());
+    numPendingDocs -= pendingFlush->flushState->numDocs;
+    numPendingBytes -= pendingFlush->bytesUsed;
+    return pendingFlush;
+}
+
+int32_t DocumentsWriter::numPendingFlushes() {
+    SyncLock syncLock(this);
+    return pendingFlushes.size();
+}
+
+void DocumentsWriter::waitForPendingFlush() {
+    SyncLock syncLock(this);
+    while (!pendingFlushes.empty() && !pendingFlushes[0]->written) {
+        wait(1000);
+    }
+}
+
 HashSet<String> DocumentsWriter::getFlushedFiles() {
     return flushState->flushedFiles;
 }
 
 void DocumentsWriter::createCompoundFile(const String& segment) {
+    createCompoundFile(segment, flushState->flushedFiles);
+}
+
+void DocumentsWriter::createCompoundFile(const String& segment, HashSet<String> files) {
     CompoundFileWriterPtr cfsWriter(newLucene<CompoundFileWriter>(directory, segment + L"." + IndexFileNames::COMPOUND_FILE_EXTENSION()));
-    for (HashSet<String>::iterator flushedFile = flushState->flushedFiles.begin(); flushedFile != flushState->flushedFiles.end(); ++flushedFile) {
+    for (HashSet<String>::iterator flushedFile = files.begin(); flushedFile != files.end(); ++flushedFile) {
         cfsWriter->addFile(*flushedFile);
     }
 
@@ -550,6 +789,11 @@ void DocumentsWriter::pushDeletes() {
     deletesFlushed->update(deletesInRAM);
 }
 
+void DocumentsWriter::pushDeletes(const BufferedDeletesPtr& deletes) {
+    SyncLock syncLock(this);
+    deletesFlushed->update(deletes);
+}
+
 void DocumentsWriter::close() {
     SyncLock syncLock(this);
     closed = true;
@@ -580,22 +824,47 @@ DocumentsWriterThreadStatePtr DocumentsWriter::getThreadState(const DocumentPtr&
                 minThreadState = *threadState;
             }
         }
-        if (minThreadState && (minThreadState->numThreads == 0 || threadStates.size() >= MAX_THREAD_STATE)) {
+        if (minThreadState && (minThreadState->numThreads == 0 || threadStates.size() >= maxThreadStates)) {
             state = minThreadState;
             ++state->numThreads;
         } else {
             // Just create a new "private" thread state
             threadStates.resize(threadStates.size() + 1);
-            state = newLucene<DocumentsWriterThreadState>(shared_from_this());
+            state = newThreadState();
             threadStates[threadStates.size() - 1] = state;
         }
         threadBindings.put(LuceneThread::currentId(), state);
+    } else if (!state->isIdle && state->numThreads > 1) {
+        // Our thread state is shared and busy with another thread.  Rather than queue up behind it, move to
+        // a new private thread state if the limit allows, else to an idle one, giving up affinity
+        if (threadStates.size() < maxThreadStates) {
+            --state->numThreads;
+            threadStates.resize(threadStates.size() + 1);
+            state = newThreadState();
+            threadStates[threadStates.size() - 1] = state;
+            threadBindings.put(LuceneThread::currentId(), state);
+        } else {
+            for (Collection<DocumentsWriterThreadStatePtr>::iterator threadState = threadStates.begin(); threadState != threadStates.end(); ++threadState) {
+                if ((*threadState)->isIdle) {
+                    --state->numThreads;
+                    state = *threadState;
+                    ++state->numThreads;
+                    threadBindings.put(LuceneThread::currentId(), state);
+                    break;
+                }
+            }
+        }
     }
 
     // Next, wait until my thread state is idle (in case it's shared with other threads) and for threads to
     // not be paused nor a flush pending
     waitReady(state);
 
+    if (!threadStates.contains(state)) {
+        // Our thread state was frozen into a pending flush while we waited, so start over with the new ones
+        return getThreadState(doc, delTerm);
+    }
+
     // Allocate segment name if this is the first doc since last flush
     initSegmentName(false);
 
@@ -735,12 +1004,16 @@ MapTermNum DocumentsWriter::getBufferedDeleteTerms() {
 void DocumentsWriter::remapDeletes(const SegmentInfosPtr& infos, Collection< Collection<int32_t> > docMaps, Collection<int32_t> delCounts, const OneMergePtr& merge, int32_t mergeDocCount) {
     SyncLock syncLock(this);
     if (!docMaps) {
-        // The merged segments had no deletes so docIDs did not change and we have nothing to do
+        // The merged segments had no deletes so docIDs did not change and we have nothing to do.  This also
+        // holds for non-adjacent merges: buffered deletes only refer to docIDs after the last merged segment
         return;
     }
     MergeDocIDRemapperPtr mapper(newLucene<MergeDocIDRemapper>(infos, docMaps, delCounts, merge, mergeDocCount));
     deletesInRAM->remap(mapper, infos, docMaps, delCounts, merge, mergeDocCount);
     deletesFlushed->remap(mapper, infos, docMaps, delCounts, merge, mergeDocCount);
+    for (Collection<PendingFlushPtr>::iterator pendingFlush = pendingFlushes.begin(); pendingFlush != pendingFlushes.end(); ++pendingFlush) {
+        (*pendingFlush)->deletes->remap(mapper, infos, docMaps, delCounts, merge, mergeDocCount);
+    }
     flushedDocCount -= mapper->docShift;
 }
 
@@ -963,7 +1236,7 @@ bool DocumentsWriter::doBalanceRAM() {
     SyncLock syncLock(this);
     return (ramBufferSize != IndexWriter::DISABLE_AUTO_FLUSH && !bufferIsFull &&
             (numBytesUsed + deletesInRAM->bytesUsed + deletesFlushed->bytesUsed >= ramBufferSize ||
-             numBytesAlloc >= freeTrigger));
+             numBytesAlloc - numPendingBytes >= freeTrigger));
 }
 
 void DocumentsWriter::finishDocument(const DocumentsWriterThreadStatePtr& perThread, const DocWriterPtr& docWriter) {
@@ -1022,7 +1295,7 @@ void DocumentsWriter::waitForWaitQueue() {
 }
 
 int64_t DocumentsWriter::getRAMUsed() {
-    return numBytesUsed + deletesInRAM->bytesUsed + deletesFlushed->bytesUsed;
+    return numBytesUsed + numPendingBytes + deletesInRAM->bytesUsed + deletesFlushed->bytesUsed;
 }
 
 IntArray DocumentsWriter::getIntBlock(bool trackAllocations) {
@@ -1099,7 +1372,8 @@ void DocumentsWriter::balanceRAM() {
 
     int64_t deletesRAMUsed = deletesInRAM->bytesUsed + deletesFlushed->bytesUsed;
 
-    if (numBytesAlloc + deletesRAMUsed > freeTrigger) {
+    // RAM held by pending flushes comes back to the pools once they are written, so we don't count it here
+    if (numBytesAlloc - numPendingBytes + deletesRAMUsed > freeTrigger) {
         if (infoStream) {
             message(L"  RAM: now balance allocations: usedMB=" + toMB(numBytesUsed) +
                     L" vs trigger=" + toMB(flushTrigger) +
@@ -1119,7 +1393,7 @@ void DocumentsWriter::balanceRAM() {
 
         bool any = true;
 
-        while (numBytesAlloc + deletesRAMUsed > freeLevel) {
+        while (numBytesAlloc - numPendingBytes + deletesRAMUsed > freeLevel) {
             {
                 SyncLock syncLock(this);
                 if (perDocAllocator->freeByteBlocks.empty() && byteBlockAllocator->freeByteBlocks.empty() &&
@@ -1263,7 +1537,8 @@ DocConsumerPtr DefaultIndexingChain::getChain(const DocumentsWriterPtr& document
                                              termVectorsWriter, TermsHashPtr())));
 
     DocInverterPtr docInverter(newLucene<DocInverter>(termsHash, newLucene<NormsWriter>()));
-    return newLucene<DocFieldProcessor>(documentsWriter, docInverter);
+    DocFieldConsumerPtr docValuesWriter(newLucene<DocValuesWriter>());
+    return newLucene<DocFieldProcessor>(documentsWriter, newLucene<DocFieldConsumers>(docInverter, docValuesWriter));
 }
 
 SkipDocWriter::~SkipDocWriter() {
@@ -1399,6 +1674,23 @@ bool WaitQueue::add(const DocWriterPtr& doc) {
     return doPause();
 }
 
+PendingFlush::PendingFlush(const SegmentWriteStatePtr& flushState, Collection<DocumentsWriterThreadStatePtr> threadStates,
+                           const BufferedDeletesPtr& deletes, int32_t docStoreOffset, int64_t bytesUsed) {
+    this->flushState = flushState;
+    this->threadStates = threadStates;
+    this->deletes = deletes;
+    this->docStoreOffset = docStoreOffset;
+    this->bytesUsed = bytesUsed;
+    this->useCompoundFile = false;
+    this->flushDeletes = false;
+    this->writing = false;
+    this->written = false;
+    this->aborted = false;
+}
+
+PendingFlush::~PendingFlush() {
+}
+
 ByteBlockAllocator::ByteBlockAllocator(const DocumentsWriterPtr& docWriter, int32_t blockSize) {
     this->blockSize = blockSize;
     this->freeByteBlocks = Collection<ByteArray>::newInstance();
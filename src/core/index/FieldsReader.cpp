@@ -7,6 +7,7 @@
 #include "LuceneInc.h"
 #include "FieldsReader.h"
 #include "BufferedIndexInput.h"
+#include "ByteArrayIndexInput.h"
 #include "IndexFileNames.h"
 #include "FieldsWriter.h"
 #include "FieldInfos.h"
@@ -16,6 +17,7 @@
 #include "Document.h"
 #include "Field.h"
 #include "CompressionTools.h"
+#include "LZ4.h"
 #include "MiscUtils.h"
 #include "StringUtils.h"
 #include "VariantUtils.h"
@@ -35,6 +37,8 @@ FieldsReader::FieldsReader(const FieldInfosPtr& fieldInfos, int32_t numTotalDocs
     this->docStoreOffset = docStoreOffset;
     this->cloneableFieldsStream = cloneableFieldsStream;
     this->cloneableIndexStream = cloneableIndexStream;
+    this->blockPointer = -1;
+    this->blockDocBase = 0;
     fieldsStream = boost::dynamic_pointer_cast<IndexInput>(cloneableFieldsStream->clone());
     indexStream = boost::dynamic_pointer_cast<IndexInput>(cloneableIndexStream->clone());
 }
@@ -58,6 +62,8 @@ void FieldsReader::ConstructReader(const DirectoryPtr& d, const String& segment,
     closed = false;
     format = 0;
     formatSize = 0;
+    blockPointer = -1;
+    blockDocBase = 0;
     docStoreOffset = docStoreOffset;
     LuceneException finally;
     try {
@@ -158,19 +164,28 @@ bool FieldsReader::canReadRawDocs() {
     return (format >= FieldsWriter::FORMAT_LUCENE_3_0_NO_COMPRESSED_FIELDS);
 }
 
+bool FieldsReader::canReadRawBlocks() {
+    return (format >= FieldsWriter::FORMAT_LUCENE_3_0_COMPRESSED_BLOCKS);
+}
+
 DocumentPtr FieldsReader::doc(int32_t n, const FieldSelectorPtr& fieldSelector) {
     seekIndex(n);
     int64_t position = indexStream->readLong();
-    fieldsStream->seek(position);
+    IndexInputPtr input(fieldsStream);
+    if (format >= FieldsWriter::FORMAT_LUCENE_3_0_COMPRESSED_BLOCKS) {
+        input = seekBlock(position, n);
+    } else {
+        fieldsStream->seek(position);
+    }
 
     DocumentPtr doc(newLucene<Document>());
-    int32_t numFields = fieldsStream->readVInt();
+    int32_t numFields = input->readVInt();
     for (int32_t i = 0; i < numFields; ++i) {
-        int32_t fieldNumber = fieldsStream->readVInt();
+        int32_t fieldNumber = input->readVInt();
         FieldInfoPtr fi = fieldInfos->fieldInfo(fieldNumber);
         FieldSelector::FieldSelectorResult acceptField = fieldSelector ? fieldSelector->accept(fi->name) : FieldSelector::SELECTOR_LOAD;
 
-        uint8_t bits = fieldsStream->readByte();
+        uint8_t bits = input->readByte();
         BOOST_ASSERT(bits <= FieldsWriter::FIELD_IS_COMPRESSED + FieldsWriter::FIELD_IS_TOKENIZED + FieldsWriter::FIELD_IS_BINARY);
 
         bool compressed = ((bits & FieldsWriter::FIELD_IS_COMPRESSED) != 0);
@@ -182,19 +197,19 @@ DocumentPtr FieldsReader::doc(int32_t n, const FieldSelectorPtr& fieldSelector)
         bool binary = ((bits & FieldsWriter::FIELD_IS_BINARY) != 0);
 
         if (acceptField == FieldSelector::SELECTOR_LOAD) {
-            addField(doc, fi, binary, compressed, tokenize);
+            addField(input, doc, fi, binary, compressed, tokenize);
         } else if (acceptField == FieldSelector::SELECTOR_LOAD_AND_BREAK) {
-            addField(doc, fi, binary, compressed, tokenize);
+            addField(input, doc, fi, binary, compressed, tokenize);
             break; // Get out of this loop
         } else if (acceptField == FieldSelector::SELECTOR_LAZY_LOAD) {
-            addFieldLazy(doc, fi, binary, compressed, tokenize);
+            addFieldLazy(input, doc, fi, binary, compressed, tokenize);
         } else if (acceptField == FieldSelector::SELECTOR_SIZE) {
-            skipField(binary, compressed, addFieldSize(doc, fi, binary, compressed));
+            skipField(input, binary, compressed, addFieldSize(input, doc, fi, binary, compressed));
         } else if (acceptField == FieldSelector::SELECTOR_SIZE_AND_BREAK) {
-            addFieldSize(doc, fi, binary, compressed);
+            addFieldSize(input, doc, fi, binary, compressed);
             break;
         } else {
-            skipField(binary, compressed);
+            skipField(input, binary, compressed);
         }
     }
 
@@ -202,6 +217,46 @@ DocumentPtr FieldsReader::doc(int32_t n, const FieldSelectorPtr& fieldSelector)
 }
 
 IndexInputPtr FieldsReader::rawDocs(Collection<int32_t> lengths, int32_t startDocID, int32_t numDocs) {
+    if (format >= FieldsWriter::FORMAT_LUCENE_3_0_COMPRESSED_BLOCKS) {
+        // raw documents are the decompressed bytes of each document, which only need copying when the
+        // documents span more than one block
+        ByteArray bytes;
+        int32_t upto = 0;
+        ByteArray firstBlock;
+        int64_t firstPointer = -1;
+        int32_t firstOffset = 0;
+        bool singleBlock = true;
+        for (int32_t count = 0; count < numDocs; ++count) {
+            seekIndex(startDocID + count);
+            int64_t pointer = indexStream->readLong();
+            int32_t docOffset = (int32_t)seekBlock(pointer, startDocID + count)->getFilePointer();
+            int32_t length = blockOffsets[startDocID + count + docStoreOffset - blockDocBase + 1] - docOffset;
+            lengths[count] = length;
+            if (count == 0) {
+                firstBlock = blockBytes;
+                firstPointer = pointer;
+                firstOffset = docOffset;
+            } else if (singleBlock && pointer != firstPointer) {
+                // copy the documents read so far out of the first block
+                singleBlock = false;
+                bytes = ByteArray::newInstance(MiscUtils::getNextSize(upto + length));
+                MiscUtils::arrayCopy(firstBlock.get(), firstOffset, bytes.get(), 0, upto);
+            }
+            if (!singleBlock) {
+                if (bytes.size() < upto + length) {
+                    bytes.resize(MiscUtils::getNextSize(upto + length));
+                }
+                MiscUtils::arrayCopy(blockBytes.get(), docOffset, bytes.get(), upto, length);
+            }
+            upto += length;
+        }
+        if (singleBlock) {
+            blockStream->seek(firstOffset);
+            return blockStream;
+        }
+        return newLucene<ByteArrayIndexInput>(bytes, upto);
+    }
+
     seekIndex(startDocID);
     int64_t startOffset = indexStream->readLong();
     int64_t lastOffset = startOffset;
@@ -219,25 +274,135 @@ IndexInputPtr FieldsReader::rawDocs(Collection<int32_t> lengths, int32_t startDo
     return fieldsStream;
 }
 
-void FieldsReader::skipField(bool binary, bool compressed) {
-    skipField(binary, compressed, fieldsStream->readVInt());
+int32_t FieldsReader::blockDocs(int32_t n, int32_t& firstDocID) {
+    seekIndex(n);
+    fieldsStream->seek(indexStream->readLong());
+    firstDocID = fieldsStream->readVInt() - docStoreOffset;
+    int32_t numDocs = fieldsStream->readVInt();
+    if (n < firstDocID || n >= firstDocID + numDocs) {
+        boost::throw_exception(CorruptIndexException(L"document " + StringUtils::toString(n) + L" is not in its stored fields block"));
+    }
+    return numDocs;
 }
 
-void FieldsReader::skipField(bool binary, bool compressed, int32_t toRead) {
+IndexInputPtr FieldsReader::rawBlock(int32_t n, int64_t& length) {
+    seekIndex(n);
+    fieldsStream->seek(indexStream->readLong());
+    int32_t docBase = fieldsStream->readVInt();
+    BOOST_ASSERT(docBase == n + docStoreOffset);
+    int64_t start = fieldsStream->getFilePointer();
+
+    // the block ends where the block of the next document in the store starts
+    int32_t nextDocID = docBase + fieldsStream->readVInt();
+    int64_t end = fieldsStream->length();
+    if (nextDocID < numTotalDocs) {
+        indexStream->seek(formatSize + (int64_t)nextDocID * 8);
+        end = indexStream->readLong();
+    }
+
+    length = end - start;
+    fieldsStream->seek(start);
+    return fieldsStream;
+}
+
+void FieldsReader::readBlock(int64_t pointer) {
+    if (pointer == blockPointer) {
+        return;
+    }
+    blockPointer = -1;
+
+    fieldsStream->seek(pointer);
+    blockDocBase = fieldsStream->readVInt();
+    int32_t numDocs = fieldsStream->readVInt();
+    if (numDocs <= 0) {
+        boost::throw_exception(CorruptIndexException(L"invalid stored fields block: " + StringUtils::toString(numDocs) + L" documents"));
+    }
+    if (!blockOffsets) {
+        blockOffsets = Collection<int32_t>::newInstance(numDocs + 1);
+    } else {
+        blockOffsets.resize(numDocs + 1);
+    }
+    blockOffsets[0] = 0;
+    for (int32_t i = 0; i < numDocs; ++i) {
+        blockOffsets[i + 1] = blockOffsets[i] + fieldsStream->readVInt();
+    }
+
+    int32_t mode = fieldsStream->readByte();
+    int32_t length = fieldsStream->readVInt();
+    int32_t uncompressedLength = blockOffsets[numDocs];
+
+    // every block gets a new array, as lazy fields may still refer to the previous one
+    ByteArray bytes;
+    if (mode == FieldsWriter::COMPRESSION_NONE) {
+        if (length != uncompressedLength) {
+            boost::throw_exception(CorruptIndexException(L"stored fields block length mismatch"));
+        }
+        bytes = ByteArray::newInstance(length);
+        fieldsStream->readBytes(bytes.get(), 0, length);
+    } else if (mode == FieldsWriter::COMPRESSION_FAST) {
+        if (!compressedBytes || compressedBytes.size() < length) {
+            compressedBytes.resize(MiscUtils::getNextSize(length));
+        }
+        fieldsStream->readBytes(compressedBytes.get(), 0, length);
+        bytes = ByteArray::newInstance(uncompressedLength);
+        int32_t decompressedLength = 0;
+        try {
+            decompressedLength = LZ4::decompress(compressedBytes.get(), length, bytes.get(), uncompressedLength);
+        } catch (LuceneException& e) {
+            boost::throw_exception(CorruptIndexException(L"field data are in wrong format [" + e.getError() + L"]"));
+        }
+        if (decompressedLength != uncompressedLength) {
+            boost::throw_exception(CorruptIndexException(L"stored fields block length mismatch"));
+        }
+    } else if (mode == FieldsWriter::COMPRESSION_HIGH) {
+        ByteArray compressed(ByteArray::newInstance(length));
+        fieldsStream->readBytes(compressed.get(), 0, length);
+        bytes = uncompress(compressed);
+        if (bytes.size() != uncompressedLength) {
+            boost::throw_exception(CorruptIndexException(L"stored fields block length mismatch"));
+        }
+    } else {
+        boost::throw_exception(CorruptIndexException(L"unknown stored fields compression mode: " + StringUtils::toString(mode)));
+    }
+
+    blockBytes = bytes;
+    blockStream = newLucene<ByteArrayIndexInput>(blockBytes);
+    blockPointer = pointer;
+}
+
+IndexInputPtr FieldsReader::seekBlock(int64_t pointer, int32_t n) {
+    readBlock(pointer);
+    int32_t index = n + docStoreOffset - blockDocBase;
+    if (index < 0 || index >= blockOffsets.size() - 1) {
+        boost::throw_exception(CorruptIndexException(L"document " + StringUtils::toString(n) + L" is not in its stored fields block"));
+    }
+    blockStream->seek(blockOffsets[index]);
+    return blockStream;
+}
+
+void FieldsReader::skipField(const IndexInputPtr& input, bool binary, bool compressed) {
+    skipField(input, binary, compressed, input->readVInt());
+}
+
+void FieldsReader::skipField(const IndexInputPtr& input, bool binary, bool compressed, int32_t toRead) {
     if (format >= FieldsWriter::FORMAT_VERSION_UTF8_LENGTH_IN_BYTES || binary || compressed) {
-        fieldsStream->seek(fieldsStream->getFilePointer() + toRead);
+        input->seek(input->getFilePointer() + toRead);
     } else {
         // We need to skip chars.  This will slow us down, but still better
-        fieldsStream->skipChars(toRead);
+        input->skipChars(toRead);
     }
 }
 
-void FieldsReader::addFieldLazy(const DocumentPtr& doc, const FieldInfoPtr& fi, bool binary, bool compressed, bool tokenize) {
+void FieldsReader::addFieldLazy(const IndexInputPtr& input, const DocumentPtr& doc, const FieldInfoPtr& fi, bool binary, bool compressed, bool tokenize) {
+    // lazy fields of a compressed block keep hold of the decompressed block rather than reading it again
+    ByteArray block(format >= FieldsWriter::FORMAT_LUCENE_3_0_COMPRESSED_BLOCKS ? blockBytes : ByteArray());
     if (binary) {
-        int32_t toRead = fieldsStream->readVInt();
-        int64_t pointer = fieldsStream->getFilePointer();
-        doc->add(newLucene<LazyField>(shared_from_this(), fi->name, Field::STORE_YES, toRead, pointer, binary, compressed));
-        fieldsStream->seek(pointer + toRead);
+        int32_t toRead = input->readVInt();
+        int64_t pointer = input->getFilePointer();
+        LazyFieldPtr field(newLucene<LazyField>(shared_from_this(), fi->name, Field::STORE_YES, toRead, pointer, binary, compressed));
+        field->block = block;
+        doc->add(field);
+        input->seek(pointer + toRead);
     } else {
         Field::Store store = Field::STORE_YES;
         Field::Index index = Field::toIndex(fi->isIndexed, tokenize);
@@ -245,23 +410,25 @@ void FieldsReader::addFieldLazy(const DocumentPtr& doc, const FieldInfoPtr& fi,
 
         AbstractFieldPtr f;
         if (compressed) {
-            int32_t toRead = fieldsStream->readVInt();
-            int64_t pointer = fieldsStream->getFilePointer();
+            int32_t toRead = input->readVInt();
+            int64_t pointer = input->getFilePointer();
             f = newLucene<LazyField>(shared_from_this(), fi->name, store, toRead, pointer, binary, compressed);
             // skip over the part that we aren't loading
-            fieldsStream->seek(pointer + toRead);
+            input->seek(pointer + toRead);
             f->setOmitNorms(fi->omitNorms);
             f->setOmitTermFreqAndPositions(fi->omitTermFreqAndPositions);
         } else {
-            int32_t length = fieldsStream->readVInt();
-            int64_t pointer = fieldsStream->getFilePointer();
+            int32_t length = input->readVInt();
+            int64_t pointer = input->getFilePointer();
             // skip ahead of where we are by the length of what is stored
             if (format >= FieldsWriter::FORMAT_VERSION_UTF8_LENGTH_IN_BYTES) {
-                fieldsStream->seek(pointer + length);
+                input->seek(pointer + length);
             } else {
-                fieldsStream->skipChars(length);
+                input->skipChars(length);
             }
-            f = newLucene<LazyField>(shared_from_this(), fi->name, store, index, termVector, length, pointer, binary, compressed);
+            LazyFieldPtr field(newLucene<LazyField>(shared_from_this(), fi->name, store, index, termVector, length, pointer, binary, compressed));
+            field->block = block;
+            f = field;
             f->setOmitNorms(fi->omitNorms);
             f->setOmitTermFreqAndPositions(fi->omitTermFreqAndPositions);
         }
@@ -270,12 +437,12 @@ void FieldsReader::addFieldLazy(const DocumentPtr& doc, const FieldInfoPtr& fi,
     }
 }
 
-void FieldsReader::addField(const DocumentPtr& doc, const FieldInfoPtr& fi, bool binary, bool compressed, bool tokenize) {
+void FieldsReader::addField(const IndexInputPtr& input, const DocumentPtr& doc, const FieldInfoPtr& fi, bool binary, bool compressed, bool tokenize) {
     // we have a binary stored field, and it may be compressed
     if (binary) {
-        int32_t toRead = fieldsStream->readVInt();
+        int32_t toRead = input->readVInt();
         ByteArray b(ByteArray::newInstance(toRead));
-        fieldsStream->readBytes(b.get(), 0, b.size());
+        input->readBytes(b.get(), 0, b.size());
         if (compressed) {
             doc->add(newLucene<Field>(fi->name, uncompress(b), Field::STORE_YES));
         } else {
@@ -288,15 +455,15 @@ void FieldsReader::addField(const DocumentPtr& doc, const FieldInfoPtr& fi, bool
 
         AbstractFieldPtr f;
         if (compressed) {
-            int32_t toRead = fieldsStream->readVInt();
+            int32_t toRead = input->readVInt();
 
             ByteArray b(ByteArray::newInstance(toRead));
-            fieldsStream->readBytes(b.get(), 0, b.size());
+            input->readBytes(b.get(), 0, b.size());
             f = newLucene<Field>(fi->name, uncompressString(b), store, index, termVector);
             f->setOmitTermFreqAndPositions(fi->omitTermFreqAndPositions);
             f->setOmitNorms(fi->omitNorms);
         } else {
-            f = newLucene<Field>(fi->name, fieldsStream->readString(), store, index, termVector);
+            f = newLucene<Field>(fi->name, input->readString(), store, index, termVector);
             f->setOmitTermFreqAndPositions(fi->omitTermFreqAndPositions);
             f->setOmitNorms(fi->omitNorms);
         }
@@ -305,8 +472,8 @@ void FieldsReader::addField(const DocumentPtr& doc, const FieldInfoPtr& fi, bool
     }
 }
 
-int32_t FieldsReader::addFieldSize(const DocumentPtr& doc, const FieldInfoPtr& fi, bool binary, bool compressed) {
-    int32_t size = fieldsStream->readVInt();
+int32_t FieldsReader::addFieldSize(const IndexInputPtr& input, const DocumentPtr& doc, const FieldInfoPtr& fi, bool binary, bool compressed) {
+    int32_t size = input->readVInt();
     int32_t bytesize = (binary || compressed) ? size : 2 * size;
     ByteArray sizebytes(ByteArray::newInstance(4));
     sizebytes[0] = (uint8_t)MiscUtils::unsignedShift(bytesize, 24);
@@ -365,6 +532,9 @@ LazyField::~LazyField() {
 }
 
 IndexInputPtr LazyField::getFieldStream() {
+    if (block) {
+        return newLucene<ByteArrayIndexInput>(block);
+    }
     FieldsReaderPtr reader(_reader);
     IndexInputPtr localFieldsStream = reader->fieldsStreamTL.get();
     if (!localFieldsStream) {
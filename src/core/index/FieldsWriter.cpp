@@ -14,7 +14,11 @@
 #include "FieldInfos.h"
 #include "Fieldable.h"
 #include "Document.h"
+#include "CompressionTools.h"
+#include "LZ4.h"
 #include "TestPoint.h"
+#include "MiscUtils.h"
+#include "StringUtils.h"
 
 namespace Lucene {
 
@@ -25,13 +29,25 @@ const uint8_t FieldsWriter::FIELD_IS_COMPRESSED = 0x4;
 const int32_t FieldsWriter::FORMAT = 0; // Original format
 const int32_t FieldsWriter::FORMAT_VERSION_UTF8_LENGTH_IN_BYTES = 1; // Changed strings to UTF8
 const int32_t FieldsWriter::FORMAT_LUCENE_3_0_NO_COMPRESSED_FIELDS = 2; // Lucene 3.0: Removal of compressed fields
+const int32_t FieldsWriter::FORMAT_LUCENE_3_0_COMPRESSED_BLOCKS = 3; // Documents compressed together in blocks
 
 // NOTE: if you introduce a new format, make it 1 higher than the current one, and always change this if you
 // switch to a new format!
-const int32_t FieldsWriter::FORMAT_CURRENT = FieldsWriter::FORMAT_LUCENE_3_0_NO_COMPRESSED_FIELDS;
+const int32_t FieldsWriter::FORMAT_CURRENT = FieldsWriter::FORMAT_LUCENE_3_0_COMPRESSED_BLOCKS;
+
+const int32_t FieldsWriter::BLOCK_SIZE = 16384;
+
+const int32_t FieldsWriter::COMPRESSION_NONE = 0;
+const int32_t FieldsWriter::COMPRESSION_FAST = 1;
+const int32_t FieldsWriter::COMPRESSION_HIGH = 2;
 
 FieldsWriter::FieldsWriter(const DirectoryPtr& d, const String& segment, const FieldInfosPtr& fn) {
     fieldInfos = fn;
+    compressionMode = COMPRESSION_FAST;
+    blockStream = newLucene<RAMOutputStream>();
+    blockLengths = Collection<int32_t>::newInstance(64);
+    blockDocs = 0;
+    numDocsInStore = 0;
 
     bool success = false;
     String fieldsName(segment + L"." + IndexFileNames::FIELDS_EXTENSION());
@@ -81,6 +97,11 @@ FieldsWriter::FieldsWriter(const IndexOutputPtr& fdx, const IndexOutputPtr& fdt,
     fieldsStream = fdt;
     indexStream = fdx;
     doClose = false;
+    compressionMode = COMPRESSION_FAST;
+    blockStream = newLucene<RAMOutputStream>();
+    blockLengths = Collection<int32_t>::newInstance(64);
+    blockDocs = 0;
+    numDocsInStore = 0;
 }
 
 FieldsWriter::~FieldsWriter() {
@@ -90,19 +111,96 @@ void FieldsWriter::setFieldsStream(const IndexOutputPtr& stream) {
     this->fieldsStream = stream;
 }
 
+void FieldsWriter::setCompressionMode(int32_t mode) {
+    if (mode < COMPRESSION_NONE || mode > COMPRESSION_HIGH) {
+        boost::throw_exception(IllegalArgumentException(L"unknown stored fields compression mode: " + StringUtils::toString(mode)));
+    }
+    compressionMode = mode;
+}
+
+int32_t FieldsWriter::getCompressionMode() {
+    return compressionMode;
+}
+
 void FieldsWriter::flushDocument(int32_t numStoredFields, const RAMOutputStreamPtr& buffer) {
     TestScope testScope(L"FieldsWriter", L"flushDocument");
-    indexStream->writeLong(fieldsStream->getFilePointer());
-    fieldsStream->writeVInt(numStoredFields);
-    buffer->writeTo(fieldsStream);
+    int64_t start = blockStream->getFilePointer();
+    blockStream->writeVInt(numStoredFields);
+    buffer->writeTo(blockStream);
+    finishDocument(start);
 }
 
 void FieldsWriter::skipDocument() {
+    int64_t start = blockStream->getFilePointer();
+    blockStream->writeVInt(0);
+    finishDocument(start);
+}
+
+void FieldsWriter::finishDocument(int64_t start) {
+    // the pending block will be written at the current end of the fields stream
     indexStream->writeLong(fieldsStream->getFilePointer());
-    fieldsStream->writeVInt(0);
+    if (blockDocs == blockLengths.size()) {
+        blockLengths.resize(MiscUtils::getNextSize(blockDocs + 1));
+    }
+    blockLengths[blockDocs++] = (int32_t)(blockStream->getFilePointer() - start);
+    if (blockStream->getFilePointer() >= BLOCK_SIZE) {
+        flushBlock();
+    }
+}
+
+void FieldsWriter::flushBlock() {
+    if (blockDocs == 0) {
+        return;
+    }
+
+    int32_t length = (int32_t)blockStream->getFilePointer();
+    if (!blockBytes || blockBytes.size() < length) {
+        blockBytes.resize(MiscUtils::getNextSize(length));
+    }
+    blockStream->writeTo(blockBytes.get(), 0);
+
+    // block header: the first document's number in this store and the length of every document
+    fieldsStream->writeVInt(numDocsInStore);
+    fieldsStream->writeVInt(blockDocs);
+    for (int32_t i = 0; i < blockDocs; ++i) {
+        fieldsStream->writeVInt(blockLengths[i]);
+    }
+
+    uint8_t* data = blockBytes.get();
+    int32_t dataLength = length;
+    int32_t mode = COMPRESSION_NONE;
+    ByteArray compressed;
+    if (compressionMode == COMPRESSION_FAST) {
+        int32_t maxLength = LZ4::maxCompressedLength(length);
+        if (!compressedBytes || compressedBytes.size() < maxLength) {
+            compressedBytes.resize(MiscUtils::getNextSize(maxLength));
+        }
+        int32_t compressedLength = LZ4::compress(data, length, compressedBytes.get());
+        if (compressedLength < length) {
+            data = compressedBytes.get();
+            dataLength = compressedLength;
+            mode = COMPRESSION_FAST;
+        }
+    } else if (compressionMode == COMPRESSION_HIGH) {
+        compressed = CompressionTools::compress(data, 0, length);
+        if (compressed.size() < length) {
+            data = compressed.get();
+            dataLength = compressed.size();
+            mode = COMPRESSION_HIGH;
+        }
+    }
+
+    fieldsStream->writeByte((uint8_t)mode);
+    fieldsStream->writeVInt(dataLength);
+    fieldsStream->writeBytes(data, dataLength);
+
+    numDocsInStore += blockDocs;
+    blockDocs = 0;
+    blockStream->reset();
 }
 
 void FieldsWriter::flush() {
+    flushBlock();
     indexStream->flush();
     fieldsStream->flush();
 }
@@ -110,11 +208,20 @@ void FieldsWriter::flush() {
 void FieldsWriter::close() {
     if (doClose) {
         LuceneException finally;
+        if (fieldsStream && indexStream) {
+            try {
+                flushBlock();
+            } catch (LuceneException& e) {
+                finally = e;
+            }
+        }
         if (fieldsStream) {
             try {
                 fieldsStream->close();
             } catch (LuceneException& e) {
-                finally = e;
+                if (finally.isNull()) { // throw first exception hit
+                    finally = e;
+                }
             }
             fieldsStream.reset();
         }
@@ -133,7 +240,11 @@ void FieldsWriter::close() {
 }
 
 void FieldsWriter::writeField(const FieldInfoPtr& fi, const FieldablePtr& field) {
-    fieldsStream->writeVInt(fi->number);
+    writeField(fieldsStream, fi, field);
+}
+
+void FieldsWriter::writeField(const IndexOutputPtr& output, const FieldInfoPtr& fi, const FieldablePtr& field) {
+    output->writeVInt(fi->number);
     uint8_t bits = 0;
     if (field->isTokenized()) {
         bits |= FIELD_IS_TOKENIZED;
@@ -142,33 +253,42 @@ void FieldsWriter::writeField(const FieldInfoPtr& fi, const FieldablePtr& field)
         bits |= FIELD_IS_BINARY;
     }
 
-    fieldsStream->writeByte(bits);
+    output->writeByte(bits);
 
     if (field->isBinary()) {
         ByteArray data(field->getBinaryValue());
         int32_t len = field->getBinaryLength();
         int32_t offset = field->getBinaryOffset();
 
-        fieldsStream->writeVInt(len);
-        fieldsStream->writeBytes(data.get(), offset, len);
+        output->writeVInt(len);
+        output->writeBytes(data.get(), offset, len);
     } else {
-        fieldsStream->writeString(field->stringValue());
+        output->writeString(field->stringValue());
     }
 }
 
 void FieldsWriter::addRawDocuments(const IndexInputPtr& stream, Collection<int32_t> lengths, int32_t numDocs) {
+    for (int32_t i = 0; i < numDocs; ++i) {
+        int64_t start = blockStream->getFilePointer();
+        blockStream->copyBytes(stream, lengths[i]);
+        finishDocument(start);
+    }
+}
+
+void FieldsWriter::addRawBlock(const IndexInputPtr& stream, int32_t numDocs, int64_t length) {
+    flushBlock();
     int64_t position = fieldsStream->getFilePointer();
-    int64_t start = position;
     for (int32_t i = 0; i < numDocs; ++i) {
         indexStream->writeLong(position);
-        position += lengths[i];
     }
-    fieldsStream->copyBytes(stream, position - start);
-    BOOST_ASSERT(fieldsStream->getFilePointer() == position);
+    // the copied block keeps its header apart from the number of its first document
+    fieldsStream->writeVInt(numDocsInStore);
+    fieldsStream->copyBytes(stream, length);
+    numDocsInStore += numDocs;
 }
 
 void FieldsWriter::addDocument(const DocumentPtr& doc) {
-    indexStream->writeLong(fieldsStream->getFilePointer());
+    int64_t start = blockStream->getFilePointer();
 
     int32_t storedCount = 0;
     Collection<FieldablePtr> fields(doc->getFields());
@@ -177,13 +297,15 @@ void FieldsWriter::addDocument(const DocumentPtr& doc) {
             ++storedCount;
         }
     }
-    fieldsStream->writeVInt(storedCount);
+    blockStream->writeVInt(storedCount);
 
     for (Collection<FieldablePtr>::iterator field = fields.begin(); field != fields.end(); ++field) {
         if ((*field)->isStored()) {
-            writeField(fieldInfos->fieldInfo((*field)->name()), *field);
+            writeField(blockStream, fieldInfos->fieldInfo((*field)->name()), *field);
         }
     }
+
+    finishDocument(start);
 }
 
 }
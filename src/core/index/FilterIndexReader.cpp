@@ -85,6 +85,16 @@ void FilterIndexReader::norms(const String& field, ByteArray norms, int32_t offs
     in->norms(field, norms, offset);
 }
 
+PackedIntsPtr FilterIndexReader::getNumericDocValues(const String& field) {
+    ensureOpen();
+    return in->getNumericDocValues(field);
+}
+
+StringIndexPtr FilterIndexReader::getSortedDocValues(const String& field) {
+    ensureOpen();
+    return in->getSortedDocValues(field);
+}
+
 void FilterIndexReader::doSetNorm(int32_t doc, const String& field, uint8_t value) {
     in->setNorm(doc, field, value);
 }
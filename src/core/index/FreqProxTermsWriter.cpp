@@ -19,6 +19,8 @@
 #include "FormatPostingsTermsConsumer.h"
 #include "FormatPostingsPositionsConsumer.h"
 #include "FieldInfo.h"
+#include "FieldInfos.h"
+#include "SegmentWriteState.h"
 #include "ByteSliceReader.h"
 #include "RawPostingList.h"
 #include "DocumentsWriter.h"
@@ -83,7 +85,7 @@ void FreqProxTermsWriter::flush(MapTermsHashConsumerPerThreadCollectionTermsHash
 
     int32_t numAllFields = allFields.size();
 
-    FormatPostingsFieldsConsumerPtr consumer(newLucene<FormatPostingsFieldsWriter>(state, fieldInfos));
+    FormatPostingsFieldsConsumerPtr consumer(newLucene<FormatPostingsFieldsWriter>(state, state->fieldInfos));
 
     // Current writer chain:
     // FormatPostingsFieldsConsumer
@@ -97,8 +99,10 @@ void FreqProxTermsWriter::flush(MapTermsHashConsumerPerThreadCollectionTermsHash
 
     int32_t start = 0;
     while (start < numAllFields) {
-        FieldInfoPtr fieldInfo(allFields[start]->fieldInfo);
-        String fieldName(fieldInfo->name);
+        String fieldName(allFields[start]->fieldInfo->name);
+
+        // Write with the flush's own snapshot of the field, as other threads may be updating the shared one
+        FieldInfoPtr fieldInfo(state->fieldInfos->fieldInfo(fieldName));
 
         int32_t end = start + 1;
         while (end < numAllFields && allFields[end]->fieldInfo->name == fieldName) {
@@ -112,11 +116,12 @@ void FreqProxTermsWriter::flush(MapTermsHashConsumerPerThreadCollectionTermsHash
             // Aggregate the storePayload as seen by the same field across multiple threads
             if (fields[i - start]->hasPayloads) {
                 fieldInfo->storePayloads = true;
+                fields[i - start]->fieldInfo->storePayloads = true;
             }
         }
 
         // If this field has postings then add them to the segment
-        appendPostings(fields, consumer);
+        appendPostings(fieldInfo, fields, consumer);
 
         for (int32_t i = 0; i < fields.size(); ++i) {
             TermsHashPerFieldPtr perField(fields[i]->_termsHashPerField);
@@ -136,7 +141,7 @@ void FreqProxTermsWriter::flush(MapTermsHashConsumerPerThreadCollectionTermsHash
     consumer->finish();
 }
 
-void FreqProxTermsWriter::appendPostings(Collection<FreqProxTermsWriterPerFieldPtr> fields, const FormatPostingsFieldsConsumerPtr& consumer) {
+void FreqProxTermsWriter::appendPostings(const FieldInfoPtr& fieldInfo, Collection<FreqProxTermsWriterPerFieldPtr> fields, const FormatPostingsFieldsConsumerPtr& consumer) {
     TestScope testScope(L"FreqProxTermsWriter", L"appendPostings");
     int32_t numFields = fields.size();
 
@@ -153,11 +158,11 @@ void FreqProxTermsWriter::appendPostings(Collection<FreqProxTermsWriterPerFieldP
         BOOST_ASSERT(result);
     }
 
-    FormatPostingsTermsConsumerPtr termsConsumer(consumer->addField(fields[0]->fieldInfo));
+    FormatPostingsTermsConsumerPtr termsConsumer(consumer->addField(fieldInfo));
 
     Collection<FreqProxFieldMergeStatePtr> termStates(Collection<FreqProxFieldMergeStatePtr>::newInstance(numFields));
 
-    bool currentFieldOmitTermFreqAndPositions = fields[0]->fieldInfo->omitTermFreqAndPositions;
+    bool currentFieldOmitTermFreqAndPositions = fieldInfo->omitTermFreqAndPositions;
 
     while (numFields > 0) {
         // Get the next term to merge
@@ -188,6 +188,16 @@ bool IndexReader::hasNorms(const String& field) {
     return norms(field);
 }
 
+PackedIntsPtr IndexReader::getNumericDocValues(const String& field) {
+    ensureOpen();
+    return PackedIntsPtr();
+}
+
+StringIndexPtr IndexReader::getSortedDocValues(const String& field) {
+    ensureOpen();
+    return StringIndexPtr();
+}
+
 void IndexReader::setNorm(int32_t doc, const String& field, uint8_t value) {
     SyncLock syncLock(this);
     ensureOpen();
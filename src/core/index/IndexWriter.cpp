@@ -15,6 +15,8 @@
 #include "IndexFileNames.h"
 #include "Lock.h"
 #include "SegmentInfo.h"
+#include "SegmentWriteState.h"
+#include "FieldInfos.h"
 #include "SegmentReader.h"
 #include "ReadOnlyDirectoryReader.h"
 #include "BufferedIndexInput.h"
@@ -24,6 +26,7 @@
 #include "ConcurrentMergeScheduler.h"
 #include "CompoundFileWriter.h"
 #include "SegmentMerger.h"
+#include "FieldsWriter.h"
 #include "DateTools.h"
 #include "Constants.h"
 #include "InfoStream.h"
@@ -54,6 +57,12 @@ const int32_t IndexWriter::DEFAULT_MAX_BUFFERED_DOCS = IndexWriter::DISABLE_AUTO
 /// Default value is 16 MB (which means flush when buffered docs consume 16 MB RAM).
 const double IndexWriter::DEFAULT_RAM_BUFFER_SIZE_MB = 16.0;
 
+/// Default value is 5.
+const int32_t IndexWriter::DEFAULT_MAX_THREAD_STATES = 5;
+
+/// Default value is 1.
+const int32_t IndexWriter::DEFAULT_MAX_PENDING_FLUSHES = 1;
+
 /// Disabled by default (because IndexWriter flushes by RAM usage by default).
 const int32_t IndexWriter::DEFAULT_MAX_BUFFERED_DELETE_TERMS = IndexWriter::DISABLE_AUTO_FLUSH;
 
@@ -156,6 +165,7 @@ void IndexWriter::initialize() {
     mergeScheduler = newLucene<ConcurrentMergeScheduler>();
     similarity = Similarity::getDefault();
     termIndexInterval = DEFAULT_TERM_INDEX_INTERVAL;
+    storedFieldsCompression = FieldsWriter::COMPRESSION_FAST;
     commitLock  = newInstance<Synchronize>();
 
     if (!indexingChain) {
@@ -227,6 +237,7 @@ void IndexWriter::initialize() {
         docWriter = newLucene<DocumentsWriter>(directory, shared_from_this(), indexingChain);
         docWriter->setInfoStream(infoStream);
         docWriter->setMaxFieldLength(maxFieldLength);
+        docWriter->setStoredFieldsCompression(storedFieldsCompression);
 
         // Default deleter (for backwards compatibility) is KeepOnlyLastCommitDeleter
         deleter = newLucene<IndexFileDeleter>(directory, deletionPolicy ? deletionPolicy : newLucene<KeepOnlyLastCommitDeletionPolicy>(), segmentInfos, infoStream, docWriter, synced);
@@ -315,6 +326,11 @@ int32_t IndexWriter::numDeletedDocs(const SegmentInfoPtr& info) {
     return deletedDocs;
 }
 
+SetSegmentInfo IndexWriter::getMergingSegments() {
+    SyncLock syncLock(this);
+    return SetSegmentInfo::newInstance(mergingSegments.begin(), mergingSegments.end());
+}
+
 void IndexWriter::acquireWrite() {
     SyncLock syncLock(this);
     BOOST_ASSERT(writeThread != LuceneThread::currentId());
@@ -436,6 +452,21 @@ int32_t IndexWriter::getTermIndexInterval() {
     return termIndexInterval;
 }
 
+void IndexWriter::setStoredFieldsCompression(int32_t mode) {
+    ensureOpen();
+    if (mode < FieldsWriter::COMPRESSION_NONE || mode > FieldsWriter::COMPRESSION_HIGH) {
+        boost::throw_exception(IllegalArgumentException(L"unknown stored fields compression mode: " + StringUtils::toString(mode)));
+    }
+    this->storedFieldsCompression = mode;
+    docWriter->setStoredFieldsCompression(mode);
+}
+
+int32_t IndexWriter::getStoredFieldsCompression() {
+    // We pass false because this method is called by SegmentMerger while we are in the process of closing
+    ensureOpen(false);
+    return storedFieldsCompression;
+}
+
 void IndexWriter::setRollbackSegmentInfos(const SegmentInfosPtr& infos) {
     SyncLock syncLock(this);
     rollbackSegmentInfos = boost::dynamic_pointer_cast<SegmentInfos>(infos->clone());
@@ -562,6 +593,38 @@ int32_t IndexWriter::getMaxBufferedDocs() {
     return docWriter->getMaxBufferedDocs();
 }
 
+void IndexWriter::setMaxThreadStates(int32_t maxThreadStates) {
+    ensureOpen();
+    if (maxThreadStates < 1) {
+        boost::throw_exception(IllegalArgumentException(L"maxThreadStates must be at least 1"));
+    }
+    docWriter->setMaxThreadStates(maxThreadStates);
+    if (infoStream) {
+        message(L"setMaxThreadStates " + StringUtils::toString(maxThreadStates));
+    }
+}
+
+int32_t IndexWriter::getMaxThreadStates() {
+    ensureOpen();
+    return docWriter->getMaxThreadStates();
+}
+
+void IndexWriter::setMaxPendingFlushes(int32_t maxPendingFlushes) {
+    ensureOpen();
+    if (maxPendingFlushes < 0) {
+        boost::throw_exception(IllegalArgumentException(L"maxPendingFlushes must be >= 0"));
+    }
+    docWriter->setMaxPendingFlushes(maxPendingFlushes);
+    if (infoStream) {
+        message(L"setMaxPendingFlushes " + StringUtils::toString(maxPendingFlushes));
+    }
+}
+
+int32_t IndexWriter::getMaxPendingFlushes() {
+    ensureOpen();
+    return docWriter->getMaxPendingFlushes();
+}
+
 void IndexWriter::setRAMBufferSizeMB(double mb) {
     if (mb > 2048.0) {
         boost::throw_exception(IllegalArgumentException(L"ramBufferSize " + StringUtils::toString(mb) + L" is too large; should be comfortably less than 2048"));
@@ -931,7 +994,7 @@ void IndexWriter::addDocument(const DocumentPtr& doc, const AnalyzerPtr& analyze
         }
         finally.throwException();
         if (doFlush) {
-            flush(true, false, false);
+            flushBufferedDocs();
         }
     } catch (std::bad_alloc& oom) {
         boost::throw_exception(handleOOM(oom, L"addDocument"));
@@ -1013,7 +1076,7 @@ void IndexWriter::updateDocument(const TermPtr& term, const DocumentPtr& doc, co
         }
         finally.throwException();
         if (doFlush) {
-            flush(true, false, false);
+            flushBufferedDocs();
         }
     } catch (std::bad_alloc& oom) {
         boost::throw_exception(handleOOM(oom, L"updateDocument"));
@@ -1173,14 +1236,16 @@ void IndexWriter::expungeDeletes(bool doWait) {
     {
         SyncLock syncLock(this);
         spec = mergePolicy->findMergesToExpungeDeletes(segmentInfos);
-        for (Collection<OneMergePtr>::iterator merge = spec->merges.begin(); merge != spec->merges.end(); ++merge) {
-            registerMerge(*merge);
+        if (spec) {
+            for (Collection<OneMergePtr>::iterator merge = spec->merges.begin(); merge != spec->merges.end(); ++merge) {
+                registerMerge(*merge);
+            }
         }
     }
 
     mergeScheduler->merge(shared_from_this());
 
-    if (doWait) {
+    if (spec && doWait) {
         {
             SyncLock syncLock(this);
             bool running = true;
@@ -2104,6 +2169,12 @@ bool IndexWriter::doFlushInternal(bool flushDocStores, bool flushDeletes) {
 
     BOOST_ASSERT(testPoint(L"startDoFlush"));
 
+    // Segments frozen by other threads must go into the index first, in order
+    while (docWriter->numPendingFlushes() > 0) {
+        docWriter->waitForPendingFlush();
+        publishFlushedSegments();
+    }
+
     doBeforeFlush();
 
     ++flushCount;
@@ -2264,6 +2335,143 @@ bool IndexWriter::doFlushInternal(bool flushDocStores, bool flushDeletes) {
     return flushDocs;
 }
 
+void IndexWriter::flushBufferedDocs() {
+    TestScope testScope(L"IndexWriter", L"doFlush");
+    ensureOpen(false);
+
+    DocumentsWriterPtr docWriter(this->docWriter);
+    if (docWriter->getMaxPendingFlushes() == 0) {
+        flush(true, false, false);
+        return;
+    }
+
+    PendingFlushPtr pendingFlush;
+    {
+        SyncLock syncLock(this);
+        LuceneException finally;
+        try {
+            if (hitOOM) {
+                boost::throw_exception(IllegalStateException(L"this writer hit an OutOfMemoryError; cannot flush"));
+            }
+
+            // Publish what other threads have written, and hold this thread back while too many segments
+            // are still waiting to be written
+            publishFlushedSegments();
+            while (docWriter->numPendingFlushes() >= docWriter->getMaxPendingFlushes()) {
+                docWriter->waitForPendingFlush();
+                publishFlushedSegments();
+            }
+
+            bool flushDeletes = docWriter->doApplyDeletes();
+
+            pendingFlush = docWriter->freezeBufferedDocs();
+            if (pendingFlush) {
+                try {
+                    doBeforeFlush();
+                    ++flushCount;
+
+                    SegmentWriteStatePtr state(pendingFlush->flushState);
+                    if (infoStream) {
+                        message(L" flush: segment=" + state->segmentName +
+                                L" docStoreSegment=" + state->docStoreSegmentName +
+                                L" docStoreOffset=" + StringUtils::toString(pendingFlush->docStoreOffset) +
+                                L" flushDeletes=" + StringUtils::toString(flushDeletes) +
+                                L" numDocs=" + StringUtils::toString(state->numDocs) +
+                                L" pendingFlushes=" + StringUtils::toString(docWriter->numPendingFlushes()));
+                    }
+
+                    // Doc stores stay open to be shared with the next segment
+                    SegmentInfoPtr newSegment(newLucene<SegmentInfo>(state->segmentName, state->numDocs, directory, false, true, pendingFlush->docStoreOffset, state->docStoreSegmentName, false, state->fieldInfos->hasProx()));
+                    setDiagnostics(newSegment, L"flush");
+                    pendingFlush->segmentInfo = newSegment;
+                    pendingFlush->useCompoundFile = mergePolicy->useCompoundFile(segmentInfos, newSegment);
+                    pendingFlush->flushDeletes = flushDeletes;
+                } catch (LuceneException&) {
+                    // Nobody will write this segment, so discard it rather than leave others waiting for it
+                    docWriter->abort();
+                    throw;
+                }
+            }
+        } catch (std::bad_alloc& oom) {
+            finally = handleOOM(oom, L"doFlush");
+        } catch (LuceneException& e) {
+            finally = e;
+        }
+        if (!pendingFlush) {
+            docWriter->clearFlushPending();
+        }
+        finally.throwException();
+    }
+
+    if (!pendingFlush) {
+        // Nothing was buffered; the flush was triggered by buffered deletes alone
+        flush(true, false, false);
+        return;
+    }
+
+    // Write the segment without holding our lock, so other threads keep indexing meanwhile
+    bool success = false;
+    LuceneException finally;
+    try {
+        docWriter->writePendingFlush(pendingFlush);
+        success = true;
+    } catch (LuceneException& e) {
+        finally = e;
+    }
+    if (!success) {
+        SyncLock syncLock(this);
+        if (infoStream) {
+            message(L"hit exception flushing segment " + pendingFlush->flushState->segmentName);
+        }
+        deleter->refresh(pendingFlush->flushState->segmentName);
+    }
+    finally.throwException();
+
+    {
+        SyncLock syncLock(this);
+        publishFlushedSegments();
+        if (this->docWriter && docWriter->doBalanceRAM()) {
+            docWriter->balanceRAM();
+        }
+    }
+
+    maybeMerge();
+}
+
+void IndexWriter::publishFlushedSegments() {
+    SyncLock syncLock(this);
+    if (!docWriter) {
+        return;
+    }
+    for (PendingFlushPtr pendingFlush(docWriter->nextWrittenFlush()); pendingFlush; pendingFlush = docWriter->nextWrittenFlush()) {
+        SegmentInfoPtr newSegment(pendingFlush->segmentInfo);
+
+        if (infoStream) {
+            message(L"publish flushed segment " + newSegment->name + L" flushedFiles=" + StringUtils::toString(pendingFlush->flushState->flushedFiles));
+        }
+
+        docWriter->pushDeletes(pendingFlush->deletes);
+
+        segmentInfos->add(newSegment);
+        checkpoint();
+
+        if (pendingFlush->useCompoundFile) {
+            // The compound file was built along with the segment; switching over now lets the deleter
+            // remove the separate files
+            newSegment->setUseCompoundFile(true);
+            checkpoint();
+        }
+
+        if (pendingFlush->flushDeletes) {
+            applyDeletes();
+        }
+
+        checkpoint();
+
+        doAfterFlush();
+    }
+}
+
 int64_t IndexWriter::ramSizeInBytes() {
     ensureOpen();
     return docWriter->getRAMUsed();
@@ -2275,28 +2483,14 @@ int32_t IndexWriter::numRamDocs() {
     return docWriter->getNumDocsInRAM();
 }
 
-int32_t IndexWriter::ensureContiguousMerge(const OneMergePtr& merge) {
-    int32_t first = segmentInfos->find(merge->segments->info(0));
-    if (first == -1) {
-        boost::throw_exception(MergeException(L"Could not find segment " + merge->segments->info(0)->name + L" in current index " + segString()));
-    }
-
-    int32_t numSegments = segmentInfos->size();
+void IndexWriter::ensureValidMerge(const OneMergePtr& merge) {
     int32_t numSegmentsToMerge = merge->segments->size();
-
     for (int32_t i = 0; i < numSegmentsToMerge; ++i) {
         SegmentInfoPtr info(merge->segments->info(i));
-
-        if (first + i >= numSegments || !segmentInfos->info(first + i)->equals(info)) {
-            if (!segmentInfos->contains(info)) {
-                boost::throw_exception(MergeException(L"MergePolicy selected a segment (" + info->name + L") that is not in the current index " + segString()));
-            } else {
-                boost::throw_exception(MergeException(L"MergePolicy selected non-contiguous segments to merge (" + merge->segString(directory) + L" vs " + segString() + L"), which IndexWriter (currently) cannot handle"));
-            }
+        if (!segmentInfos->contains(info)) {
+            boost::throw_exception(MergeException(L"MergePolicy selected a segment (" + info->name + L") that is not in the current index " + segString()));
         }
     }
-
-    return first;
 }
 
 void IndexWriter::commitMergedDeletes(const OneMergePtr& merge, const SegmentReaderPtr& mergeReader) {
@@ -2383,7 +2577,7 @@ bool IndexWriter::commitMerge(const OneMergePtr& merge, const SegmentMergerPtr&
         return false;
     }
 
-    int32_t start = ensureContiguousMerge(merge);
+    ensureValidMerge(merge);
 
     commitMergedDeletes(merge, mergedReader);
     docWriter->remapDeletes(segmentInfos, merger->getDocMaps(), merger->getDelCounts(), merge, mergedDocCount);
@@ -2394,7 +2588,14 @@ bool IndexWriter::commitMerge(const OneMergePtr& merge, const SegmentMergerPtr&
 
     merge->info->setHasProx(merger->hasProx());
 
-    segmentInfos->remove(start, start + merge->segments->size());
+    // The merged segments need not be adjacent; the merged segment takes the place of the first of them
+    int32_t start = segmentInfos->size();
+    for (int32_t i = segmentInfos->size() - 1; i >= 0; --i) {
+        if (merge->segments->contains(segmentInfos->info(i))) {
+            segmentInfos->remove(i);
+            start = i;
+        }
+    }
     BOOST_ASSERT(!segmentInfos->contains(merge->info));
     segmentInfos->add(start, merge->info);
 
@@ -2524,7 +2725,7 @@ bool IndexWriter::registerMerge(const OneMergePtr& merge) {
         }
     }
 
-    ensureContiguousMerge(merge);
+    ensureValidMerge(merge);
 
     pendingMerges.add(merge);
 
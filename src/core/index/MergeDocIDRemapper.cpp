@@ -13,35 +13,48 @@
 namespace Lucene {
 
 MergeDocIDRemapper::MergeDocIDRemapper(const SegmentInfosPtr& infos, Collection< Collection<int32_t> > docMaps, Collection<int32_t> delCounts, const OneMergePtr& merge, int32_t mergedDocCount) {
-    this->docMaps = docMaps;
-    SegmentInfoPtr firstSegment(merge->segments->info(0));
-    int32_t i = 0;
-    this->minDocID = 0;
-    while (true) {
-        SegmentInfoPtr info(infos->info(i));
-        if (info->equals(firstSegment)) {
-            break;
-        }
-        minDocID += info->docCount;
-        ++i;
+    int32_t numMerged = merge->segments->size();
+
+    // Find the range of segments touched by the merge
+    Collection<int32_t> positions(Collection<int32_t>::newInstance(numMerged));
+    int32_t first = infos->size();
+    int32_t last = -1;
+    for (int32_t j = 0; j < numMerged; ++j) {
+        positions[j] = infos->find(merge->segments->info(j));
+        BOOST_ASSERT(positions[j] != -1);
+        first = std::min(first, positions[j]);
+        last = std::max(last, positions[j]);
     }
 
-    int32_t numDocs = 0;
-    for (int32_t j = 0; j < docMaps.size(); ++i, ++j) {
-        numDocs += infos->info(i)->docCount;
-        BOOST_ASSERT(infos->info(i)->equals(merge->segments->info(j)));
+    this->minDocID = 0;
+    for (int32_t i = 0; i < first; ++i) {
+        minDocID += infos->info(i)->docCount;
     }
-    this->maxDocID = minDocID + numDocs;
 
-    starts = Collection<int32_t>::newInstance(docMaps.size());
-    newStarts = Collection<int32_t>::newInstance(docMaps.size());
+    int32_t numRange = last - first + 1;
+    starts = Collection<int32_t>::newInstance(numRange);
+    newStarts = Collection<int32_t>::newInstance(numRange);
+    this->docMaps = Collection< Collection<int32_t> >::newInstance(numRange);
 
-    starts[0] = minDocID;
-    newStarts[0] = minDocID;
-    for (i = 1; i < docMaps.size(); ++i) {
-        int32_t lastDocCount = merge->segments->info(i - 1)->docCount;
-        starts[i] = starts[i - 1] + lastDocCount;
-        newStarts[i] = newStarts[i - 1] + lastDocCount - delCounts[i - 1];
+    int32_t start = minDocID;
+    for (int32_t i = 0; i < numRange; ++i) {
+        starts[i] = start;
+        newStarts[i] = -1;
+        start += infos->info(first + i)->docCount;
+    }
+    this->maxDocID = start;
+
+    // The merged segment takes the place of the first merged segment, holding the merged segments' docs
+    // in merge order
+    int32_t numDocs = 0;
+    int32_t newStart = minDocID;
+    for (int32_t j = 0; j < numMerged; ++j) {
+        int32_t i = positions[j] - first;
+        int32_t docCount = merge->segments->info(j)->docCount;
+        newStarts[i] = newStart;
+        this->docMaps[i] = docMaps ? docMaps[j] : Collection<int32_t>();
+        newStart += docCount - (delCounts ? delCounts[j] : 0);
+        numDocs += docCount;
     }
     this->docShift = numDocs - mergedDocCount;
 
@@ -49,8 +62,16 @@ MergeDocIDRemapper::MergeDocIDRemapper(const SegmentInfosPtr& infos, Collection<
     // out of bounds, because the SegmentReader still allocates deletedDocs and pretends it has
     // deletions ... so we can't make this assert here: BOOST_ASSERT(docShift > 0);
 
+    // Segments that were not merged but sat between merged segments follow the merged segment
+    for (int32_t i = 0; i < numRange; ++i) {
+        if (newStarts[i] == -1) {
+            newStarts[i] = newStart;
+            newStart += infos->info(first + i)->docCount;
+        }
+    }
+
     // Make sure it all adds up
-    BOOST_ASSERT(docShift == maxDocID - (newStarts[docMaps.size() - 1] + merge->segments->info(docMaps.size() - 1)->docCount - delCounts[docMaps.size() - 1]));
+    BOOST_ASSERT(newStart == maxDocID - docShift);
 }
 
 MergeDocIDRemapper::~MergeDocIDRemapper() {
@@ -65,7 +86,7 @@ int32_t MergeDocIDRemapper::remap(int32_t oldDocID) {
         return oldDocID - docShift;
     } else {
         // Binary search to locate this document & find its new docID
-        Collection<int32_t>::iterator doc = std::upper_bound(starts.begin(), starts.begin() + docMaps.size(), oldDocID);
+        Collection<int32_t>::iterator doc = std::upper_bound(starts.begin(), starts.end(), oldDocID);
         int32_t docMap = std::distance(starts.begin(), doc) - 1;
 
         if (docMaps[docMap]) {
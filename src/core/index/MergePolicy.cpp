@@ -8,7 +8,9 @@
 #include "MergePolicy.h"
 #include "SegmentInfos.h"
 #include "SegmentInfo.h"
+#include "RateLimiter.h"
 #include "StringUtils.h"
+#include "MiscUtils.h"
 
 namespace Lucene {
 
@@ -26,6 +28,9 @@ OneMerge::OneMerge(const SegmentInfosPtr& segments, bool useCompoundFile) {
     mergeGen = 0;
     isExternal = false;
     maxNumSegmentsOptimize = 0;
+    estimatedMergeBytes = 0;
+    mergeStartTime = 0;
+    mergeEndTime = 0;
     aborted = false;
 
     if (segments->empty()) {
@@ -65,6 +70,32 @@ void OneMerge::checkAborted(const DirectoryPtr& dir) {
     }
 }
 
+int64_t OneMerge::getTotalBytesWritten() {
+    SyncLock syncLock(this);
+    return rateLimiter ? rateLimiter->getTotalBytes() : 0;
+}
+
+int64_t OneMerge::getTotalThrottledMillis() {
+    SyncLock syncLock(this);
+    return rateLimiter ? rateLimiter->getTotalPausedMillis() : 0;
+}
+
+int64_t OneMerge::getElapsedMillis() {
+    SyncLock syncLock(this);
+    if (mergeStartTime == 0) {
+        return 0;
+    }
+    return (mergeEndTime == 0 ? (int64_t)MiscUtils::currentTimeMillis() : mergeEndTime) - mergeStartTime;
+}
+
+double OneMerge::getMBPerSec() {
+    int64_t elapsed = getElapsedMillis();
+    if (elapsed <= 0) {
+        return 0.0;
+    }
+    return ((double)getTotalBytesWritten() / 1024.0 / 1024.0) / ((double)elapsed / 1000.0);
+}
+
 String OneMerge::segString(const DirectoryPtr& dir) {
     StringStream buffer;
     int32_t numSegments = segments->size();
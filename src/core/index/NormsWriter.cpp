@@ -49,21 +49,21 @@ void NormsWriter::setFieldInfos(const FieldInfosPtr& fieldInfos) {
 }
 
 void NormsWriter::flush(MapInvertedDocEndConsumerPerThreadCollectionInvertedDocEndConsumerPerField threadsAndFields, const SegmentWriteStatePtr& state) {
-    MapFieldInfoCollectionNormsWriterPerField byField(MapFieldInfoCollectionNormsWriterPerField::newInstance());
+    int32_t numField = state->fieldInfos->size();
+    Collection< Collection<NormsWriterPerFieldPtr> > byField(Collection< Collection<NormsWriterPerFieldPtr> >::newInstance(numField));
 
     // Typically, each thread will have encountered the same field.  So first we collate by field, ie all
-    // per-thread field instances that correspond to the same FieldInfo
+    // per-thread field instances that correspond to the same field number
     for (MapInvertedDocEndConsumerPerThreadCollectionInvertedDocEndConsumerPerField::iterator entry = threadsAndFields.begin(); entry != threadsAndFields.end(); ++entry) {
         for (Collection<InvertedDocEndConsumerPerFieldPtr>::iterator perField = entry->second.begin(); perField != entry->second.end();) {
             NormsWriterPerFieldPtr normsPerField(boost::static_pointer_cast<NormsWriterPerField>(*perField));
             if (normsPerField->upto > 0) {
                 // It has some norms
-                Collection<NormsWriterPerFieldPtr> l = byField.get(normsPerField->fieldInfo);
-                if (!l) {
-                    l = Collection<NormsWriterPerFieldPtr>::newInstance();
-                    byField.put(normsPerField->fieldInfo, l);
+                int32_t fieldNumber = normsPerField->fieldInfo->number;
+                if (!byField[fieldNumber]) {
+                    byField[fieldNumber] = Collection<NormsWriterPerFieldPtr>::newInstance();
                 }
-                l.add(normsPerField);
+                byField[fieldNumber].add(normsPerField);
                 ++perField;
             } else {
                 // Remove this field since we haven't seen it since the previous flush
@@ -80,14 +80,12 @@ void NormsWriter::flush(MapInvertedDocEndConsumerPerThreadCollectionInvertedDocE
     try {
         normsOut->writeBytes(SegmentMerger::NORMS_HEADER, 0, SegmentMerger::NORMS_HEADER_LENGTH);
 
-        int32_t numField = fieldInfos->size();
-
         int32_t normCount = 0;
 
         for (int32_t fieldNumber = 0; fieldNumber < numField; ++fieldNumber) {
-            FieldInfoPtr fieldInfo(fieldInfos->fieldInfo(fieldNumber));
+            FieldInfoPtr fieldInfo(state->fieldInfos->fieldInfo(fieldNumber));
 
-            Collection<NormsWriterPerFieldPtr> toMerge = byField.get(fieldInfo);
+            Collection<NormsWriterPerFieldPtr> toMerge = byField[fieldNumber];
             int32_t upto = 0;
 
             if (toMerge) {
@@ -272,6 +272,18 @@ void ParallelReader::norms(const String& field, ByteArray norms, int32_t offset)
     }
 }
 
+PackedIntsPtr ParallelReader::getNumericDocValues(const String& field) {
+    ensureOpen();
+    MapStringIndexReader::iterator reader = fieldToReader.find(field);
+    return reader == fieldToReader.end() ? PackedIntsPtr() : reader->second->getNumericDocValues(field);
+}
+
+StringIndexPtr ParallelReader::getSortedDocValues(const String& field) {
+    ensureOpen();
+    MapStringIndexReader::iterator reader = fieldToReader.find(field);
+    return reader == fieldToReader.end() ? StringIndexPtr() : reader->second->getSortedDocValues(field);
+}
+
 void ParallelReader::doSetNorm(int32_t doc, const String& field, uint8_t value) {
     ensureOpen();
     MapStringIndexReader::iterator reader = fieldToReader.find(field);
@@ -18,6 +18,7 @@
 #include "SegmentReader.h"
 #include "_SegmentReader.h"
 #include "Directory.h"
+#include "RateLimitedDirectoryWrapper.h"
 #include "TermPositions.h"
 #include "TermVectorsReader.h"
 #include "TermVectorsWriter.h"
@@ -28,6 +29,10 @@
 #include "SegmentMergeInfo.h"
 #include "SegmentMergeQueue.h"
 #include "SegmentWriteState.h"
+#include "DocValuesWriter.h"
+#include "AbstractField.h"
+#include "FieldCache.h"
+#include "PackedInts.h"
 #include "TestPoint.h"
 #include "MiscUtils.h"
 #include "StringUtils.h"
@@ -44,9 +49,11 @@ const int32_t SegmentMerger::NORMS_HEADER_LENGTH = 4;
 SegmentMerger::SegmentMerger(const DirectoryPtr& dir, const String& name) {
     readers = Collection<IndexReaderPtr>::newInstance();
     termIndexInterval = IndexWriter::DEFAULT_TERM_INDEX_INTERVAL;
+    storedFieldsCompression = FieldsWriter::COMPRESSION_FAST;
     mergedDocs = 0;
     mergeDocStores = false;
     omitTermFreqAndPositions = false;
+    hasDocValues = false;
 
     directory = dir;
     segment = name;
@@ -58,16 +65,22 @@ SegmentMerger::SegmentMerger(const IndexWriterPtr& writer, const String& name, c
     mergedDocs = 0;
     mergeDocStores = false;
     omitTermFreqAndPositions = false;
+    hasDocValues = false;
 
     directory = writer->getDirectory();
     segment = name;
 
     if (merge) {
         checkAbort = newLucene<CheckAbort>(merge, directory);
+        if (merge->rateLimiter) {
+            // throttle everything this merge writes, including the compound file
+            directory = newLucene<RateLimitedDirectoryWrapper>(directory, merge->rateLimiter);
+        }
     } else {
         checkAbort = newLucene<CheckAbortNull>();
     }
     termIndexInterval = writer->getTermIndexInterval();
+    storedFieldsCompression = writer->getStoredFieldsCompression();
 }
 
 SegmentMerger::~SegmentMerger() {
@@ -98,6 +111,7 @@ int32_t SegmentMerger::merge(bool mergeDocStores) {
     mergedDocs = mergeFields();
     mergeTerms();
     mergeNorms();
+    mergeDocValues();
 
     if (mergeDocStores && fieldInfos->hasVectors()) {
         mergeVectors();
@@ -135,6 +149,11 @@ HashSet<String> SegmentMerger::getMergedFiles() {
         }
     }
 
+    // Per-document values
+    if (hasDocValues) {
+        fileSet.add(segment + L"." + IndexFileNames::DOC_VALUES_EXTENSION());
+    }
+
     // Vector files
     if (fieldInfos->hasVectors() && mergeDocStores) {
         for (HashSet<String>::iterator ext = IndexFileNames::VECTOR_EXTENSIONS().begin(); ext != IndexFileNames::VECTOR_EXTENSIONS().end(); ++ext) {
@@ -238,6 +257,7 @@ int32_t SegmentMerger::mergeFields() {
     if (mergeDocStores) {
         // merge field values
         FieldsWriterPtr fieldsWriter(newLucene<FieldsWriter>(directory, segment, fieldInfos));
+        fieldsWriter->setCompressionMode(storedFieldsCompression);
 
         LuceneException finally;
         try {
@@ -251,7 +271,9 @@ int32_t SegmentMerger::mergeFields() {
                         matchingFieldsReader = fieldsReader;
                     }
                 }
-                if ((*reader)->hasDeletions()) {
+                if (matchingFieldsReader && matchingFieldsReader->canReadRawBlocks()) {
+                    docCount += copyFieldBlocks(fieldsWriter, *reader, matchingFieldsReader);
+                } else if ((*reader)->hasDeletions()) {
                     docCount += copyFieldsWithDeletions(fieldsWriter, *reader, matchingFieldsReader);
                 } else {
                     docCount += copyFieldsNoDeletions(fieldsWriter, *reader, matchingFieldsReader);
@@ -353,6 +375,54 @@ int32_t SegmentMerger::copyFieldsNoDeletions(const FieldsWriterPtr& fieldsWriter
     return docCount;
 }
 
+int32_t SegmentMerger::copyFieldBlocks(const FieldsWriterPtr& fieldsWriter, const IndexReaderPtr& reader, const FieldsReaderPtr& matchingFieldsReader) {
+    int32_t docCount = 0;
+    int32_t maxDoc = reader->maxDoc();
+    bool hasDeletions = reader->hasDeletions();
+    for (int32_t j = 0; j < maxDoc;) {
+        int32_t firstDocID = 0;
+        int32_t numDocs = matchingFieldsReader->blockDocs(j, firstDocID);
+        int32_t end = std::min(firstDocID + numDocs, maxDoc);
+
+        bool wholeBlock = (firstDocID == j && end == firstDocID + numDocs);
+        for (int32_t k = j; wholeBlock && hasDeletions && k < end; ++k) {
+            wholeBlock = !reader->isDeleted(k);
+        }
+
+        if (wholeBlock) {
+            // every document of the block is copied, so copy it still compressed
+            int64_t length = 0;
+            IndexInputPtr stream(matchingFieldsReader->rawBlock(j, length));
+            fieldsWriter->addRawBlock(stream, numDocs, length);
+            docCount += numDocs;
+            checkAbort->work(300 * numDocs);
+            j = end;
+            continue;
+        }
+
+        // bulk-copy each run of live documents of this block out of the decompressed block
+        while (j < end) {
+            if (hasDeletions && reader->isDeleted(j)) {
+                ++j;
+                continue;
+            }
+            int32_t start = j;
+            while (j < end && !(hasDeletions && reader->isDeleted(j))) {
+                ++j;
+            }
+            int32_t runDocs = j - start;
+            if (rawDocLengths.size() < runDocs) {
+                rawDocLengths.resize(runDocs);
+            }
+            IndexInputPtr stream(matchingFieldsReader->rawDocs(rawDocLengths, start, runDocs));
+            fieldsWriter->addRawDocuments(stream, rawDocLengths, runDocs);
+            docCount += runDocs;
+            checkAbort->work(300 * runDocs);
+        }
+    }
+    return docCount;
+}
+
 void SegmentMerger::mergeVectors() {
     TermVectorsWriterPtr termVectorsWriter(newLucene<TermVectorsWriter>(directory, segment, fieldInfos));
 
@@ -651,6 +721,133 @@ void SegmentMerger::mergeNorms() {
     finally.throwException();
 }
 
+void SegmentMerger::mergeDocValues() {
+    // A field takes the type of the values in the first segment that has any
+    Collection<String> fields(Collection<String>::newInstance());
+    Collection<int32_t> types(Collection<int32_t>::newInstance());
+    int32_t numFieldInfos = fieldInfos->size();
+    for (int32_t i = 0; i < numFieldInfos; ++i) {
+        String name(fieldInfos->fieldInfo(i)->name);
+        for (Collection<IndexReaderPtr>::iterator reader = readers.begin(); reader != readers.end(); ++reader) {
+            if ((*reader)->getNumericDocValues(name)) {
+                fields.add(name);
+                types.add(AbstractField::DOC_VALUES_NUMERIC);
+                break;
+            } else if ((*reader)->getSortedDocValues(name)) {
+                fields.add(name);
+                types.add(AbstractField::DOC_VALUES_SORTED);
+                break;
+            }
+        }
+    }
+
+    if (fields.empty()) {
+        return;
+    }
+    hasDocValues = true;
+
+    IndexOutputPtr output(directory->createOutput(segment + L"." + IndexFileNames::DOC_VALUES_EXTENSION()));
+    LuceneException finally;
+    try {
+        DocValuesWriter::writeHeader(output, fields.size());
+        for (int32_t i = 0; i < fields.size(); ++i) {
+            if (types[i] == AbstractField::DOC_VALUES_NUMERIC) {
+                // find the range of the values of the live documents first, documents without values read 0
+                Collection<PackedIntsPtr> values(Collection<PackedIntsPtr>::newInstance(readers.size()));
+                int64_t minValue = 0;
+                int64_t maxValue = 0;
+                bool first = true;
+                for (int32_t r = 0; r < readers.size(); ++r) {
+                    values[r] = readers[r]->getNumericDocValues(fields[i]);
+                    int32_t maxDoc = readers[r]->maxDoc();
+                    for (int32_t doc = 0; doc < maxDoc; ++doc) {
+                        if (readers[r]->isDeleted(doc)) {
+                            continue;
+                        }
+                        int64_t value = values[r] ? values[r]->get(doc) : 0;
+                        minValue = first ? value : std::min(minValue, value);
+                        maxValue = first ? value : std::max(maxValue, value);
+                        first = false;
+                    }
+                    checkAbort->work(maxDoc);
+                }
+
+                PackedIntsPtr merged(PackedInts::forRange(mergedDocs, minValue, maxValue));
+                int32_t upto = 0;
+                for (int32_t r = 0; r < readers.size(); ++r) {
+                    int32_t maxDoc = readers[r]->maxDoc();
+                    for (int32_t doc = 0; doc < maxDoc; ++doc) {
+                        if (!readers[r]->isDeleted(doc)) {
+                            merged->set(upto++, values[r] ? values[r]->get(doc) : 0);
+                        }
+                    }
+                    checkAbort->work(maxDoc);
+                }
+                BOOST_ASSERT(upto == mergedDocs);
+                DocValuesWriter::writeNumeric(output, fields[i], merged);
+            } else {
+                // collect the values still referenced by live documents
+                Collection<StringIndexPtr> values(Collection<StringIndexPtr>::newInstance(readers.size()));
+                Collection<String> terms(Collection<String>::newInstance());
+                terms.add(L"");
+                for (int32_t r = 0; r < readers.size(); ++r) {
+                    values[r] = readers[r]->getSortedDocValues(fields[i]);
+                    if (!values[r]) {
+                        continue;
+                    }
+                    Collection<uint8_t> used(Collection<uint8_t>::newInstance(values[r]->numOrd()));
+                    int32_t maxDoc = readers[r]->maxDoc();
+                    for (int32_t doc = 0; doc < maxDoc; ++doc) {
+                        if (!readers[r]->isDeleted(doc)) {
+                            used[values[r]->getOrd(doc)] = 1;
+                        }
+                    }
+                    for (int32_t ord = 1; ord < used.size(); ++ord) {
+                        if (used[ord]) {
+                            terms.add(values[r]->lookup(ord));
+                        }
+                    }
+                    checkAbort->work(maxDoc);
+                }
+
+                std::sort(terms.begin(), terms.end());
+                terms.resize(std::unique(terms.begin(), terms.end()) - terms.begin());
+
+                Collection<int32_t> ords(Collection<int32_t>::newInstance(mergedDocs));
+                int32_t upto = 0;
+                for (int32_t r = 0; r < readers.size(); ++r) {
+                    int32_t maxDoc = readers[r]->maxDoc();
+                    if (!values[r]) {
+                        // ords are already 0
+                        upto += readers[r]->numDocs();
+                        continue;
+                    }
+
+                    // map the ordinals of this segment to the merged ordinals as they are needed
+                    Collection<int32_t> ordMap(Collection<int32_t>::newInstance(values[r]->numOrd()));
+                    for (int32_t doc = 0; doc < maxDoc; ++doc) {
+                        if (readers[r]->isDeleted(doc)) {
+                            continue;
+                        }
+                        int32_t ord = values[r]->getOrd(doc);
+                        if (ord != 0 && ordMap[ord] == 0) {
+                            ordMap[ord] = (int32_t)(std::lower_bound(terms.begin(), terms.end(), values[r]->lookup(ord)) - terms.begin());
+                        }
+                        ords[upto++] = ordMap[ord];
+                    }
+                    checkAbort->work(maxDoc);
+                }
+                BOOST_ASSERT(upto == mergedDocs);
+                DocValuesWriter::writeSorted(output, fields[i], terms, ords);
+            }
+        }
+    } catch (LuceneException& e) {
+        finally = e;
+    }
+    output->close();
+    finally.throwException();
+}
+
 CheckAbort::CheckAbort(const OneMergePtr& merge, const DirectoryPtr& dir) {
     workCount = 0;
     this->merge = merge;
@@ -17,6 +17,7 @@
 #include "TermInfo.h"
 #include "TermInfosReader.h"
 #include "TermVectorsReader.h"
+#include "DocValuesReader.h"
 #include "IndexOutput.h"
 #include "ReadOnlySegmentReader.h"
 #include "BitVector.h"
@@ -485,6 +486,16 @@ ByteArray SegmentReader::norms(const String& field) {
     return getNorms(field);
 }
 
+PackedIntsPtr SegmentReader::getNumericDocValues(const String& field) {
+    ensureOpen();
+    return core->docValuesReader ? core->docValuesReader->getNumeric(field) : PackedIntsPtr();
+}
+
+StringIndexPtr SegmentReader::getSortedDocValues(const String& field) {
+    ensureOpen();
+    return core->docValuesReader ? core->docValuesReader->getSorted(field) : StringIndexPtr();
+}
+
 void SegmentReader::doSetNorm(int32_t doc, const String& field, uint8_t value) {
     NormPtr norm(_norms.get(field));
     if (!norm) { // not an indexed field
@@ -735,6 +746,10 @@ int32_t SegmentReader::getTermInfosIndexDivisor() {
     return core->termsIndexDivisor;
 }
 
+int64_t SegmentReader::getTermInfosIndexBytesUsed() {
+    return core->getTermsReader()->ramBytesUsed();
+}
+
 CoreReaders::CoreReaders(const SegmentReaderPtr& origInstance, const DirectoryPtr& dir, const SegmentInfoPtr& si, int32_t readBufferSize, int32_t termsIndexDivisor) {
     ref = newLucene<SegmentReaderRef>();
 
@@ -770,6 +785,10 @@ CoreReaders::CoreReaders(const SegmentReaderPtr& origInstance, const DirectoryPt
             proxStream = cfsDir->openInput(segment + L"." + IndexFileNames::PROX_EXTENSION(), readBufferSize);
         }
 
+        if (cfsDir->fileExists(segment + L"." + IndexFileNames::DOC_VALUES_EXTENSION())) {
+            docValuesReader = newLucene<DocValuesReader>(cfsDir, segment, readBufferSize);
+        }
+
         success = true;
     } catch (LuceneException& e) {
         finally = e;
@@ -854,6 +873,9 @@ void CoreReaders::decRef() {
         if (proxStream) {
             proxStream->close();
         }
+        if (docValuesReader) {
+            docValuesReader->close();
+        }
         if (termVectorsReaderOrig) {
             termVectorsReaderOrig->close();
         }
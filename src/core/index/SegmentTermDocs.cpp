@@ -21,6 +21,12 @@
 
 namespace Lucene {
 
+/// Largest encoding of a single VInt.
+const int32_t SegmentTermDocs::MAX_VINT_BYTES = 5;
+
+/// Largest encoding of a doc delta followed by a freq.
+const int32_t SegmentTermDocs::MAX_PAIR_BYTES = 2 * SegmentTermDocs::MAX_VINT_BYTES;
+
 SegmentTermDocs::SegmentTermDocs(const SegmentReaderPtr& parent) {
     this->_parent = parent;
     this->count = 0;
@@ -137,45 +143,115 @@ bool SegmentTermDocs::next() {
 
 int32_t SegmentTermDocs::read(Collection<int32_t> docs, Collection<int32_t> freqs) {
     int32_t length = docs.size();
+    if (length == 0) {
+        return 0;
+    }
     if (currentFieldOmitTermFreqAndPositions) {
         return readNoTf(docs, freqs, length);
     } else {
+        int32_t* docBuffer = &docs[0];
+        int32_t* freqBuffer = &freqs[0];
         int32_t i = 0;
         while (i < length && count < df) {
-            // manually inlined call to next() for speed
-            int32_t docCode = _freqStream->readVInt();
-            _doc += MiscUtils::unsignedShift(docCode, 1); // shift off low bit
-            if ((docCode & 1) != 0) { // if low bit is set
-                _freq = 1;    // freq is one
-            } else {
-                _freq = _freqStream->readVInt();    // else read freq
+            int32_t start = i;
+            int32_t available = 0;
+            const uint8_t* bytes = _freqStream->bufferedBytes(available);
+
+            // decode doc deltas and freqs straight from the input's buffer while it holds a complete pair
+            int32_t end = i + std::min(length - i, df - count);
+            int32_t last = available - MAX_PAIR_BYTES;
+            int32_t position = 0;
+            while (i < end && position <= last) {
+                int32_t docCode = decodeVInt(bytes, position);
+                docBuffer[i] = MiscUtils::unsignedShift(docCode, 1); // shift off low bit
+                freqBuffer[i] = (docCode & 1) != 0 ? 1 : decodeVInt(bytes, position); // freq is one if low bit is set
+                ++i;
             }
-            ++count;
-
-            if (!deletedDocs || !deletedDocs->get(_doc)) {
-                docs[i] = _doc;
-                freqs[i] = _freq;
+            count += i - start;
+
+            if (i == start) {
+                // a pair may straddle the end of the buffer, so read it through the stream
+                int32_t docCode = _freqStream->readVInt();
+                docBuffer[i] = MiscUtils::unsignedShift(docCode, 1);
+                freqBuffer[i] = (docCode & 1) != 0 ? 1 : _freqStream->readVInt();
+                ++count;
                 ++i;
+            } else {
+                _freqStream->skipBufferedBytes(position);
             }
+
+            _freq = freqBuffer[i - 1];
+            i = accumulateDocs(docBuffer, freqBuffer, start, i);
         }
         return i;
     }
 }
 
 int32_t SegmentTermDocs::readNoTf(Collection<int32_t> docs, Collection<int32_t> freqs, int32_t length) {
+    int32_t* docBuffer = &docs[0];
+    int32_t* freqBuffer = &freqs[0];
     int32_t i = 0;
     while (i < length && count < df) {
-        // manually inlined call to next() for speed
-        _doc += _freqStream->readVInt();
-        ++count;
-
-        if (!deletedDocs || !deletedDocs->get(_doc)) {
-            docs[i] = _doc;
+        int32_t start = i;
+        int32_t available = 0;
+        const uint8_t* bytes = _freqStream->bufferedBytes(available);
+
+        int32_t end = i + std::min(length - i, df - count);
+        int32_t last = available - MAX_VINT_BYTES;
+        int32_t position = 0;
+        while (i < end && position <= last) {
+            docBuffer[i] = decodeVInt(bytes, position);
+            ++i;
+        }
+        count += i - start;
 
-            // Hardware freq to 1 when term freqs were not stored in the index
-            freqs[i] = 1;
+        if (i == start) {
+            docBuffer[i] = _freqStream->readVInt();
+            ++count;
             ++i;
+        } else {
+            _freqStream->skipBufferedBytes(position);
         }
+
+        i = accumulateDocs(docBuffer, freqBuffer, start, i);
+    }
+
+    // Hardware freq to 1 when term freqs were not stored in the index
+    MiscUtils::arrayFill(freqBuffer, 0, i, 1);
+    return i;
+}
+
+int32_t SegmentTermDocs::accumulateDocs(int32_t* docs, int32_t* freqs, int32_t start, int32_t end) {
+    // prefix sum of the doc deltas, kept out of the decoding loop so that it runs without branches
+    int32_t doc = _doc;
+    for (int32_t i = start; i < end; ++i) {
+        doc += docs[i];
+        docs[i] = doc;
+    }
+    _doc = doc;
+
+    if (!deletedDocs) {
+        return end;
+    }
+
+    // squeeze out deleted documents
+    int32_t upto = start;
+    for (int32_t i = start; i < end; ++i) {
+        if (!deletedDocs->get(docs[i])) {
+            docs[upto] = docs[i];
+            freqs[upto] = freqs[i];
+            ++upto;
+        }
+    }
+    return upto;
+}
+
+int32_t SegmentTermDocs::decodeVInt(const uint8_t* bytes, int32_t& position) {
+    uint8_t b = bytes[position++];
+    int32_t i = (b & 0x7f);
+    for (int32_t shift = 7; (b & 0x80) != 0; shift += 7) {
+        b = bytes[position++];
+        i |= (b & 0x7f) << shift;
     }
     return i;
 }
@@ -58,6 +58,7 @@ void StoredFieldsWriter::initFieldsWriter() {
         String docStoreSegment(docWriter->getDocStoreSegment());
         if (!docStoreSegment.empty()) {
             fieldsWriter = newLucene<FieldsWriter>(docWriter->directory, docStoreSegment, fieldInfos);
+            fieldsWriter->setCompressionMode(docWriter->getStoredFieldsCompression());
             docWriter->addOpenFile(docStoreSegment + L"." + IndexFileNames::FIELDS_EXTENSION());
             docWriter->addOpenFile(docStoreSegment + L"." + IndexFileNames::FIELDS_INDEX_EXTENSION());
             lastDocID = 0;
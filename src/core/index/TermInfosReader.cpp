@@ -6,6 +6,7 @@
 
 #include "LuceneInc.h"
 #include "TermInfosReader.h"
+#include "TermInfosReaderIndex.h"
 #include "SegmentTermEnum.h"
 #include "Directory.h"
 #include "IndexFileNames.h"
@@ -38,23 +39,7 @@ TermInfosReader::TermInfosReader(const DirectoryPtr& dir, const String& seg, con
             SegmentTermEnumPtr indexEnum(newLucene<SegmentTermEnum>(directory->openInput(segment + L"." + IndexFileNames::TERMS_INDEX_EXTENSION(), readBufferSize), fieldInfos, true));
 
             try {
-                int32_t indexSize = 1 + ((int32_t)indexEnum->size - 1) / indexDivisor; // otherwise read index
-
-                indexTerms = Collection<TermPtr>::newInstance(indexSize);
-                indexInfos = Collection<TermInfoPtr>::newInstance(indexSize);
-                indexPointers = Collection<int64_t>::newInstance(indexSize);
-
-                for (int32_t i = 0; indexEnum->next(); ++i) {
-                    indexTerms[i] = indexEnum->term();
-                    indexInfos[i] = indexEnum->termInfo();
-                    indexPointers[i] = indexEnum->indexPointer;
-
-                    for (int32_t j = 1; j < indexDivisor; ++j) {
-                        if (!indexEnum->next()) {
-                            break;
-                        }
-                    }
-                }
+                index = newLucene<TermInfosReaderIndex>(indexEnum, indexDivisor);
             } catch (LuceneException& e) {
                 finally = e;
             }
@@ -97,6 +82,10 @@ int64_t TermInfosReader::size() {
     return _size;
 }
 
+int64_t TermInfosReader::ramBytesUsed() {
+    return index ? index->ramBytesUsed() : 0;
+}
+
 TermInfosReaderThreadResourcesPtr TermInfosReader::getThreadResources() {
     TermInfosReaderThreadResourcesPtr resources(threadResources.get());
     if (!resources) {
@@ -111,13 +100,11 @@ TermInfosReaderThreadResourcesPtr TermInfosReader::getThreadResources() {
 }
 
 int32_t TermInfosReader::getIndexOffset(const TermPtr& term) {
-    // binary search indexTerms
-    Collection<TermPtr>::iterator indexTerm = std::upper_bound(indexTerms.begin(), indexTerms.end(), term, luceneCompare<TermPtr>());
-    return (std::distance(indexTerms.begin(), indexTerm) - 1);
+    return index->getIndexOffset(term);
 }
 
 void TermInfosReader::seekEnum(const SegmentTermEnumPtr& enumerator, int32_t indexOffset) {
-    enumerator->seek(indexPointers[indexOffset], ((int64_t)indexOffset * (int64_t)totalIndexInterval) - 1, indexTerms[indexOffset], indexInfos[indexOffset]);
+    index->seekEnum(enumerator, indexOffset, ((int64_t)indexOffset * (int64_t)totalIndexInterval) - 1);
 }
 
 TermInfoPtr TermInfosReader::get(const TermPtr& term) {
@@ -151,8 +138,8 @@ TermInfoPtr TermInfosReader::get(const TermPtr& term, bool useCache) {
             ((enumerator->prev() && term->compareTo(enumerator->prev()) > 0) ||
              term->compareTo(enumerator->term()) >= 0)) {
         int32_t enumOffset = (int32_t)(enumerator->position / totalIndexInterval ) + 1;
-        if (indexTerms.size() == enumOffset || // but before end of block
-                term->compareTo(indexTerms[enumOffset]) < 0) {
+        if (index->size() == enumOffset || // but before end of block
+                index->compareTo(term, enumOffset) < 0) {
             // no need to seek
             int32_t numScans = enumerator->scanTo(term);
             if (enumerator->term() && term->compareTo(enumerator->term()) == 0) {
@@ -185,7 +172,7 @@ TermInfoPtr TermInfosReader::get(const TermPtr& term, bool useCache) {
 }
 
 void TermInfosReader::ensureIndexIsRead() {
-    if (!indexTerms) {
+    if (!index) {
         boost::throw_exception(IllegalStateException(L"terms index was not loaded when this reader was created"));
     }
 }
@@ -0,0 +1,176 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "LuceneInc.h"
+#include "TermInfosReaderIndex.h"
+#include "SegmentTermEnum.h"
+#include "Term.h"
+#include "TermInfo.h"
+#include "MiscUtils.h"
+#include "UnicodeUtils.h"
+#include "StringUtils.h"
+
+namespace Lucene {
+
+TermInfosReaderIndex::TermInfosReaderIndex(const SegmentTermEnumPtr& indexEnum, int32_t indexDivisor) {
+    int32_t maxSize = std::max(1 + ((int32_t)indexEnum->size - 1) / indexDivisor, 0);
+
+    termBytes = ByteArray::newInstance(std::max(maxSize * 8, 16));
+    termOffsets = IntArray::newInstance(maxSize + 1);
+    fields = Collection<String>::newInstance();
+    fieldStarts = Collection<int32_t>::newInstance();
+    docFreqs = IntArray::newInstance(maxSize);
+    freqPointers = LongArray::newInstance(maxSize);
+    proxPointers = LongArray::newInstance(maxSize);
+    skipOffsets = IntArray::newInstance(maxSize);
+    indexPointers = LongArray::newInstance(maxSize);
+
+    UTF8ResultPtr utf8(newLucene<UTF8Result>());
+    TermInfoPtr termInfo(newLucene<TermInfo>());
+    int32_t upto = 0;
+
+    indexSize = 0;
+    while (indexSize < maxSize && indexEnum->next()) {
+        // the first entry is the unset term, kept as an empty field that sorts before all others
+        TermPtr term(indexEnum->term());
+        String field(term ? term->_field : L"");
+        String text(term ? term->_text : L"");
+        if (fields.empty() || fields[fields.size() - 1] != field) {
+            fields.add(field);
+            fieldStarts.add(indexSize);
+        }
+
+        StringUtils::toUTF8(text.c_str(), text.length(), utf8);
+        if (upto + utf8->length > termBytes.size()) {
+            termBytes.resize(MiscUtils::getNextSize(upto + utf8->length));
+        }
+        MiscUtils::arrayCopy(utf8->result.get(), 0, termBytes.get(), upto, utf8->length);
+        termOffsets[indexSize] = upto;
+        upto += utf8->length;
+
+        indexEnum->termInfo(termInfo);
+        docFreqs[indexSize] = termInfo->docFreq;
+        freqPointers[indexSize] = termInfo->freqPointer;
+        proxPointers[indexSize] = termInfo->proxPointer;
+        skipOffsets[indexSize] = termInfo->skipOffset;
+        indexPointers[indexSize] = indexEnum->indexPointer;
+        ++indexSize;
+
+        for (int32_t j = 1; j < indexDivisor; ++j) {
+            if (!indexEnum->next()) {
+                break;
+            }
+        }
+    }
+    termOffsets[indexSize] = upto;
+    fieldStarts.add(indexSize);
+
+    // release the slack of the growing arena
+    termBytes.resize(std::max(upto, 1));
+}
+
+TermInfosReaderIndex::~TermInfosReaderIndex() {
+}
+
+int32_t TermInfosReaderIndex::size() {
+    return indexSize;
+}
+
+int32_t TermInfosReaderIndex::getIndexOffset(const TermPtr& term) {
+    int32_t run = (int32_t)std::distance(fields.begin(), std::lower_bound(fields.begin(), fields.end(), term->_field));
+    if (run == fields.size() || fields[run] != term->_field) {
+        // all entries of the preceding fields are smaller than term, all others are greater
+        return fieldStarts[run] - 1;
+    }
+
+    // binary search for the first entry of the field run that is greater than term
+    int32_t low = fieldStarts[run];
+    int32_t high = fieldStarts[run + 1];
+    while (low < high) {
+        int32_t mid = MiscUtils::unsignedShift(low + high, 1);
+        if (compareText(term->_text, mid) < 0) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return low - 1;
+}
+
+int32_t TermInfosReaderIndex::compareTo(const TermPtr& term, int32_t indexOffset) {
+    int32_t cmp = term->_field.compare(fields[getFieldRun(indexOffset)]);
+    return cmp != 0 ? cmp : compareText(term->_text, indexOffset);
+}
+
+TermPtr TermInfosReaderIndex::getTerm(int32_t indexOffset) {
+    const String& field = fields[getFieldRun(indexOffset)];
+    if (field.empty()) {
+        return TermPtr();
+    }
+    int32_t start = termOffsets[indexOffset];
+    return newLucene<Term>(field, StringUtils::toUnicode(termBytes.get() + start, termOffsets[indexOffset + 1] - start));
+}
+
+void TermInfosReaderIndex::seekEnum(const SegmentTermEnumPtr& enumerator, int32_t indexOffset, int64_t position) {
+    TermInfoPtr termInfo(newLucene<TermInfo>(docFreqs[indexOffset], freqPointers[indexOffset], proxPointers[indexOffset]));
+    termInfo->skipOffset = skipOffsets[indexOffset];
+    enumerator->seek(indexPointers[indexOffset], position, getTerm(indexOffset), termInfo);
+}
+
+int64_t TermInfosReaderIndex::ramBytesUsed() {
+    int64_t bytes = termBytes.size() + (int64_t)termOffsets.size() * sizeof(int32_t);
+    bytes += (int64_t)indexSize * (2 * sizeof(int32_t) + 3 * sizeof(int64_t));
+    bytes += (int64_t)fieldStarts.size() * sizeof(int32_t);
+    for (Collection<String>::iterator field = fields.begin(); field != fields.end(); ++field) {
+        bytes += sizeof(String) + field->length() * sizeof(wchar_t);
+    }
+    return bytes;
+}
+
+int32_t TermInfosReaderIndex::getFieldRun(int32_t indexOffset) {
+    return (int32_t)std::distance(fieldStarts.begin(), std::upper_bound(fieldStarts.begin(), fieldStarts.end(), indexOffset)) - 1;
+}
+
+int32_t TermInfosReaderIndex::compareText(const String& text, int32_t indexOffset) {
+    const uint8_t* utf8 = termBytes.get() + termOffsets[indexOffset];
+    const uint8_t* end = termBytes.get() + termOffsets[indexOffset + 1];
+    String::const_iterator ch = text.begin();
+    wchar_t lowSurrogate = 0; // second half of a decoded surrogate pair, if wchar_t is 16 bits wide
+
+    for (; ch != text.end(); ++ch) {
+        wchar_t indexChar;
+        if (lowSurrogate != 0) {
+            indexChar = lowSurrogate;
+            lowSurrogate = 0;
+        } else if (utf8 == end) {
+            return 1; // index text is a prefix of text
+        } else {
+            // decode the next code point
+            int32_t b = *utf8++;
+            int32_t codePoint = b;
+            if (b >= 0x80) {
+                int32_t trailing = b < 0xe0 ? 1 : (b < 0xf0 ? 2 : 3);
+                codePoint = b & (0x3f >> trailing);
+                for (; trailing > 0 && utf8 != end; --trailing) {
+                    codePoint = (codePoint << 6) | (*utf8++ & 0x3f);
+                }
+            }
+            if (sizeof(wchar_t) == 2 && codePoint >= 0x10000) {
+                indexChar = (wchar_t)(0xd800 + ((codePoint - 0x10000) >> 10));
+                lowSurrogate = (wchar_t)(0xdc00 + ((codePoint - 0x10000) & 0x3ff));
+            } else {
+                indexChar = (wchar_t)codePoint;
+            }
+        }
+        if (*ch != indexChar) {
+            return *ch < indexChar ? -1 : 1;
+        }
+    }
+
+    return (utf8 == end && lowSurrogate == 0) ? 0 : -1;
+}
+
+}
@@ -44,23 +44,29 @@ void TermVectorsTermsWriter::createPostings(Collection<RawPostingListPtr> postin
 }
 
 void TermVectorsTermsWriter::flush(MapTermsHashConsumerPerThreadCollectionTermsHashConsumerPerField threadsAndFields, const SegmentWriteStatePtr& state) {
-    SyncLock syncLock(this);
-
-    // NOTE: it's possible that all documents seen in this segment hit non-aborting exceptions, in which case we will
-    // not have yet init'd the TermVectorsWriter.  This is actually OK (unlike in the stored fields case) because,
-    // although IieldInfos.hasVectors() will return true, the TermVectorsReader gracefully handles non-existence of
-    // the term vectors files.
-    if (tvx) {
-        if (state->numDocsInStore > 0) {
-            // In case there are some final documents that we didn't see (because they hit a non-aborting exception)
-            fill(state->numDocsInStore - DocumentsWriterPtr(_docWriter)->getDocStoreOffset());
+    {
+        SyncLock syncLock(this);
+
+        // NOTE: it's possible that all documents seen in this segment hit non-aborting exceptions, in which case we will
+        // not have yet init'd the TermVectorsWriter.  This is actually OK (unlike in the stored fields case) because,
+        // although IieldInfos.hasVectors() will return true, the TermVectorsReader gracefully handles non-existence of
+        // the term vectors files.
+        if (tvx) {
+            if (state->numDocsInStore > 0) {
+                // In case there are some final documents that we didn't see (because they hit a non-aborting exception)
+                fill(state->numDocsInStore - DocumentsWriterPtr(_docWriter)->getDocStoreOffset());
+            }
+
+            tvx->flush();
+            tvd->flush();
+            tvf->flush();
         }
-
-        tvx->flush();
-        tvd->flush();
-        tvf->flush();
     }
 
+    // The per-thread state belongs to the segment being flushed, so it is reset without holding our lock
+    // (resetting recycles blocks back to the DocumentsWriter, which other threads may hold while they
+    // finish documents into our doc store)
+
     for (MapTermsHashConsumerPerThreadCollectionTermsHashConsumerPerField::iterator entry = threadsAndFields.begin(); entry != threadsAndFields.end(); ++entry) {
         for (Collection<TermsHashConsumerPerFieldPtr>::iterator field = entry->second.begin(); field != entry->second.end(); ++field) {
             TermVectorsTermsWriterPerFieldPtr perField(boost::static_pointer_cast<TermVectorsTermsWriterPerField>(*field));
@@ -57,7 +57,13 @@ void TermsHash::abort() {
 }
 
 void TermsHash::shrinkFreePostings(MapInvertedDocConsumerPerThreadCollectionInvertedDocConsumerPerField threadsAndFields, const SegmentWriteStatePtr& state) {
-    BOOST_ASSERT(postingsFreeCount == postingsAllocCount);
+    SyncLock syncLock(this);
+
+    // Postings may still be out with threads that kept indexing while this segment was written; we
+    // can only shrink once they are all back
+    if (postingsFreeCount != postingsAllocCount) {
+        return;
+    }
 
     int32_t newSize = 1;
     if (newSize != postingsFreeList.size()) {
@@ -81,7 +87,6 @@ void TermsHash::closeDocStore(const SegmentWriteStatePtr& state) {
 }
 
 void TermsHash::flush(MapInvertedDocConsumerPerThreadCollectionInvertedDocConsumerPerField threadsAndFields, const SegmentWriteStatePtr& state) {
-    SyncLock syncLock(this);
     MapTermsHashConsumerPerThreadCollectionTermsHashConsumerPerField childThreadsAndFields(MapTermsHashConsumerPerThreadCollectionTermsHashConsumerPerField::newInstance());
     MapInvertedDocConsumerPerThreadCollectionInvertedDocConsumerPerField nextThreadsAndFields;
     if (nextTermsHash) {
@@ -0,0 +1,516 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "LuceneInc.h"
+#include "TieredMergePolicy.h"
+#include "IndexWriter.h"
+#include "SegmentInfo.h"
+#include "StringUtils.h"
+
+namespace Lucene {
+
+/// Default maximum number of segments merged at once during normal merging.
+const int32_t TieredMergePolicy::DEFAULT_MAX_MERGE_AT_ONCE = 10;
+
+/// Default maximum number of segments merged at once by optimize or expungeDeletes.
+const int32_t TieredMergePolicy::DEFAULT_MAX_MERGE_AT_ONCE_EXPLICIT = 30;
+
+/// Default maximum size of a merged segment during normal merging.
+const double TieredMergePolicy::DEFAULT_MAX_MERGED_SEGMENT_MB = 5 * 1024;
+
+/// Default size below which segments are rounded up when choosing merges.
+const double TieredMergePolicy::DEFAULT_FLOOR_SEGMENT_MB = 2.0;
+
+/// Default number of segments allowed per tier.
+const double TieredMergePolicy::DEFAULT_SEGMENTS_PER_TIER = 10.0;
+
+/// Default percentage of deleted documents a segment may have before expungeDeletes merges it.
+const double TieredMergePolicy::DEFAULT_EXPUNGE_DELETES_PCT_ALLOWED = 10.0;
+
+/// Default weight given to reclaiming deletes when scoring merges.
+const double TieredMergePolicy::DEFAULT_RECLAIM_DELETES_WEIGHT = 2.0;
+
+/// Default noCFSRatio.  If a merge's size is >= 10% of the index, then we disable compound file for it.
+const double TieredMergePolicy::DEFAULT_NO_CFS_RATIO = 0.1;
+
+TieredMergePolicy::TieredMergePolicy(const IndexWriterPtr& writer) : MergePolicy(writer) {
+    maxMergeAtOnce = DEFAULT_MAX_MERGE_AT_ONCE;
+    maxMergeAtOnceExplicit = DEFAULT_MAX_MERGE_AT_ONCE_EXPLICIT;
+    maxMergedSegmentBytes = (int64_t)(DEFAULT_MAX_MERGED_SEGMENT_MB * 1024 * 1024);
+    floorSegmentBytes = (int64_t)(DEFAULT_FLOOR_SEGMENT_MB * 1024 * 1024);
+    segsPerTier = DEFAULT_SEGMENTS_PER_TIER;
+    expungeDeletesPctAllowed = DEFAULT_EXPUNGE_DELETES_PCT_ALLOWED;
+    reclaimDeletesWeight = DEFAULT_RECLAIM_DELETES_WEIGHT;
+    noCFSRatio = DEFAULT_NO_CFS_RATIO;
+    _useCompoundFile = true;
+    _useCompoundDocStore = true;
+}
+
+TieredMergePolicy::~TieredMergePolicy() {
+}
+
+void TieredMergePolicy::setMaxMergeAtOnce(int32_t maxMergeAtOnce) {
+    if (maxMergeAtOnce < 2) {
+        boost::throw_exception(IllegalArgumentException(L"maxMergeAtOnce must be > 1 (got " + StringUtils::toString(maxMergeAtOnce) + L")"));
+    }
+    this->maxMergeAtOnce = maxMergeAtOnce;
+}
+
+int32_t TieredMergePolicy::getMaxMergeAtOnce() {
+    return maxMergeAtOnce;
+}
+
+void TieredMergePolicy::setMaxMergeAtOnceExplicit(int32_t maxMergeAtOnceExplicit) {
+    if (maxMergeAtOnceExplicit < 2) {
+        boost::throw_exception(IllegalArgumentException(L"maxMergeAtOnceExplicit must be > 1 (got " + StringUtils::toString(maxMergeAtOnceExplicit) + L")"));
+    }
+    this->maxMergeAtOnceExplicit = maxMergeAtOnceExplicit;
+}
+
+int32_t TieredMergePolicy::getMaxMergeAtOnceExplicit() {
+    return maxMergeAtOnceExplicit;
+}
+
+void TieredMergePolicy::setMaxMergedSegmentMB(double mb) {
+    if (mb < 0.0) {
+        boost::throw_exception(IllegalArgumentException(L"maxMergedSegmentMB must be >= 0 (got " + StringUtils::toString(mb) + L")"));
+    }
+    maxMergedSegmentBytes = (int64_t)(mb * 1024 * 1024);
+}
+
+double TieredMergePolicy::getMaxMergedSegmentMB() {
+    return ((double)maxMergedSegmentBytes) / 1024 / 1024;
+}
+
+void TieredMergePolicy::setReclaimDeletesWeight(double weight) {
+    if (weight < 0.0) {
+        boost::throw_exception(IllegalArgumentException(L"reclaimDeletesWeight must be >= 0.0 (got " + StringUtils::toString(weight) + L")"));
+    }
+    reclaimDeletesWeight = weight;
+}
+
+double TieredMergePolicy::getReclaimDeletesWeight() {
+    return reclaimDeletesWeight;
+}
+
+void TieredMergePolicy::setFloorSegmentMB(double mb) {
+    if (mb <= 0.0) {
+        boost::throw_exception(IllegalArgumentException(L"floorSegmentMB must be > 0.0 (got " + StringUtils::toString(mb) + L")"));
+    }
+    floorSegmentBytes = (int64_t)(mb * 1024 * 1024);
+}
+
+double TieredMergePolicy::getFloorSegmentMB() {
+    return ((double)floorSegmentBytes) / 1024 / 1024;
+}
+
+void TieredMergePolicy::setExpungeDeletesPctAllowed(double pct) {
+    if (pct < 0.0 || pct > 100.0) {
+        boost::throw_exception(IllegalArgumentException(L"expungeDeletesPctAllowed must be between 0.0 and 100.0 inclusive (got " + StringUtils::toString(pct) + L")"));
+    }
+    expungeDeletesPctAllowed = pct;
+}
+
+double TieredMergePolicy::getExpungeDeletesPctAllowed() {
+    return expungeDeletesPctAllowed;
+}
+
+void TieredMergePolicy::setSegmentsPerTier(double segsPerTier) {
+    if (segsPerTier < 2.0) {
+        boost::throw_exception(IllegalArgumentException(L"segmentsPerTier must be >= 2.0 (got " + StringUtils::toString(segsPerTier) + L")"));
+    }
+    this->segsPerTier = segsPerTier;
+}
+
+double TieredMergePolicy::getSegmentsPerTier() {
+    return segsPerTier;
+}
+
+void TieredMergePolicy::setUseCompoundFile(bool useCompoundFile) {
+    _useCompoundFile = useCompoundFile;
+}
+
+bool TieredMergePolicy::getUseCompoundFile() {
+    return _useCompoundFile;
+}
+
+void TieredMergePolicy::setUseCompoundDocStore(bool useCompoundDocStore) {
+    _useCompoundDocStore = useCompoundDocStore;
+}
+
+bool TieredMergePolicy::getUseCompoundDocStore() {
+    return _useCompoundDocStore;
+}
+
+void TieredMergePolicy::setNoCFSRatio(double noCFSRatio) {
+    if (noCFSRatio < 0.0 || noCFSRatio > 1.0) {
+        boost::throw_exception(IllegalArgumentException(L"noCFSRatio must be 0.0 to 1.0 inclusive; got " + StringUtils::toString(noCFSRatio)));
+    }
+    this->noCFSRatio = noCFSRatio;
+}
+
+double TieredMergePolicy::getNoCFSRatio() {
+    return noCFSRatio;
+}
+
+MergeSpecificationPtr TieredMergePolicy::findMerges(const SegmentInfosPtr& segmentInfos) {
+    int32_t numSegments = segmentInfos->size();
+    message(L"findMerges: " + StringUtils::toString(numSegments) + L" segments");
+    if (numSegments == 0) {
+        return MergeSpecificationPtr();
+    }
+
+    SetSegmentInfo merging(IndexWriterPtr(_writer)->getMergingSegments());
+    SetSegmentInfo toBeMerged(SetSegmentInfo::newInstance());
+
+    Collection<SegmentInfoPtr> infosSorted(Collection<SegmentInfoPtr>::newInstance(numSegments));
+    for (int32_t i = 0; i < numSegments; ++i) {
+        infosSorted[i] = segmentInfos->info(i);
+    }
+    sortBySizeDescending(infosSorted);
+
+    // Compute total index bytes
+    int64_t totIndexBytes = 0;
+    int64_t minSegmentBytes = std::numeric_limits<int64_t>::max();
+    for (Collection<SegmentInfoPtr>::iterator info = infosSorted.begin(); info != infosSorted.end(); ++info) {
+        int64_t segBytes = size(*info);
+        minSegmentBytes = std::min(segBytes, minSegmentBytes);
+        totIndexBytes += segBytes;
+    }
+
+    // If we have too-large segments, grace them out of the maximum segment count
+    int32_t tooBigCount = 0;
+    while (tooBigCount < infosSorted.size() && size(infosSorted[tooBigCount]) >= maxMergedSegmentBytes / 2) {
+        totIndexBytes -= size(infosSorted[tooBigCount]);
+        ++tooBigCount;
+    }
+
+    minSegmentBytes = floorSize(minSegmentBytes);
+
+    // Compute max allowed segments in the index
+    int64_t levelSize = minSegmentBytes;
+    int64_t bytesLeft = totIndexBytes;
+    double allowedSegCount = 0;
+    while (true) {
+        double segCountLevel = (double)bytesLeft / (double)levelSize;
+        if (segCountLevel < segsPerTier) {
+            allowedSegCount += std::ceil(segCountLevel);
+            break;
+        }
+        allowedSegCount += segsPerTier;
+        bytesLeft -= (int64_t)(segsPerTier * levelSize);
+        levelSize *= maxMergeAtOnce;
+    }
+    int32_t allowedSegCountInt = (int32_t)allowedSegCount;
+
+    MergeSpecificationPtr spec;
+
+    // Cycle to possibly select more than one merge
+    while (true) {
+        int64_t mergingBytes = 0;
+
+        // Gather eligible segments for merging, ie segments not already being merged and not already
+        // picked (by prior iteration of this loop) for merging
+        Collection<SegmentInfoPtr> eligible(Collection<SegmentInfoPtr>::newInstance());
+        for (int32_t i = tooBigCount; i < infosSorted.size(); ++i) {
+            SegmentInfoPtr info(infosSorted[i]);
+            if (merging.contains(info)) {
+                mergingBytes += info->sizeInBytes();
+            } else if (!toBeMerged.contains(info)) {
+                eligible.add(info);
+            }
+        }
+
+        bool maxMergeIsRunning = (mergingBytes >= maxMergedSegmentBytes);
+
+        message(L"  allowedSegmentCount=" + StringUtils::toString(allowedSegCountInt) + L" vs count=" + StringUtils::toString(infosSorted.size()) + L" (eligible count=" + StringUtils::toString(eligible.size()) + L") tooBigCount=" + StringUtils::toString(tooBigCount));
+
+        if (eligible.empty() || eligible.size() < allowedSegCountInt) {
+            return spec;
+        }
+
+        // We are over budget, so find the best merge
+        double bestScore = 0.0;
+        Collection<SegmentInfoPtr> best;
+        bool bestTooLarge = false;
+        int64_t bestMergeBytes = 0;
+
+        // Consider all merge starts
+        for (int32_t startIdx = 0; startIdx <= eligible.size() - maxMergeAtOnce; ++startIdx) {
+            int64_t totAfterMergeBytes = 0;
+            Collection<SegmentInfoPtr> candidate(Collection<SegmentInfoPtr>::newInstance());
+            bool hitTooLarge = false;
+            for (int32_t i = startIdx; i < eligible.size() && candidate.size() < maxMergeAtOnce; ++i) {
+                SegmentInfoPtr info(eligible[i]);
+                int64_t segBytes = size(info);
+
+                if (totAfterMergeBytes + segBytes > maxMergedSegmentBytes) {
+                    // We continue, so that we can try "packing" smaller segments into this merge to
+                    // see if we can get closer to the max size
+                    hitTooLarge = true;
+                    continue;
+                }
+                candidate.add(info);
+                totAfterMergeBytes += segBytes;
+            }
+
+            if (candidate.empty()) {
+                continue;
+            }
+
+            double mergeScore = score(candidate, hitTooLarge);
+            if (verbose()) {
+                message(L"  maybe=" + segString(candidate) + L" score=" + StringUtils::toString(mergeScore) + L" tooLarge=" + StringUtils::toString(hitTooLarge) + L" size=" + StringUtils::toString(totAfterMergeBytes));
+            }
+
+            // If we are already running a max sized merge, don't allow another max sized merge to kick off
+            if ((!best || mergeScore < bestScore) && (!hitTooLarge || !maxMergeIsRunning)) {
+                best = candidate;
+                bestScore = mergeScore;
+                bestTooLarge = hitTooLarge;
+                bestMergeBytes = totAfterMergeBytes;
+            }
+        }
+
+        if (!best) {
+            return spec;
+        }
+
+        if (!spec) {
+            spec = newLucene<MergeSpecification>();
+        }
+        spec->add(makeOneMerge(segmentInfos, best));
+        for (Collection<SegmentInfoPtr>::iterator info = best.begin(); info != best.end(); ++info) {
+            toBeMerged.add(*info);
+        }
+
+        if (verbose()) {
+            message(L"  add merge=" + segString(best) + L" size=" + StringUtils::toString(bestMergeBytes) + L" score=" + StringUtils::toString(bestScore) + (bestTooLarge ? L" [max merge]" : L""));
+        }
+    }
+}
+
+double TieredMergePolicy::score(Collection<SegmentInfoPtr> candidate, bool hitTooLarge) {
+    int64_t totBeforeMergeBytes = 0;
+    int64_t totAfterMergeBytes = 0;
+    int64_t totAfterMergeBytesFloored = 0;
+    for (Collection<SegmentInfoPtr>::iterator info = candidate.begin(); info != candidate.end(); ++info) {
+        int64_t segBytes = size(*info);
+        totAfterMergeBytes += segBytes;
+        totAfterMergeBytesFloored += floorSize(segBytes);
+        totBeforeMergeBytes += (*info)->sizeInBytes();
+    }
+
+    // Measure "skew" of the merge, which can range from 1.0/numSegsBeingMerged (good) to 1.0 (poor)
+    double skew;
+    if (hitTooLarge) {
+        // Pretend the merge has perfect skew; skew doesn't matter in this case because this merge will
+        // not "cascade" and so it cannot lead to N^2 merge cost over time
+        skew = 1.0 / (double)maxMergeAtOnce;
+    } else {
+        skew = (double)floorSize(size(candidate[0])) / (double)totAfterMergeBytesFloored;
+    }
+
+    // Strongly favor merges with less skew (smaller score is better)
+    double mergeScore = skew;
+
+    // Gently favor smaller merges over bigger ones.  We don't want to make this exponent too large else
+    // we can end up doing poor merges of small segments in order to avoid the large merges
+    mergeScore *= std::pow((double)std::max(totAfterMergeBytes, (int64_t)1), 0.05);
+
+    // Strongly favor merges that reclaim deletes
+    double nonDelRatio = totBeforeMergeBytes <= 0 ? 1.0 : ((double)totAfterMergeBytes / (double)totBeforeMergeBytes);
+    mergeScore *= std::pow(nonDelRatio, reclaimDeletesWeight);
+
+    return mergeScore;
+}
+
+MergeSpecificationPtr TieredMergePolicy::findMergesForOptimize(const SegmentInfosPtr& segmentInfos, int32_t maxSegmentCount, SetSegmentInfo segmentsToOptimize) {
+    BOOST_ASSERT(maxSegmentCount > 0);
+
+    message(L"findMergesForOptimize maxSegmentCount=" + StringUtils::toString(maxSegmentCount) + L" segmentsToOptimize=" + StringUtils::toString(segmentsToOptimize.size()));
+
+    SetSegmentInfo merging(IndexWriterPtr(_writer)->getMergingSegments());
+    Collection<SegmentInfoPtr> eligible(Collection<SegmentInfoPtr>::newInstance());
+    bool optimizeMergeRunning = false;
+    for (int32_t i = 0; i < segmentInfos->size(); ++i) {
+        SegmentInfoPtr info(segmentInfos->info(i));
+        if (segmentsToOptimize.contains(info)) {
+            if (merging.contains(info)) {
+                optimizeMergeRunning = true;
+            } else {
+                eligible.add(info);
+            }
+        }
+    }
+
+    if (eligible.empty()) {
+        return MergeSpecificationPtr();
+    }
+
+    if ((maxSegmentCount > 1 && eligible.size() <= maxSegmentCount) || (maxSegmentCount == 1 && eligible.size() == 1 && isOptimized(eligible[0]))) {
+        message(L"already optimized");
+        return MergeSpecificationPtr();
+    }
+
+    sortBySizeDescending(eligible);
+
+    int32_t end = eligible.size();
+    MergeSpecificationPtr spec;
+
+    // Do full merges first, starting from the smallest segments
+    while (end >= maxMergeAtOnceExplicit + maxSegmentCount - 1) {
+        if (!spec) {
+            spec = newLucene<MergeSpecification>();
+        }
+        OneMergePtr merge(makeOneMerge(segmentInfos, Collection<SegmentInfoPtr>::newInstance(eligible.begin() + end - maxMergeAtOnceExplicit, eligible.begin() + end)));
+        message(L"add merge=" + merge->segString(IndexWriterPtr(_writer)->getDirectory()));
+        spec->add(merge);
+        end -= maxMergeAtOnceExplicit;
+    }
+
+    if (!spec && !optimizeMergeRunning) {
+        // Do final merge
+        int32_t numToMerge = end - maxSegmentCount + 1;
+        OneMergePtr merge(makeOneMerge(segmentInfos, Collection<SegmentInfoPtr>::newInstance(eligible.begin() + end - numToMerge, eligible.begin() + end)));
+        message(L"add final merge=" + merge->segString(IndexWriterPtr(_writer)->getDirectory()));
+        spec = newLucene<MergeSpecification>();
+        spec->add(merge);
+    }
+
+    return spec;
+}
+
+MergeSpecificationPtr TieredMergePolicy::findMergesToExpungeDeletes(const SegmentInfosPtr& segmentInfos) {
+    message(L"findMergesToExpungeDeletes: " + StringUtils::toString(segmentInfos->size()) + L" segments expungeDeletesPctAllowed=" + StringUtils::toString(expungeDeletesPctAllowed));
+
+    IndexWriterPtr writer(_writer);
+    SetSegmentInfo merging(writer->getMergingSegments());
+    Collection<SegmentInfoPtr> eligible(Collection<SegmentInfoPtr>::newInstance());
+    for (int32_t i = 0; i < segmentInfos->size(); ++i) {
+        SegmentInfoPtr info(segmentInfos->info(i));
+        double pctDeletes = info->docCount <= 0 ? 0.0 : (100.0 * (double)writer->numDeletedDocs(info) / (double)info->docCount);
+        if (pctDeletes > expungeDeletesPctAllowed && !merging.contains(info)) {
+            eligible.add(info);
+        }
+    }
+
+    if (eligible.empty()) {
+        return MergeSpecificationPtr();
+    }
+
+    sortBySizeDescending(eligible);
+
+    MergeSpecificationPtr spec;
+    int32_t start = 0;
+    while (start < eligible.size()) {
+        // Don't enforce max merged size here: app is explicitly calling expungeDeletes, and knows this
+        // may take a long time / produce big segments (like optimize)
+        int32_t end = std::min(start + maxMergeAtOnceExplicit, eligible.size());
+        if (!spec) {
+            spec = newLucene<MergeSpecification>();
+        }
+        OneMergePtr merge(makeOneMerge(segmentInfos, Collection<SegmentInfoPtr>::newInstance(eligible.begin() + start, eligible.begin() + end)));
+        message(L"add merge=" + merge->segString(writer->getDirectory()));
+        spec->add(merge);
+        start = end;
+    }
+
+    return spec;
+}
+
+bool TieredMergePolicy::useCompoundFile(const SegmentInfosPtr& segments, const SegmentInfoPtr& newSegment) {
+    return _useCompoundFile;
+}
+
+bool TieredMergePolicy::useCompoundDocStore(const SegmentInfosPtr& segments) {
+    return _useCompoundDocStore;
+}
+
+void TieredMergePolicy::close() {
+}
+
+bool TieredMergePolicy::verbose() {
+    return (!_writer.expired() && IndexWriterPtr(_writer)->verbose());
+}
+
+void TieredMergePolicy::message(const String& message) {
+    if (verbose()) {
+        IndexWriterPtr(_writer)->message(L"TMP: " + message);
+    }
+}
+
+int64_t TieredMergePolicy::size(const SegmentInfoPtr& info) {
+    int64_t byteSize = info->sizeInBytes();
+    int32_t delCount = IndexWriterPtr(_writer)->numDeletedDocs(info);
+    double delRatio = info->docCount <= 0 ? 0.0 : ((double)delCount / (double)info->docCount);
+    BOOST_ASSERT(delRatio <= 1.0);
+    return (int64_t)((double)byteSize * (1.0 - delRatio));
+}
+
+int64_t TieredMergePolicy::floorSize(int64_t bytes) {
+    return std::max(floorSegmentBytes, bytes);
+}
+
+bool TieredMergePolicy::isOptimized(const SegmentInfoPtr& info) {
+    IndexWriterPtr writer(_writer);
+    bool hasDeletions = (writer->numDeletedDocs(info) > 0);
+    return (!hasDeletions && !info->hasSeparateNorms() && info->dir == writer->getDirectory() && (info->getUseCompoundFile() == _useCompoundFile || noCFSRatio < 1.0));
+}
+
+void TieredMergePolicy::sortBySizeDescending(Collection<SegmentInfoPtr> segments) {
+    // Negate the sizes so an ascending sort puts the largest segment first
+    Collection< std::pair<int64_t, int32_t> > order(Collection< std::pair<int64_t, int32_t> >::newInstance(segments.size()));
+    for (int32_t i = 0; i < segments.size(); ++i) {
+        order[i] = std::make_pair(-size(segments[i]), i);
+    }
+    std::sort(order.begin(), order.end());
+    Collection<SegmentInfoPtr> sorted(Collection<SegmentInfoPtr>::newInstance(segments.size()));
+    for (int32_t i = 0; i < segments.size(); ++i) {
+        sorted[i] = segments[order[i].second];
+    }
+    std::copy(sorted.begin(), sorted.end(), segments.begin());
+}
+
+OneMergePtr TieredMergePolicy::makeOneMerge(const SegmentInfosPtr& infos, Collection<SegmentInfoPtr> segments) {
+    SegmentInfosPtr infosToMerge(newLucene<SegmentInfos>());
+    int64_t mergeSize = 0;
+    int64_t totSize = 0;
+    for (int32_t i = 0; i < infos->size(); ++i) {
+        SegmentInfoPtr info(infos->info(i));
+        int64_t segBytes = size(info);
+        totSize += segBytes;
+        if (segments.contains(info)) {
+            infosToMerge->add(info);
+            mergeSize += segBytes;
+        }
+    }
+    BOOST_ASSERT(infosToMerge->size() == segments.size());
+
+    bool doCFS;
+    if (!_useCompoundFile) {
+        doCFS = false;
+    } else if (noCFSRatio == 1.0) {
+        doCFS = true;
+    } else {
+        doCFS = (mergeSize <= noCFSRatio * totSize);
+    }
+    return newLucene<OneMerge>(infosToMerge, doCFS);
+}
+
+String TieredMergePolicy::segString(Collection<SegmentInfoPtr> segments) {
+    StringStream buffer;
+    DirectoryPtr directory(IndexWriterPtr(_writer)->getDirectory());
+    for (Collection<SegmentInfoPtr>::iterator info = segments.begin(); info != segments.end(); ++info) {
+        if (info != segments.begin()) {
+            buffer << L" ";
+        }
+        buffer << (*info)->segString(directory);
+    }
+    return buffer.str();
+}
+
+}
@@ -0,0 +1,140 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "LuceneInc.h"
+#include "AutomatonTermEnum.h"
+#include "Automaton.h"
+#include "IndexReader.h"
+#include "Term.h"
+
+namespace Lucene {
+
+const int32_t AutomatonTermEnum::SEEK_THRESHOLD = 16;
+
+AutomatonTermEnum::AutomatonTermEnum(const IndexReaderPtr& reader, const String& field, const AutomatonPtr& automaton) {
+    ConstructTermEnum(reader, field, automaton);
+}
+
+AutomatonTermEnum::AutomatonTermEnum() {
+    this->_endEnum = false;
+    this->seekPending = false;
+    this->skipped = 0;
+}
+
+AutomatonTermEnum::~AutomatonTermEnum() {
+}
+
+void AutomatonTermEnum::ConstructTermEnum(const IndexReaderPtr& reader, const String& field, const AutomatonPtr& automaton) {
+    if (!automaton->isDeterministic()) {
+        boost::throw_exception(IllegalArgumentException(L"automaton must be deterministic"));
+    }
+    this->reader = reader;
+    this->field = field;
+    this->automaton = automaton;
+    this->_endEnum = false;
+    this->seekPending = false;
+    this->skipped = 0;
+    this->states = Collection<int32_t>::newInstance();
+    setEnum(reader->terms(newLucene<Term>(field, automaton->getCommonPrefix())));
+}
+
+double AutomatonTermEnum::difference() {
+    return 1.0;
+}
+
+bool AutomatonTermEnum::endEnum() {
+    return _endEnum;
+}
+
+bool AutomatonTermEnum::next() {
+    if (!actualEnum) {
+        return false; // the actual enumerator is not initialized
+    }
+    currentTerm.reset();
+    while (!_endEnum) {
+        if (seekPending && skipped >= SEEK_THRESHOLD) {
+            // many terms in a row cannot match, so jump to the next possible match
+            actualEnum->close();
+            actualEnum = reader->terms(newLucene<Term>(field, seekText));
+            seekPending = false;
+        } else if (!actualEnum->next()) {
+            return false;
+        }
+        TermPtr term(actualEnum->term());
+        if (!term) {
+            return false;
+        }
+        if (termCompare(term)) {
+            currentTerm = term;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AutomatonTermEnum::termCompare(const TermPtr& term) {
+    if (term->_field != field) {
+        _endEnum = true;
+        return false;
+    }
+
+    if (seekPending) {
+        // no term before seekText can be accepted
+        if (term->_text.compare(seekText) < 0) {
+            ++skipped;
+            return false;
+        }
+        seekPending = false;
+    }
+
+    int32_t consumed = runStates(term->_text);
+    if (consumed == (int32_t)term->_text.length() && automaton->isAccept(states[consumed])) {
+        return true;
+    }
+
+    if (nextString(term->_text, consumed, seekText)) {
+        seekPending = true;
+        skipped = 0;
+    } else {
+        _endEnum = true;
+    }
+    return false;
+}
+
+int32_t AutomatonTermEnum::runStates(const String& text) {
+    states.clear();
+    int32_t state = 0;
+    states.add(state);
+    int32_t length = (int32_t)text.length();
+    for (int32_t i = 0; i < length; ++i) {
+        state = automaton->step(state, text[i]);
+        if (state == -1) {
+            return i;
+        }
+        states.add(state);
+    }
+    return length;
+}
+
+bool AutomatonTermEnum::nextString(const String& text, int32_t consumed, String& next) {
+    int32_t label;
+    // try to extend text itself, then to increase the character at each position, rightmost first
+    if (consumed == (int32_t)text.length() && automaton->nextLabel(states[consumed], 0, label)) {
+        next = text;
+        next += (wchar_t)label;
+        return true;
+    }
+    for (int32_t i = std::min(consumed, (int32_t)text.length() - 1); i >= 0; --i) {
+        if (automaton->nextLabel(states[i], (int32_t)text[i] + 1, label)) {
+            next = text.substr(0, i);
+            next += (wchar_t)label;
+            return true;
+        }
+    }
+    return false;
+}
+
+}
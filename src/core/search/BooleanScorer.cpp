@@ -7,6 +7,7 @@
 #include "LuceneInc.h"
 #include "BooleanScorer.h"
 #include "Similarity.h"
+#include "MiscUtils.h"
 
 namespace Lucene {
 
@@ -19,6 +20,7 @@ BooleanScorer::BooleanScorer(const SimilarityPtr& similarity, int32_t minNrShoul
     this->minNrShouldMatch = minNrShouldMatch;
     this->end = 0;
     this->doc = -1;
+    this->current = -1;
 
     if (optionalScorers && !optionalScorers.empty()) {
         for (Collection<ScorerPtr>::iterator scorer = optionalScorers.begin(); scorer != optionalScorers.end(); ++scorer) {
@@ -52,37 +54,43 @@ BooleanScorer::~BooleanScorer() {
 
 bool BooleanScorer::score(const CollectorPtr& collector, int32_t max, int32_t firstDocID) {
     bool more = false;
-    BucketPtr tmp;
+    int32_t tmp;
+    BucketTable* table = bucketTable.get();
+    int32_t* docs = table->docs.get();
+    double* scores = table->scores.get();
+    int32_t* bits = table->bits.get();
+    int32_t* coords = table->coords.get();
+    int32_t* next = table->next.get();
     BucketScorerPtr bs(newLucene<BucketScorer>());
     // The internal loop will set the score and doc before calling collect.
     collector->setScorer(bs);
     do {
-        bucketTable->first.reset();
+        table->first = -1;
 
-        while (current) { // more queued
+        while (current != -1) { // more queued
             // check prohibited & required
-            if ((current->bits & prohibitedMask) == 0 && (current->bits & requiredMask) == requiredMask) {
-                if (current->doc >= max) {
+            if ((bits[current] & prohibitedMask) == 0 && (bits[current] & requiredMask) == requiredMask) {
+                if (docs[current] >= max) {
                     tmp = current;
-                    current = current->_next.lock();
-                    tmp->_next = bucketTable->first;
-                    bucketTable->first = tmp;
+                    current = next[current];
+                    next[tmp] = table->first;
+                    table->first = tmp;
                     continue;
                 }
 
-                if (current->coord >= minNrShouldMatch) {
-                    bs->_score = current->score * coordFactors[current->coord];
-                    bs->doc = current->doc;
-                    collector->collect(current->doc);
+                if (coords[current] >= minNrShouldMatch) {
+                    bs->_score = scores[current] * coordFactors[coords[current]];
+                    bs->doc = docs[current];
+                    collector->collect(docs[current]);
                 }
             }
 
-            current = current->_next.lock(); // pop the queue
+            current = next[current]; // pop the queue
         }
 
-        if (bucketTable->first) {
-            current = bucketTable->first;
-            bucketTable->first = current->_next.lock();
+        if (table->first != -1) {
+            current = table->first;
+            table->first = next[current];
             return true;
         }
 
@@ -98,8 +106,8 @@ bool BooleanScorer::score(const CollectorPtr& collector, int32_t max, int32_t fi
                 }
             }
         }
-        current = bucketTable->first;
-    } while (current || more);
+        current = table->first;
+    } while (current != -1 || more);
 
     return false;
 }
@@ -115,14 +123,16 @@ int32_t BooleanScorer::docID() {
 
 int32_t BooleanScorer::nextDoc() {
     bool more = false;
+    BucketTable* table = bucketTable.get();
     do {
-        while (bucketTable->first) { // more queued
-            current = bucketTable->first;
-            bucketTable->first = current->_next.lock(); // pop the queue
+        while (table->first != -1) { // more queued
+            current = table->first;
+            table->first = table->next[current]; // pop the queue
 
             // check prohibited & required and minNrShouldMatch
-            if ((current->bits & prohibitedMask) == 0 && (current->bits & requiredMask) == requiredMask && current->coord >= minNrShouldMatch) {
-                doc = current->doc;
+            int32_t bits = table->bits[current];
+            if ((bits & prohibitedMask) == 0 && (bits & requiredMask) == requiredMask && table->coords[current] >= minNrShouldMatch) {
+                doc = table->docs[current];
                 return doc;
             }
         }
@@ -143,14 +153,14 @@ int32_t BooleanScorer::nextDoc() {
                 more = true;
             }
         }
-    } while (bucketTable->first || more);
+    } while (table->first != -1 || more);
 
     doc = NO_MORE_DOCS;
     return doc;
 }
 
 double BooleanScorer::score() {
-    return current->score * coordFactors[current->coord];
+    return bucketTable->scores[current] * coordFactors[bucketTable->coords[current]];
 }
 
 void BooleanScorer::score(const CollectorPtr& collector) {
@@ -169,33 +179,28 @@ String BooleanScorer::toString() {
 
 BooleanScorerCollector::BooleanScorerCollector(int32_t mask, const BucketTablePtr& bucketTable) {
     this->mask = mask;
-    this->_bucketTable = bucketTable;
+    this->bucketTable = bucketTable;
 }
 
 BooleanScorerCollector::~BooleanScorerCollector() {
 }
 
 void BooleanScorerCollector::collect(int32_t doc) {
-    BucketTablePtr table(_bucketTable);
+    BucketTable* table = bucketTable.get();
     int32_t i = doc & BucketTable::MASK;
-    BucketPtr bucket(table->buckets[i]);
-    if (!bucket) {
-        bucket = newLucene<Bucket>();
-        table->buckets[i] = bucket;
-    }
 
-    if (bucket->doc != doc) { // invalid bucket
-        bucket->doc = doc; // set doc
-        bucket->score = ScorerPtr(_scorer)->score(); // initialize score
-        bucket->bits = mask; // initialize mask
-        bucket->coord = 1; // initialize coord
+    if (table->docs[i] != doc) { // invalid bucket
+        table->docs[i] = doc; // set doc
+        table->scores[i] = scorer->score(); // initialize score
+        table->bits[i] = mask; // initialize mask
+        table->coords[i] = 1; // initialize coord
 
-        bucket->_next = table->first; // push onto valid list
-        table->first = bucket;
+        table->next[i] = table->first; // push onto valid list
+        table->first = i;
     } else {
-        bucket->score += ScorerPtr(_scorer)->score(); // increment score
-        bucket->bits |= mask; // add bits in mask
-        ++bucket->coord; // increment coord
+        table->scores[i] += scorer->score(); // increment score
+        table->bits[i] |= mask; // add bits in mask
+        ++table->coords[i]; // increment coord
     }
 }
 
@@ -204,7 +209,7 @@ void BooleanScorerCollector::setNextReader(const IndexReaderPtr& reader, int32_t
 }
 
 void BooleanScorerCollector::setScorer(const ScorerPtr& scorer) {
-    this->_scorer = scorer;
+    this->scorer = scorer;
 }
 
 bool BooleanScorerCollector::acceptsDocsOutOfOrder() {
@@ -235,21 +240,18 @@ double BucketScorer::score() {
     return _score;
 }
 
-Bucket::Bucket() {
-    doc = -1;
-    score = 0;
-    bits = 0;
-    coord = 0;
-}
-
-Bucket::~Bucket() {
-}
-
 const int32_t BucketTable::SIZE = 1 << 11;
 const int32_t BucketTable::MASK = BucketTable::SIZE - 1;
 
 BucketTable::BucketTable() {
-    buckets = Collection<BucketPtr>::newInstance(SIZE);
+    docs = IntArray::newInstance(SIZE);
+    scores = DoubleArray::newInstance(SIZE);
+    bits = IntArray::newInstance(SIZE);
+    coords = IntArray::newInstance(SIZE);
+    next = IntArray::newInstance(SIZE);
+    MiscUtils::arrayFill(docs.get(), 0, SIZE, -1);
+    MiscUtils::arrayFill(next.get(), 0, SIZE, -1);
+    first = -1;
 }
 
 BucketTable::~BucketTable() {
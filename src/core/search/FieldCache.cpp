@@ -8,8 +8,11 @@
 #include "FieldCache.h"
 #include "_FieldCache.h"
 #include "FieldCacheImpl.h"
+#include "MiscUtils.h"
 #include "NumericUtils.h"
 #include "StringUtils.h"
+#include "UnicodeUtils.h"
+#include "VariantUtils.h"
 
 namespace Lucene {
 
@@ -141,6 +144,26 @@ StringIndexPtr FieldCache::getStringIndex(const IndexReaderPtr& reader, const St
     return StringIndexPtr(); // override
 }
 
+PackedIntsPtr FieldCache::getPackedInts(const IndexReaderPtr& reader, const String& field) {
+    BOOST_ASSERT(false);
+    return PackedIntsPtr(); // override
+}
+
+PackedIntsPtr FieldCache::getPackedInts(const IndexReaderPtr& reader, const String& field, const IntParserPtr& parser) {
+    BOOST_ASSERT(false);
+    return PackedIntsPtr(); // override
+}
+
+PackedIntsPtr FieldCache::getPackedLongs(const IndexReaderPtr& reader, const String& field) {
+    BOOST_ASSERT(false);
+    return PackedIntsPtr(); // override
+}
+
+PackedIntsPtr FieldCache::getPackedLongs(const IndexReaderPtr& reader, const String& field, const LongParserPtr& parser) {
+    BOOST_ASSERT(false);
+    return PackedIntsPtr(); // override
+}
+
 void FieldCache::setInfoStream(const InfoStreamPtr& stream) {
     BOOST_ASSERT(false);
     // override
@@ -151,21 +174,94 @@ InfoStreamPtr FieldCache::getInfoStream() {
     return InfoStreamPtr(); // override
 }
 
+int64_t FieldCache::ramBytesUsed() {
+    BOOST_ASSERT(false);
+    return 0; // override
+}
+
+void FieldCache::setMaxRamBytes(int64_t maxRamBytes) {
+    BOOST_ASSERT(false);
+    // override
+}
+
+int64_t FieldCache::getMaxRamBytes() {
+    BOOST_ASSERT(false);
+    return 0; // override
+}
+
 CreationPlaceholder::~CreationPlaceholder() {
 }
 
 StringIndex::StringIndex(Collection<int32_t> values, Collection<String> lookup) {
-    this->order = values;
-    this->lookup = lookup;
+    this->order = PackedInts::forRange(values.size(), 0, std::max(lookup.size() - 1, 0));
+    for (int32_t doc = 0; doc < values.size(); ++doc) {
+        order->set(doc, values[doc]);
+    }
+
+    Collection<int32_t> offsets(Collection<int32_t>::newInstance(lookup.size() + 1));
+    UTF8ResultPtr utf8(newLucene<UTF8Result>());
+    int32_t upto = 0;
+    this->termBytes = ByteArray::newInstance(std::max(lookup.size() * 8, 16));
+    for (int32_t ord = 0; ord < lookup.size(); ++ord) {
+        StringUtils::toUTF8(lookup[ord].c_str(), lookup[ord].length(), utf8);
+        if (upto + utf8->length > termBytes.size()) {
+            termBytes.resize(MiscUtils::getNextSize(upto + utf8->length));
+        }
+        MiscUtils::arrayCopy(utf8->result.get(), 0, termBytes.get(), upto, utf8->length);
+        offsets[ord] = upto;
+        upto += utf8->length;
+    }
+    offsets[lookup.size()] = upto;
+    termBytes.resize(std::max(upto, 1));
+
+    this->termOffsets = PackedInts::forRange(offsets.size(), 0, upto);
+    for (int32_t ord = 0; ord < offsets.size(); ++ord) {
+        termOffsets->set(ord, offsets[ord]);
+    }
+}
+
+StringIndex::StringIndex(const PackedIntsPtr& order, ByteArray termBytes, const PackedIntsPtr& termOffsets) {
+    this->order = order;
+    this->termBytes = termBytes;
+    this->termOffsets = termOffsets;
 }
 
 StringIndex::~StringIndex() {
 }
 
+int32_t StringIndex::size() {
+    return order->size();
+}
+
+int32_t StringIndex::numOrd() {
+    return termOffsets->size() - 1;
+}
+
+String StringIndex::lookup(int32_t ord) {
+    int32_t start = (int32_t)termOffsets->get(ord);
+    return StringUtils::toUnicode(termBytes.get() + start, (int32_t)termOffsets->get(ord + 1) - start);
+}
+
 int32_t StringIndex::binarySearchLookup(const String& key) {
-    Collection<String>::iterator search = std::lower_bound(lookup.begin(), lookup.end(), key);
-    int32_t keyPos = std::distance(lookup.begin(), search);
-    return (search == lookup.end() || key < *search) ? -(keyPos + 1) : keyPos;
+    return binarySearchLookup(key, 0, numOrd() - 1);
+}
+
+int32_t StringIndex::binarySearchLookup(const String& key, int32_t low, int32_t high) {
+    // find the first ord whose term is not less than the key
+    int32_t last = high;
+    while (low <= high) {
+        int32_t mid = MiscUtils::unsignedShift(low + high, 1);
+        if (lookup(mid).compare(key) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return (low > last || lookup(low) != key) ? -(low + 1) : low;
+}
+
+int64_t StringIndex::ramBytesUsed() {
+    return order->ramBytesUsed() + termBytes.size() + termOffsets->ramBytesUsed();
 }
 
 Parser::~Parser() {
@@ -291,6 +387,34 @@ String NumericUtilsDoubleParser::toString() {
 FieldCacheEntry::~FieldCacheEntry() {
 }
 
+int64_t FieldCacheEntry::ramBytesUsed() {
+    return ramBytesUsed(getValue());
+}
+
+int64_t FieldCacheEntry::ramBytesUsed(const boost::any& value) {
+    if (VariantUtils::typeOf< Collection<uint8_t> >(value)) {
+        return (int64_t)VariantUtils::get< Collection<uint8_t> >(value).size() * sizeof(uint8_t);
+    } else if (VariantUtils::typeOf< Collection<int32_t> >(value)) {
+        return (int64_t)VariantUtils::get< Collection<int32_t> >(value).size() * sizeof(int32_t);
+    } else if (VariantUtils::typeOf< Collection<int64_t> >(value)) {
+        return (int64_t)VariantUtils::get< Collection<int64_t> >(value).size() * sizeof(int64_t);
+    } else if (VariantUtils::typeOf< Collection<double> >(value)) {
+        return (int64_t)VariantUtils::get< Collection<double> >(value).size() * sizeof(double);
+    } else if (VariantUtils::typeOf< Collection<String> >(value)) {
+        Collection<String> strings(VariantUtils::get< Collection<String> >(value));
+        int64_t bytes = (int64_t)strings.size() * sizeof(String);
+        for (Collection<String>::iterator string = strings.begin(); string != strings.end(); ++string) {
+            bytes += (int64_t)string->capacity() * sizeof(wchar_t);
+        }
+        return bytes;
+    } else if (VariantUtils::typeOf<StringIndexPtr>(value)) {
+        return VariantUtils::get<StringIndexPtr>(value)->ramBytesUsed();
+    } else if (VariantUtils::typeOf<PackedIntsPtr>(value)) {
+        return VariantUtils::get<PackedIntsPtr>(value)->ramBytesUsed();
+    }
+    return 0;
+}
+
 String FieldCacheEntry::toString() {
     StringStream buffer;
     buffer << L"'" << getReaderKey()->toString() << L"'=>" << getFieldName() << L"'," << getCacheType();
@@ -5,6 +5,8 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include "LuceneInc.h"
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
 #include "FieldCacheImpl.h"
 #include "FieldCacheSanityChecker.h"
 #include "IndexReader.h"
@@ -14,10 +16,16 @@
 #include "Term.h"
 #include "StringUtils.h"
 #include "VariantUtils.h"
+#include "MiscUtils.h"
+#include "UnicodeUtils.h"
+#include "OpenBitSet.h"
+#include "PackedInts.h"
 
 namespace Lucene {
 
 FieldCacheImpl::FieldCacheImpl() {
+    maxRamBytes = 0;
+    accessClock = 0;
 }
 
 FieldCacheImpl::~FieldCacheImpl() {
@@ -31,6 +39,8 @@ void FieldCacheImpl::initialize() {
     caches.put(CACHE_DOUBLE, newLucene<DoubleCache>(shared_from_this()));
     caches.put(CACHE_STRING, newLucene<StringCache>(shared_from_this()));
     caches.put(CACHE_STRING_INDEX, newLucene<StringIndexCache>(shared_from_this()));
+    caches.put(CACHE_PACKED_INT, newLucene<PackedIntCache>(shared_from_this()));
+    caches.put(CACHE_PACKED_LONG, newLucene<PackedLongCache>(shared_from_this()));
 }
 
 void FieldCacheImpl::purgeAllCaches() {
@@ -100,6 +110,22 @@ StringIndexPtr FieldCacheImpl::getStringIndex(const IndexReaderPtr& reader, cons
     return VariantUtils::get< StringIndexPtr >(caches.get(CACHE_STRING_INDEX)->get(reader, newLucene<Entry>(field, ParserPtr())));
 }
 
+PackedIntsPtr FieldCacheImpl::getPackedInts(const IndexReaderPtr& reader, const String& field) {
+    return getPackedInts(reader, field, IntParserPtr());
+}
+
+PackedIntsPtr FieldCacheImpl::getPackedInts(const IndexReaderPtr& reader, const String& field, const IntParserPtr& parser) {
+    return VariantUtils::get<PackedIntsPtr>(caches.get(CACHE_PACKED_INT)->get(reader, newLucene<Entry>(field, parser)));
+}
+
+PackedIntsPtr FieldCacheImpl::getPackedLongs(const IndexReaderPtr& reader, const String& field) {
+    return getPackedLongs(reader, field, LongParserPtr());
+}
+
+PackedIntsPtr FieldCacheImpl::getPackedLongs(const IndexReaderPtr& reader, const String& field, const LongParserPtr& parser) {
+    return VariantUtils::get<PackedIntsPtr>(caches.get(CACHE_PACKED_LONG)->get(reader, newLucene<Entry>(field, parser)));
+}
+
 void FieldCacheImpl::setInfoStream(const InfoStreamPtr& stream) {
     infoStream = stream;
 }
@@ -108,9 +134,113 @@ InfoStreamPtr FieldCacheImpl::getInfoStream() {
     return infoStream;
 }
 
+/// A cached value with the entries that refer to it; an entry created without a parser shares the value
+/// of the entry for the default parser.
+struct CachedValue {
+    int64_t ramBytes;
+    int64_t lastAccess;
+    std::vector< std::pair<CachePtr, std::pair<LuceneObjectPtr, EntryPtr> > > entries;
+};
+
+typedef std::map<const void*, CachedValue> MapCachedValues;
+
+/// Identity of a cached value, shared by all entries that refer to the same array or object.
+static const void* valueIdentity(const boost::any& value) {
+    if (VariantUtils::typeOf<StringIndexPtr>(value)) {
+        return VariantUtils::get<StringIndexPtr>(value).get();
+    }
+    if (VariantUtils::typeOf<PackedIntsPtr>(value)) {
+        return VariantUtils::get<PackedIntsPtr>(value).get();
+    }
+    return (const void*)(intptr_t)VariantUtils::hashCode(value);
+}
+
+static void collectCachedValues(MapStringCache caches, MapCachedValues& values) {
+    for (MapStringCache::iterator cache = caches.begin(); cache != caches.end(); ++cache) {
+        SyncLock cacheLock(&cache->second->readerCache);
+        for (WeakMapLuceneObjectMapEntryAny::iterator key = cache->second->readerCache.begin(); key != cache->second->readerCache.end(); ++key) {
+            LuceneObjectPtr readerKey(key->first.lock());
+            if (!readerKey) {
+                continue;
+            }
+            for (MapEntryAny::iterator mapEntry = key->second.begin(); mapEntry != key->second.end(); ++mapEntry) {
+                if (VariantUtils::typeOf<CreationPlaceholderPtr>(mapEntry->second)) {
+                    continue; // not created yet
+                }
+                const void* hash = valueIdentity(mapEntry->second);
+                if (values.find(hash) == values.end()) {
+                    values[hash].ramBytes = 0;
+                    values[hash].lastAccess = 0;
+                }
+                CachedValue& value = values[hash];
+                value.ramBytes = std::max(value.ramBytes, mapEntry->first->ramBytes);
+                value.lastAccess = std::max(value.lastAccess, mapEntry->first->lastAccess);
+                value.entries.push_back(std::make_pair(cache->second, std::make_pair(readerKey, mapEntry->first)));
+            }
+        }
+    }
+}
+
+int64_t FieldCacheImpl::ramBytesUsed() {
+    MapCachedValues values;
+    collectCachedValues(caches, values);
+    int64_t bytes = 0;
+    for (MapCachedValues::iterator value = values.begin(); value != values.end(); ++value) {
+        bytes += value->second.ramBytes;
+    }
+    return bytes;
+}
+
+void FieldCacheImpl::setMaxRamBytes(int64_t maxRamBytes) {
+    this->maxRamBytes = maxRamBytes;
+    enforceRamBudget();
+}
+
+int64_t FieldCacheImpl::getMaxRamBytes() {
+    return maxRamBytes;
+}
+
+int64_t FieldCacheImpl::nextAccess() {
+    SyncLock syncLock(this);
+    return ++accessClock;
+}
+
+void FieldCacheImpl::enforceRamBudget() {
+    if (maxRamBytes <= 0) {
+        return;
+    }
+    SyncLock syncLock(this); // one eviction at a time
+
+    MapCachedValues values;
+    collectCachedValues(caches, values);
+    int64_t bytes = 0;
+    std::vector< std::pair<int64_t, const void*> > byAccess;
+    for (MapCachedValues::iterator value = values.begin(); value != values.end(); ++value) {
+        bytes += value->second.ramBytes;
+        byAccess.push_back(std::make_pair(value->second.lastAccess, value->first));
+    }
+    std::sort(byAccess.begin(), byAccess.end());
+
+    // drop the least recently used values, but never the most recently used one
+    for (int32_t i = 0; bytes > maxRamBytes && i + 1 < (int32_t)byAccess.size(); ++i) {
+        CachedValue& value = values[byAccess[i].second];
+        for (int32_t j = 0; j < (int32_t)value.entries.size(); ++j) {
+            CachePtr cache(value.entries[j].first);
+            SyncLock cacheLock(&cache->readerCache);
+            MapEntryAny innerCache(cache->readerCache.get(value.entries[j].second.first));
+            if (innerCache) {
+                innerCache.remove(value.entries[j].second.second);
+            }
+        }
+        bytes -= value.ramBytes;
+    }
+}
+
 Entry::Entry(const String& field, const boost::any& custom) {
     this->field = field;
     this->custom = custom;
+    this->ramBytes = 0;
+    this->lastAccess = 0;
 }
 
 Entry::~Entry() {
@@ -152,29 +282,41 @@ boost::any Cache::get(const IndexReaderPtr& reader, const EntryPtr& key) {
     MapEntryAny innerCache;
     boost::any value;
     LuceneObjectPtr readerKey(reader->getFieldCacheKey());
+    FieldCacheImplPtr wrapperImpl(boost::dynamic_pointer_cast<FieldCacheImpl>(FieldCachePtr(_wrapper.lock())));
+    int64_t access = wrapperImpl ? wrapperImpl->nextAccess() : 0;
+    EntryPtr cachedKey(key);
     {
         SyncLock cacheLock(&readerCache);
         innerCache = readerCache.get(readerKey);
         if (!innerCache) {
             innerCache = MapEntryAny::newInstance();
             readerCache.put(readerKey, innerCache);
-        } else if (innerCache.contains(key)) {
-            value = innerCache[key];
+        } else {
+            MapEntryAny::iterator existing = innerCache.find(key);
+            if (existing != innerCache.end()) {
+                cachedKey = existing->first;
+                value = existing->second;
+            }
         }
         if (VariantUtils::isNull(value)) {
             value = newLucene<CreationPlaceholder>();
             innerCache.put(key, value);
         }
+        cachedKey->lastAccess = access;
     }
     if (VariantUtils::typeOf<CreationPlaceholderPtr>(value)) {
         CreationPlaceholderPtr progress(VariantUtils::get<CreationPlaceholderPtr>(value));
         SyncLock valueLock(progress);
         if (VariantUtils::isNull(progress->value)) {
             progress->value = createValue(reader, key);
+            cachedKey->ramBytes = FieldCacheEntry::ramBytesUsed(progress->value);
             {
                 SyncLock cacheLock(&readerCache);
                 innerCache.put(key, progress->value);
             }
+            if (wrapperImpl) {
+                wrapperImpl->enforceRamBudget();
+            }
 
             FieldCachePtr wrapper(_wrapper);
 
@@ -256,6 +398,14 @@ boost::any IntCache::createValue(const IndexReaderPtr& reader, const EntryPtr& k
     String field(entry->field);
     IntParserPtr parser(VariantUtils::get<IntParserPtr>(entry->custom));
     if (!parser) {
+        PackedIntsPtr docValues(reader->getNumericDocValues(field));
+        if (docValues) {
+            Collection<int32_t> retArray(Collection<int32_t>::newInstance(docValues->size()));
+            for (int32_t doc = 0; doc < retArray.size(); ++doc) {
+                retArray[doc] = (int32_t)docValues->get(doc);
+            }
+            return retArray;
+        }
         FieldCachePtr wrapper(_wrapper);
         boost::any ints;
         try {
@@ -308,6 +458,14 @@ boost::any LongCache::createValue(const IndexReaderPtr& reader, const EntryPtr&
     String field(entry->field);
     LongParserPtr parser(VariantUtils::get<LongParserPtr>(entry->custom));
     if (!parser) {
+        PackedIntsPtr docValues(reader->getNumericDocValues(field));
+        if (docValues) {
+            Collection<int64_t> retArray(Collection<int64_t>::newInstance(docValues->size()));
+            for (int32_t doc = 0; doc < retArray.size(); ++doc) {
+                retArray[doc] = docValues->get(doc);
+            }
+            return retArray;
+        }
         FieldCachePtr wrapper(_wrapper);
         boost::any longs;
         try {
@@ -411,6 +569,13 @@ boost::any StringCache::createValue(const IndexReaderPtr& reader, const EntryPtr
     EntryPtr entry(key);
     String field(entry->field);
     Collection<String> retArray(Collection<String>::newInstance(reader->maxDoc()));
+    StringIndexPtr docValues(reader->getSortedDocValues(field));
+    if (docValues) {
+        for (int32_t doc = 0; doc < retArray.size(); ++doc) {
+            retArray[doc] = docValues->lookup(docValues->getOrd(doc));
+        }
+        return retArray;
+    }
     TermDocsPtr termDocs(reader->termDocs());
     TermEnumPtr termEnum(reader->terms(newLucene<Term>(field)));
     LuceneException finally;
@@ -444,31 +609,66 @@ StringIndexCache::~StringIndexCache() {
 boost::any StringIndexCache::createValue(const IndexReaderPtr& reader, const EntryPtr& key) {
     EntryPtr entry(key);
     String field(entry->field);
-    Collection<int32_t> retArray(Collection<int32_t>::newInstance(reader->maxDoc()));
-    Collection<String> mterms(Collection<String>::newInstance(reader->maxDoc() + 1));
-    TermDocsPtr termDocs(reader->termDocs());
+    int32_t maxDoc = reader->maxDoc();
+
+    // per-document values are loaded in the same form
+    StringIndexPtr docValues(reader->getSortedDocValues(field));
+    if (docValues) {
+        return docValues;
+    }
+
+    // count the terms first so that the ords can be packed with as few bits as possible
+    int32_t numTerms = 0;
     TermEnumPtr termEnum(reader->terms(newLucene<Term>(field)));
-    int32_t t = 0; // current term number
+    LuceneException finally;
+    try {
+        do {
+            TermPtr term(termEnum->term());
+            if (!term || term->field() != field || numTerms >= maxDoc) {
+                break;
+            }
+            ++numTerms;
+        } while (termEnum->next());
+    } catch (LuceneException& e) {
+        finally = e;
+    }
+    termEnum->close();
+    finally.throwException();
+
+    PackedIntsPtr order(PackedInts::forRange(maxDoc, 0, numTerms));
+    IntArray offsets(IntArray::newInstance(numTerms + 2));
+    ByteArray termBytes(ByteArray::newInstance(16));
+    UTF8ResultPtr utf8(newLucene<UTF8Result>());
+    int32_t upto = 0;
 
     // an entry for documents that have no terms in this field should a document with no terms be at
     // top or bottom?  This puts them at the top - if it is changed, FieldDocSortedHitQueue needs to
     // change as well.
-    mterms[t++] = L"";
+    offsets[0] = 0;
+    int32_t t = 1; // current term number
 
-    LuceneException finally;
+    TermDocsPtr termDocs(reader->termDocs());
+    termEnum = reader->terms(newLucene<Term>(field));
     try {
         do {
             TermPtr term(termEnum->term());
-            if (!term || term->field() != field || t >= mterms.size() ) {
+            if (!term || term->field() != field || t > numTerms) {
                 break;
             }
 
             // store term text
-            mterms[t] = term->text();
+            String text(term->text());
+            StringUtils::toUTF8(text.c_str(), text.length(), utf8);
+            if (upto + utf8->length > termBytes.size()) {
+                termBytes.resize(MiscUtils::getNextSize(upto + utf8->length));
+            }
+            MiscUtils::arrayCopy(utf8->result.get(), 0, termBytes.get(), upto, utf8->length);
+            offsets[t] = upto;
+            upto += utf8->length;
 
             termDocs->seek(termEnum);
             while (termDocs->next()) {
-                retArray[termDocs->doc()] = t;
+                order->set(termDocs->doc(), t);
             }
 
             ++t;
@@ -480,15 +680,161 @@ boost::any StringIndexCache::createValue(const IndexReaderPtr& reader, const Ent
     termEnum->close();
     finally.throwException();
 
-    if (t == 0) {
-        // if there are no terms, make the term array have a single null entry
-        mterms = Collection<String>::newInstance(1);
-    } else if (t < mterms.size()) {
-        // if there are less terms than documents, trim off the dead array space
-        mterms.resize(t);
+    offsets[t] = upto;
+    termBytes.resize(std::max(upto, 1));
+    PackedIntsPtr termOffsets(PackedInts::forRange(t + 1, 0, upto));
+    for (int32_t ord = 0; ord <= t; ++ord) {
+        termOffsets->set(ord, offsets[ord]);
     }
 
-    return newLucene<StringIndex>(retArray, mterms);
+    return newLucene<StringIndex>(order, termBytes, termOffsets);
+}
+
+/// Packs the values of the terms in a numeric field, using one pass over the terms to find the range of
+/// values and a second one to fill in the documents.
+static PackedIntsPtr createPackedValues(const IndexReaderPtr& reader, const String& field, const boost::function<int64_t (const String&)>& parse) {
+    int32_t maxDoc = reader->maxDoc();
+    int64_t minValue = 0;
+    int64_t maxValue = 0;
+    int64_t sumDocFreq = 0;
+    bool hasValues = false;
+    TermEnumPtr termEnum(reader->terms(newLucene<Term>(field)));
+    LuceneException finally;
+    try {
+        do {
+            TermPtr term(termEnum->term());
+            if (!term || term->field() != field) {
+                break;
+            }
+            int64_t termval = parse(term->text());
+            minValue = hasValues ? std::min(minValue, termval) : termval;
+            maxValue = hasValues ? std::max(maxValue, termval) : termval;
+            sumDocFreq += termEnum->docFreq();
+            hasValues = true;
+        } while (termEnum->next());
+    } catch (StopFillCacheException&) {
+    } catch (LuceneException& e) {
+        finally = e;
+    }
+    termEnum->close();
+    finally.throwException();
+
+    if (!hasValues) { // no values
+        return newLucene<PackedInts>(maxDoc, 0);
+    }
+
+    // documents without a value get 0, so keep 0 in range unless every document may have a value
+    bool mayMissValues = (sumDocFreq < maxDoc);
+    if (mayMissValues) {
+        minValue = std::min(minValue, (int64_t)0);
+        maxValue = std::max(maxValue, (int64_t)0);
+    }
+    PackedIntsPtr values(PackedInts::forRange(maxDoc, minValue, maxValue));
+    if (minValue != 0 && mayMissValues) {
+        for (int32_t doc = 0; doc < maxDoc; ++doc) {
+            values->set(doc, 0);
+        }
+    }
+    OpenBitSetPtr docsWithValue(mayMissValues ? OpenBitSetPtr() : newLucene<OpenBitSet>(maxDoc));
+
+    TermDocsPtr termDocs(reader->termDocs());
+    termEnum = reader->terms(newLucene<Term>(field));
+    try {
+        do {
+            TermPtr term(termEnum->term());
+            if (!term || term->field() != field) {
+                break;
+            }
+            int64_t termval = parse(term->text());
+            termDocs->seek(termEnum);
+            while (termDocs->next()) {
+                values->set(termDocs->doc(), termval);
+                if (docsWithValue) {
+                    docsWithValue->fastSet(termDocs->doc());
+                }
+            }
+        } while (termEnum->next());
+    } catch (StopFillCacheException&) {
+    } catch (LuceneException& e) {
+        finally = e;
+    }
+    termDocs->close();
+    termEnum->close();
+    finally.throwException();
+
+    if (docsWithValue && docsWithValue->cardinality() < maxDoc) {
+        // some documents have no value after all (multi-valued field, deletions), repack with 0 in range
+        PackedIntsPtr repacked(PackedInts::forRange(maxDoc, std::min(minValue, (int64_t)0), std::max(maxValue, (int64_t)0)));
+        for (int32_t doc = 0; doc < maxDoc; ++doc) {
+            repacked->set(doc, docsWithValue->fastGet(doc) ? values->get(doc) : 0);
+        }
+        values = repacked;
+    }
+    return values;
+}
+
+static int64_t parsePackedInt(const IntParserPtr& parser, const String& text) {
+    return parser->parseInt(text);
+}
+
+static int64_t parsePackedLong(const LongParserPtr& parser, const String& text) {
+    return parser->parseLong(text);
+}
+
+PackedIntCache::PackedIntCache(const FieldCachePtr& wrapper) : Cache(wrapper) {
+}
+
+PackedIntCache::~PackedIntCache() {
+}
+
+boost::any PackedIntCache::createValue(const IndexReaderPtr& reader, const EntryPtr& key) {
+    EntryPtr entry(key);
+    String field(entry->field);
+    IntParserPtr parser(VariantUtils::get<IntParserPtr>(entry->custom));
+    if (!parser) {
+        // per-document values are loaded already packed
+        PackedIntsPtr docValues(reader->getNumericDocValues(field));
+        if (docValues) {
+            return docValues;
+        }
+        FieldCachePtr wrapper(_wrapper);
+        boost::any ints;
+        try {
+            ints = wrapper->getPackedInts(reader, field, FieldCache::DEFAULT_INT_PARSER());
+        } catch (NumberFormatException&) {
+            ints = wrapper->getPackedInts(reader, field, FieldCache::NUMERIC_UTILS_INT_PARSER());
+        }
+        return ints;
+    }
+    return createPackedValues(reader, field, boost::bind(&parsePackedInt, parser, _1));
+}
+
+PackedLongCache::PackedLongCache(const FieldCachePtr& wrapper) : Cache(wrapper) {
+}
+
+PackedLongCache::~PackedLongCache() {
+}
+
+boost::any PackedLongCache::createValue(const IndexReaderPtr& reader, const EntryPtr& key) {
+    EntryPtr entry(key);
+    String field(entry->field);
+    LongParserPtr parser(VariantUtils::get<LongParserPtr>(entry->custom));
+    if (!parser) {
+        // per-document values are loaded already packed
+        PackedIntsPtr docValues(reader->getNumericDocValues(field));
+        if (docValues) {
+            return docValues;
+        }
+        FieldCachePtr wrapper(_wrapper);
+        boost::any longs;
+        try {
+            longs = wrapper->getPackedLongs(reader, field, FieldCache::DEFAULT_LONG_PARSER());
+        } catch (NumberFormatException&) {
+            longs = wrapper->getPackedLongs(reader, field, FieldCache::NUMERIC_UTILS_LONG_PARSER());
+        }
+        return longs;
+    }
+    return createPackedValues(reader, field, boost::bind(&parsePackedLong, parser, _1));
 }
 
 FieldCacheEntryImpl::FieldCacheEntryImpl(const LuceneObjectPtr& readerKey, const String& fieldName, int32_t cacheType, const boost::any& custom, const boost::any& value) {
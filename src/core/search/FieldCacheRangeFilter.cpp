@@ -275,10 +275,11 @@ FieldCacheDocIdSetString::~FieldCacheDocIdSetString() {
 }
 
 bool FieldCacheDocIdSetString::matchDoc(int32_t doc) {
-    if (doc < 0 || doc >= fcsi->order.size()) {
+    if (doc < 0 || doc >= fcsi->size()) {
         boost::throw_exception(IndexOutOfBoundsException());
     }
-    return (fcsi->order[doc] >= inclusiveLowerPoint && fcsi->order[doc] <= inclusiveUpperPoint);
+    int32_t ord = fcsi->getOrd(doc);
+    return (ord >= inclusiveLowerPoint && ord <= inclusiveUpperPoint);
 }
 
 FieldDocIdSetIteratorTermDocs::FieldDocIdSetIteratorTermDocs(const FieldCacheDocIdSetPtr& cacheDocIdSet, const TermDocsPtr& termDocs) {
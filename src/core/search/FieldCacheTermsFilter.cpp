@@ -30,7 +30,7 @@ DocIdSetPtr FieldCacheTermsFilter::getDocIdSet(const IndexReaderPtr& reader) {
 
 FieldCacheTermsFilterDocIdSet::FieldCacheTermsFilterDocIdSet(Collection<String> terms, const StringIndexPtr& fcsi) {
     this->fcsi = fcsi;
-    openBitSet = newLucene<OpenBitSet>(this->fcsi->lookup.size());
+    openBitSet = newLucene<OpenBitSet>(this->fcsi->numOrd());
     for (Collection<String>::iterator term = terms.begin(); term != terms.end(); ++term) {
         int32_t termNumber = this->fcsi->binarySearchLookup(*term);
         if (termNumber > 0) {
@@ -65,11 +65,11 @@ int32_t FieldCacheTermsFilterDocIdSetIterator::docID() {
 
 int32_t FieldCacheTermsFilterDocIdSetIterator::nextDoc() {
     try {
-        if (++doc >= fcsi->order.size()) {
+        if (++doc >= fcsi->size()) {
             boost::throw_exception(IndexOutOfBoundsException());
         }
-        while (!openBitSet->fastGet(fcsi->order[doc])) {
-            if (++doc >= fcsi->order.size()) {
+        while (!openBitSet->fastGet(fcsi->getOrd(doc))) {
+            if (++doc >= fcsi->size()) {
                 boost::throw_exception(IndexOutOfBoundsException());
             }
         }
@@ -82,11 +82,11 @@ int32_t FieldCacheTermsFilterDocIdSetIterator::nextDoc() {
 int32_t FieldCacheTermsFilterDocIdSetIterator::advance(int32_t target) {
     try {
         doc = target;
-        if (doc < 0 || doc >= fcsi->order.size()) {
+        if (doc < 0 || doc >= fcsi->size()) {
             boost::throw_exception(IndexOutOfBoundsException());
         }
-        while (!openBitSet->fastGet(fcsi->order[doc])) {
-            if (++doc >= fcsi->order.size()) {
+        while (!openBitSet->fastGet(fcsi->getOrd(doc))) {
+            if (++doc >= fcsi->size()) {
                 boost::throw_exception(IndexOutOfBoundsException());
             }
         }
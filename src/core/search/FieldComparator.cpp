@@ -187,6 +187,7 @@ StringOrdValComparator::StringOrdValComparator(int32_t numHits, const String& fi
     this->currentReaderGen = -1;
     this->bottomSlot = -1;
     this->bottomOrd = 0;
+    this->bottomExact = false;
 }
 
 StringOrdValComparator::~StringOrdValComparator() {
@@ -204,12 +205,12 @@ int32_t StringOrdValComparator::compare(int32_t slot1, int32_t slot2) {
 
 int32_t StringOrdValComparator::compareBottom(int32_t doc) {
     BOOST_ASSERT(bottomSlot != -1);
-    int32_t order = this->order[doc];
-    int32_t cmp = bottomOrd - order;
+    int32_t cmp = bottomOrd - currentIndex->getOrd(doc);
     if (cmp != 0) {
         return cmp;
     }
-    return bottomValue.compare(lookup[order]);
+    // if the bottom value is not a term of this reader then its ord is that of the next smaller term
+    return bottomExact ? 0 : 1;
 }
 
 void StringOrdValComparator::convert(int32_t slot) {
@@ -223,15 +224,15 @@ void StringOrdValComparator::convert(int32_t slot) {
 
     if (sortPos == 0 && bottomSlot != -1 && bottomSlot != slot) {
         // Since we are the primary sort, the entries in the queue are bounded by bottomOrd
-        BOOST_ASSERT(bottomOrd < lookup.size());
+        BOOST_ASSERT(bottomOrd < currentIndex->numOrd());
         if (reversed) {
-            index = binarySearch(lookup, value, bottomOrd, lookup.size() - 1);
+            index = currentIndex->binarySearchLookup(value, bottomOrd, currentIndex->numOrd() - 1);
         } else {
-            index = binarySearch(lookup, value, 0, bottomOrd);
+            index = currentIndex->binarySearchLookup(value, 0, bottomOrd);
         }
     } else {
         // Full binary search
-        index = binarySearch(lookup, value, 0, lookup.size() - 1);
+        index = currentIndex->binarySearchLookup(value);
     }
 
     if (index < 0) {
@@ -241,29 +242,22 @@ void StringOrdValComparator::convert(int32_t slot) {
     ords[slot] = index;
 }
 
-int32_t StringOrdValComparator::binarySearch(Collection<String> lookup, const String& key, int32_t low, int32_t high) {
-    Collection<String>::iterator search = std::lower_bound(lookup.begin() + low, lookup.begin() + high, key);
-    int32_t keyPos = std::distance(lookup.begin(), search);
-    return (search == lookup.end() || key < *search) ? -(keyPos + 1) : keyPos;
-}
-
 void StringOrdValComparator::copy(int32_t slot, int32_t doc) {
-    int32_t ord = order[doc];
+    int32_t ord = currentIndex->getOrd(doc);
     ords[slot] = ord;
     BOOST_ASSERT(ord >= 0);
-    values[slot] = lookup[ord];
+    values[slot] = currentIndex->lookup(ord);
     readerGen[slot] = currentReaderGen;
 }
 
 void StringOrdValComparator::setNextReader(const IndexReaderPtr& reader, int32_t docBase) {
-    StringIndexPtr currentReaderValues(FieldCache::DEFAULT()->getStringIndex(reader, field));
+    currentIndex = FieldCache::DEFAULT()->getStringIndex(reader, field);
     ++currentReaderGen;
-    order = currentReaderValues->order;
-    lookup = currentReaderValues->lookup;
-    BOOST_ASSERT(!lookup.empty());
+    BOOST_ASSERT(currentIndex->numOrd() > 0);
     if (bottomSlot != -1) {
         convert(bottomSlot);
         bottomOrd = ords[bottomSlot];
+        bottomExact = (currentIndex->lookup(bottomOrd) == bottomValue);
     }
 }
 
@@ -274,8 +268,9 @@ void StringOrdValComparator::setBottom(int32_t slot) {
     }
     bottomOrd = ords[slot];
     BOOST_ASSERT(bottomOrd >= 0);
-    BOOST_ASSERT(bottomOrd < lookup.size());
+    BOOST_ASSERT(bottomOrd < currentIndex->numOrd());
     bottomValue = values[slot];
+    bottomExact = (currentIndex->lookup(bottomOrd) == bottomValue);
 }
 
 ComparableValue StringOrdValComparator::value(int32_t slot) {
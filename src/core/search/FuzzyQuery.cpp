@@ -18,22 +18,26 @@ namespace Lucene {
 
 const int32_t FuzzyQuery::defaultPrefixLength = 0;
 
+FuzzyQuery::FuzzyQuery(const TermPtr& term, double minimumSimilarity, int32_t prefixLength, bool transpositions) {
+    ConstructQuery(term, minimumSimilarity, prefixLength, transpositions);
+}
+
 FuzzyQuery::FuzzyQuery(const TermPtr& term, double minimumSimilarity, int32_t prefixLength) {
-    ConstructQuery(term, minimumSimilarity, prefixLength);
+    ConstructQuery(term, minimumSimilarity, prefixLength, false);
 }
 
 FuzzyQuery::FuzzyQuery(const TermPtr& term, double minimumSimilarity) {
-    ConstructQuery(term, minimumSimilarity, defaultPrefixLength);
+    ConstructQuery(term, minimumSimilarity, defaultPrefixLength, false);
 }
 
 FuzzyQuery::FuzzyQuery(const TermPtr& term) {
-    ConstructQuery(term, defaultMinSimilarity(), defaultPrefixLength);
+    ConstructQuery(term, defaultMinSimilarity(), defaultPrefixLength, false);
 }
 
 FuzzyQuery::~FuzzyQuery() {
 }
 
-void FuzzyQuery::ConstructQuery(const TermPtr& term, double minimumSimilarity, int32_t prefixLength) {
+void FuzzyQuery::ConstructQuery(const TermPtr& term, double minimumSimilarity, int32_t prefixLength, bool transpositions) {
     this->term = term;
 
     if (minimumSimilarity >= 1.0) {
@@ -49,6 +53,7 @@ void FuzzyQuery::ConstructQuery(const TermPtr& term, double minimumSimilarity, i
 
     this->minimumSimilarity = minimumSimilarity;
     this->prefixLength = prefixLength;
+    this->transpositions = transpositions;
     rewriteMethod = SCORING_BOOLEAN_QUERY_REWRITE();
 }
 
@@ -65,8 +70,12 @@ int32_t FuzzyQuery::getPrefixLength() {
     return prefixLength;
 }
 
+bool FuzzyQuery::getTranspositions() {
+    return transpositions;
+}
+
 FilteredTermEnumPtr FuzzyQuery::getEnum(const IndexReaderPtr& reader) {
-    return newLucene<FuzzyTermEnum>(reader, getTerm(), minimumSimilarity, prefixLength);
+    return newLucene<FuzzyTermEnum>(reader, getTerm(), minimumSimilarity, prefixLength, transpositions);
 }
 
 TermPtr FuzzyQuery::getTerm() {
@@ -128,6 +137,7 @@ LuceneObjectPtr FuzzyQuery::clone(const LuceneObjectPtr& other) {
     FuzzyQueryPtr cloneQuery(boost::dynamic_pointer_cast<FuzzyQuery>(clone));
     cloneQuery->minimumSimilarity = minimumSimilarity;
     cloneQuery->prefixLength = prefixLength;
+    cloneQuery->transpositions = transpositions;
     cloneQuery->termLongEnough = termLongEnough;
     cloneQuery->term = term;
     return cloneQuery;
@@ -147,6 +157,7 @@ int32_t FuzzyQuery::hashCode() {
     int32_t result = MultiTermQuery::hashCode();
     result = prime * result + MiscUtils::doubleToIntBits(minimumSimilarity);
     result = prime * result + prefixLength;
+    result = prime * result + (transpositions ? 1231 : 1237);
     result = prime * result + (term ? term->hashCode() : 0);
     return result;
 }
@@ -171,6 +182,9 @@ bool FuzzyQuery::equals(const LuceneObjectPtr& other) {
     if (prefixLength != otherFuzzyQuery->prefixLength) {
         return false;
     }
+    if (transpositions != otherFuzzyQuery->transpositions) {
+        return false;
+    }
     if (!term) {
         if (otherFuzzyQuery->term) {
             return false;
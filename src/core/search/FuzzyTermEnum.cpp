@@ -5,30 +5,36 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include "LuceneInc.h"
-#include <boost/algorithm/string.hpp>
 #include "FuzzyTermEnum.h"
 #include "FuzzyQuery.h"
+#include "Automaton.h"
 #include "Term.h"
 #include "IndexReader.h"
 
 namespace Lucene {
 
+const int32_t FuzzyTermEnum::MAX_AUTOMATON_EDITS = 2;
+
+FuzzyTermEnum::FuzzyTermEnum(const IndexReaderPtr& reader, const TermPtr& term, double minSimilarity, int32_t prefixLength, bool transpositions) {
+    ConstructTermEnum(reader, term, minSimilarity, prefixLength, transpositions);
+}
+
 FuzzyTermEnum::FuzzyTermEnum(const IndexReaderPtr& reader, const TermPtr& term, double minSimilarity, int32_t prefixLength) {
-    ConstructTermEnum(reader, term, minSimilarity, prefixLength);
+    ConstructTermEnum(reader, term, minSimilarity, prefixLength, false);
 }
 
 FuzzyTermEnum::FuzzyTermEnum(const IndexReaderPtr& reader, const TermPtr& term, double minSimilarity) {
-    ConstructTermEnum(reader, term, minSimilarity, FuzzyQuery::defaultPrefixLength);
+    ConstructTermEnum(reader, term, minSimilarity, FuzzyQuery::defaultPrefixLength, false);
 }
 
 FuzzyTermEnum::FuzzyTermEnum(const IndexReaderPtr& reader, const TermPtr& term) {
-    ConstructTermEnum(reader, term, FuzzyQuery::defaultMinSimilarity(), FuzzyQuery::defaultPrefixLength);
+    ConstructTermEnum(reader, term, FuzzyQuery::defaultMinSimilarity(), FuzzyQuery::defaultPrefixLength, false);
 }
 
 FuzzyTermEnum::~FuzzyTermEnum() {
 }
 
-void FuzzyTermEnum::ConstructTermEnum(const IndexReaderPtr& reader, const TermPtr& term, double minSimilarity, int32_t prefixLength) {
+void FuzzyTermEnum::ConstructTermEnum(const IndexReaderPtr& reader, const TermPtr& term, double minSimilarity, int32_t prefixLength, bool transpositions) {
     if (minSimilarity >= 1.0) {
         boost::throw_exception(IllegalArgumentException(L"minimumSimilarity cannot be greater than or equal to 1"));
     } else if (minSimilarity < 0.0) {
@@ -41,8 +47,7 @@ void FuzzyTermEnum::ConstructTermEnum(const IndexReaderPtr& reader, const TermPt
     this->minimumSimilarity = minSimilarity;
     this->scale_factor = 1.0 / (1.0 - minimumSimilarity);
     this->searchTerm = term;
-    this->field = searchTerm->field();
-    this->_endEnum = false;
+    this->transpositions = transpositions;
     this->_similarity = 0.0;
 
     // The prefix could be longer than the word.
@@ -55,28 +60,79 @@ void FuzzyTermEnum::ConstructTermEnum(const IndexReaderPtr& reader, const TermPt
 
     this->p = Collection<int32_t>::newInstance(this->text.length() + 1);
     this->d = Collection<int32_t>::newInstance(this->text.length() + 1);
+    if (transpositions) {
+        this->pp = Collection<int32_t>::newInstance(this->text.length() + 1);
+    }
 
-    setEnum(reader->terms(newLucene<Term>(searchTerm->field(), prefix)));
+    // no term further than this from the search term can reach the minimum similarity, whatever its length
+    int32_t maxEdits = calculateMaxDistance((int32_t)text.length());
+    AutomatonTermEnum::ConstructTermEnum(reader, searchTerm->field(), toAutomaton(prefix, text, maxEdits, transpositions));
+}
+
+AutomatonPtr FuzzyTermEnum::toAutomaton(const String& prefix, const String& text, int32_t maxEdits, bool transpositions) {
+    AutomatonPtr automaton(newLucene<Automaton>());
+    int32_t state = automaton->createState();
+    for (String::const_iterator c = prefix.begin(); c != prefix.end(); ++c) {
+        int32_t next = automaton->createState();
+        automaton->addTransition(state, *c, *c, next);
+        state = next;
+    }
+
+    if (maxEdits > MAX_AUTOMATON_EDITS) {
+        // too many edits for a compact automaton, so every term with the prefix is scored
+        automaton->addTransition(state, 0, Automaton::MAX_CHAR, state);
+        automaton->setAccept(state, true);
+        return automaton->determinize();
+    }
+
+    // Levenshtein automaton: state (i, e) has consumed the first i characters of text using e edits
+    int32_t n = (int32_t)text.length();
+    int32_t edits = std::max(maxEdits, 0) + 1;
+    Collection<int32_t> states(Collection<int32_t>::newInstance((n + 1) * edits));
+    states[0] = state;
+    for (int32_t i = 1; i < states.size(); ++i) {
+        states[i] = automaton->createState();
+    }
+    for (int32_t i = 0; i <= n; ++i) {
+        for (int32_t e = 0; e < edits; ++e) {
+            int32_t from = states[i * edits + e];
+            if (i == n) {
+                automaton->setAccept(from, true);
+            } else {
+                automaton->addTransition(from, text[i], text[i], states[(i + 1) * edits + e]); // match
+            }
+            if (e + 1 == edits) {
+                continue;
+            }
+            automaton->addTransition(from, 0, Automaton::MAX_CHAR, states[i * edits + e + 1]); // insertion
+            if (i < n) {
+                automaton->addTransition(from, 0, Automaton::MAX_CHAR, states[(i + 1) * edits + e + 1]); // substitution
+                automaton->addEpsilon(from, states[(i + 1) * edits + e + 1]); // deletion
+            }
+            if (transpositions && i + 1 < n && text[i] != text[i + 1]) {
+                int32_t swapped = automaton->createState();
+                automaton->addTransition(from, text[i + 1], text[i + 1], swapped);
+                automaton->addTransition(swapped, text[i], text[i], states[(i + 2) * edits + e + 1]);
+            }
+        }
+    }
+    return automaton->determinize();
 }
 
 bool FuzzyTermEnum::termCompare(const TermPtr& term) {
-    if (field == term->field() && boost::starts_with(term->text(), prefix)) {
-        String target(term->text().substr(prefix.length()));
-        this->_similarity = similarity(target);
-        return (_similarity > minimumSimilarity);
+    if (!AutomatonTermEnum::termCompare(term)) {
+        return false;
     }
-    _endEnum = true;
-    return false;
+    // the automaton only bounds the edit distance, the similarity also depends on the term length
+    String target(term->text().substr(prefix.length()));
+    this->_similarity = similarity(target);
+    return (_similarity > minimumSimilarity);
 }
 
 double FuzzyTermEnum::difference() {
     return (_similarity - minimumSimilarity) * scale_factor;
 }
 
-bool FuzzyTermEnum::endEnum() {
-    return _endEnum;
-}
-
 double FuzzyTermEnum::similarity(const String& target) {
     int32_t m = target.length();
     int32_t n = text.length();
@@ -116,6 +172,9 @@ double FuzzyTermEnum::similarity(const String& target) {
             } else {
                 d[i] = std::min(std::min(d[i - 1] + 1, p[i] + 1), p[i - 1]);
             }
+            if (transpositions && i > 1 && j > 1 && t_j == text[i - 2] && target[j - 2] == text[i - 1] && t_j != text[i - 1]) {
+                d[i] = std::min(d[i], pp[i - 2] + 1); // adjacent characters swapped
+            }
             bestPossibleEditDistance = std::min(bestPossibleEditDistance, d[i]);
         }
 
@@ -129,6 +188,9 @@ double FuzzyTermEnum::similarity(const String& target) {
         }
 
         // copy current distance counts to 'previous row' distance counts: swap p and d
+        if (transpositions) {
+            std::swap(pp, p);
+        }
         std::swap(p, d);
     }
 
@@ -147,6 +209,7 @@ int32_t FuzzyTermEnum::calculateMaxDistance(int32_t m) {
 void FuzzyTermEnum::close() {
     p.reset();
     d.reset();
+    pp.reset();
     searchTerm.reset();
     FilteredTermEnum::close(); // call FilteredTermEnum::close() and let the garbage collector do its work.
 }
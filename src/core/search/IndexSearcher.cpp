@@ -5,6 +5,8 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include "LuceneInc.h"
+#include <boost/bind.hpp>
+#include <boost/bind/protect.hpp>
 #include "IndexSearcher.h"
 #include "IndexReader.h"
 #include "TopScoreDocCollector.h"
@@ -16,6 +18,11 @@
 #include "Filter.h"
 #include "Query.h"
 #include "ReaderUtil.h"
+#include "_MultiSearcher.h"
+#include "HitQueue.h"
+#include "FieldDocSortedHitQueue.h"
+#include "FieldDoc.h"
+#include "ThreadPool.h"
 
 namespace Lucene {
 
@@ -36,14 +43,19 @@ IndexSearcher::IndexSearcher(const IndexReaderPtr& reader, Collection<IndexReade
     closeReader = false;
 }
 
+IndexSearcher::IndexSearcher(const IndexReaderPtr& reader, const ThreadPoolPtr& executor) {
+    ConstructSearcher(reader, false, executor);
+}
+
 IndexSearcher::~IndexSearcher() {
 }
 
-void IndexSearcher::ConstructSearcher(const IndexReaderPtr& reader, bool closeReader) {
+void IndexSearcher::ConstructSearcher(const IndexReaderPtr& reader, bool closeReader, const ThreadPoolPtr& executor) {
     this->fieldSortDoTrackScores = false;
     this->fieldSortDoMaxScore = false;
     this->reader = reader;
     this->closeReader = closeReader;
+    this->executor = executor;
 
     Collection<IndexReaderPtr> subReadersList(Collection<IndexReaderPtr>::newInstance());
     gatherSubReaders(subReadersList, reader);
@@ -54,6 +66,19 @@ void IndexSearcher::ConstructSearcher(const IndexReaderPtr& reader, bool closeRe
         docStarts[i] = maxDoc;
         maxDoc += subReaders[i]->maxDoc();
     }
+
+    if (executor) {
+        // each sub-searcher sees a single segment with docs starting at 0; the callables
+        // rebase hits using docStarts when merging
+        subSearchers = Collection<IndexSearcherPtr>::newInstance(subReaders.size());
+        for (int32_t i = 0; i < subReaders.size(); ++i) {
+            subSearchers[i] = newLucene<IndexSearcher>(subReaders[i], newCollection<IndexReaderPtr>(subReaders[i]), newCollection<int32_t>(0));
+        }
+    }
+}
+
+bool IndexSearcher::searchConcurrently() {
+    return (executor && subReaders.size() > 1);
 }
 
 void IndexSearcher::gatherSubReaders(Collection<IndexReaderPtr> allSubReaders, const IndexReaderPtr& reader) {
@@ -90,6 +115,34 @@ TopDocsPtr IndexSearcher::search(const WeightPtr& weight, const FilterPtr& filte
     if (n <= 0) {
         boost::throw_exception(IllegalArgumentException(L"n must be > 0"));
     }
+    if (searchConcurrently()) {
+        int32_t limit = std::min(n, reader->maxDoc());
+        HitQueuePtr hq(newLucene<HitQueue>(limit, false));
+        SynchronizePtr lock(newInstance<Synchronize>());
+        Collection<FuturePtr> searchThreads(Collection<FuturePtr>::newInstance(subSearchers.size()));
+        Collection<MultiSearcherCallableNoSortPtr> callables(Collection<MultiSearcherCallableNoSortPtr>::newInstance(subSearchers.size()));
+        for (int32_t i = 0; i < subSearchers.size(); ++i) { // search each segment
+            callables[i] = newLucene<MultiSearcherCallableNoSort>(lock, subSearchers[i], weight, filter, limit, hq, i, docStarts);
+            searchThreads[i] = executor->scheduleTask(boost::protect(boost::bind<TopDocsPtr>(boost::mem_fn(&MultiSearcherCallableNoSort::call), callables[i])));
+        }
+
+        int32_t totalHits = 0;
+        double maxScore = -std::numeric_limits<double>::infinity();
+        for (int32_t i = 0; i < searchThreads.size(); ++i) {
+            TopDocsPtr topDocs(searchThreads[i]->get<TopDocsPtr>());
+            if (topDocs->totalHits != 0) {
+                totalHits += topDocs->totalHits;
+                maxScore = std::max(maxScore, topDocs->maxScore);
+            }
+        }
+
+        Collection<ScoreDocPtr> scoreDocs(Collection<ScoreDocPtr>::newInstance(hq->size()));
+        for (int32_t i = hq->size() - 1; i >= 0; --i) { // put docs in array
+            scoreDocs[i] = hq->pop();
+        }
+
+        return newLucene<TopDocs>(totalHits, scoreDocs, totalHits == 0 ? std::numeric_limits<double>::quiet_NaN() : maxScore);
+    }
     TopScoreDocCollectorPtr collector(TopScoreDocCollector::create(std::min(n, reader->maxDoc()), !weight->scoresDocsOutOfOrder()));
     search(weight, filter, collector);
     return collector->topDocs();
@@ -100,6 +153,38 @@ TopFieldDocsPtr IndexSearcher::search(const WeightPtr& weight, const FilterPtr&
 }
 
 TopFieldDocsPtr IndexSearcher::search(const WeightPtr& weight, const FilterPtr& filter, int32_t n, const SortPtr& sort, bool fillFields) {
+    if (searchConcurrently()) {
+        // sort values are always filled by the segment searches, since they are needed to merge the hits
+        int32_t limit = std::min(n, reader->maxDoc());
+        FieldDocSortedHitQueuePtr hq(newLucene<FieldDocSortedHitQueue>(limit));
+        SynchronizePtr lock(newInstance<Synchronize>());
+        Collection<FuturePtr> searchThreads(Collection<FuturePtr>::newInstance(subSearchers.size()));
+        Collection<MultiSearcherCallableWithSortPtr> callables(Collection<MultiSearcherCallableWithSortPtr>::newInstance(subSearchers.size()));
+        for (int32_t i = 0; i < subSearchers.size(); ++i) { // search each segment
+            callables[i] = newLucene<MultiSearcherCallableWithSort>(lock, subSearchers[i], weight, filter, limit, hq, sort, i, docStarts);
+            searchThreads[i] = executor->scheduleTask(boost::protect(boost::bind<TopFieldDocsPtr>(boost::mem_fn(&MultiSearcherCallableWithSort::call), callables[i])));
+        }
+
+        int32_t totalHits = 0;
+        double maxScore = -std::numeric_limits<double>::infinity();
+        for (int32_t i = 0; i < searchThreads.size(); ++i) {
+            TopFieldDocsPtr topDocs(searchThreads[i]->get<TopFieldDocsPtr>());
+            totalHits += topDocs->totalHits;
+            if (!MiscUtils::isNaN(topDocs->maxScore)) {
+                maxScore = std::max(maxScore, topDocs->maxScore);
+            }
+        }
+
+        Collection<ScoreDocPtr> scoreDocs(Collection<ScoreDocPtr>::newInstance(hq->size()));
+        for (int32_t i = hq->size() - 1; i >= 0; --i) { // put docs in array
+            scoreDocs[i] = hq->pop();
+        }
+
+        if (totalHits == 0 || !fieldSortDoMaxScore) {
+            maxScore = std::numeric_limits<double>::quiet_NaN();
+        }
+        return newLucene<TopFieldDocs>(totalHits, scoreDocs, hq->getFields(), maxScore);
+    }
     TopFieldCollectorPtr collector(TopFieldCollector::create(sort, std::min(n, reader->maxDoc()), fillFields, fieldSortDoTrackScores, fieldSortDoMaxScore, !weight->scoresDocsOutOfOrder()));
     search(weight, filter, collector);
     return boost::dynamic_pointer_cast<TopFieldDocs>(collector->topDocs());
@@ -183,6 +268,11 @@ ExplanationPtr IndexSearcher::explain(const WeightPtr& weight, int32_t doc) {
 void IndexSearcher::setDefaultFieldSortScoring(bool doTrackScores, bool doMaxScore) {
     fieldSortDoTrackScores = doTrackScores;
     fieldSortDoMaxScore = doMaxScore;
+    if (subSearchers) {
+        for (Collection<IndexSearcherPtr>::iterator subSearcher = subSearchers.begin(); subSearcher != subSearchers.end(); ++subSearcher) {
+            (*subSearcher)->setDefaultFieldSortScoring(doTrackScores, doMaxScore);
+        }
+    }
 }
 
 }
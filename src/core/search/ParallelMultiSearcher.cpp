@@ -18,13 +18,17 @@
 namespace Lucene {
 
 ParallelMultiSearcher::ParallelMultiSearcher(Collection<SearchablePtr> searchables) : MultiSearcher(searchables) {
+    this->threadPool = ThreadPool::getInstance();
+}
+
+ParallelMultiSearcher::ParallelMultiSearcher(Collection<SearchablePtr> searchables, const ThreadPoolPtr& threadPool) : MultiSearcher(searchables) {
+    this->threadPool = threadPool ? threadPool : ThreadPool::getInstance();
 }
 
 ParallelMultiSearcher::~ParallelMultiSearcher() {
 }
 
 int32_t ParallelMultiSearcher::docFreq(const TermPtr& term) {
-    ThreadPoolPtr threadPool(ThreadPool::getInstance());
     Collection<FuturePtr> searchThreads(Collection<FuturePtr>::newInstance(searchables.size()));
     for (int32_t i = 0; i < searchables.size(); ++i) {
         searchThreads[i] = threadPool->scheduleTask(boost::protect(boost::bind<int32_t>(boost::mem_fn(&Searchable::docFreq), searchables[i], term)));
@@ -39,7 +43,6 @@ int32_t ParallelMultiSearcher::docFreq(const TermPtr& term) {
 TopDocsPtr ParallelMultiSearcher::search(const WeightPtr& weight, const FilterPtr& filter, int32_t n) {
     HitQueuePtr hq(newLucene<HitQueue>(n, false));
     SynchronizePtr lock(newInstance<Synchronize>());
-    ThreadPoolPtr threadPool(ThreadPool::getInstance());
     Collection<FuturePtr> searchThreads(Collection<FuturePtr>::newInstance(searchables.size()));
     Collection<MultiSearcherCallableNoSortPtr> multiSearcher(Collection<MultiSearcherCallableNoSortPtr>::newInstance(searchables.size()));
     for (int32_t i = 0; i < searchables.size(); ++i) { // search each searchable
@@ -70,7 +73,6 @@ TopFieldDocsPtr ParallelMultiSearcher::search(const WeightPtr& weight, const Fil
     }
     FieldDocSortedHitQueuePtr hq(newLucene<FieldDocSortedHitQueue>(n));
     SynchronizePtr lock(newInstance<Synchronize>());
-    ThreadPoolPtr threadPool(ThreadPool::getInstance());
     Collection<FuturePtr> searchThreads(Collection<FuturePtr>::newInstance(searchables.size()));
     Collection<MultiSearcherCallableWithSortPtr> multiSearcher(Collection<MultiSearcherCallableWithSortPtr>::newInstance(searchables.size()));
     for (int32_t i = 0; i < searchables.size(); ++i) { // search each searchable
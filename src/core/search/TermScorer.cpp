@@ -13,6 +13,7 @@
 
 namespace Lucene {
 
+const int32_t TermScorer::BUFFER_SIZE = 128;
 const int32_t TermScorer::SCORE_CACHE_SIZE = 32;
 
 TermScorer::TermScorer(const WeightPtr& weight, const TermDocsPtr& td, const SimilarityPtr& similarity, ByteArray norms) : Scorer(similarity) {
@@ -21,8 +22,8 @@ TermScorer::TermScorer(const WeightPtr& weight, const TermDocsPtr& td, const Sim
     this->norms = norms;
     this->weightValue = weight->getValue();
     this->doc = -1;
-    this->docs = Collection<int32_t>::newInstance(32);
-    this->freqs = Collection<int32_t>::newInstance(32);
+    this->docs = Collection<int32_t>::newInstance(BUFFER_SIZE);
+    this->freqs = Collection<int32_t>::newInstance(BUFFER_SIZE);
     this->pointer = 0;
     this->pointerMax = 0;
     this->scoreCache = Collection<double>::newInstance(SCORE_CACHE_SIZE);
@@ -92,8 +93,12 @@ double TermScorer::score() {
 }
 
 int32_t TermScorer::advance(int32_t target) {
-    // first scan in cache
-    for (++pointer; pointer < pointerMax; ++pointer) {
+    // first scan in cache, unless the target lies beyond the last buffered doc
+    ++pointer;
+    if (pointer < pointerMax && docs[pointerMax - 1] < target) {
+        pointer = pointerMax;
+    }
+    for (; pointer < pointerMax; ++pointer) {
         if (docs[pointer] >= target) {
             doc = docs[pointer];
             return doc;
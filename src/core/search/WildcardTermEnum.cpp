@@ -5,8 +5,8 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include "LuceneInc.h"
-#include <boost/algorithm/string.hpp>
 #include "WildcardTermEnum.h"
+#include "Automaton.h"
 #include "Term.h"
 #include "IndexReader.h"
 
@@ -15,47 +15,31 @@ namespace Lucene {
 const wchar_t WildcardTermEnum::WILDCARD_STRING = L'*';
 const wchar_t WildcardTermEnum::WILDCARD_CHAR = L'?';
 
-WildcardTermEnum::WildcardTermEnum(const IndexReaderPtr& reader, const TermPtr& term) {
-    _endEnum = false;
+WildcardTermEnum::WildcardTermEnum(const IndexReaderPtr& reader, const TermPtr& term) : AutomatonTermEnum(reader, term->field(), toAutomaton(term->text())) {
     searchTerm = term;
-    field = searchTerm->field();
-    String searchTermText(searchTerm->text());
-
-    String::size_type sidx = searchTermText.find(WILDCARD_STRING);
-    String::size_type cidx = searchTermText.find(WILDCARD_CHAR);
-    String::size_type idx = sidx;
-    if (idx == String::npos) {
-        idx = cidx;
-    } else if (cidx != String::npos) {
-        idx = std::min(idx, cidx);
-    }
-    pre = idx != String::npos ? searchTerm->text().substr(0, idx) : L"";
-
-    preLen = pre.length();
-    text = searchTermText.substr(preLen);
-    setEnum(reader->terms(newLucene<Term>(searchTerm->field(), pre)));
 }
 
 WildcardTermEnum::~WildcardTermEnum() {
 }
 
-bool WildcardTermEnum::termCompare(const TermPtr& term) {
-    if (field == term->field()) {
-        String searchText(term->text());
-        if (boost::starts_with(searchText, pre)) {
-            return wildcardEquals(text, 0, searchText, preLen);
+AutomatonPtr WildcardTermEnum::toAutomaton(const String& pattern) {
+    AutomatonPtr automaton(newLucene<Automaton>());
+    int32_t state = automaton->createState();
+    for (String::const_iterator c = pattern.begin(); c != pattern.end(); ++c) {
+        if (*c == WILDCARD_STRING) {
+            automaton->addTransition(state, 0, Automaton::MAX_CHAR, state);
+        } else {
+            int32_t next = automaton->createState();
+            if (*c == WILDCARD_CHAR) {
+                automaton->addTransition(state, 0, Automaton::MAX_CHAR, next);
+            } else {
+                automaton->addTransition(state, *c, *c, next);
+            }
+            state = next;
         }
     }
-    _endEnum = true;
-    return false;
-}
-
-double WildcardTermEnum::difference() {
-    return 1.0;
-}
-
-bool WildcardTermEnum::endEnum() {
-    return _endEnum;
+    automaton->setAccept(state, true);
+    return automaton->determinize();
 }
 
 bool WildcardTermEnum::wildcardEquals(const String& pattern, int32_t patternIdx, const String& string, int32_t stringIdx) {
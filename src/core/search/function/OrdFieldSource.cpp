@@ -25,8 +25,8 @@ String OrdFieldSource::description() {
 }
 
 DocValuesPtr OrdFieldSource::getValues(const IndexReaderPtr& reader) {
-    Collection<int32_t> arr(FieldCache::DEFAULT()->getStringIndex(reader, field)->order);
-    return newLucene<OrdDocValues>(shared_from_this(), arr);
+    StringIndexPtr sindex(FieldCache::DEFAULT()->getStringIndex(reader, field));
+    return newLucene<OrdDocValues>(shared_from_this(), sindex);
 }
 
 bool OrdFieldSource::equals(const LuceneObjectPtr& other) {
@@ -44,35 +44,31 @@ int32_t OrdFieldSource::hashCode() {
     return StringUtils::hashCode(OrdFieldSource::_getClassName()) + StringUtils::hashCode(field);
 }
 
-OrdDocValues::OrdDocValues(const OrdFieldSourcePtr& source, Collection<int32_t> arr) {
+OrdDocValues::OrdDocValues(const OrdFieldSourcePtr& source, const StringIndexPtr& sindex) {
     this->_source = source;
-    this->arr = arr;
+    this->sindex = sindex;
 }
 
 OrdDocValues::~OrdDocValues() {
 }
 
 double OrdDocValues::doubleVal(int32_t doc) {
-    if (doc < 0 || doc >= arr.size()) {
+    if (doc < 0 || doc >= sindex->size()) {
         boost::throw_exception(IndexOutOfBoundsException());
     }
-    return (double)arr[doc];
+    return (double)sindex->getOrd(doc);
 }
 
 String OrdDocValues::strVal(int32_t doc) {
     // the string value of the ordinal, not the string itself
-    if (doc < 0 || doc >= arr.size()) {
+    if (doc < 0 || doc >= sindex->size()) {
         boost::throw_exception(IndexOutOfBoundsException());
     }
-    return StringUtils::toString(arr[doc]);
+    return StringUtils::toString(sindex->getOrd(doc));
 }
 
 String OrdDocValues::toString(int32_t doc) {
     return OrdFieldSourcePtr(_source)->description() + L"=" + StringUtils::toString(intVal(doc));
 }
 
-CollectionValue OrdDocValues::getInnerArray() {
-    return arr;
-}
-
 }
@@ -26,9 +26,8 @@ String ReverseOrdFieldSource::description() {
 
 DocValuesPtr ReverseOrdFieldSource::getValues(const IndexReaderPtr& reader) {
     StringIndexPtr sindex(FieldCache::DEFAULT()->getStringIndex(reader, field));
-    Collection<int32_t> arr(sindex->order);
-    int32_t end = sindex->lookup.size();
-    return newLucene<ReverseOrdDocValues>(shared_from_this(), arr, end);
+    int32_t end = sindex->numOrd();
+    return newLucene<ReverseOrdDocValues>(shared_from_this(), sindex, end);
 }
 
 bool ReverseOrdFieldSource::equals(const LuceneObjectPtr& other) {
@@ -46,9 +45,9 @@ int32_t ReverseOrdFieldSource::hashCode() {
     return StringUtils::hashCode(ReverseOrdFieldSource::_getClassName()) + StringUtils::hashCode(field);
 }
 
-ReverseOrdDocValues::ReverseOrdDocValues(const ReverseOrdFieldSourcePtr& source, Collection<int32_t> arr, int32_t end) {
+ReverseOrdDocValues::ReverseOrdDocValues(const ReverseOrdFieldSourcePtr& source, const StringIndexPtr& sindex, int32_t end) {
     this->_source = source;
-    this->arr = arr;
+    this->sindex = sindex;
     this->end = end;
 }
 
@@ -56,17 +55,17 @@ ReverseOrdDocValues::~ReverseOrdDocValues() {
 }
 
 double ReverseOrdDocValues::doubleVal(int32_t doc) {
-    if (doc < 0 || doc >= arr.size()) {
+    if (doc < 0 || doc >= sindex->size()) {
         boost::throw_exception(IndexOutOfBoundsException());
     }
-    return (double)(end - arr[doc]);
+    return (double)(end - sindex->getOrd(doc));
 }
 
 int32_t ReverseOrdDocValues::intVal(int32_t doc) {
-    if (doc < 0 || doc >= arr.size()) {
+    if (doc < 0 || doc >= sindex->size()) {
         boost::throw_exception(IndexOutOfBoundsException());
     }
-    return (end - arr[doc]);
+    return (end - sindex->getOrd(doc));
 }
 
 String ReverseOrdDocValues::strVal(int32_t doc) {
@@ -78,8 +77,4 @@ String ReverseOrdDocValues::toString(int32_t doc) {
     return ReverseOrdFieldSourcePtr(_source)->description() + L"=" + strVal(doc);
 }
 
-CollectionValue ReverseOrdDocValues::getInnerArray() {
-    return arr;
-}
-
 }
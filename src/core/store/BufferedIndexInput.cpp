@@ -115,6 +115,19 @@ void BufferedIndexInput::readBytes(uint8_t* b, int32_t offset, int32_t length, b
     }
 }
 
+const uint8_t* BufferedIndexInput::bufferedBytes(int32_t& available) {
+    if (bufferPosition >= bufferLength && bufferStart + bufferPosition < length()) {
+        refill();
+    }
+    available = bufferLength - bufferPosition;
+    return available > 0 ? buffer.get() + bufferPosition : NULL;
+}
+
+void BufferedIndexInput::skipBufferedBytes(int32_t count) {
+    BOOST_ASSERT(bufferPosition + count <= bufferLength);
+    bufferPosition += count;
+}
+
 void BufferedIndexInput::refill() {
     int64_t start = bufferStart + bufferPosition;
     int64_t end = start + bufferSize;
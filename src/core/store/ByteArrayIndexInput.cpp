@@ -0,0 +1,83 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "LuceneInc.h"
+#include "ByteArrayIndexInput.h"
+#include "MiscUtils.h"
+#include "StringUtils.h"
+
+namespace Lucene {
+
+ByteArrayIndexInput::ByteArrayIndexInput(ByteArray bytes) {
+    this->bytes = bytes;
+    this->_length = !bytes ? 0 : bytes.size();
+    this->position = 0;
+}
+
+ByteArrayIndexInput::ByteArrayIndexInput(ByteArray bytes, int32_t length) {
+    BOOST_ASSERT(length <= bytes.size());
+    this->bytes = bytes;
+    this->_length = length;
+    this->position = 0;
+}
+
+ByteArrayIndexInput::~ByteArrayIndexInput() {
+}
+
+uint8_t ByteArrayIndexInput::readByte() {
+    if (position >= _length) {
+        boost::throw_exception(IOException(L"Read past EOF"));
+    }
+    return bytes[position++];
+}
+
+void ByteArrayIndexInput::readBytes(uint8_t* b, int32_t offset, int32_t length) {
+    if (length > _length - position) {
+        boost::throw_exception(IOException(L"Read past EOF"));
+    }
+    MiscUtils::arrayCopy(bytes.get(), position, b, offset, length);
+    position += length;
+}
+
+const uint8_t* ByteArrayIndexInput::bufferedBytes(int32_t& available) {
+    available = _length - position;
+    return available > 0 ? bytes.get() + position : NULL;
+}
+
+void ByteArrayIndexInput::skipBufferedBytes(int32_t count) {
+    BOOST_ASSERT(position + count <= _length);
+    position += count;
+}
+
+void ByteArrayIndexInput::close() {
+    // nothing to do here
+}
+
+int64_t ByteArrayIndexInput::getFilePointer() {
+    return position;
+}
+
+void ByteArrayIndexInput::seek(int64_t pos) {
+    if (pos < 0 || pos > _length) {
+        boost::throw_exception(IOException(L"Seek past EOF: " + StringUtils::toString(pos)));
+    }
+    position = (int32_t)pos;
+}
+
+int64_t ByteArrayIndexInput::length() {
+    return _length;
+}
+
+LuceneObjectPtr ByteArrayIndexInput::clone(const LuceneObjectPtr& other) {
+    LuceneObjectPtr clone = IndexInput::clone(other ? other : newLucene<ByteArrayIndexInput>(bytes, _length));
+    ByteArrayIndexInputPtr cloneInput(boost::dynamic_pointer_cast<ByteArrayIndexInput>(clone));
+    cloneInput->bytes = bytes;
+    cloneInput->_length = _length;
+    cloneInput->position = position;
+    return cloneInput;
+}
+
+}
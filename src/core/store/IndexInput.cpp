@@ -32,6 +32,15 @@ int32_t IndexInput::readInt() {
     return i;
 }
 
+const uint8_t* IndexInput::bufferedBytes(int32_t& available) {
+    available = 0;
+    return NULL;
+}
+
+void IndexInput::skipBufferedBytes(int32_t count) {
+    seek(getFilePointer() + count);
+}
+
 int32_t IndexInput::readVInt() {
     uint8_t b = readByte();
     int32_t i = (b & 0x7f);
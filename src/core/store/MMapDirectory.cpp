@@ -9,21 +9,53 @@
 #include "_MMapDirectory.h"
 #include "SimpleFSDirectory.h"
 #include "_SimpleFSDirectory.h"
+#include "FileSwitchDirectory.h"
 #include "MiscUtils.h"
 #include "FileUtils.h"
 #include "StringUtils.h"
 
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <sys/mman.h>
+#endif
+
 namespace Lucene {
 
+const int32_t MMapDirectory::DEFAULT_MAX_CHUNK_SIZE = sizeof(void*) == 8 ? (1 << 30) : (1 << 28);
+
 MMapDirectory::MMapDirectory(const String& path, const LockFactoryPtr& lockFactory) : FSDirectory(path, lockFactory) {
+    accessHints = MapStringInt::newInstance();
+    setMaxChunkSize(DEFAULT_MAX_CHUNK_SIZE);
 }
 
 MMapDirectory::~MMapDirectory() {
 }
 
+void MMapDirectory::setMaxChunkSize(int32_t maxChunkSize) {
+    if (maxChunkSize < (int32_t)boost::iostreams::mapped_file_source::alignment()) {
+        boost::throw_exception(IllegalArgumentException(L"Maximum chunk size must be at least the page size"));
+    }
+    chunkSizePower = 0;
+    while ((maxChunkSize >> (chunkSizePower + 1)) > 0) {
+        ++chunkSizePower;
+    }
+}
+
+int32_t MMapDirectory::getMaxChunkSize() {
+    return 1 << chunkSizePower;
+}
+
+void MMapDirectory::setAccessHint(const String& extension, AccessHint hint) {
+    accessHints.put(extension, hint);
+}
+
+MMapDirectory::AccessHint MMapDirectory::getAccessHint(const String& name) {
+    MapStringInt::iterator hint = accessHints.find(FileSwitchDirectory::getExtension(name));
+    return hint == accessHints.end() ? ACCESS_NORMAL : (AccessHint)hint->second;
+}
+
 IndexInputPtr MMapDirectory::openInput(const String& name, int32_t bufferSize) {
     ensureOpen();
-    return newLucene<MMapIndexInput>(FileUtils::joinPath(directory, name));
+    return newLucene<MMapIndexInput>(FileUtils::joinPath(directory, name), chunkSizePower, getAccessHint(name));
 }
 
 IndexOutputPtr MMapDirectory::createOutput(const String& name) {
@@ -31,70 +63,158 @@ IndexOutputPtr MMapDirectory::createOutput(const String& name) {
     return newLucene<SimpleFSIndexOutput>(FileUtils::joinPath(directory, name));
 }
 
-MMapIndexInput::MMapIndexInput(const String& path) {
-    _length = path.empty() ? 0 : (int32_t)FileUtils::fileLength(path);
-    bufferPosition = 0;
-    if (!path.empty()) {
-        try {
-            file.open(boost::filesystem::wpath(path), _length);
-        } catch (...) {
-            boost::throw_exception(FileNotFoundException(path));
+MMapIndexInput::MMapIndexInput(const String& path, int32_t chunkSizePower, int32_t accessHint) {
+    _length = path.empty() ? 0 : FileUtils::fileLength(path);
+    isClone = false;
+    this->chunkSizePower = chunkSizePower;
+    chunkIndex = 0;
+    chunk = NULL;
+    chunkLength = 0;
+    chunkPosition = 0;
+
+    int64_t chunkSize = (int64_t)1 << chunkSizePower;
+    int32_t numChunks = (int32_t)((_length + chunkSize - 1) >> chunkSizePower);
+    chunks = Collection<MappedChunk>::newInstance(numChunks);
+    try {
+        for (int32_t i = 0; i < numChunks; ++i) {
+            int64_t offset = (int64_t)i << chunkSizePower;
+            chunks[i].open(boost::filesystem::wpath(path), (size_t)std::min(chunkSize, _length - offset), offset);
+#if !defined(_WIN32) && !defined(_WIN64)
+            int32_t advice = POSIX_MADV_NORMAL;
+            switch (accessHint) {
+            case MMapDirectory::ACCESS_RANDOM:
+                advice = POSIX_MADV_RANDOM;
+                break;
+            case MMapDirectory::ACCESS_SEQUENTIAL:
+                advice = POSIX_MADV_SEQUENTIAL;
+                break;
+            case MMapDirectory::ACCESS_WILLNEED:
+                advice = POSIX_MADV_WILLNEED;
+                break;
+            }
+            if (advice != POSIX_MADV_NORMAL) {
+                // only a hint, so failures are ignored
+                posix_madvise((void*)chunks[i].data(), chunks[i].size(), advice);
+            }
+#endif
+        }
+    } catch (...) {
+        for (Collection<MappedChunk>::iterator mapped = chunks.begin(); mapped != chunks.end(); ++mapped) {
+            mapped->close();
         }
+        boost::throw_exception(FileNotFoundException(path));
+    }
+    if (numChunks > 0) {
+        setChunk(0);
     }
-    isClone = false;
 }
 
 MMapIndexInput::~MMapIndexInput() {
 }
 
-uint8_t MMapIndexInput::readByte() {
-    try {
-        return file.data()[bufferPosition++];
-    } catch (...) {
+void MMapIndexInput::setChunk(int32_t index) {
+    chunkIndex = index;
+    chunk = (const uint8_t*)chunks[index].data();
+    chunkLength = (int32_t)chunks[index].size();
+    chunkPosition = 0;
+}
+
+void MMapIndexInput::nextChunk() {
+    if (!chunks || chunkIndex + 1 >= chunks.size()) {
         boost::throw_exception(IOException(L"Read past EOF"));
-        return 0;
     }
+    setChunk(chunkIndex + 1);
+}
+
+uint8_t MMapIndexInput::readByte() {
+    if (chunkPosition >= chunkLength) {
+        nextChunk();
+    }
+    return chunk[chunkPosition++];
 }
 
 void MMapIndexInput::readBytes(uint8_t* b, int32_t offset, int32_t length) {
-    try {
-        MiscUtils::arrayCopy(file.data(), bufferPosition, b, offset, length);
-        bufferPosition += length;
-    } catch (...) {
-        boost::throw_exception(IOException(L"Read past EOF"));
+    while (length > 0) {
+        if (chunkPosition >= chunkLength) {
+            nextChunk();
+        }
+        int32_t bytesToCopy = std::min(length, chunkLength - chunkPosition);
+        MiscUtils::arrayCopy(chunk, chunkPosition, b, offset, bytesToCopy);
+        chunkPosition += bytesToCopy;
+        offset += bytesToCopy;
+        length -= bytesToCopy;
     }
 }
 
+const uint8_t* MMapIndexInput::bufferedBytes(int32_t& available) {
+    if (chunkPosition >= chunkLength && chunks && chunkIndex + 1 < chunks.size()) {
+        setChunk(chunkIndex + 1);
+    }
+    available = chunkLength - chunkPosition;
+    return available > 0 ? chunk + chunkPosition : NULL;
+}
+
+void MMapIndexInput::skipBufferedBytes(int32_t count) {
+    BOOST_ASSERT(chunkPosition + count <= chunkLength);
+    chunkPosition += count;
+}
+
 int64_t MMapIndexInput::getFilePointer() {
-    return bufferPosition;
+    return ((int64_t)chunkIndex << chunkSizePower) + chunkPosition;
 }
 
 void MMapIndexInput::seek(int64_t pos) {
-    bufferPosition = (int32_t)pos;
+    if (pos < 0 || pos > _length) {
+        boost::throw_exception(IOException(L"Seek past EOF: " + StringUtils::toString(pos)));
+    }
+    if (!chunks || chunks.empty()) {
+        return;
+    }
+    int32_t index = (int32_t)(pos >> chunkSizePower);
+    if (index == chunks.size()) {
+        // positioned at the end of a file that fills its last chunk
+        setChunk(index - 1);
+        chunkPosition = chunkLength;
+    } else {
+        if (index != chunkIndex || !chunk) {
+            setChunk(index);
+        }
+        chunkPosition = (int32_t)(pos - ((int64_t)index << chunkSizePower));
+    }
 }
 
 int64_t MMapIndexInput::length() {
-    return (int64_t)_length;
+    return _length;
 }
 
 void MMapIndexInput::close() {
-    if (isClone || !file.is_open()) {
+    if (isClone || !chunks) {
         return;
     }
+    for (Collection<MappedChunk>::iterator mapped = chunks.begin(); mapped != chunks.end(); ++mapped) {
+        mapped->close();
+    }
+    chunks.reset();
     _length = 0;
-    bufferPosition = 0;
-    file.close();
+    chunkIndex = 0;
+    chunk = NULL;
+    chunkLength = 0;
+    chunkPosition = 0;
 }
 
 LuceneObjectPtr MMapIndexInput::clone(const LuceneObjectPtr& other) {
-    if (!file.is_open()) {
+    if (!chunks) {
         boost::throw_exception(AlreadyClosedException(L"MMapIndexInput already closed"));
     }
     LuceneObjectPtr clone = IndexInput::clone(other ? other : newLucene<MMapIndexInput>());
     MMapIndexInputPtr cloneIndexInput(boost::dynamic_pointer_cast<MMapIndexInput>(clone));
     cloneIndexInput->_length = _length;
-    cloneIndexInput->file = file;
-    cloneIndexInput->bufferPosition = bufferPosition;
+    cloneIndexInput->chunkSizePower = chunkSizePower;
+    cloneIndexInput->chunks = chunks;
+    cloneIndexInput->chunkIndex = chunkIndex;
+    cloneIndexInput->chunk = chunk;
+    cloneIndexInput->chunkLength = chunkLength;
+    cloneIndexInput->chunkPosition = chunkPosition;
     cloneIndexInput->isClone = true;
     return cloneIndexInput;
 }
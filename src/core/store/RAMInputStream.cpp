@@ -74,6 +74,20 @@ void RAMInputStream::readBytes(uint8_t* b, int32_t offset, int32_t length) {
     }
 }
 
+const uint8_t* RAMInputStream::bufferedBytes(int32_t& available) {
+    if (bufferPosition >= bufferLength && getFilePointer() < _length) {
+        ++currentBufferIndex;
+        switchCurrentBuffer(true);
+    }
+    available = bufferLength - bufferPosition;
+    return available > 0 ? currentBuffer.get() + bufferPosition : NULL;
+}
+
+void RAMInputStream::skipBufferedBytes(int32_t count) {
+    BOOST_ASSERT(bufferPosition + count <= bufferLength);
+    bufferPosition += count;
+}
+
 void RAMInputStream::switchCurrentBuffer(bool enforceEOF) {
     if (currentBufferIndex >= file->numBuffers()) {
         // end of file reached, no more buffers left
@@ -53,6 +53,19 @@ void RAMOutputStream::writeTo(const IndexOutputPtr& out) {
     }
 }
 
+void RAMOutputStream::writeTo(uint8_t* bytes, int32_t offset) {
+    flush();
+    int64_t end = file->length;
+    int64_t pos = 0;
+    int32_t buffer = 0;
+    while (pos < end) {
+        int32_t length = (int32_t)std::min((int64_t)BUFFER_SIZE, end - pos);
+        MiscUtils::arrayCopy(file->getBuffer(buffer++).get(), 0, bytes, offset, length);
+        offset += length;
+        pos += length;
+    }
+}
+
 void RAMOutputStream::reset() {
     currentBuffer.reset();
     currentBufferIndex = -1;
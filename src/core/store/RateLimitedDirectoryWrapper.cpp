@@ -0,0 +1,87 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "LuceneInc.h"
+#include "RateLimitedDirectoryWrapper.h"
+#include "RateLimitedIndexOutput.h"
+#include "RateLimiter.h"
+
+namespace Lucene {
+
+RateLimitedDirectoryWrapper::RateLimitedDirectoryWrapper(const DirectoryPtr& dir, const RateLimiterPtr& rateLimiter) {
+    this->dir = dir;
+    this->rateLimiter = rateLimiter;
+    this->lockFactory = dir->getLockFactory();
+}
+
+RateLimitedDirectoryWrapper::~RateLimitedDirectoryWrapper() {
+}
+
+DirectoryPtr RateLimitedDirectoryWrapper::getDelegate() {
+    return dir;
+}
+
+RateLimiterPtr RateLimitedDirectoryWrapper::getRateLimiter() {
+    return rateLimiter;
+}
+
+HashSet<String> RateLimitedDirectoryWrapper::listAll() {
+    return dir->listAll();
+}
+
+bool RateLimitedDirectoryWrapper::fileExists(const String& name) {
+    return dir->fileExists(name);
+}
+
+uint64_t RateLimitedDirectoryWrapper::fileModified(const String& name) {
+    return dir->fileModified(name);
+}
+
+void RateLimitedDirectoryWrapper::touchFile(const String& name) {
+    dir->touchFile(name);
+}
+
+void RateLimitedDirectoryWrapper::deleteFile(const String& name) {
+    dir->deleteFile(name);
+}
+
+int64_t RateLimitedDirectoryWrapper::fileLength(const String& name) {
+    return dir->fileLength(name);
+}
+
+IndexOutputPtr RateLimitedDirectoryWrapper::createOutput(const String& name) {
+    return newLucene<RateLimitedIndexOutput>(rateLimiter, dir->createOutput(name));
+}
+
+IndexInputPtr RateLimitedDirectoryWrapper::openInput(const String& name) {
+    return dir->openInput(name);
+}
+
+IndexInputPtr RateLimitedDirectoryWrapper::openInput(const String& name, int32_t bufferSize) {
+    return dir->openInput(name, bufferSize);
+}
+
+void RateLimitedDirectoryWrapper::close() {
+    isOpen = false;
+}
+
+void RateLimitedDirectoryWrapper::sync(const String& name) {
+    dir->sync(name);
+}
+
+LockPtr RateLimitedDirectoryWrapper::makeLock(const String& name) {
+    return dir->makeLock(name);
+}
+
+String RateLimitedDirectoryWrapper::getLockID() {
+    return dir->getLockID();
+}
+
+String RateLimitedDirectoryWrapper::toString() {
+    return L"RateLimitedDirectoryWrapper(" + dir->toString() + L")";
+}
+
+}
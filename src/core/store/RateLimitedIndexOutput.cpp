@@ -0,0 +1,74 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "LuceneInc.h"
+#include "RateLimitedIndexOutput.h"
+#include "RateLimiter.h"
+
+namespace Lucene {
+
+RateLimitedIndexOutput::RateLimitedIndexOutput(const RateLimiterPtr& rateLimiter, const IndexOutputPtr& delegate) {
+    this->rateLimiter = rateLimiter;
+    this->delegate = delegate;
+    this->bytesSinceLastPause = 0;
+    this->currentMinPauseCheckBytes = rateLimiter->getMinPauseCheckBytes();
+}
+
+RateLimitedIndexOutput::~RateLimitedIndexOutput() {
+}
+
+void RateLimitedIndexOutput::writeByte(uint8_t b) {
+    ++bytesSinceLastPause;
+    checkRate();
+    delegate->writeByte(b);
+}
+
+void RateLimitedIndexOutput::writeBytes(const uint8_t* b, int32_t offset, int32_t length) {
+    bytesSinceLastPause += length;
+    checkRate();
+    delegate->writeBytes(b, offset, length);
+}
+
+void RateLimitedIndexOutput::checkRate() {
+    if (bytesSinceLastPause > currentMinPauseCheckBytes) {
+        rateLimiter->pause(bytesSinceLastPause);
+        bytesSinceLastPause = 0;
+        currentMinPauseCheckBytes = rateLimiter->getMinPauseCheckBytes();
+    }
+}
+
+void RateLimitedIndexOutput::flush() {
+    delegate->flush();
+}
+
+void RateLimitedIndexOutput::close() {
+    LuceneException finally;
+    try {
+        // account for the tail of the file, so the limiter's byte count is exact
+        if (bytesSinceLastPause > 0) {
+            rateLimiter->pause(bytesSinceLastPause);
+            bytesSinceLastPause = 0;
+        }
+    } catch (LuceneException& e) {
+        finally = e;
+    }
+    delegate->close();
+    finally.throwException();
+}
+
+int64_t RateLimitedIndexOutput::getFilePointer() {
+    return delegate->getFilePointer();
+}
+
+void RateLimitedIndexOutput::seek(int64_t pos) {
+    delegate->seek(pos);
+}
+
+int64_t RateLimitedIndexOutput::length() {
+    return delegate->length();
+}
+
+}
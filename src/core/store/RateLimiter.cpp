@@ -0,0 +1,91 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "LuceneInc.h"
+#include "RateLimiter.h"
+#include "LuceneThread.h"
+#include "MiscUtils.h"
+
+namespace Lucene {
+
+const int32_t RateLimiter::MIN_PAUSE_CHECK_MSEC = 25;
+
+RateLimiter::RateLimiter(double mbPerSec) {
+    this->lastTime = 0.0;
+    this->totalBytes = 0;
+    this->totalPausedMillis = 0;
+    setMbPerSec(mbPerSec);
+}
+
+RateLimiter::~RateLimiter() {
+}
+
+void RateLimiter::setMbPerSec(double mbPerSec) {
+    if (mbPerSec <= 0.0) {
+        boost::throw_exception(IllegalArgumentException(L"mbPerSec must be positive"));
+    }
+    SyncLock syncLock(this);
+    this->mbPerSec = mbPerSec;
+    if (MiscUtils::isInfinite(mbPerSec)) {
+        bytesPerMilli = mbPerSec;
+        minPauseCheckBytes = std::numeric_limits<int64_t>::max();
+    } else {
+        bytesPerMilli = mbPerSec * 1024.0 * 1024.0 / 1000.0;
+        minPauseCheckBytes = std::max((int64_t)1, (int64_t)(MIN_PAUSE_CHECK_MSEC * bytesPerMilli));
+    }
+}
+
+double RateLimiter::getMbPerSec() {
+    SyncLock syncLock(this);
+    return mbPerSec;
+}
+
+int64_t RateLimiter::getMinPauseCheckBytes() {
+    SyncLock syncLock(this);
+    return minPauseCheckBytes;
+}
+
+int64_t RateLimiter::pause(int64_t bytes) {
+    double targetTime = 0.0;
+    {
+        SyncLock syncLock(this);
+        totalBytes += bytes;
+        if (MiscUtils::isInfinite(bytesPerMilli)) {
+            return 0;
+        }
+        // Time we were idle does not count as credit, otherwise a writer that stalled for a while
+        // could then burst at full speed
+        targetTime = lastTime + (double)bytes / bytesPerMilli;
+        lastTime = std::max(targetTime, (double)MiscUtils::currentTimeMillis());
+    }
+
+    int64_t startTime = MiscUtils::currentTimeMillis();
+    int64_t curTime = startTime;
+    // Loop because the thread may wake up early
+    while (targetTime - (double)curTime >= 1.0) {
+        LuceneThread::threadSleep((int32_t)(targetTime - (double)curTime));
+        curTime = MiscUtils::currentTimeMillis();
+    }
+
+    int64_t pausedMillis = curTime - startTime;
+    if (pausedMillis > 0) {
+        SyncLock syncLock(this);
+        totalPausedMillis += pausedMillis;
+    }
+    return pausedMillis;
+}
+
+int64_t RateLimiter::getTotalBytes() {
+    SyncLock syncLock(this);
+    return totalBytes;
+}
+
+int64_t RateLimiter::getTotalPausedMillis() {
+    SyncLock syncLock(this);
+    return totalPausedMillis;
+}
+
+}
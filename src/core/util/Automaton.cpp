@@ -0,0 +1,246 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "LuceneInc.h"
+#include <map>
+#include "Automaton.h"
+
+namespace Lucene {
+
+const int32_t Automaton::MAX_CHAR = sizeof(wchar_t) == 2 ? 0xffff : 0x10ffff;
+
+Automaton::Automaton() {
+    transitions = Collection< Collection<Transition> >::newInstance();
+    epsilons = Collection< Collection<int32_t> >::newInstance();
+    acceptStates = HashSet<int32_t>::newInstance();
+    deterministic = false;
+}
+
+Automaton::~Automaton() {
+}
+
+int32_t Automaton::createState() {
+    transitions.add(Collection<Transition>::newInstance());
+    epsilons.add(Collection<int32_t>::newInstance());
+    return transitions.size() - 1;
+}
+
+int32_t Automaton::getNumStates() {
+    return transitions.size();
+}
+
+void Automaton::setAccept(int32_t state, bool accept) {
+    if (accept) {
+        acceptStates.add(state);
+    } else {
+        acceptStates.remove(state);
+    }
+}
+
+bool Automaton::isAccept(int32_t state) {
+    return acceptStates.contains(state);
+}
+
+void Automaton::addTransition(int32_t from, int32_t min, int32_t max, int32_t to) {
+    Transition transition = {min, max, to};
+    transitions[from].add(transition);
+    deterministic = false;
+}
+
+void Automaton::addEpsilon(int32_t from, int32_t to) {
+    epsilons[from].add(to);
+    deterministic = false;
+}
+
+bool Automaton::isDeterministic() {
+    return deterministic;
+}
+
+void Automaton::addClosure(int32_t state, Collection<int32_t> closure) {
+    if (closure.contains(state)) {
+        return;
+    }
+    closure.add(state);
+    for (Collection<int32_t>::iterator next = epsilons[state].begin(); next != epsilons[state].end(); ++next) {
+        addClosure(*next, closure);
+    }
+}
+
+AutomatonPtr Automaton::determinize() {
+    // subset construction: each deterministic state stands for a sorted set of states of this automaton
+    typedef std::map< std::vector<int32_t>, int32_t > StateSets;
+    StateSets stateSets;
+    Collection< std::vector<int32_t> > pending = Collection< std::vector<int32_t> >::newInstance();
+    AutomatonPtr dfa(newLucene<Automaton>());
+
+    Collection<int32_t> closure(Collection<int32_t>::newInstance());
+    if (getNumStates() > 0) {
+        addClosure(0, closure);
+    }
+    std::vector<int32_t> initial(closure.begin(), closure.end());
+    std::sort(initial.begin(), initial.end());
+    stateSets[initial] = dfa->createState();
+    pending.add(initial);
+
+    for (int32_t current = 0; current < pending.size(); ++current) {
+        std::vector<int32_t> states(pending[current]);
+        int32_t from = stateSets[states];
+
+        // split the alphabet at every transition boundary, so each interval leads to a single set of states
+        std::vector<int32_t> points;
+        for (std::vector<int32_t>::iterator state = states.begin(); state != states.end(); ++state) {
+            if (acceptStates.contains(*state)) {
+                dfa->setAccept(from, true);
+            }
+            for (Collection<Transition>::iterator transition = transitions[*state].begin(); transition != transitions[*state].end(); ++transition) {
+                points.push_back(transition->min);
+                points.push_back(transition->max + 1);
+            }
+        }
+        std::sort(points.begin(), points.end());
+        points.erase(std::unique(points.begin(), points.end()), points.end());
+
+        for (int32_t i = 0; i + 1 < (int32_t)points.size(); ++i) {
+            closure.clear();
+            for (std::vector<int32_t>::iterator state = states.begin(); state != states.end(); ++state) {
+                for (Collection<Transition>::iterator transition = transitions[*state].begin(); transition != transitions[*state].end(); ++transition) {
+                    if (transition->min <= points[i] && points[i] <= transition->max) {
+                        addClosure(transition->to, closure);
+                    }
+                }
+            }
+            if (closure.empty()) {
+                continue;
+            }
+            std::vector<int32_t> target(closure.begin(), closure.end());
+            std::sort(target.begin(), target.end());
+            StateSets::iterator known = stateSets.find(target);
+            int32_t to;
+            if (known == stateSets.end()) {
+                to = dfa->createState();
+                stateSets[target] = to;
+                pending.add(target);
+            } else {
+                to = known->second;
+            }
+
+            // merge with the previous interval if it is adjacent and leads to the same state
+            Collection<Transition> fromTransitions(dfa->transitions[from]);
+            if (!fromTransitions.empty() && fromTransitions[fromTransitions.size() - 1].to == to && fromTransitions[fromTransitions.size() - 1].max + 1 == points[i]) {
+                fromTransitions[fromTransitions.size() - 1].max = points[i + 1] - 1;
+            } else {
+                dfa->addTransition(from, points[i], points[i + 1] - 1, to);
+            }
+        }
+    }
+
+    // find the live states, from which an accepting state can be reached
+    int32_t numStates = dfa->getNumStates();
+    Collection< Collection<int32_t> > reverse(Collection< Collection<int32_t> >::newInstance(numStates));
+    Collection<int32_t> live(Collection<int32_t>::newInstance(numStates));
+    Collection<int32_t> queue(Collection<int32_t>::newInstance());
+    for (int32_t state = 0; state < numStates; ++state) {
+        reverse[state] = Collection<int32_t>::newInstance();
+    }
+    for (int32_t state = 0; state < numStates; ++state) {
+        for (Collection<Transition>::iterator transition = dfa->transitions[state].begin(); transition != dfa->transitions[state].end(); ++transition) {
+            reverse[transition->to].add(state);
+        }
+        if (dfa->isAccept(state)) {
+            live[state] = 1;
+            queue.add(state);
+        }
+    }
+    for (int32_t i = 0; i < queue.size(); ++i) {
+        for (Collection<int32_t>::iterator from = reverse[queue[i]].begin(); from != reverse[queue[i]].end(); ++from) {
+            if (live[*from] == 0) {
+                live[*from] = 1;
+                queue.add(*from);
+            }
+        }
+    }
+
+    // copy the live states, keeping the initial state first
+    AutomatonPtr result(newLucene<Automaton>());
+    Collection<int32_t> renumber(Collection<int32_t>::newInstance(numStates));
+    result->createState();
+    renumber[0] = 0;
+    for (int32_t state = 1; state < numStates; ++state) {
+        renumber[state] = live[state] != 0 ? result->createState() : -1;
+    }
+    if (live[0] != 0) {
+        for (int32_t state = 0; state < numStates; ++state) {
+            if (renumber[state] == -1) {
+                continue;
+            }
+            result->setAccept(renumber[state], dfa->isAccept(state));
+            for (Collection<Transition>::iterator transition = dfa->transitions[state].begin(); transition != dfa->transitions[state].end(); ++transition) {
+                if (renumber[transition->to] != -1) {
+                    result->addTransition(renumber[state], transition->min, transition->max, renumber[transition->to]);
+                }
+            }
+            std::sort(result->transitions[renumber[state]].begin(), result->transitions[renumber[state]].end());
+        }
+    }
+    result->deterministic = true;
+    return result;
+}
+
+int32_t Automaton::step(int32_t state, int32_t c) {
+    BOOST_ASSERT(deterministic);
+    Collection<Transition> stateTransitions(transitions[state]);
+    int32_t low = 0;
+    int32_t high = stateTransitions.size() - 1;
+    while (low <= high) {
+        int32_t mid = (low + high) >> 1;
+        const Transition& transition = stateTransitions[mid];
+        if (c < transition.min) {
+            high = mid - 1;
+        } else if (c > transition.max) {
+            low = mid + 1;
+        } else {
+            return transition.to;
+        }
+    }
+    return -1;
+}
+
+bool Automaton::run(const String& text) {
+    int32_t state = 0;
+    for (String::const_iterator c = text.begin(); c != text.end() && state != -1; ++c) {
+        state = step(state, *c);
+    }
+    return state != -1 && isAccept(state);
+}
+
+bool Automaton::nextLabel(int32_t state, int32_t minChar, int32_t& label) {
+    BOOST_ASSERT(deterministic);
+    Collection<Transition> stateTransitions(transitions[state]);
+    for (Collection<Transition>::iterator transition = stateTransitions.begin(); transition != stateTransitions.end(); ++transition) {
+        if (transition->max >= minChar) {
+            label = std::max(transition->min, minChar);
+            return true;
+        }
+    }
+    return false;
+}
+
+String Automaton::getCommonPrefix() {
+    BOOST_ASSERT(deterministic);
+    StringStream prefix;
+    int32_t state = 0;
+    // a state can only be visited once unless the automaton loops on a single string
+    for (int32_t visited = 0; visited < getNumStates(); ++visited) {
+        if (isAccept(state) || transitions[state].size() != 1 || transitions[state][0].min != transitions[state][0].max) {
+            break;
+        }
+        prefix << (wchar_t)transitions[state][0].min;
+        state = transitions[state][0].to;
+    }
+    return prefix.str();
+}
+
+}
@@ -0,0 +1,187 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "LuceneInc.h"
+#include "LZ4.h"
+
+namespace Lucene {
+
+/// Shortest match worth encoding.
+const int32_t LZ4::MIN_MATCH = 4;
+
+/// The last bytes of a block are always literals.
+const int32_t LZ4::LAST_LITERALS = 5;
+
+/// The last match must start at least this many bytes before the end of a block.
+const int32_t LZ4::MATCH_FIND_LIMIT = 12;
+
+/// Largest offset that fits in a sequence.
+const int32_t LZ4::MAX_DISTANCE = 65535;
+
+/// Log2 of the number of hash table entries.
+const int32_t LZ4::HASH_LOG = 12;
+
+/// Grow the search step by one for every 2^SKIP_TRIGGER bytes without a match, so incompressible data is
+/// skipped quickly.
+const int32_t LZ4::SKIP_TRIGGER = 6;
+
+static inline uint32_t readSequence(const uint8_t* bytes) {
+    uint32_t sequence;
+    std::memcpy(&sequence, bytes, sizeof(sequence));
+    return sequence;
+}
+
+int32_t LZ4::maxCompressedLength(int32_t length) {
+    return length + length / 255 + 16;
+}
+
+int32_t LZ4::writeLength(uint8_t* dest, int32_t op, int32_t length) {
+    while (length >= 255) {
+        dest[op++] = 255;
+        length -= 255;
+    }
+    dest[op++] = (uint8_t)length;
+    return op;
+}
+
+int32_t LZ4::readLength(const uint8_t* src, int32_t& ip, int32_t end, int32_t limit) {
+    int32_t length = 0;
+    uint8_t b = 0;
+    do {
+        if (ip >= end) {
+            boost::throw_exception(CompressionException(L"Truncated LZ4 block"));
+        }
+        b = src[ip++];
+        length += b;
+        if (length > limit) {
+            boost::throw_exception(CompressionException(L"LZ4 block decompresses past the end of the buffer"));
+        }
+    } while (b == 255);
+    return length;
+}
+
+int32_t LZ4::compress(const uint8_t* src, int32_t length, uint8_t* dest) {
+    int32_t op = 0;
+    int32_t anchor = 0;
+
+    if (length > MATCH_FIND_LIMIT) {
+        int32_t hashTable[1 << HASH_LOG];
+        std::fill(hashTable, hashTable + (1 << HASH_LOG), -1);
+
+        int32_t matchLimit = length - LAST_LITERALS;
+        int32_t findLimit = length - MATCH_FIND_LIMIT;
+        int32_t ip = 0;
+        while (ip < findLimit) {
+            uint32_t sequence = readSequence(src + ip);
+            int32_t hash = (int32_t)((sequence * 2654435761U) >> (32 - HASH_LOG));
+            int32_t ref = hashTable[hash];
+            hashTable[hash] = ip;
+            if (ref < 0 || ip - ref > MAX_DISTANCE || readSequence(src + ref) != sequence) {
+                ip += 1 + ((ip - anchor) >> SKIP_TRIGGER);
+                continue;
+            }
+
+            // extend the match backwards over pending literals, then forwards
+            while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) {
+                --ip;
+                --ref;
+            }
+            int32_t matchLength = MIN_MATCH;
+            while (ip + matchLength < matchLimit && src[ip + matchLength] == src[ref + matchLength]) {
+                ++matchLength;
+            }
+
+            int32_t literals = ip - anchor;
+            int32_t extraLength = matchLength - MIN_MATCH;
+            dest[op++] = (uint8_t)((std::min(literals, 15) << 4) | std::min(extraLength, 15));
+            if (literals >= 15) {
+                op = writeLength(dest, op, literals - 15);
+            }
+            std::memcpy(dest + op, src + anchor, literals);
+            op += literals;
+
+            int32_t offset = ip - ref;
+            dest[op++] = (uint8_t)offset;
+            dest[op++] = (uint8_t)(offset >> 8);
+            if (extraLength >= 15) {
+                op = writeLength(dest, op, extraLength - 15);
+            }
+
+            ip += matchLength;
+            anchor = ip;
+        }
+    }
+
+    // the last sequence holds the remaining literals and no match
+    int32_t literals = length - anchor;
+    dest[op++] = (uint8_t)(std::min(literals, 15) << 4);
+    if (literals >= 15) {
+        op = writeLength(dest, op, literals - 15);
+    }
+    std::memcpy(dest + op, src + anchor, literals);
+    op += literals;
+
+    BOOST_ASSERT(op <= maxCompressedLength(length));
+    return op;
+}
+
+int32_t LZ4::decompress(const uint8_t* src, int32_t length, uint8_t* dest, int32_t destLength) {
+    int32_t ip = 0;
+    int32_t op = 0;
+    while (true) {
+        if (ip >= length) {
+            boost::throw_exception(CompressionException(L"Truncated LZ4 block"));
+        }
+        int32_t token = src[ip++];
+
+        int32_t literals = token >> 4;
+        if (literals == 15) {
+            literals += readLength(src, ip, length, destLength);
+        }
+        if (literals > length - ip || literals > destLength - op) {
+            boost::throw_exception(CompressionException(L"LZ4 literals run past the end of the buffer"));
+        }
+        std::memcpy(dest + op, src + ip, literals);
+        ip += literals;
+        op += literals;
+
+        if (ip == length) {
+            break; // the last sequence has no match
+        }
+
+        if (length - ip < 2) {
+            boost::throw_exception(CompressionException(L"Truncated LZ4 block"));
+        }
+        int32_t offset = src[ip] | (src[ip + 1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op) {
+            boost::throw_exception(CompressionException(L"Invalid LZ4 match offset"));
+        }
+
+        int32_t matchLength = token & 15;
+        if (matchLength == 15) {
+            matchLength += readLength(src, ip, length, destLength);
+        }
+        matchLength += MIN_MATCH;
+        if (matchLength > destLength - op) {
+            boost::throw_exception(CompressionException(L"LZ4 block decompresses past the end of the buffer"));
+        }
+
+        int32_t ref = op - offset;
+        if (offset >= matchLength) {
+            std::memcpy(dest + op, dest + ref, matchLength);
+            op += matchLength;
+        } else {
+            // overlapping match repeats the last offset bytes
+            for (int32_t i = 0; i < matchLength; ++i) {
+                dest[op++] = dest[ref + i];
+            }
+        }
+    }
+    return op;
+}
+
+}
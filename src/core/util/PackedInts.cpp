@@ -0,0 +1,112 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "LuceneInc.h"
+#include "PackedInts.h"
+#include "IndexInput.h"
+#include "IndexOutput.h"
+#include "MiscUtils.h"
+
+namespace Lucene {
+
+PackedInts::PackedInts(int32_t valueCount, int32_t bitsPerValue, int64_t minValue) {
+    if (valueCount < 0) {
+        boost::throw_exception(IllegalArgumentException(L"valueCount must not be negative"));
+    }
+    if (bitsPerValue < 0 || bitsPerValue > 64) {
+        boost::throw_exception(IllegalArgumentException(L"bitsPerValue must be between 0 and 64"));
+    }
+    this->valueCount = valueCount;
+    this->bitsPerValue = bitsPerValue;
+    this->minValue = minValue;
+    this->mask = bitsPerValue == 64 ? ~(uint64_t)0 : (((uint64_t)1 << bitsPerValue) - 1);
+    int32_t numBlocks = (int32_t)(((int64_t)valueCount * bitsPerValue + 63) >> 6);
+    this->blocks = LongArray::newInstance(std::max(numBlocks, 1));
+    MiscUtils::arrayFill(blocks.get(), 0, blocks.size(), 0);
+}
+
+PackedInts::~PackedInts() {
+}
+
+int32_t PackedInts::bitsRequired(uint64_t maxValue) {
+    int32_t bits = 0;
+    while (maxValue != 0) {
+        ++bits;
+        maxValue >>= 1;
+    }
+    return bits;
+}
+
+PackedIntsPtr PackedInts::forRange(int32_t valueCount, int64_t minValue, int64_t maxValue) {
+    return newLucene<PackedInts>(valueCount, bitsRequired((uint64_t)maxValue - (uint64_t)minValue), minValue);
+}
+
+void PackedInts::set(int32_t index, int64_t value) {
+    if (bitsPerValue == 0) {
+        return;
+    }
+    uint64_t packed = ((uint64_t)value - (uint64_t)minValue) & mask;
+    uint64_t bitPos = (uint64_t)index * (uint64_t)bitsPerValue;
+    int32_t block = (int32_t)(bitPos >> 6);
+    int32_t shift = (int32_t)(bitPos & 63);
+    int64_t* data = blocks.get();
+    data[block] = (int64_t)(((uint64_t)data[block] & ~(mask << shift)) | (packed << shift));
+    if (shift + bitsPerValue > 64) {
+        // the value spans two blocks
+        int32_t spilled = 64 - shift;
+        data[block + 1] = (int64_t)(((uint64_t)data[block + 1] & ~(mask >> spilled)) | (packed >> spilled));
+    }
+}
+
+int32_t PackedInts::size() {
+    return valueCount;
+}
+
+int32_t PackedInts::getBitsPerValue() {
+    return bitsPerValue;
+}
+
+int64_t PackedInts::getMinValue() {
+    return minValue;
+}
+
+int64_t PackedInts::ramBytesUsed() {
+    return (int64_t)blocks.size() * sizeof(int64_t);
+}
+
+void PackedInts::write(const IndexOutputPtr& output) {
+    output->writeVInt(valueCount);
+    output->writeVInt(bitsPerValue);
+    output->writeLong(minValue);
+    int32_t numBlocks = (int32_t)(((int64_t)valueCount * bitsPerValue + 63) >> 6);
+    const int64_t* data = blocks.get();
+    for (int32_t i = 0; i < numBlocks; ++i) {
+        output->writeLong(data[i]);
+    }
+}
+
+PackedIntsPtr PackedInts::read(const IndexInputPtr& input) {
+    int32_t valueCount = input->readVInt();
+    int32_t bitsPerValue = input->readVInt();
+    int64_t minValue = input->readLong();
+    PackedIntsPtr values(newLucene<PackedInts>(valueCount, bitsPerValue, minValue));
+    int32_t numBlocks = (int32_t)(((int64_t)valueCount * bitsPerValue + 63) >> 6);
+    int64_t* data = values->blocks.get();
+    for (int32_t i = 0; i < numBlocks; ++i) {
+        data[i] = input->readLong();
+    }
+    return values;
+}
+
+void PackedInts::skip(const IndexInputPtr& input) {
+    int32_t valueCount = input->readVInt();
+    int32_t bitsPerValue = input->readVInt();
+    input->readLong();
+    int64_t numBlocks = ((int64_t)valueCount * bitsPerValue + 63) >> 6;
+    input->seek(input->getFilePointer() + numBlocks * sizeof(int64_t));
+}
+
+}
@@ -5,25 +5,230 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include "LuceneInc.h"
+#include <deque>
+#include <boost/thread/tss.hpp>
 #include "ThreadPool.h"
 
 namespace Lucene {
 
+/// Per-thread queue of pending tasks.
+struct WorkQueue {
+    boost::mutex queueMutex;
+    std::deque<ThreadPool::Task> tasks;
+};
+
+typedef boost::shared_ptr<WorkQueue> WorkQueuePtr;
+
+class ThreadPoolQueues {
+public:
+    ThreadPoolQueues(int32_t queueCount) {
+        pendingTasks = 0;
+        nextQueue = 0;
+        shutdown = false;
+        for (int32_t i = 0; i < queueCount; ++i) {
+            queues.push_back(WorkQueuePtr(new WorkQueue()));
+        }
+    }
+
+protected:
+    std::vector<WorkQueuePtr> queues;
+
+    boost::mutex poolMutex;
+    boost::condition_variable poolCondition;
+    int32_t pendingTasks;
+    int32_t nextQueue;
+    bool shutdown;
+
+public:
+    int32_t size() {
+        return (int32_t)queues.size();
+    }
+
+    void schedule(const ThreadPool::Task& task);
+
+    /// Execute one pending task on the calling thread, if there is one.
+    bool runPendingTask();
+
+    /// Stop all threads once pending tasks are done.
+    void stop();
+
+    /// Main loop of each pool thread.
+    static void run(const boost::shared_ptr<ThreadPoolQueues>& queues, int32_t queue);
+
+protected:
+    /// Pop a task from the given queue, stealing from the other queues if it is empty.
+    bool popTask(int32_t queue, ThreadPool::Task& task);
+
+    /// Return index of the queue owned by the calling thread, or -1 if it is not one of our threads.
+    int32_t currentQueue();
+};
+
+/// Identifies the queues and queue owned by a pool thread.
+struct PoolThread {
+    PoolThread(ThreadPoolQueues* queues, int32_t queue) : queues(queues), queue(queue) {
+    }
+
+    ThreadPoolQueues* queues;
+    int32_t queue;
+};
+
+static boost::thread_specific_ptr<PoolThread> currentPoolThread;
+
+void ThreadPoolQueues::schedule(const ThreadPool::Task& task) {
+    int32_t queue = currentQueue();
+    boost::mutex::scoped_lock poolLock(poolMutex);
+    if (queue == -1) {
+        queue = nextQueue;
+        nextQueue = (nextQueue + 1) % (int32_t)queues.size();
+    }
+    {
+        boost::mutex::scoped_lock queueLock(queues[queue]->queueMutex);
+        queues[queue]->tasks.push_back(task);
+    }
+    ++pendingTasks;
+    poolCondition.notify_one();
+}
+
+bool ThreadPoolQueues::popTask(int32_t queue, ThreadPool::Task& task) {
+    int32_t queueCount = (int32_t)queues.size();
+    if (queue != -1) {
+        // newest task from our own queue first, it is most likely to still be in cache
+        boost::mutex::scoped_lock queueLock(queues[queue]->queueMutex);
+        if (!queues[queue]->tasks.empty()) {
+            task = queues[queue]->tasks.back();
+            queues[queue]->tasks.pop_back();
+            return true;
+        }
+    }
+    // otherwise steal the oldest task from one of the other queues
+    for (int32_t i = 1; i <= queueCount; ++i) {
+        int32_t victim = (std::max(queue, (int32_t)0) + i) % queueCount;
+        if (victim == queue) {
+            continue;
+        }
+        boost::mutex::scoped_lock queueLock(queues[victim]->queueMutex);
+        if (!queues[victim]->tasks.empty()) {
+            task = queues[victim]->tasks.front();
+            queues[victim]->tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPoolQueues::runPendingTask() {
+    ThreadPool::Task task;
+    if (!popTask(currentQueue(), task)) {
+        return false;
+    }
+    {
+        boost::mutex::scoped_lock poolLock(poolMutex);
+        --pendingTasks;
+    }
+    task();
+    return true;
+}
+
+void ThreadPoolQueues::stop() {
+    boost::mutex::scoped_lock poolLock(poolMutex);
+    shutdown = true;
+    poolCondition.notify_all();
+}
+
+int32_t ThreadPoolQueues::currentQueue() {
+    PoolThread* poolThread = currentPoolThread.get();
+    return (poolThread && poolThread->queues == this) ? poolThread->queue : -1;
+}
+
+void ThreadPoolQueues::run(const boost::shared_ptr<ThreadPoolQueues>& queues, int32_t queue) {
+    // queues are kept alive by this thread, even if the pool itself is released by one of its tasks
+    boost::shared_ptr<ThreadPoolQueues> poolQueues(queues);
+    currentPoolThread.reset(new PoolThread(poolQueues.get(), queue));
+    while (true) {
+        if (poolQueues->runPendingTask()) {
+            continue;
+        }
+        boost::mutex::scoped_lock poolLock(poolQueues->poolMutex);
+        while (poolQueues->pendingTasks == 0 && !poolQueues->shutdown) {
+            poolQueues->poolCondition.wait(poolLock);
+        }
+        if (poolQueues->pendingTasks == 0 && poolQueues->shutdown) {
+            break;
+        }
+    }
+    currentPoolThread.reset();
+}
+
+Future::Future() {
+    done = false;
+}
+
 Future::~Future() {
 }
 
+void Future::set(const boost::any& value) {
+    boost::mutex::scoped_lock futureLock(futureMutex);
+    this->value = value;
+    done = true;
+    futureCondition.notify_all();
+}
+
+void Future::setException(const LuceneException& exception) {
+    boost::mutex::scoped_lock futureLock(futureMutex);
+    this->exception = exception;
+    done = true;
+    futureCondition.notify_all();
+}
+
+bool Future::isDone() {
+    boost::mutex::scoped_lock futureLock(futureMutex);
+    return done;
+}
+
+void Future::waitDone() {
+    PoolThread* poolThread = currentPoolThread.get();
+    if (poolThread) {
+        // help out with pending tasks rather than blocking a pool thread
+        while (!isDone()) {
+            if (!poolThread->queues->runPendingTask()) {
+                break;
+            }
+        }
+    }
+    boost::mutex::scoped_lock futureLock(futureMutex);
+    while (!done) {
+        futureCondition.wait(futureLock);
+    }
+}
+
 const int32_t ThreadPool::THREADPOOL_SIZE = 5;
 
-ThreadPool::ThreadPool() {
-    work.reset(new boost::asio::io_service::work(io_service));
-    for (int32_t i = 0; i < THREADPOOL_SIZE; ++i) {
-        threadGroup.create_thread(boost::bind(&boost::asio::io_service::run, &io_service));
+ThreadPool::ThreadPool(int32_t threadCount) {
+    if (threadCount < 0) {
+        boost::throw_exception(IllegalArgumentException(L"threadCount must be >= 0"));
+    }
+    if (threadCount == 0) {
+        threadCount = (int32_t)boost::thread::hardware_concurrency();
+        if (threadCount == 0) {
+            threadCount = THREADPOOL_SIZE;
+        }
+    }
+    queues.reset(new ThreadPoolQueues(threadCount));
+    threads = Collection<threadPtr>::newInstance(threadCount);
+    for (int32_t i = 0; i < threadCount; ++i) {
+        threads[i] = newInstance<boost::thread>(boost::bind(&ThreadPoolQueues::run, queues, i));
     }
 }
 
 ThreadPool::~ThreadPool() {
-    work.reset(); // stop all threads
-    threadGroup.join_all(); // wait for all competition
+    queues->stop(); // stop all threads
+    for (Collection<threadPtr>::iterator thread = threads.begin(); thread != threads.end(); ++thread) {
+        if ((*thread)->get_id() == boost::this_thread::get_id()) {
+            (*thread)->detach(); // released from within one of our own tasks
+        } else {
+            (*thread)->join(); // wait for all competition
+        }
+    }
 }
 
 ThreadPoolPtr ThreadPool::getInstance() {
@@ -35,4 +240,12 @@ ThreadPoolPtr ThreadPool::getInstance() {
     return threadPool;
 }
 
+int32_t ThreadPool::getThreadCount() {
+    return queues->size();
+}
+
+void ThreadPool::schedule(const Task& task) {
+    queues->schedule(task);
+}
+
 }
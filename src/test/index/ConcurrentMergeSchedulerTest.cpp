@@ -22,6 +22,12 @@
 #include "IndexFileDeleter.h"
 #include "KeepOnlyLastCommitDeletionPolicy.h"
 #include "TestPoint.h"
+#include "ThreadPool.h"
+#include "SegmentInfo.h"
+#include "RAMDirectory.h"
+#include "MergePolicy.h"
+#include "Random.h"
+#include "MiscUtils.h"
 
 using namespace Lucene;
 
@@ -214,6 +220,35 @@ TEST_F(ConcurrentMergeSchedulerTest, testNoExtraFiles) {
     directory->close();
 }
 
+TEST_F(ConcurrentMergeSchedulerTest, testThreadPoolMerges) {
+    RAMDirectoryPtr directory = newLucene<MockRAMDirectory>();
+    ThreadPoolPtr threadPool = newLucene<ThreadPool>(2);
+
+    IndexWriterPtr writer = newLucene<IndexWriter>(directory, newLucene<SimpleAnalyzer>(), true, IndexWriter::MaxFieldLengthUNLIMITED);
+    ConcurrentMergeSchedulerPtr cms = newLucene<ConcurrentMergeScheduler>();
+    cms->setThreadPool(threadPool);
+    cms->setMaxThreadCount(2);
+    EXPECT_EQ(threadPool, cms->getThreadPool());
+    writer->setMergeScheduler(cms);
+    writer->setMaxBufferedDocs(2);
+    writer->setMergeFactor(3);
+
+    for (int32_t i = 0; i < 200; ++i) {
+        DocumentPtr doc = newLucene<Document>();
+        doc->add(newLucene<Field>(L"content", L"a b c", Field::STORE_NO, Field::INDEX_ANALYZED));
+        writer->addDocument(doc);
+    }
+
+    writer->close();
+    checkNoUnreferencedFiles(directory);
+
+    IndexReaderPtr reader = IndexReader::open(directory, true);
+    EXPECT_EQ(200, reader->numDocs());
+    EXPECT_TRUE(reader->getSequentialSubReaders().size() < 100);
+    reader->close();
+    directory->close();
+}
+
 TEST_F(ConcurrentMergeSchedulerTest, testNoWaitClose) {
     RAMDirectoryPtr directory = newLucene<MockRAMDirectory>();
 
@@ -346,3 +381,118 @@ TEST_F(ConcurrentMergeSchedulerTest, testSubclassConcurrentMergeScheduler) {
     dir->close();
     EXPECT_TRUE(ConcurrentMergeScheduler::anyUnhandledExceptions());
 }
+
+namespace TestMergeIOThrottle {
+
+DECLARE_SHARED_PTR(RecordingMergeScheduler)
+
+class RecordingMergeScheduler : public ConcurrentMergeScheduler {
+public:
+    RecordingMergeScheduler() {
+        merges = Collection<OneMergePtr>::newInstance();
+    }
+
+    virtual ~RecordingMergeScheduler() {
+    }
+
+    LUCENE_CLASS(RecordingMergeScheduler);
+
+public:
+    Collection<OneMergePtr> merges;
+
+    using ConcurrentMergeScheduler::updateIOThrottle;
+
+protected:
+    virtual void doMerge(const OneMergePtr& merge) {
+        ConcurrentMergeScheduler::doMerge(merge);
+        SyncLock syncLock(this);
+        merges.add(merge);
+    }
+};
+
+}
+
+TEST_F(ConcurrentMergeSchedulerTest, testMergeIOThrottle) {
+    MockRAMDirectoryPtr directory = newLucene<MockRAMDirectory>();
+    IndexWriterPtr writer = newLucene<IndexWriter>(directory, newLucene<WhitespaceAnalyzer>(), true, IndexWriter::MaxFieldLengthUNLIMITED);
+    TestMergeIOThrottle::RecordingMergeSchedulerPtr cms = newLucene<TestMergeIOThrottle::RecordingMergeScheduler>();
+    cms->setIORateLimitMBPerSec(0.1);
+    EXPECT_EQ(0.1, cms->getIORateLimitMBPerSec());
+    writer->setMergeScheduler(cms);
+    writer->setMaxBufferedDocs(10);
+    writer->setMergeFactor(10);
+
+    RandomPtr random = newLucene<Random>(42);
+    for (int32_t i = 0; i < 100; ++i) {
+        DocumentPtr doc = newLucene<Document>();
+        StringStream content;
+        for (int32_t j = 0; j < 50; ++j) {
+            content << L" " << random->nextInt(100000);
+        }
+        doc->add(newLucene<Field>(L"content", content.str(), Field::STORE_YES, Field::INDEX_ANALYZED));
+        writer->addDocument(doc);
+    }
+    writer->close();
+
+    EXPECT_EQ(1, cms->merges.size());
+    OneMergePtr merge = cms->merges[0];
+    EXPECT_TRUE(merge->getTotalBytesWritten() > 0);
+    EXPECT_TRUE(merge->getTotalThrottledMillis() > 0);
+    EXPECT_TRUE(merge->getElapsedMillis() >= merge->getTotalThrottledMillis());
+    EXPECT_TRUE(merge->getMBPerSec() > 0.0);
+
+    IndexReaderPtr reader = IndexReader::open(directory, true);
+    EXPECT_EQ(100, reader->numDocs());
+    reader->close();
+    directory->close();
+}
+
+TEST_F(ConcurrentMergeSchedulerTest, testAutoIOThrottle) {
+    TestMergeIOThrottle::RecordingMergeSchedulerPtr cms = newLucene<TestMergeIOThrottle::RecordingMergeScheduler>();
+    EXPECT_TRUE(!cms->getAutoIOThrottle());
+    EXPECT_TRUE(MiscUtils::isInfinite(cms->getIORateLimitMBPerSec()));
+
+    cms->enableAutoIOThrottle();
+    EXPECT_TRUE(cms->getAutoIOThrottle());
+    EXPECT_EQ(ConcurrentMergeScheduler::START_MB_PER_SEC, cms->getIORateLimitMBPerSec());
+
+    SegmentInfosPtr segments = newLucene<SegmentInfos>();
+    segments->add(newLucene<SegmentInfo>(L"_0", 10, newLucene<RAMDirectory>()));
+    OneMergePtr merge = newLucene<OneMerge>(segments, false);
+
+    // small merges are not throttled
+    merge->estimatedMergeBytes = 1024 * 1024;
+    EXPECT_TRUE(MiscUtils::isInfinite(cms->getMergeMBPerSec(merge)));
+
+    merge->estimatedMergeBytes = (int64_t)ConcurrentMergeScheduler::MIN_BIG_MERGE_MB * 2 * 1024 * 1024;
+    EXPECT_EQ(ConcurrentMergeScheduler::START_MB_PER_SEC, cms->getMergeMBPerSec(merge));
+
+    // merges back off while searches are running
+    cms->searchStarted();
+    cms->searchStarted();
+    EXPECT_EQ(ConcurrentMergeScheduler::START_MB_PER_SEC * ConcurrentMergeScheduler::SEARCH_BACKOFF_RATIO, cms->getMergeMBPerSec(merge));
+    cms->searchFinished();
+    EXPECT_EQ(ConcurrentMergeScheduler::START_MB_PER_SEC * ConcurrentMergeScheduler::SEARCH_BACKOFF_RATIO, cms->getMergeMBPerSec(merge));
+    cms->searchFinished();
+    EXPECT_EQ(ConcurrentMergeScheduler::START_MB_PER_SEC, cms->getMergeMBPerSec(merge));
+    EXPECT_THROW(cms->searchFinished(), IllegalStateException);
+
+    // with no backlog the rate keeps dropping, down to the minimum
+    cms->updateIOThrottle(merge);
+    EXPECT_TRUE(cms->getIORateLimitMBPerSec() < ConcurrentMergeScheduler::START_MB_PER_SEC);
+    for (int32_t i = 0; i < 100; ++i) {
+        cms->updateIOThrottle(merge);
+    }
+    EXPECT_EQ(ConcurrentMergeScheduler::MIN_MERGE_MB_PER_SEC, cms->getIORateLimitMBPerSec());
+
+    // optimize merges have their own limit
+    merge->optimize = true;
+    EXPECT_TRUE(MiscUtils::isInfinite(cms->getMergeMBPerSec(merge)));
+    cms->setForceMergeMBPerSec(7.0);
+    EXPECT_EQ(7.0, cms->getMergeMBPerSec(merge));
+
+    cms->disableAutoIOThrottle();
+    merge->optimize = false;
+    EXPECT_TRUE(MiscUtils::isInfinite(cms->getMergeMBPerSec(merge)));
+    EXPECT_THROW(cms->setIORateLimitMBPerSec(0.0), IllegalArgumentException);
+}
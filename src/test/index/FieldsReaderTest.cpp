@@ -5,6 +5,7 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include "TestInc.h"
+#include <boost/algorithm/string.hpp>
 #include "LuceneTestFixture.h"
 #include "TestUtils.h"
 #include "RAMDirectory.h"
@@ -20,6 +21,9 @@
 #include "FSDirectory.h"
 #include "BufferedIndexInput.h"
 #include "IndexReader.h"
+#include "FieldsWriter.h"
+#include "IndexFileNames.h"
+#include "Term.h"
 #include "MiscUtils.h"
 #include "FileUtils.h"
 
@@ -435,3 +439,155 @@ TEST_F(FieldsReaderTest, testExceptions) {
     FileUtils::removeDirectory(indexDir);
     finally.throwException();
 }
+
+namespace TestCompressedBlocks {
+
+static String storedValue(int32_t i) {
+    StringStream value;
+    value << L"document " << i << L":";
+    for (int32_t j = 0; j < i % 13; ++j) {
+        value << L" stored field value " << (i % 7);
+    }
+    return value.str();
+}
+
+static ByteArray binaryValue(int32_t i) {
+    ByteArray bytes(ByteArray::newInstance(1 + i % 50));
+    for (int32_t j = 0; j < bytes.size(); ++j) {
+        bytes[j] = (uint8_t)(i + j / 4);
+    }
+    return bytes;
+}
+
+static void addDocuments(const IndexWriterPtr& writer, int32_t start, int32_t numDocs) {
+    for (int32_t i = start; i < start + numDocs; ++i) {
+        DocumentPtr doc = newLucene<Document>();
+        doc->add(newLucene<Field>(L"id", StringUtils::toString(i), Field::STORE_YES, Field::INDEX_NOT_ANALYZED));
+        doc->add(newLucene<Field>(L"text", storedValue(i), Field::STORE_YES, Field::INDEX_ANALYZED));
+        if (i % 3 == 0) {
+            doc->add(newLucene<Field>(L"binary", binaryValue(i), Field::STORE_YES));
+        }
+        writer->addDocument(doc);
+    }
+}
+
+static void checkDocument(const DocumentPtr& doc, int32_t i) {
+    EXPECT_EQ(StringUtils::toString(i), doc->get(L"id"));
+    EXPECT_EQ(storedValue(i), doc->get(L"text"));
+    if (i % 3 == 0) {
+        EXPECT_TRUE(binaryValue(i).equals(doc->getBinaryValue(L"binary")));
+    } else {
+        EXPECT_TRUE(!doc->getBinaryValue(L"binary"));
+    }
+}
+
+static int64_t storedFieldsLength(const DirectoryPtr& dir) {
+    int64_t length = 0;
+    HashSet<String> files(dir->listAll());
+    for (HashSet<String>::iterator file = files.begin(); file != files.end(); ++file) {
+        if (boost::ends_with(*file, L"." + IndexFileNames::FIELDS_EXTENSION())) {
+            length += dir->fileLength(*file);
+        }
+    }
+    return length;
+}
+
+static int64_t indexStoredFields(const DirectoryPtr& dir, int32_t compressionMode, int32_t numDocs) {
+    IndexWriterPtr writer = newLucene<IndexWriter>(dir, newLucene<WhitespaceAnalyzer>(), true, IndexWriter::MaxFieldLengthLIMITED);
+    writer->setUseCompoundFile(false);
+    writer->setStoredFieldsCompression(compressionMode);
+    writer->setMaxBufferedDocs(500);
+    addDocuments(writer, 0, numDocs);
+    writer->optimize();
+    writer->close();
+
+    IndexReaderPtr reader = IndexReader::open(dir, true);
+    EXPECT_EQ(numDocs, reader->maxDoc());
+    // read backwards, so that each block is decompressed for its last document first
+    for (int32_t i = numDocs - 1; i >= 0; --i) {
+        checkDocument(reader->document(i), i);
+    }
+    reader->close();
+    return storedFieldsLength(dir);
+}
+
+}
+
+TEST_F(FieldsReaderTest, testCompressedBlocks) {
+    static const int32_t numDocs = 2000;
+    int64_t uncompressed = TestCompressedBlocks::indexStoredFields(newLucene<RAMDirectory>(), FieldsWriter::COMPRESSION_NONE, numDocs);
+    int64_t fast = TestCompressedBlocks::indexStoredFields(newLucene<RAMDirectory>(), FieldsWriter::COMPRESSION_FAST, numDocs);
+    int64_t high = TestCompressedBlocks::indexStoredFields(newLucene<RAMDirectory>(), FieldsWriter::COMPRESSION_HIGH, numDocs);
+    EXPECT_TRUE(fast < uncompressed / 2);
+    EXPECT_TRUE(high < fast);
+}
+
+TEST_F(FieldsReaderTest, testCompressedBlockLazyFields) {
+    DirectoryPtr dir = newLucene<RAMDirectory>();
+    IndexWriterPtr writer = newLucene<IndexWriter>(dir, newLucene<WhitespaceAnalyzer>(), true, IndexWriter::MaxFieldLengthLIMITED);
+    TestCompressedBlocks::addDocuments(writer, 0, 1000);
+    writer->close();
+
+    HashSet<String> lazyFieldNames = HashSet<String>::newInstance();
+    lazyFieldNames.add(L"text");
+    lazyFieldNames.add(L"binary");
+    SetBasedFieldSelectorPtr fieldSelector = newLucene<SetBasedFieldSelector>(HashSet<String>::newInstance(), lazyFieldNames);
+
+    IndexReaderPtr reader = IndexReader::open(dir, true);
+    DocumentPtr first = reader->document(0, fieldSelector);
+    DocumentPtr last = reader->document(999, fieldSelector);
+    EXPECT_TRUE(first->getFieldable(L"text")->isLazy());
+
+    // lazy fields still read the right block after the reader has moved on to another one
+    EXPECT_EQ(TestCompressedBlocks::storedValue(0), first->get(L"text"));
+    EXPECT_TRUE(TestCompressedBlocks::binaryValue(0).equals(first->getBinaryValue(L"binary")));
+    EXPECT_EQ(TestCompressedBlocks::storedValue(999), last->get(L"text"));
+    EXPECT_TRUE(TestCompressedBlocks::binaryValue(999).equals(last->getBinaryValue(L"binary")));
+    reader->close();
+}
+
+TEST_F(FieldsReaderTest, testMergeCompressedBlocks) {
+    DirectoryPtr dir = newLucene<RAMDirectory>();
+    IndexWriterPtr writer = newLucene<IndexWriter>(dir, newLucene<WhitespaceAnalyzer>(), true, IndexWriter::MaxFieldLengthLIMITED);
+    writer->setMaxBufferedDocs(300);
+    writer->setMergeFactor(1000);
+    TestCompressedBlocks::addDocuments(writer, 0, 600);
+    writer->commit();
+    writer->setStoredFieldsCompression(FieldsWriter::COMPRESSION_HIGH);
+    TestCompressedBlocks::addDocuments(writer, 600, 600);
+    writer->commit();
+    writer->setStoredFieldsCompression(FieldsWriter::COMPRESSION_FAST);
+
+    // deletions spread over the first segment and clustered in the third, leaving whole blocks untouched
+    for (int32_t i = 0; i < 300; i += 37) {
+        writer->deleteDocuments(newLucene<Term>(L"id", StringUtils::toString(i)));
+    }
+    for (int32_t i = 700; i < 720; ++i) {
+        writer->deleteDocuments(newLucene<Term>(L"id", StringUtils::toString(i)));
+    }
+    writer->optimize();
+    writer->close();
+
+    IndexReaderPtr reader = IndexReader::open(dir, true);
+    EXPECT_EQ(1200 - 9 - 20, reader->maxDoc());
+    int32_t doc = 0;
+    for (int32_t i = 0; i < 1200; ++i) {
+        if ((i < 300 && i % 37 == 0) || (i >= 700 && i < 720)) {
+            continue;
+        }
+        TestCompressedBlocks::checkDocument(reader->document(doc++), i);
+    }
+    reader->close();
+}
+
+TEST_F(FieldsReaderTest, testStoredFieldsCompressionMode) {
+    IndexWriterPtr writer = newLucene<IndexWriter>(newLucene<RAMDirectory>(), newLucene<WhitespaceAnalyzer>(), true, IndexWriter::MaxFieldLengthLIMITED);
+    EXPECT_EQ(FieldsWriter::COMPRESSION_FAST, writer->getStoredFieldsCompression());
+    try {
+        writer->setStoredFieldsCompression(3);
+    } catch (IllegalArgumentException& e) {
+        EXPECT_TRUE(check_exception(LuceneException::IllegalArgument)(e));
+    }
+    EXPECT_EQ(FieldsWriter::COMPRESSION_FAST, writer->getStoredFieldsCompression());
+    writer->close();
+}
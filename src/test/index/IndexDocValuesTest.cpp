@@ -0,0 +1,230 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "TestInc.h"
+#include "LuceneTestFixture.h"
+#include "RAMDirectory.h"
+#include "IndexWriter.h"
+#include "IndexReader.h"
+#include "WhitespaceAnalyzer.h"
+#include "Document.h"
+#include "Field.h"
+#include "Term.h"
+#include "IndexSearcher.h"
+#include "MatchAllDocsQuery.h"
+#include "Sort.h"
+#include "SortField.h"
+#include "TopFieldDocs.h"
+#include "ScoreDoc.h"
+#include "FieldCache.h"
+#include "PackedInts.h"
+
+using namespace Lucene;
+
+/// Per-document values written at index time and read back without un-inverting the fields.
+class IndexDocValuesTest : public LuceneTestFixture {
+public:
+    IndexDocValuesTest() {
+        dir = newLucene<RAMDirectory>();
+    }
+
+    virtual ~IndexDocValuesTest() {
+        dir->close();
+    }
+
+protected:
+    DirectoryPtr dir;
+
+public:
+    /// The numeric value of document i, 0 if it has none.
+    static int64_t numericValue(int32_t i) {
+        return i % 7 == 0 ? 0 : (int64_t)i * 3 - 50;
+    }
+
+    /// The sorted value of document i, empty if it has none.
+    static String sortedValue(int32_t i) {
+        return i % 7 == 0 ? L"" : L"cat" + StringUtils::toString(i % 5);
+    }
+
+    void addDocs(const IndexWriterPtr& writer, int32_t numDocs) {
+        for (int32_t i = 0; i < numDocs; ++i) {
+            DocumentPtr doc = newLucene<Document>();
+            doc->add(newLucene<Field>(L"id", StringUtils::toString(i), Field::STORE_YES, Field::INDEX_NOT_ANALYZED));
+            if (i % 7 != 0) {
+                FieldPtr number = newLucene<Field>(L"number", StringUtils::toString(numericValue(i)), Field::STORE_YES, Field::INDEX_NO);
+                number->setDocValuesType(AbstractField::DOC_VALUES_NUMERIC);
+                doc->add(number);
+                FieldPtr category = newLucene<Field>(L"category", sortedValue(i), Field::STORE_YES, Field::INDEX_NO);
+                category->setDocValuesType(AbstractField::DOC_VALUES_SORTED);
+                doc->add(category);
+            }
+            writer->addDocument(doc);
+        }
+    }
+
+    void checkValues(const IndexReaderPtr& reader) {
+        Collection<IndexReaderPtr> subReaders(reader->getSequentialSubReaders());
+        EXPECT_TRUE(subReaders);
+        for (Collection<IndexReaderPtr>::iterator subReader = subReaders.begin(); subReader != subReaders.end(); ++subReader) {
+            PackedIntsPtr numbers((*subReader)->getNumericDocValues(L"number"));
+            StringIndexPtr categories((*subReader)->getSortedDocValues(L"category"));
+            EXPECT_TRUE(numbers);
+            EXPECT_TRUE(categories);
+            EXPECT_TRUE(!(*subReader)->getNumericDocValues(L"category"));
+            EXPECT_TRUE(!(*subReader)->getSortedDocValues(L"id"));
+            EXPECT_EQ((*subReader)->maxDoc(), numbers->size());
+            EXPECT_EQ((*subReader)->maxDoc(), categories->size());
+            for (int32_t doc = 0; doc < (*subReader)->maxDoc(); ++doc) {
+                if ((*subReader)->isDeleted(doc)) {
+                    continue;
+                }
+                int32_t id = StringUtils::toInt((*subReader)->document(doc)->get(L"id"));
+                EXPECT_EQ(numericValue(id), numbers->get(doc));
+                EXPECT_EQ(sortedValue(id), categories->lookup(categories->getOrd(doc)));
+            }
+        }
+    }
+};
+
+TEST_F(IndexDocValuesTest, testFlushedSegments) {
+    IndexWriterPtr writer = newLucene<IndexWriter>(dir, newLucene<WhitespaceAnalyzer>(), true, IndexWriter::MaxFieldLengthUNLIMITED);
+    writer->setMaxBufferedDocs(10);
+    writer->setMergeFactor(100);
+    writer->setUseCompoundFile(false);
+    addDocs(writer, 45);
+    writer->close();
+
+    EXPECT_TRUE(dir->fileExists(L"_0.dv"));
+
+    IndexReaderPtr reader = IndexReader::open(dir, true);
+    EXPECT_EQ(5, reader->getSequentialSubReaders().size());
+
+    // composite readers don't hold values
+    EXPECT_TRUE(!reader->getNumericDocValues(L"number"));
+    checkValues(reader);
+
+    // the distinct values of a segment are sorted, with the empty value first
+    StringIndexPtr categories(reader->getSequentialSubReaders()[0]->getSortedDocValues(L"category"));
+    EXPECT_EQ(6, categories->numOrd());
+    EXPECT_EQ(L"", categories->lookup(0));
+    for (int32_t ord = 1; ord < categories->numOrd(); ++ord) {
+        EXPECT_EQ(L"cat" + StringUtils::toString(ord - 1), categories->lookup(ord));
+    }
+    reader->close();
+}
+
+TEST_F(IndexDocValuesTest, testMergedSegments) {
+    IndexWriterPtr writer = newLucene<IndexWriter>(dir, newLucene<WhitespaceAnalyzer>(), true, IndexWriter::MaxFieldLengthUNLIMITED);
+    writer->setMaxBufferedDocs(10);
+    addDocs(writer, 63);
+
+    // leave only documents without values or with the values of cat1 and cat3
+    for (int32_t i = 0; i < 63; ++i) {
+        if (i % 5 != 1 && i % 5 != 3 && i % 7 != 0) {
+            writer->deleteDocuments(newLucene<Term>(L"id", StringUtils::toString(i)));
+        }
+    }
+    writer->optimize();
+    writer->close();
+
+    IndexReaderPtr reader = IndexReader::open(dir, true);
+    EXPECT_EQ(1, reader->getSequentialSubReaders().size());
+    checkValues(reader);
+
+    // values only held by deleted documents are dropped
+    StringIndexPtr categories(reader->getSequentialSubReaders()[0]->getSortedDocValues(L"category"));
+    EXPECT_EQ(3, categories->numOrd());
+    EXPECT_EQ(L"cat1", categories->lookup(1));
+    EXPECT_EQ(L"cat3", categories->lookup(2));
+    reader->close();
+}
+
+TEST_F(IndexDocValuesTest, testAddIndexes) {
+    DirectoryPtr other = newLucene<RAMDirectory>();
+    IndexWriterPtr writer = newLucene<IndexWriter>(other, newLucene<WhitespaceAnalyzer>(), true, IndexWriter::MaxFieldLengthUNLIMITED);
+    addDocs(writer, 20);
+    writer->close();
+
+    // segments without values are merged with ones that have values
+    writer = newLucene<IndexWriter>(dir, newLucene<WhitespaceAnalyzer>(), true, IndexWriter::MaxFieldLengthUNLIMITED);
+    for (int32_t i = 0; i < 5; ++i) {
+        DocumentPtr doc = newLucene<Document>();
+        doc->add(newLucene<Field>(L"id", StringUtils::toString(i * 7), Field::STORE_YES, Field::INDEX_NOT_ANALYZED));
+        writer->addDocument(doc);
+    }
+    writer->addIndexesNoOptimize(newCollection<DirectoryPtr>(other));
+    writer->optimize();
+    writer->close();
+
+    IndexReaderPtr reader = IndexReader::open(dir, true);
+    EXPECT_EQ(25, reader->maxDoc());
+    checkValues(reader);
+    reader->close();
+    other->close();
+}
+
+TEST_F(IndexDocValuesTest, testFieldCache) {
+    IndexWriterPtr writer = newLucene<IndexWriter>(dir, newLucene<WhitespaceAnalyzer>(), true, IndexWriter::MaxFieldLengthUNLIMITED);
+    writer->setMaxBufferedDocs(10);
+    addDocs(writer, 30);
+    writer->close();
+
+    IndexReaderPtr reader = IndexReader::open(dir, true);
+    IndexReaderPtr segment = reader->getSequentialSubReaders()[1];
+
+    // the values are not indexed, so they can only come from the per-document values
+    EXPECT_EQ(segment->getNumericDocValues(L"number"), FieldCache::DEFAULT()->getPackedLongs(segment, L"number"));
+    EXPECT_EQ(segment->getSortedDocValues(L"category"), FieldCache::DEFAULT()->getStringIndex(segment, L"category"));
+    Collection<int64_t> longs = FieldCache::DEFAULT()->getLongs(segment, L"number");
+    Collection<String> strings = FieldCache::DEFAULT()->getStrings(segment, L"category");
+    for (int32_t doc = 0; doc < segment->maxDoc(); ++doc) {
+        EXPECT_EQ(numericValue(10 + doc), longs[doc]);
+        EXPECT_EQ(sortedValue(10 + doc), strings[doc]);
+    }
+
+    IndexSearcherPtr searcher = newLucene<IndexSearcher>(reader);
+    TopFieldDocsPtr hits = searcher->search(newLucene<MatchAllDocsQuery>(), FilterPtr(), 30, newLucene<Sort>(newLucene<SortField>(L"number", SortField::LONG)));
+    EXPECT_EQ(30, hits->totalHits);
+    int64_t last = std::numeric_limits<int64_t>::min();
+    for (int32_t i = 0; i < hits->scoreDocs.size(); ++i) {
+        int64_t value = numericValue(hits->scoreDocs[i]->doc);
+        EXPECT_TRUE(value >= last);
+        last = value;
+    }
+
+    hits = searcher->search(newLucene<MatchAllDocsQuery>(), FilterPtr(), 30, newLucene<Sort>(newLucene<SortField>(L"category", SortField::STRING)));
+    String lastCategory;
+    for (int32_t i = 0; i < hits->scoreDocs.size(); ++i) {
+        String category = sortedValue(hits->scoreDocs[i]->doc);
+        EXPECT_TRUE(category >= lastCategory);
+        lastCategory = category;
+    }
+    searcher->close();
+    reader->close();
+}
+
+TEST_F(IndexDocValuesTest, testTypeConflict) {
+    IndexWriterPtr writer = newLucene<IndexWriter>(dir, newLucene<WhitespaceAnalyzer>(), true, IndexWriter::MaxFieldLengthUNLIMITED);
+    addDocs(writer, 5);
+
+    DocumentPtr doc = newLucene<Document>();
+    FieldPtr number = newLucene<Field>(L"number", L"abc", Field::STORE_YES, Field::INDEX_NO);
+    number->setDocValuesType(AbstractField::DOC_VALUES_SORTED);
+    doc->add(number);
+    bool conflict = false;
+    try {
+        writer->addDocument(doc);
+    } catch (LuceneException& e) {
+        EXPECT_TRUE(check_exception(LuceneException::IllegalArgument)(e));
+        conflict = true;
+    }
+    EXPECT_TRUE(conflict);
+    writer->close();
+
+    IndexReaderPtr reader = IndexReader::open(dir, true);
+    checkValues(reader);
+    reader->close();
+}
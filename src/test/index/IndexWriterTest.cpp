@@ -26,6 +26,7 @@
 #include "StandardAnalyzer.h"
 #include "DocumentsWriter.h"
 #include "TermPositions.h"
+#include "TermDocs.h"
 #include "LogDocMergePolicy.h"
 #include "SegmentInfos.h"
 #include "SegmentInfo.h"
@@ -4633,3 +4634,282 @@ TEST_F(IndexWriterTest, testNoUnwantedTVFiles) {
 
     dir->close();
 }
+
+namespace TestMaxThreadStates {
+
+class IndexerThread : public LuceneThread {
+public:
+    IndexerThread(int32_t id, const IndexWriterPtr& writer) {
+        this->id = id;
+        this->writer = writer;
+    }
+
+    virtual ~IndexerThread() {
+    }
+
+    LUCENE_CLASS(IndexerThread);
+
+protected:
+    int32_t id;
+    IndexWriterPtr writer;
+
+public:
+    virtual void run() {
+        try {
+            for (int32_t i = 0; i < 100; ++i) {
+                DocumentPtr doc = newLucene<Document>();
+                doc->add(newLucene<Field>(L"id", StringUtils::toString(id) + L"_" + StringUtils::toString(i), Field::STORE_YES, Field::INDEX_NOT_ANALYZED));
+                doc->add(newLucene<Field>(L"content", L"aaa bbb ccc " + StringUtils::toString(i), Field::STORE_NO, Field::INDEX_ANALYZED));
+                writer->addDocument(doc);
+            }
+        } catch (...) {
+            FAIL() << "Unexpected exception";
+        }
+    }
+};
+
+}
+
+TEST_F(IndexWriterTest, testMaxThreadStates) {
+    static const int32_t NUM_THREADS = 12;
+    DirectoryPtr dir = newLucene<MockRAMDirectory>();
+    IndexWriterPtr writer = newLucene<IndexWriter>(dir, newLucene<WhitespaceAnalyzer>(), IndexWriter::MaxFieldLengthUNLIMITED);
+    EXPECT_EQ(IndexWriter::DEFAULT_MAX_THREAD_STATES, writer->getMaxThreadStates());
+    try {
+        writer->setMaxThreadStates(0);
+    } catch (IllegalArgumentException& e) {
+        EXPECT_TRUE(check_exception(LuceneException::IllegalArgument)(e));
+    }
+    writer->setMaxThreadStates(16);
+    EXPECT_EQ(16, writer->getMaxThreadStates());
+    writer->setMaxBufferedDocs(77);
+
+    Collection<LuceneThreadPtr> threads = Collection<LuceneThreadPtr>::newInstance(NUM_THREADS);
+    for (int32_t i = 0; i < NUM_THREADS; ++i) {
+        threads[i] = newLucene<TestMaxThreadStates::IndexerThread>(i, writer);
+        threads[i]->start();
+    }
+    for (int32_t i = 0; i < NUM_THREADS; ++i) {
+        threads[i]->join();
+    }
+    writer->close();
+
+    IndexReaderPtr reader = IndexReader::open(dir, true);
+    EXPECT_EQ(NUM_THREADS * 100, reader->numDocs());
+    for (int32_t i = 0; i < NUM_THREADS; ++i) {
+        EXPECT_EQ(1, reader->docFreq(newLucene<Term>(L"id", StringUtils::toString(i) + L"_99")));
+    }
+    EXPECT_EQ(NUM_THREADS * 100, reader->docFreq(newLucene<Term>(L"content", L"aaa")));
+    reader->close();
+
+    checkIndex(dir);
+    dir->close();
+}
+
+namespace TestConcurrentFlush {
+
+DECLARE_SHARED_PTR(BlockOnFlush)
+
+/// Holds up the first flush while it writes postings, until released (or 10 seconds have passed)
+class BlockOnFlush : public MockDirectoryFailure {
+public:
+    BlockOnFlush() {
+        blocked = false;
+        released = false;
+    }
+
+    virtual ~BlockOnFlush() {
+    }
+
+    LUCENE_CLASS(BlockOnFlush);
+
+protected:
+    bool blocked;
+    bool released;
+
+public:
+    virtual void eval(const MockRAMDirectoryPtr& dir) {
+        if (this->doFail && TestPoint::getTestPoint(L"FreqProxTermsWriter", L"appendPostings")) {
+            this->doFail = false;
+            setBlocked(true);
+            for (int32_t i = 0; i < 1000 && !isReleased(); ++i) {
+                LuceneThread::threadSleep(10);
+            }
+            setBlocked(false);
+        }
+    }
+
+    bool isBlocked() {
+        SyncLock syncLock(this);
+        return blocked;
+    }
+
+    void setBlocked(bool blocked) {
+        SyncLock syncLock(this);
+        this->blocked = blocked;
+    }
+
+    bool isReleased() {
+        SyncLock syncLock(this);
+        return released;
+    }
+
+    void release() {
+        SyncLock syncLock(this);
+        released = true;
+    }
+};
+
+class FlushingThread : public LuceneThread {
+public:
+    FlushingThread(const IndexWriterPtr& writer) {
+        this->writer = writer;
+    }
+
+    virtual ~FlushingThread() {
+    }
+
+    LUCENE_CLASS(FlushingThread);
+
+protected:
+    IndexWriterPtr writer;
+
+public:
+    virtual void run() {
+        try {
+            // The tenth doc triggers the flush
+            for (int32_t i = 0; i < 10; ++i) {
+                DocumentPtr doc = newLucene<Document>();
+                doc->add(newLucene<Field>(L"content", L"aaa " + StringUtils::toString(i), Field::STORE_NO, Field::INDEX_ANALYZED));
+                writer->addDocument(doc);
+            }
+        } catch (...) {
+            FAIL() << "Unexpected exception";
+        }
+    }
+};
+
+class UpdatingThread : public LuceneThread {
+public:
+    UpdatingThread(int32_t id, const IndexWriterPtr& writer) {
+        this->id = id;
+        this->writer = writer;
+    }
+
+    virtual ~UpdatingThread() {
+    }
+
+    LUCENE_CLASS(UpdatingThread);
+
+protected:
+    int32_t id;
+    IndexWriterPtr writer;
+
+public:
+    virtual void run() {
+        try {
+            // Every doc is added and then updated twice, with deletes interleaved across flushes
+            for (int32_t pass = 0; pass < 3; ++pass) {
+                for (int32_t i = 0; i < 50; ++i) {
+                    DocumentPtr doc = newLucene<Document>();
+                    String docId(StringUtils::toString(id) + L"_" + StringUtils::toString(i));
+                    doc->add(newLucene<Field>(L"id", docId, Field::STORE_YES, Field::INDEX_NOT_ANALYZED));
+                    doc->add(newLucene<Field>(L"pass", StringUtils::toString(pass), Field::STORE_YES, Field::INDEX_NOT_ANALYZED));
+                    doc->add(newLucene<Field>(L"content", L"aaa bbb " + docId, Field::STORE_NO, Field::INDEX_ANALYZED, Field::TERM_VECTOR_YES));
+                    writer->updateDocument(newLucene<Term>(L"id", docId), doc);
+                }
+            }
+        } catch (...) {
+            FAIL() << "Unexpected exception";
+        }
+    }
+};
+
+}
+
+/// Another thread can keep adding documents while a flush is being written
+TEST_F(IndexWriterTest, testConcurrentFlush) {
+    MockRAMDirectoryPtr dir = newLucene<MockRAMDirectory>();
+    TestConcurrentFlush::BlockOnFlushPtr failure = newLucene<TestConcurrentFlush::BlockOnFlush>();
+    dir->failOn(failure);
+
+    IndexWriterPtr writer = newLucene<IndexWriter>(dir, newLucene<WhitespaceAnalyzer>(), true, IndexWriter::MaxFieldLengthUNLIMITED);
+    EXPECT_EQ(IndexWriter::DEFAULT_MAX_PENDING_FLUSHES, writer->getMaxPendingFlushes());
+    try {
+        writer->setMaxPendingFlushes(-1);
+    } catch (IllegalArgumentException& e) {
+        EXPECT_TRUE(check_exception(LuceneException::IllegalArgument)(e));
+    }
+    writer->setMaxBufferedDocs(10);
+    failure->setDoFail();
+
+    LuceneThreadPtr flusher = newLucene<TestConcurrentFlush::FlushingThread>(writer);
+    flusher->start();
+    for (int32_t i = 0; i < 1000 && !failure->isBlocked(); ++i) {
+        LuceneThread::threadSleep(10);
+    }
+    EXPECT_TRUE(failure->isBlocked());
+
+    // Unstored docs don't touch the directory, so these only wait if the flush holds up indexing
+    for (int32_t i = 0; i < 5; ++i) {
+        DocumentPtr doc = newLucene<Document>();
+        doc->add(newLucene<Field>(L"content", L"bbb " + StringUtils::toString(i), Field::STORE_NO, Field::INDEX_ANALYZED));
+        writer->addDocument(doc);
+    }
+    EXPECT_TRUE(failure->isBlocked());
+    EXPECT_EQ(15, writer->numRamDocs());
+
+    failure->release();
+    flusher->join();
+
+    EXPECT_EQ(1, writer->getSegmentCount());
+    EXPECT_EQ(5, writer->numRamDocs());
+    EXPECT_EQ(15, writer->maxDoc());
+    writer->close();
+
+    IndexReaderPtr reader = IndexReader::open(dir, true);
+    EXPECT_EQ(15, reader->numDocs());
+    EXPECT_EQ(10, reader->docFreq(newLucene<Term>(L"content", L"aaa")));
+    EXPECT_EQ(5, reader->docFreq(newLucene<Term>(L"content", L"bbb")));
+    reader->close();
+    dir->close();
+}
+
+TEST_F(IndexWriterTest, testConcurrentFlushUpdates) {
+    static const int32_t NUM_THREADS = 4;
+    MockRAMDirectoryPtr dir = newLucene<MockRAMDirectory>();
+    IndexWriterPtr writer = newLucene<IndexWriter>(dir, newLucene<WhitespaceAnalyzer>(), true, IndexWriter::MaxFieldLengthUNLIMITED);
+    writer->setMaxBufferedDocs(7);
+    writer->setMaxPendingFlushes(2);
+    writer->setMergeFactor(3);
+
+    Collection<LuceneThreadPtr> threads = Collection<LuceneThreadPtr>::newInstance(NUM_THREADS);
+    for (int32_t i = 0; i < NUM_THREADS; ++i) {
+        threads[i] = newLucene<TestConcurrentFlush::UpdatingThread>(i, writer);
+        threads[i]->start();
+    }
+    for (int32_t i = 0; i < NUM_THREADS; ++i) {
+        threads[i]->join();
+    }
+    writer->close();
+
+    IndexReaderPtr reader = IndexReader::open(dir, true);
+    EXPECT_EQ(NUM_THREADS * 50, reader->numDocs());
+    for (int32_t i = 0; i < NUM_THREADS; ++i) {
+        for (int32_t j = 0; j < 50; ++j) {
+            String docId(StringUtils::toString(i) + L"_" + StringUtils::toString(j));
+            TermDocsPtr termDocs = reader->termDocs(newLucene<Term>(L"id", docId));
+            EXPECT_TRUE(termDocs->next());
+            EXPECT_EQ(L"2", reader->document(termDocs->doc())->get(L"pass"));
+            EXPECT_FALSE(termDocs->next());
+            termDocs->close();
+        }
+    }
+    TermDocsPtr termDocs = reader->termDocs(newLucene<Term>(L"pass", L"0"));
+    EXPECT_FALSE(termDocs->next());
+    termDocs->close();
+    reader->close();
+
+    checkIndex(dir);
+    dir->close();
+}
@@ -19,6 +19,9 @@
 #include "TermPositions.h"
 #include "DefaultSimilarity.h"
 #include "TermFreqVector.h"
+#include "IndexReader.h"
+#include "IndexWriter.h"
+#include "WhitespaceAnalyzer.h"
 
 using namespace Lucene;
 
@@ -175,3 +178,54 @@ TEST_F(SegmentReaderTest, testTermVectors) {
     EXPECT_TRUE(results);
     EXPECT_EQ(results.size(), 3);
 }
+
+static void checkTermsIndex(const DirectoryPtr& dir, int32_t termInfosIndexDivisor) {
+    IndexReaderPtr reader = IndexReader::open(dir, IndexDeletionPolicyPtr(), true, termInfosIndexDivisor);
+    SegmentReaderPtr segmentReader = SegmentReader::getOnlySegmentReader(reader);
+    EXPECT_TRUE(segmentReader->getTermInfosIndexBytesUsed() > 0);
+
+    Collection<TermPtr> terms = Collection<TermPtr>::newInstance();
+    Collection<int32_t> docFreqs = Collection<int32_t>::newInstance();
+    TermEnumPtr termEnum = reader->terms();
+    while (termEnum->next()) {
+        terms.add(termEnum->term());
+        docFreqs.add(termEnum->docFreq());
+    }
+    termEnum->close();
+    EXPECT_TRUE(terms.size() > 1000);
+
+    // look up in reverse order to defeat the sequential scan optimization
+    for (int32_t i = terms.size() - 1; i >= 0; --i) {
+        EXPECT_EQ(docFreqs[i], reader->docFreq(terms[i]));
+        EXPECT_EQ(0, reader->docFreq(newLucene<Term>(terms[i]->field(), terms[i]->text() + L"\x01")));
+        termEnum = reader->terms(newLucene<Term>(terms[i]->field(), terms[i]->text()));
+        EXPECT_TRUE(termEnum->term()->equals(terms[i]));
+        termEnum->close();
+    }
+    EXPECT_EQ(0, reader->docFreq(newLucene<Term>(L"", L"")));
+    EXPECT_EQ(0, reader->docFreq(newLucene<Term>(L"zzz", L"")));
+    reader->close();
+}
+
+TEST_F(SegmentReaderTest, testTermsIndex) {
+    static const wchar_t* suffixes[] = {L"", L"\x00e9", L"\x4e2d", L"\U0001D11E", L"\xffe0"};
+    DirectoryPtr indexDir = newLucene<RAMDirectory>();
+    IndexWriterPtr writer = newLucene<IndexWriter>(indexDir, newLucene<WhitespaceAnalyzer>(), true, IndexWriter::MaxFieldLengthLIMITED);
+    for (int32_t i = 0; i < 500; ++i) {
+        DocumentPtr doc = newLucene<Document>();
+        String text = StringUtils::toString(i * 7919 % 1000) + suffixes[i % 5];
+        doc->add(newLucene<Field>(L"aaa", text, Field::STORE_NO, Field::INDEX_NOT_ANALYZED));
+        doc->add(newLucene<Field>(L"bbb", suffixes[i % 5] + StringUtils::toString(i), Field::STORE_NO, Field::INDEX_NOT_ANALYZED));
+        doc->add(newLucene<Field>(L"ccc", L"term" + StringUtils::toString(i % 300), Field::STORE_NO, Field::INDEX_NOT_ANALYZED));
+        writer->addDocument(doc);
+    }
+    writer->optimize();
+    writer->close();
+
+    checkTermsIndex(indexDir, 1);
+    checkTermsIndex(indexDir, 3);
+
+    IndexReaderPtr reader = IndexReader::open(indexDir, IndexDeletionPolicyPtr(), true, -1);
+    EXPECT_EQ(0, SegmentReader::getOnlySegmentReader(reader)->getTermInfosIndexBytesUsed());
+    reader->close();
+}
@@ -19,6 +19,8 @@
 #include "IndexReader.h"
 #include "TermDocs.h"
 #include "Field.h"
+#include "FSDirectory.h"
+#include "FileUtils.h"
 
 using namespace Lucene;
 
@@ -208,6 +210,68 @@ public:
         dir->close();
     }
 
+    void checkBulkRead(const DirectoryPtr& dir) {
+        IndexWriterPtr writer = newLucene<IndexWriter>(dir, newLucene<WhitespaceAnalyzer>(), true, IndexWriter::MaxFieldLengthLIMITED);
+        for (int32_t i = 0; i < 3000; ++i) {
+            DocumentPtr doc = newLucene<Document>();
+            String content = L"aaa";
+            for (int32_t j = 0; j < i % 3; ++j) {
+                content += L" aaa";
+            }
+            if (i % 150 == 0) {
+                content += L" bbb";
+            }
+            doc->add(newLucene<Field>(L"content", content, Field::STORE_NO, Field::INDEX_ANALYZED));
+            FieldPtr noTf = newLucene<Field>(L"notf", i % 2 == 0 ? L"ccc" : L"ddd", Field::STORE_NO, Field::INDEX_ANALYZED);
+            noTf->setOmitTermFreqAndPositions(true);
+            doc->add(noTf);
+            writer->addDocument(doc);
+        }
+        writer->optimize();
+        writer->close();
+
+        IndexReaderPtr reader = IndexReader::open(dir, false);
+        for (int32_t i = 0; i < 3000; i += 7) {
+            reader->deleteDocument(i);
+        }
+
+        Collection<TermPtr> terms = newCollection<TermPtr>(newLucene<Term>(L"content", L"aaa"), newLucene<Term>(L"content", L"bbb"), newLucene<Term>(L"notf", L"ccc"));
+        for (Collection<TermPtr>::iterator term = terms.begin(); term != terms.end(); ++term) {
+            Collection<int32_t> expectedDocs = Collection<int32_t>::newInstance();
+            Collection<int32_t> expectedFreqs = Collection<int32_t>::newInstance();
+            TermDocsPtr termDocs = reader->termDocs(*term);
+            while (termDocs->next()) {
+                expectedDocs.add(termDocs->doc());
+                expectedFreqs.add(termDocs->freq());
+            }
+            termDocs->close();
+            EXPECT_TRUE(!expectedDocs.empty());
+
+            Collection<int32_t> docs = Collection<int32_t>::newInstance(61);
+            Collection<int32_t> freqs = Collection<int32_t>::newInstance(61);
+            termDocs = reader->termDocs(*term);
+            int32_t upto = 0;
+            int32_t count;
+            while ((count = termDocs->read(docs, freqs)) > 0) {
+                for (int32_t i = 0; i < count; ++i, ++upto) {
+                    EXPECT_TRUE(upto < expectedDocs.size());
+                    EXPECT_EQ(expectedDocs[upto], docs[i]);
+                    EXPECT_EQ(expectedFreqs[upto], freqs[i]);
+                }
+            }
+            EXPECT_EQ(expectedDocs.size(), upto);
+            termDocs->close();
+
+            // mix bulk reads with skipping
+            termDocs = reader->termDocs(*term);
+            EXPECT_EQ(5, termDocs->read(Collection<int32_t>::newInstance(5), Collection<int32_t>::newInstance(5)));
+            EXPECT_TRUE(termDocs->skipTo(2000));
+            EXPECT_EQ(*std::lower_bound(expectedDocs.begin(), expectedDocs.end(), 2000), termDocs->doc());
+            termDocs->close();
+        }
+        reader->close();
+    }
+
     void addDoc(const IndexWriterPtr& writer, const String& value) {
         DocumentPtr doc = newLucene<Document>();
         doc->add(newLucene<Field>(L"content", value, Field::STORE_NO, Field::INDEX_ANALYZED));
@@ -236,3 +300,13 @@ TEST_F(SegmentTermDocsTest, testIndexDivisor) {
     checkBadSeek(2);
     checkSkipTo(2);
 }
+
+TEST_F(SegmentTermDocsTest, testBulkReadMatchesNext) {
+    checkBulkRead(newLucene<RAMDirectory>());
+
+    String indexDir(FileUtils::joinPath(getTempDir(), L"testBulkRead"));
+    DirectoryPtr fsDir = FSDirectory::open(indexDir);
+    checkBulkRead(fsDir);
+    fsDir->close();
+    FileUtils::removeDirectory(indexDir);
+}
@@ -0,0 +1,211 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "TestInc.h"
+#include "LuceneTestFixture.h"
+#include "TieredMergePolicy.h"
+#include "LogDocMergePolicy.h"
+#include "IndexWriter.h"
+#include "IndexReader.h"
+#include "RAMDirectory.h"
+#include "WhitespaceAnalyzer.h"
+#include "Document.h"
+#include "Field.h"
+#include "Term.h"
+#include "TermDocs.h"
+#include "SegmentInfos.h"
+#include "SegmentInfo.h"
+#include "Random.h"
+
+using namespace Lucene;
+
+typedef LuceneTestFixture TieredMergePolicyTest;
+
+static void addDoc(const IndexWriterPtr& writer, int32_t id) {
+    DocumentPtr doc = newLucene<Document>();
+    doc->add(newLucene<Field>(L"id", StringUtils::toString(id), Field::STORE_YES, Field::INDEX_NOT_ANALYZED));
+    doc->add(newLucene<Field>(L"content", L"aaa " + StringUtils::toString(id % 4), Field::STORE_NO, Field::INDEX_ANALYZED));
+    writer->addDocument(doc);
+}
+
+/// Writes one segment per entry of docCounts, without merging any of them.
+static void addSegments(const DirectoryPtr& dir, Collection<int32_t> docCounts) {
+    IndexWriterPtr writer = newLucene<IndexWriter>(dir, newLucene<WhitespaceAnalyzer>(), true, IndexWriter::MaxFieldLengthLIMITED);
+    writer->setMaxBufferedDocs(1000);
+    LogDocMergePolicyPtr mp = newLucene<LogDocMergePolicy>(writer);
+    mp->setMergeFactor(1000);
+    writer->setMergePolicy(mp);
+    int32_t id = 0;
+    for (Collection<int32_t>::iterator docCount = docCounts.begin(); docCount != docCounts.end(); ++docCount) {
+        for (int32_t i = 0; i < *docCount; ++i) {
+            addDoc(writer, id++);
+        }
+        writer->commit();
+    }
+    EXPECT_EQ(docCounts.size(), writer->getSegmentCount());
+    writer->close();
+}
+
+TEST_F(TieredMergePolicyTest, testMergeNonAdjacentSegments) {
+    DirectoryPtr dir = newLucene<RAMDirectory>();
+    addSegments(dir, newCollection<int32_t>(200, 5, 200, 5));
+
+    IndexWriterPtr writer = newLucene<IndexWriter>(dir, newLucene<WhitespaceAnalyzer>(), false, IndexWriter::MaxFieldLengthLIMITED);
+    SegmentInfosPtr infos = newLucene<SegmentInfos>();
+    infos->read(dir);
+
+    TieredMergePolicyPtr tmp = newLucene<TieredMergePolicy>(writer);
+    tmp->setMaxMergeAtOnce(2);
+    tmp->setSegmentsPerTier(2);
+
+    // all segments are below the floor size, so the two small segments make the cheapest merge even
+    // though they are not adjacent
+    MergeSpecificationPtr spec = tmp->findMerges(infos);
+    EXPECT_TRUE(spec);
+    SegmentInfosPtr merged = spec->merges[0]->segments;
+    EXPECT_EQ(2, merged->size());
+    EXPECT_TRUE(merged->info(0)->equals(infos->info(1)));
+    EXPECT_TRUE(merged->info(1)->equals(infos->info(3)));
+
+    // segments at least half the maximum merged size are never picked
+    tmp->setMaxMergedSegmentMB(0.0001);
+    EXPECT_TRUE(!tmp->findMerges(infos));
+
+    writer->close();
+}
+
+TEST_F(TieredMergePolicyTest, testFavorDeletes) {
+    DirectoryPtr dir = newLucene<RAMDirectory>();
+    addSegments(dir, newCollection<int32_t>(100, 100, 100));
+
+    // delete most of the last segment
+    IndexWriterPtr writer = newLucene<IndexWriter>(dir, newLucene<WhitespaceAnalyzer>(), false, IndexWriter::MaxFieldLengthLIMITED);
+    for (int32_t id = 200; id < 290; ++id) {
+        writer->deleteDocuments(newLucene<Term>(L"id", StringUtils::toString(id)));
+    }
+    writer->commit();
+
+    SegmentInfosPtr infos = newLucene<SegmentInfos>();
+    infos->read(dir);
+
+    TieredMergePolicyPtr tmp = newLucene<TieredMergePolicy>(writer);
+    tmp->setMaxMergeAtOnce(2);
+    tmp->setSegmentsPerTier(2);
+
+    MergeSpecificationPtr spec = tmp->findMerges(infos);
+    EXPECT_TRUE(spec);
+    SegmentInfosPtr merged = spec->merges[0]->segments;
+    EXPECT_TRUE(merged->contains(infos->info(2)));
+
+    writer->close();
+}
+
+TEST_F(TieredMergePolicyTest, testExpungeDeletes) {
+    DirectoryPtr dir = newLucene<RAMDirectory>();
+    IndexWriterPtr writer = newLucene<IndexWriter>(dir, newLucene<WhitespaceAnalyzer>(), true, IndexWriter::MaxFieldLengthLIMITED);
+    TieredMergePolicyPtr tmp = newLucene<TieredMergePolicy>(writer);
+    writer->setMergePolicy(tmp);
+    writer->setMaxBufferedDocs(4);
+    tmp->setMaxMergeAtOnce(100);
+    tmp->setSegmentsPerTier(100);
+    tmp->setExpungeDeletesPctAllowed(30.0);
+
+    for (int32_t i = 0; i < 80; ++i) {
+        addDoc(writer, i);
+    }
+    EXPECT_EQ(80, writer->maxDoc());
+    EXPECT_EQ(80, writer->numDocs());
+
+    // each segment has 25% deletes, which is under the allowed percentage
+    writer->deleteDocuments(newLucene<Term>(L"content", L"0"));
+    writer->commit();
+    writer->expungeDeletes();
+    EXPECT_EQ(80, writer->maxDoc());
+    EXPECT_EQ(60, writer->numDocs());
+
+    tmp->setExpungeDeletesPctAllowed(10.0);
+    writer->expungeDeletes();
+    EXPECT_EQ(60, writer->maxDoc());
+    EXPECT_EQ(60, writer->numDocs());
+
+    writer->close();
+}
+
+TEST_F(TieredMergePolicyTest, testPartialOptimize) {
+    RandomPtr random = newLucene<Random>(123);
+    for (int32_t iter = 0; iter < 10; ++iter) {
+        DirectoryPtr dir = newLucene<RAMDirectory>();
+        IndexWriterPtr writer = newLucene<IndexWriter>(dir, newLucene<WhitespaceAnalyzer>(), true, IndexWriter::MaxFieldLengthLIMITED);
+        TieredMergePolicyPtr tmp = newLucene<TieredMergePolicy>(writer);
+        writer->setMergePolicy(tmp);
+        writer->setMaxBufferedDocs(2);
+        tmp->setMaxMergeAtOnce(3);
+        tmp->setSegmentsPerTier(6);
+        tmp->setMaxMergeAtOnceExplicit(4);
+
+        int32_t numDocs = 20 + random->nextInt(100);
+        for (int32_t i = 0; i < numDocs; ++i) {
+            addDoc(writer, i);
+        }
+        writer->commit();
+        writer->waitForMerges();
+
+        int32_t segmentCount = writer->getSegmentCount();
+        int32_t targetCount = 1 + random->nextInt(segmentCount);
+        writer->optimize(targetCount);
+        EXPECT_EQ(targetCount, writer->getSegmentCount());
+        EXPECT_EQ(numDocs, writer->maxDoc());
+
+        writer->close();
+    }
+}
+
+/// Deletes buffered while non-adjacent segments are merged must still hit the right documents
+TEST_F(TieredMergePolicyTest, testUpdatesDuringMerges) {
+    DirectoryPtr dir = newLucene<RAMDirectory>();
+    IndexWriterPtr writer = newLucene<IndexWriter>(dir, newLucene<WhitespaceAnalyzer>(), true, IndexWriter::MaxFieldLengthLIMITED);
+    TieredMergePolicyPtr tmp = newLucene<TieredMergePolicy>(writer);
+    writer->setMergePolicy(tmp);
+    writer->setMaxBufferedDocs(7);
+    writer->setMaxBufferedDeleteTerms(50);
+    tmp->setMaxMergeAtOnce(3);
+    tmp->setSegmentsPerTier(3);
+
+    RandomPtr random = newLucene<Random>(17);
+    int32_t numIds = 100;
+    Collection<int32_t> versions(Collection<int32_t>::newInstance(numIds));
+    for (int32_t i = 0; i < 2000; ++i) {
+        int32_t id = random->nextInt(numIds);
+        ++versions[id];
+        DocumentPtr doc = newLucene<Document>();
+        doc->add(newLucene<Field>(L"id", StringUtils::toString(id), Field::STORE_YES, Field::INDEX_NOT_ANALYZED));
+        doc->add(newLucene<Field>(L"version", StringUtils::toString(versions[id]), Field::STORE_YES, Field::INDEX_NOT_ANALYZED));
+        writer->updateDocument(newLucene<Term>(L"id", StringUtils::toString(id)), doc);
+    }
+    writer->commit();
+
+    int32_t numUpdated = 0;
+    for (int32_t id = 0; id < numIds; ++id) {
+        numUpdated += versions[id] > 0 ? 1 : 0;
+    }
+    EXPECT_EQ(numUpdated, writer->numDocs());
+    writer->close();
+
+    IndexReaderPtr reader = IndexReader::open(dir, true);
+    EXPECT_EQ(numUpdated, reader->numDocs());
+    for (int32_t id = 0; id < numIds; ++id) {
+        TermDocsPtr termDocs = reader->termDocs(newLucene<Term>(L"id", StringUtils::toString(id)));
+        if (versions[id] == 0) {
+            EXPECT_TRUE(!termDocs->next());
+        } else {
+            EXPECT_TRUE(termDocs->next());
+            EXPECT_EQ(StringUtils::toString(versions[id]), reader->document(termDocs->doc())->get(L"version"));
+            EXPECT_TRUE(!termDocs->next());
+        }
+        termDocs->close();
+    }
+    reader->close();
+}
@@ -0,0 +1,93 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "TestInc.h"
+#include "LuceneTestFixture.h"
+#include "RAMDirectory.h"
+#include "IndexWriter.h"
+#include "WhitespaceAnalyzer.h"
+#include "Document.h"
+#include "Field.h"
+#include "BooleanQuery.h"
+#include "TermQuery.h"
+#include "Term.h"
+#include "IndexSearcher.h"
+#include "TopDocs.h"
+#include "Random.h"
+#include "MiscUtils.h"
+
+using namespace Lucene;
+
+/// Times pure disjunctions (scored by BooleanScorer) of 2, 8 and 32 term clauses.
+class BooleanScorerPerfTest : public LuceneTestFixture {
+public:
+    BooleanScorerPerfTest() {
+        RandomPtr random = newLucene<Random>(42);
+        directory = newLucene<RAMDirectory>();
+        IndexWriterPtr writer = newLucene<IndexWriter>(directory, newLucene<WhitespaceAnalyzer>(), true, IndexWriter::MaxFieldLengthLIMITED);
+        writer->setMaxBufferedDocs(1000);
+        for (int32_t i = 0; i < numDocs; ++i) {
+            // term tN occurs in roughly 1 in (N + 2) documents
+            StringStream contents;
+            for (int32_t term = 0; term < numTerms; ++term) {
+                if (random->nextInt(term + 2) == 0) {
+                    contents << L"t" << term << L" ";
+                }
+            }
+            DocumentPtr doc = newLucene<Document>();
+            doc->add(newLucene<Field>(L"contents", contents.str(), Field::STORE_NO, Field::INDEX_ANALYZED));
+            writer->addDocument(doc);
+        }
+        writer->optimize();
+        writer->close();
+        searcher = newLucene<IndexSearcher>(directory, true);
+    }
+
+    virtual ~BooleanScorerPerfTest() {
+        searcher->close();
+    }
+
+protected:
+    static const int32_t numDocs;
+    static const int32_t numTerms;
+
+    DirectoryPtr directory;
+    IndexSearcherPtr searcher;
+
+public:
+    void doDisjunctions(int32_t numClauses, int32_t iter) {
+        BooleanQueryPtr query = newLucene<BooleanQuery>();
+        for (int32_t i = 0; i < numClauses; ++i) {
+            query->add(newLucene<TermQuery>(newLucene<Term>(L"contents", L"t" + StringUtils::toString(i % numTerms))), BooleanClause::SHOULD);
+        }
+
+        int32_t totalHits = searcher->search(query, 10)->totalHits;
+        EXPECT_TRUE(totalHits > 0);
+
+        int64_t start = MiscUtils::currentTimeMillis();
+        for (int32_t i = 0; i < iter; ++i) {
+            EXPECT_EQ(totalHits, searcher->search(query, 10)->totalHits);
+        }
+        int64_t end = MiscUtils::currentTimeMillis();
+
+        // std::wcout << L"Milliseconds for " << iter << L" " << numClauses << L"-clause disjunctions: " << (end - start) << L"\n";
+    }
+};
+
+const int32_t BooleanScorerPerfTest::numDocs = 20000;
+const int32_t BooleanScorerPerfTest::numTerms = 32;
+
+TEST_F(BooleanScorerPerfTest, testDisjunction2Perf) {
+    doDisjunctions(2, 200);
+}
+
+TEST_F(BooleanScorerPerfTest, testDisjunction8Perf) {
+    doDisjunctions(8, 100);
+}
+
+TEST_F(BooleanScorerPerfTest, testDisjunction32Perf) {
+    doDisjunctions(32, 50);
+}
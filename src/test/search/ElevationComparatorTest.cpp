@@ -74,7 +74,7 @@ public:
 
 protected:
     int32_t docVal(int32_t doc) {
-        String id = idIndex->lookup[idIndex->order[doc]];
+        String id = idIndex->lookup(idIndex->getOrd(doc));
         return priority.contains(id) ? priority.get(id) : 0;
     }
 };
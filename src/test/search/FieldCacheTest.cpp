@@ -14,6 +14,7 @@
 #include "Field.h"
 #include "IndexReader.h"
 #include "FieldCache.h"
+#include "PackedInts.h"
 
 using namespace Lucene;
 
@@ -32,6 +33,10 @@ public:
             doc->add(newLucene<Field>(L"theDouble", StringUtils::toString(theDouble--), Field::STORE_NO, Field::INDEX_NOT_ANALYZED));
             doc->add(newLucene<Field>(L"theByte", StringUtils::toString(theByte--), Field::STORE_NO, Field::INDEX_NOT_ANALYZED));
             doc->add(newLucene<Field>(L"theInt", StringUtils::toString(theInt--), Field::STORE_NO, Field::INDEX_NOT_ANALYZED));
+            doc->add(newLucene<Field>(L"theString", L"s" + StringUtils::toString(i % 97), Field::STORE_NO, Field::INDEX_NOT_ANALYZED));
+            if (i % 3 == 0) {
+                doc->add(newLucene<Field>(L"theSparseInt", StringUtils::toString(1000 + i), Field::STORE_NO, Field::INDEX_NOT_ANALYZED));
+            }
             writer->addDocument(doc);
         }
         writer->close();
@@ -90,3 +95,86 @@ TEST_F(FieldCacheTest, testFieldCache) {
         EXPECT_EQ(ints[i], (INT_MAX - i));
     }
 }
+
+TEST_F(FieldCacheTest, testPackedValues) {
+    FieldCachePtr cache = FieldCache::DEFAULT();
+    PackedIntsPtr packedInts = cache->getPackedInts(reader, L"theInt");
+    EXPECT_EQ(packedInts, cache->getPackedInts(reader, L"theInt"));
+    EXPECT_EQ(packedInts, cache->getPackedInts(reader, L"theInt", FieldCache::DEFAULT_INT_PARSER()));
+    EXPECT_EQ(NUM_DOCS, packedInts->size());
+    EXPECT_EQ(PackedInts::bitsRequired(NUM_DOCS - 1), packedInts->getBitsPerValue());
+    Collection<int32_t> ints = cache->getInts(reader, L"theInt");
+    for (int32_t i = 0; i < NUM_DOCS; ++i) {
+        EXPECT_EQ(ints[i], packedInts->get(i));
+    }
+
+    PackedIntsPtr packedLongs = cache->getPackedLongs(reader, L"theLong");
+    EXPECT_EQ(packedLongs, cache->getPackedLongs(reader, L"theLong", FieldCache::DEFAULT_LONG_PARSER()));
+    Collection<int64_t> longs = cache->getLongs(reader, L"theLong");
+    for (int32_t i = 0; i < NUM_DOCS; ++i) {
+        EXPECT_EQ(longs[i], packedLongs->get(i));
+    }
+    EXPECT_TRUE(packedLongs->ramBytesUsed() < (int64_t)(longs.size() * sizeof(int64_t)));
+
+    // documents without a value get 0
+    PackedIntsPtr sparse = cache->getPackedInts(reader, L"theSparseInt");
+    for (int32_t i = 0; i < NUM_DOCS; ++i) {
+        EXPECT_EQ(i % 3 == 0 ? 1000 + i : 0, sparse->get(i));
+    }
+
+    cache->purgeAllCaches();
+}
+
+TEST_F(FieldCacheTest, testStringIndex) {
+    FieldCachePtr cache = FieldCache::DEFAULT();
+    StringIndexPtr index = cache->getStringIndex(reader, L"theString");
+    Collection<String> strings = cache->getStrings(reader, L"theString");
+    EXPECT_EQ(NUM_DOCS, index->size());
+    EXPECT_EQ(98, index->numOrd());
+    EXPECT_EQ(L"", index->lookup(0));
+    for (int32_t ord = 2; ord < index->numOrd(); ++ord) {
+        EXPECT_TRUE(index->lookup(ord - 1) < index->lookup(ord));
+    }
+    for (int32_t i = 0; i < NUM_DOCS; ++i) {
+        EXPECT_EQ(strings[i], index->lookup(index->getOrd(i)));
+        EXPECT_EQ(index->getOrd(i), index->binarySearchLookup(strings[i]));
+    }
+    EXPECT_EQ(0, index->binarySearchLookup(L""));
+    EXPECT_EQ(-2, index->binarySearchLookup(L"a"));
+    EXPECT_EQ(-99, index->binarySearchLookup(L"z"));
+    EXPECT_TRUE(index->ramBytesUsed() > 0);
+    cache->purgeAllCaches();
+}
+
+TEST_F(FieldCacheTest, testRamBudget) {
+    FieldCachePtr cache = FieldCache::DEFAULT();
+    cache->purgeAllCaches();
+    EXPECT_EQ(0, cache->ramBytesUsed());
+
+    Collection<int32_t> ints = cache->getInts(reader, L"theInt");
+    int64_t intBytes = cache->ramBytesUsed();
+    EXPECT_EQ((int64_t)(NUM_DOCS * sizeof(int32_t)), intBytes);
+
+    int32_t intEntries = cache->getCacheEntries().size();
+    EXPECT_TRUE(intEntries > 0);
+
+    cache->setMaxRamBytes(intBytes + NUM_DOCS * sizeof(int64_t) / 2);
+    EXPECT_EQ(intEntries, cache->getCacheEntries().size());
+
+    // loading the longs exceeds the budget, so the least recently used ints are dropped
+    Collection<int64_t> longs = cache->getLongs(reader, L"theLong");
+    Collection<FieldCacheEntryPtr> entries = cache->getCacheEntries();
+    EXPECT_TRUE(entries.size() > 0);
+    for (Collection<FieldCacheEntryPtr>::iterator entry = entries.begin(); entry != entries.end(); ++entry) {
+        EXPECT_EQ(L"theLong", (*entry)->getFieldName());
+    }
+    EXPECT_EQ((int64_t)(NUM_DOCS * sizeof(int64_t)), cache->ramBytesUsed());
+
+    // dropped values are loaded again on demand, dropping the longs in turn
+    EXPECT_NE(ints.hashCode(), cache->getInts(reader, L"theInt").hashCode());
+    EXPECT_EQ(intBytes, cache->ramBytesUsed());
+
+    cache->setMaxRamBytes(0);
+    EXPECT_EQ(0, cache->getMaxRamBytes());
+    cache->purgeAllCaches();
+}
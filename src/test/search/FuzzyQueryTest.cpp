@@ -5,6 +5,7 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include "TestInc.h"
+#include <boost/algorithm/string.hpp>
 #include "LuceneTestFixture.h"
 #include "MockRAMDirectory.h"
 #include "IndexWriter.h"
@@ -20,6 +21,10 @@
 #include "StandardAnalyzer.h"
 #include "QueryParser.h"
 #include "IndexReader.h"
+#include "FuzzyTermEnum.h"
+#include "Automaton.h"
+#include "TermEnum.h"
+#include "Random.h"
 
 using namespace Lucene;
 
@@ -332,3 +337,140 @@ TEST_F(FuzzyQueryTest, testGiga) {
     EXPECT_EQ(L"Giga byte", searcher->doc(hits[0]->doc)->get(L"field"));
     r->close();
 }
+
+/// Reference edit distance, counting swaps of adjacent characters as one edit if transpositions is set.
+static int32_t editDistance(const String& s, const String& t, bool transpositions) {
+    int32_t n = (int32_t)s.length();
+    int32_t m = (int32_t)t.length();
+    Collection< Collection<int32_t> > d = Collection< Collection<int32_t> >::newInstance(n + 1);
+    for (int32_t i = 0; i <= n; ++i) {
+        d[i] = Collection<int32_t>::newInstance(m + 1);
+        for (int32_t j = 0; j <= m; ++j) {
+            if (i == 0 || j == 0) {
+                d[i][j] = i + j;
+                continue;
+            }
+            d[i][j] = std::min(std::min(d[i - 1][j], d[i][j - 1]) + 1, d[i - 1][j - 1] + (s[i - 1] == t[j - 1] ? 0 : 1));
+            if (transpositions && i > 1 && j > 1 && s[i - 1] == t[j - 2] && s[i - 2] == t[j - 1]) {
+                d[i][j] = std::min(d[i][j], d[i - 2][j - 2] + 1);
+            }
+        }
+    }
+    return d[n][m];
+}
+
+TEST_F(FuzzyQueryTest, testLevenshteinAutomaton) {
+    static const wchar_t* strings[] = {L"", L"a", L"ab", L"ba", L"abc", L"acb", L"bac", L"abcd", L"abdc", L"badc", L"xabc", L"abcxx", L"aabbcc", L"cba"};
+    int32_t numStrings = (int32_t)(sizeof(strings) / sizeof(strings[0]));
+    for (int32_t maxEdits = 0; maxEdits <= FuzzyTermEnum::MAX_AUTOMATON_EDITS; ++maxEdits) {
+        for (int32_t transpositions = 0; transpositions < 2; ++transpositions) {
+            for (int32_t i = 0; i < numStrings; ++i) {
+                AutomatonPtr automaton = FuzzyTermEnum::toAutomaton(L"p", strings[i], maxEdits, transpositions != 0);
+                for (int32_t j = 0; j < numStrings; ++j) {
+                    bool expected = editDistance(strings[i], strings[j], transpositions != 0) <= maxEdits;
+                    EXPECT_EQ(expected, automaton->run(String(L"p") + strings[j]));
+                    EXPECT_TRUE(!automaton->run(strings[j]));
+                }
+            }
+        }
+    }
+}
+
+TEST_F(FuzzyQueryTest, testTranspositions) {
+    RAMDirectoryPtr directory = newLucene<RAMDirectory>();
+    IndexWriterPtr writer = newLucene<IndexWriter>(directory, newLucene<WhitespaceAnalyzer>(), true, IndexWriter::MaxFieldLengthLIMITED);
+    addDoc(L"abcd", writer);
+    addDoc(L"abdc", writer);
+    addDoc(L"badc", writer);
+    writer->close();
+    IndexSearcherPtr searcher = newLucene<IndexSearcher>(directory, true);
+
+    FuzzyQueryPtr query = newLucene<FuzzyQuery>(newLucene<Term>(L"field", L"abcd"), 0.7, 0);
+    EXPECT_EQ(1, searcher->search(query, FilterPtr(), 1000)->scoreDocs.size());
+
+    query = newLucene<FuzzyQuery>(newLucene<Term>(L"field", L"abcd"), 0.7, 0, true);
+    EXPECT_TRUE(query->getTranspositions());
+    EXPECT_TRUE(!query->equals(newLucene<FuzzyQuery>(newLucene<Term>(L"field", L"abcd"), 0.7, 0)));
+    Collection<ScoreDocPtr> hits = searcher->search(query, FilterPtr(), 1000)->scoreDocs;
+    EXPECT_EQ(2, hits.size());
+    EXPECT_EQ(L"abcd", searcher->doc(hits[0]->doc)->get(L"field"));
+    EXPECT_EQ(L"abdc", searcher->doc(hits[1]->doc)->get(L"field"));
+
+    searcher->close();
+    directory->close();
+}
+
+/// Compares the terms and scores enumerated by FuzzyTermEnum with the similarity formula applied to every term.
+TEST_F(FuzzyQueryTest, testTermEnumMatchesScan) {
+    RandomPtr random = newLucene<Random>(11);
+    RAMDirectoryPtr directory = newLucene<RAMDirectory>();
+    IndexWriterPtr writer = newLucene<IndexWriter>(directory, newLucene<WhitespaceAnalyzer>(), true, IndexWriter::MaxFieldLengthLIMITED);
+    for (int32_t i = 0; i < 1000; ++i) {
+        StringStream text;
+        int32_t length = 1 + random->nextInt(7);
+        for (int32_t k = 0; k < length; ++k) {
+            text << (wchar_t)(L'a' + random->nextInt(4));
+        }
+        addDoc(text.str(), writer);
+    }
+    writer->optimize();
+    writer->close();
+
+    IndexReaderPtr reader = IndexReader::open(directory, true);
+    static const wchar_t* queries[] = {L"abc", L"abcd", L"dcba", L"aaaaaa", L"bd", L"cabdab", L"abcdabcdab"};
+    static const double similarities[] = {0.3, 0.5, 0.7};
+    for (int32_t q = 0; q < (int32_t)(sizeof(queries) / sizeof(queries[0])); ++q) {
+        for (int32_t s = 0; s < 3; ++s) {
+            for (int32_t prefixLength = 0; prefixLength < 3; ++prefixLength) {
+                for (int32_t transpositions = 0; transpositions < 2; ++transpositions) {
+                    String text(queries[q]);
+                    String prefix(text.substr(0, std::min(prefixLength, (int32_t)text.length())));
+                    String rest(text.substr(prefix.length()));
+                    double minSimilarity = similarities[s];
+
+                    Collection<String> expected = Collection<String>::newInstance();
+                    Collection<double> expectedScores = Collection<double>::newInstance();
+                    TermEnumPtr terms = reader->terms(newLucene<Term>(L"field", L""));
+                    do {
+                        TermPtr term = terms->term();
+                        if (!term || term->field() != L"field" || !boost::starts_with(term->text(), prefix)) {
+                            continue;
+                        }
+                        String target(term->text().substr(prefix.length()));
+                        int32_t n = (int32_t)rest.length();
+                        int32_t m = (int32_t)target.length();
+                        double similarity;
+                        if (n == 0 || m == 0) {
+                            similarity = prefix.empty() ? 0.0 : 1.0 - ((double)std::max(n, m) / (double)prefix.length());
+                        } else {
+                            similarity = 1.0 - ((double)editDistance(rest, target, transpositions != 0) / (double)(prefix.length() + std::min(n, m)));
+                        }
+                        if (similarity > minSimilarity) {
+                            expected.add(term->text());
+                            expectedScores.add((similarity - minSimilarity) / (1.0 - minSimilarity));
+                        }
+                    } while (terms->next());
+                    terms->close();
+
+                    FuzzyTermEnumPtr fuzzyTerms = newLucene<FuzzyTermEnum>(reader, newLucene<Term>(L"field", text), minSimilarity, prefixLength, transpositions != 0);
+                    int32_t count = 0;
+                    do {
+                        TermPtr term = fuzzyTerms->term();
+                        if (!term) {
+                            break;
+                        }
+                        EXPECT_TRUE(count < expected.size());
+                        if (count < expected.size()) {
+                            EXPECT_EQ(expected[count], term->text());
+                            EXPECT_NEAR(expectedScores[count], fuzzyTerms->difference(), 1e-9);
+                        }
+                        ++count;
+                    } while (fuzzyTerms->next());
+                    fuzzyTerms->close();
+                    EXPECT_EQ(expected.size(), count);
+                }
+            }
+        }
+    }
+    reader->close();
+}
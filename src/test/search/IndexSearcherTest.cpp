@@ -0,0 +1,127 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "TestInc.h"
+#include "LuceneTestFixture.h"
+#include "RAMDirectory.h"
+#include "IndexWriter.h"
+#include "IndexReader.h"
+#include "WhitespaceAnalyzer.h"
+#include "Document.h"
+#include "Field.h"
+#include "IndexSearcher.h"
+#include "TermQuery.h"
+#include "BooleanQuery.h"
+#include "Term.h"
+#include "Sort.h"
+#include "SortField.h"
+#include "TopDocs.h"
+#include "TopFieldDocs.h"
+#include "ScoreDoc.h"
+#include "FieldDoc.h"
+#include "QueryWrapperFilter.h"
+#include "ThreadPool.h"
+
+using namespace Lucene;
+
+class IndexSearcherTest : public LuceneTestFixture {
+public:
+    IndexSearcherTest() {
+        directory = newLucene<RAMDirectory>();
+        IndexWriterPtr writer = newLucene<IndexWriter>(directory, newLucene<WhitespaceAnalyzer>(), true, IndexWriter::MaxFieldLengthLIMITED);
+        writer->setMaxBufferedDocs(7);
+        writer->setMergeFactor(1000);
+        static const wchar_t* words[] = {L"aaa", L"bbb", L"ccc", L"ddd"};
+        for (int32_t i = 0; i < 100; ++i) {
+            DocumentPtr doc = newLucene<Document>();
+            String contents;
+            for (int32_t j = 0; j <= i % 4; ++j) {
+                contents += String(words[(i + j) % 4]) + L" ";
+            }
+            doc->add(newLucene<Field>(L"contents", contents, Field::STORE_NO, Field::INDEX_ANALYZED));
+            doc->add(newLucene<Field>(L"value", StringUtils::toString((i * 37) % 101), Field::STORE_YES, Field::INDEX_NOT_ANALYZED));
+            writer->addDocument(doc);
+        }
+        writer->close();
+        reader = IndexReader::open(directory, true);
+    }
+
+    virtual ~IndexSearcherTest() {
+        reader->close();
+    }
+
+protected:
+    DirectoryPtr directory;
+    IndexReaderPtr reader;
+
+public:
+    void checkSameHits(Collection<ScoreDocPtr> expected, Collection<ScoreDocPtr> actual) {
+        EXPECT_EQ(expected.size(), actual.size());
+        for (int32_t i = 0; i < expected.size() && i < actual.size(); ++i) {
+            EXPECT_EQ(expected[i]->doc, actual[i]->doc);
+            EXPECT_EQ(expected[i]->score, actual[i]->score);
+        }
+    }
+};
+
+TEST_F(IndexSearcherTest, testConcurrentSearchMatchesSequential) {
+    EXPECT_TRUE(reader->getSequentialSubReaders().size() > 1);
+
+    IndexSearcherPtr sequential = newLucene<IndexSearcher>(reader);
+    IndexSearcherPtr concurrent = newLucene<IndexSearcher>(reader, ThreadPool::getInstance());
+
+    BooleanQueryPtr query = newLucene<BooleanQuery>();
+    query->add(newLucene<TermQuery>(newLucene<Term>(L"contents", L"aaa")), BooleanClause::SHOULD);
+    query->add(newLucene<TermQuery>(newLucene<Term>(L"contents", L"ccc")), BooleanClause::SHOULD);
+
+    for (int32_t n = 1; n <= 120; n += 17) {
+        TopDocsPtr expected = sequential->search(query, n);
+        TopDocsPtr actual = concurrent->search(query, n);
+        EXPECT_EQ(expected->totalHits, actual->totalHits);
+        EXPECT_EQ(expected->maxScore, actual->maxScore);
+        checkSameHits(expected->scoreDocs, actual->scoreDocs);
+    }
+
+    FilterPtr filter = newLucene<QueryWrapperFilter>(newLucene<TermQuery>(newLucene<Term>(L"contents", L"bbb")));
+    TopDocsPtr expected = sequential->search(query, filter, 10);
+    TopDocsPtr actual = concurrent->search(query, filter, 10);
+    EXPECT_EQ(expected->totalHits, actual->totalHits);
+    checkSameHits(expected->scoreDocs, actual->scoreDocs);
+
+    // no hits
+    actual = concurrent->search(newLucene<TermQuery>(newLucene<Term>(L"contents", L"zzz")), 10);
+    EXPECT_EQ(0, actual->totalHits);
+    EXPECT_EQ(0, actual->scoreDocs.size());
+}
+
+TEST_F(IndexSearcherTest, testConcurrentSortedSearchMatchesSequential) {
+    IndexSearcherPtr sequential = newLucene<IndexSearcher>(reader);
+    IndexSearcherPtr concurrent = newLucene<IndexSearcher>(reader, ThreadPool::getInstance());
+
+    QueryPtr query = newLucene<TermQuery>(newLucene<Term>(L"contents", L"bbb"));
+    Collection<SortPtr> sorts = newCollection<SortPtr>(
+                                    newLucene<Sort>(newLucene<SortField>(L"value", SortField::INT)),
+                                    newLucene<Sort>(newLucene<SortField>(L"value", SortField::INT, true)),
+                                    newLucene<Sort>(newCollection<SortFieldPtr>(SortField::FIELD_SCORE(), SortField::FIELD_DOC())));
+
+    for (Collection<SortPtr>::iterator sort = sorts.begin(); sort != sorts.end(); ++sort) {
+        TopFieldDocsPtr expected = sequential->search(query, FilterPtr(), 25, *sort);
+        TopFieldDocsPtr actual = concurrent->search(query, FilterPtr(), 25, *sort);
+        EXPECT_EQ(expected->totalHits, actual->totalHits);
+        EXPECT_EQ(expected->scoreDocs.size(), actual->scoreDocs.size());
+        for (int32_t i = 0; i < expected->scoreDocs.size() && i < actual->scoreDocs.size(); ++i) {
+            EXPECT_EQ(expected->scoreDocs[i]->doc, actual->scoreDocs[i]->doc);
+        }
+    }
+
+    sequential->setDefaultFieldSortScoring(true, true);
+    concurrent->setDefaultFieldSortScoring(true, true);
+    SortPtr sort = newLucene<Sort>(newLucene<SortField>(L"value", SortField::INT));
+    TopFieldDocsPtr expected = sequential->search(query, FilterPtr(), 10, sort);
+    TopFieldDocsPtr actual = concurrent->search(query, FilterPtr(), 10, sort);
+    EXPECT_EQ(expected->maxScore, actual->maxScore);
+    checkSameHits(expected->scoreDocs, actual->scoreDocs);
+}
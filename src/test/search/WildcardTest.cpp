@@ -24,6 +24,10 @@
 #include "QueryParser.h"
 #include "WhitespaceAnalyzer.h"
 #include "MiscUtils.h"
+#include "IndexReader.h"
+#include "WildcardTermEnum.h"
+#include "TermEnum.h"
+#include "Random.h"
 
 using namespace Lucene;
 
@@ -300,3 +304,59 @@ TEST_F(WildcardTest, testParsingAndSearching) {
 
     searcher->close();
 }
+
+/// Compares the terms enumerated by WildcardTermEnum with a linear scan using wildcardEquals, over a
+/// dictionary large enough for the enumeration to seek past non-matching runs of terms.
+TEST_F(WildcardTest, testTermEnumMatchesScan) {
+    RandomPtr random = newLucene<Random>(17);
+    RAMDirectoryPtr indexStore = newLucene<RAMDirectory>();
+    IndexWriterPtr writer = newLucene<IndexWriter>(indexStore, newLucene<WhitespaceAnalyzer>(), true, IndexWriter::MaxFieldLengthLIMITED);
+    for (int32_t i = 0; i < 500; ++i) {
+        StringStream contents;
+        for (int32_t j = 0; j < 10; ++j) {
+            int32_t length = 1 + random->nextInt(6);
+            for (int32_t k = 0; k < length; ++k) {
+                contents << (wchar_t)(L'a' + random->nextInt(5));
+            }
+            contents << L" ";
+        }
+        DocumentPtr doc = newLucene<Document>();
+        doc->add(newLucene<Field>(L"body", contents.str(), Field::STORE_NO, Field::INDEX_ANALYZED));
+        doc->add(newLucene<Field>(L"other", L"abc", Field::STORE_NO, Field::INDEX_ANALYZED));
+        writer->addDocument(doc);
+    }
+    writer->optimize();
+    writer->close();
+
+    IndexReaderPtr reader = IndexReader::open(indexStore, true);
+    static const wchar_t* patterns[] = {L"*", L"b*", L"*c", L"a?c*", L"?d?", L"c*e*a", L"*ee*", L"dd?d?", L"e*a", L"x*", L"abc"};
+    for (int32_t p = 0; p < (int32_t)(sizeof(patterns) / sizeof(patterns[0])); ++p) {
+        Collection<String> expected = Collection<String>::newInstance();
+        TermEnumPtr terms = reader->terms(newLucene<Term>(L"body", L""));
+        do {
+            TermPtr term = terms->term();
+            if (!term || term->field() != L"body") {
+                break;
+            }
+            if (WildcardTermEnum::wildcardEquals(patterns[p], 0, term->text(), 0)) {
+                expected.add(term->text());
+            }
+        } while (terms->next());
+        terms->close();
+
+        Collection<String> actual = Collection<String>::newInstance();
+        TermEnumPtr wildcardTerms = newLucene<WildcardTermEnum>(reader, newLucene<Term>(L"body", patterns[p]));
+        do {
+            TermPtr term = wildcardTerms->term();
+            if (!term) {
+                break;
+            }
+            actual.add(term->text());
+        } while (wildcardTerms->next());
+        wildcardTerms->close();
+
+        EXPECT_EQ(expected.size(), actual.size());
+        EXPECT_TRUE(expected.equals(actual));
+    }
+    reader->close();
+}
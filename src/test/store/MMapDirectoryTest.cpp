@@ -16,6 +16,9 @@
 #include "Field.h"
 #include "Random.h"
 #include "FileUtils.h"
+#include "IndexInput.h"
+#include "IndexOutput.h"
+#include "IndexReader.h"
 
 using namespace Lucene;
 
@@ -65,3 +68,94 @@ TEST_F(MMapDirectoryTest, testMmapIndex) {
 
     FileUtils::removeDirectory(storePathname);
 }
+
+TEST_F(MMapDirectoryTest, testChunkedInput) {
+    String storePathname(FileUtils::joinPath(getTempDir(), L"testLuceneMmapChunks"));
+    MMapDirectoryPtr storeDirectory(newLucene<MMapDirectory>(storePathname));
+    storeDirectory->setMaxChunkSize(70000);
+    EXPECT_EQ(65536, storeDirectory->getMaxChunkSize());
+
+    static const int32_t fileLength = 3 * 65536 + 123;
+    IndexOutputPtr output = storeDirectory->createOutput(L"chunks.bin");
+    for (int32_t i = 0; i < fileLength; ++i) {
+        output->writeByte((uint8_t)(i % 251));
+    }
+    output->close();
+
+    storeDirectory->setAccessHint(L"bin", MMapDirectory::ACCESS_SEQUENTIAL);
+    EXPECT_EQ(MMapDirectory::ACCESS_SEQUENTIAL, storeDirectory->getAccessHint(L"chunks.bin"));
+    EXPECT_EQ(MMapDirectory::ACCESS_NORMAL, storeDirectory->getAccessHint(L"_0.frq"));
+
+    IndexInputPtr input = storeDirectory->openInput(L"chunks.bin");
+    EXPECT_EQ(fileLength, input->length());
+    for (int32_t i = 0; i < fileLength; ++i) {
+        EXPECT_EQ((uint8_t)(i % 251), input->readByte());
+    }
+    EXPECT_EQ(fileLength, input->getFilePointer());
+    EXPECT_THROW(input->readByte(), IOException);
+
+    // bulk reads and seeks across chunk boundaries
+    ByteArray bytes(ByteArray::newInstance(1000));
+    input->seek(65536 - 500);
+    input->readBytes(bytes.get(), 0, 1000);
+    for (int32_t i = 0; i < 1000; ++i) {
+        EXPECT_EQ((uint8_t)((65536 - 500 + i) % 251), bytes[i]);
+    }
+    EXPECT_EQ(65536 + 500, input->getFilePointer());
+
+    input->seek(2 * 65536);
+    EXPECT_EQ((uint8_t)((2 * 65536) % 251), input->readByte());
+
+    // clones are positioned independently
+    IndexInputPtr clone = boost::dynamic_pointer_cast<IndexInput>(input->clone());
+    clone->seek(10);
+    EXPECT_EQ(10, clone->readByte());
+    EXPECT_EQ((uint8_t)((2 * 65536 + 1) % 251), input->readByte());
+
+    // direct access is limited to the current chunk
+    int32_t available = 0;
+    const uint8_t* direct = input->bufferedBytes(available);
+    EXPECT_EQ(65536 - 2, available);
+    EXPECT_EQ((uint8_t)((2 * 65536 + 2) % 251), direct[0]);
+    input->skipBufferedBytes(available);
+    EXPECT_EQ(3 * 65536, input->getFilePointer());
+    direct = input->bufferedBytes(available);
+    EXPECT_EQ(123, available);
+
+    input->seek(fileLength);
+    EXPECT_EQ(fileLength, input->getFilePointer());
+    EXPECT_THROW(input->seek(fileLength + 1), IOException);
+
+    input->close();
+    storeDirectory->close();
+    FileUtils::removeDirectory(storePathname);
+}
+
+TEST_F(MMapDirectoryTest, testChunkedIndex) {
+    String storePathname(FileUtils::joinPath(getTempDir(), L"testLuceneMmapChunkedIndex"));
+    MMapDirectoryPtr storeDirectory(newLucene<MMapDirectory>(storePathname));
+    storeDirectory->setMaxChunkSize(65536);
+    storeDirectory->setAccessHint(L"frq", MMapDirectory::ACCESS_RANDOM);
+    storeDirectory->setAccessHint(L"fdt", MMapDirectory::ACCESS_WILLNEED);
+
+    IndexWriterPtr writer = newLucene<IndexWriter>(storeDirectory, newLucene<StandardAnalyzer>(LuceneVersion::LUCENE_CURRENT, HashSet<String>()), true, IndexWriter::MaxFieldLengthLIMITED);
+    Collection<String> values = Collection<String>::newInstance(5000);
+    for (int32_t i = 0; i < values.size(); ++i) {
+        values[i] = randomField() + randomField() + randomField();
+        DocumentPtr doc = newLucene<Document>();
+        doc->add(newLucene<Field>(L"data", values[i], Field::STORE_YES, Field::INDEX_ANALYZED));
+        writer->addDocument(doc);
+    }
+    writer->optimize();
+    writer->close();
+
+    IndexReaderPtr reader = IndexReader::open(storeDirectory, true);
+    EXPECT_EQ(values.size(), reader->numDocs());
+    for (int32_t i = 0; i < values.size(); ++i) {
+        EXPECT_EQ(values[i], reader->document(i)->get(L"data"));
+    }
+    reader->close();
+
+    storeDirectory->close();
+    FileUtils::removeDirectory(storePathname);
+}
@@ -0,0 +1,88 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "TestInc.h"
+#include "LuceneTestFixture.h"
+#include "RateLimiter.h"
+#include "RateLimitedDirectoryWrapper.h"
+#include "RAMDirectory.h"
+#include "IndexOutput.h"
+#include "IndexInput.h"
+#include "MiscUtils.h"
+
+using namespace Lucene;
+
+typedef LuceneTestFixture RateLimiterTest;
+
+TEST_F(RateLimiterTest, testPause) {
+    RateLimiterPtr limiter = newLucene<RateLimiter>(1.0);
+    int64_t bytes = 1024 * 1024 / 10; // 100 msec worth at 1 MB/sec
+
+    int64_t start = MiscUtils::currentTimeMillis();
+    for (int32_t i = 0; i < 4; ++i) {
+        limiter->pause(bytes);
+    }
+    int64_t elapsed = MiscUtils::currentTimeMillis() - start;
+
+    // the first call only starts the clock
+    EXPECT_TRUE(elapsed >= 280);
+    EXPECT_TRUE(limiter->getTotalPausedMillis() >= 250);
+    EXPECT_TRUE(limiter->getTotalPausedMillis() <= elapsed);
+    EXPECT_EQ(4 * bytes, limiter->getTotalBytes());
+}
+
+TEST_F(RateLimiterTest, testUnlimited) {
+    RateLimiterPtr limiter = newLucene<RateLimiter>(std::numeric_limits<double>::infinity());
+    EXPECT_EQ(std::numeric_limits<int64_t>::max(), limiter->getMinPauseCheckBytes());
+    for (int32_t i = 0; i < 10; ++i) {
+        EXPECT_EQ(0, limiter->pause(1024 * 1024 * 1024));
+    }
+    EXPECT_EQ(0, limiter->getTotalPausedMillis());
+
+    limiter->setMbPerSec(1.0);
+    EXPECT_EQ(1.0, limiter->getMbPerSec());
+    EXPECT_EQ(1024 * 1024 * RateLimiter::MIN_PAUSE_CHECK_MSEC / 1000, limiter->getMinPauseCheckBytes());
+}
+
+TEST_F(RateLimiterTest, testInvalidRate) {
+    EXPECT_THROW(newLucene<RateLimiter>(0.0), IllegalArgumentException);
+    RateLimiterPtr limiter = newLucene<RateLimiter>(1.0);
+    EXPECT_THROW(limiter->setMbPerSec(-1.0), IllegalArgumentException);
+}
+
+TEST_F(RateLimiterTest, testRateLimitedDirectory) {
+    DirectoryPtr ramDir = newLucene<RAMDirectory>();
+    RateLimiterPtr limiter = newLucene<RateLimiter>(2.0);
+    DirectoryPtr dir = newLucene<RateLimitedDirectoryWrapper>(ramDir, limiter);
+
+    ByteArray bytes(ByteArray::newInstance(1024));
+    for (int32_t i = 0; i < bytes.size(); ++i) {
+        bytes[i] = (uint8_t)i;
+    }
+
+    int64_t start = MiscUtils::currentTimeMillis();
+    IndexOutputPtr output = dir->createOutput(L"test");
+    for (int32_t i = 0; i < 200; ++i) {
+        output->writeBytes(bytes.get(), bytes.size());
+    }
+    output->writeVInt(17);
+    output->close();
+    int64_t elapsed = MiscUtils::currentTimeMillis() - start;
+
+    // 200 KB at 2 MB/sec takes about 100 msec
+    EXPECT_TRUE(elapsed >= 60);
+    EXPECT_TRUE(limiter->getTotalPausedMillis() > 0);
+    EXPECT_EQ(200 * 1024 + 1, limiter->getTotalBytes());
+
+    // reads go straight to the wrapped directory
+    EXPECT_EQ(200 * 1024 + 1, ramDir->fileLength(L"test"));
+    IndexInputPtr input = dir->openInput(L"test");
+    input->seek(199 * 1024 + 5);
+    EXPECT_EQ(5, input->readByte());
+    input->seek(200 * 1024);
+    EXPECT_EQ(17, input->readVInt());
+    input->close();
+}
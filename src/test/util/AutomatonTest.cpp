@@ -0,0 +1,92 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "TestInc.h"
+#include "LuceneTestFixture.h"
+#include "Automaton.h"
+#include "WildcardTermEnum.h"
+
+using namespace Lucene;
+
+typedef LuceneTestFixture AutomatonTest;
+
+TEST_F(AutomatonTest, testDeterminize) {
+    // (ab|ac)d?
+    AutomatonPtr nfa = newLucene<Automaton>();
+    int32_t start = nfa->createState();
+    int32_t a1 = nfa->createState();
+    int32_t a2 = nfa->createState();
+    int32_t end = nfa->createState();
+    int32_t last = nfa->createState();
+    nfa->addTransition(start, L'a', L'a', a1);
+    nfa->addTransition(start, L'a', L'a', a2);
+    nfa->addTransition(a1, L'b', L'b', end);
+    nfa->addTransition(a2, L'c', L'c', end);
+    nfa->addTransition(end, L'd', L'd', last);
+    nfa->addEpsilon(end, last);
+    nfa->setAccept(last, true);
+    EXPECT_TRUE(!nfa->isDeterministic());
+
+    AutomatonPtr dfa = nfa->determinize();
+    EXPECT_TRUE(dfa->isDeterministic());
+    EXPECT_TRUE(dfa->run(L"ab"));
+    EXPECT_TRUE(dfa->run(L"acd"));
+    EXPECT_TRUE(!dfa->run(L"a"));
+    EXPECT_TRUE(!dfa->run(L"ad"));
+    EXPECT_TRUE(!dfa->run(L"abdd"));
+    EXPECT_TRUE(!dfa->run(L""));
+    EXPECT_EQ(L"a", dfa->getCommonPrefix());
+
+    int32_t label = 0;
+    int32_t state = dfa->step(0, L'a');
+    EXPECT_NE(-1, state);
+    EXPECT_EQ(-1, dfa->step(0, L'b'));
+    EXPECT_TRUE(dfa->nextLabel(state, 0, label));
+    EXPECT_EQ(L'b', label);
+    EXPECT_TRUE(dfa->nextLabel(state, L'c', label));
+    EXPECT_EQ(L'c', label);
+    EXPECT_TRUE(!dfa->nextLabel(state, L'd', label));
+}
+
+TEST_F(AutomatonTest, testDeadStates) {
+    AutomatonPtr nfa = newLucene<Automaton>();
+    int32_t start = nfa->createState();
+    int32_t dead = nfa->createState();
+    int32_t accept = nfa->createState();
+    nfa->addTransition(start, L'a', L'z', dead);
+    nfa->addTransition(dead, L'a', L'z', dead);
+    nfa->addTransition(start, L'0', L'9', accept);
+    nfa->setAccept(accept, true);
+
+    AutomatonPtr dfa = nfa->determinize();
+    EXPECT_EQ(2, dfa->getNumStates());
+    EXPECT_EQ(-1, dfa->step(0, L'b'));
+    EXPECT_TRUE(dfa->run(L"7"));
+
+    // nothing accepted at all
+    AutomatonPtr empty = newLucene<Automaton>();
+    empty->createState();
+    dfa = empty->determinize();
+    EXPECT_EQ(1, dfa->getNumStates());
+    EXPECT_TRUE(!dfa->run(L""));
+    int32_t label = 0;
+    EXPECT_TRUE(!dfa->nextLabel(0, 0, label));
+}
+
+TEST_F(AutomatonTest, testWildcardAutomaton) {
+    static const wchar_t* patterns[] = {L"*", L"a*", L"*b", L"a?c", L"a*b*c", L"??", L"*a*a*", L"abc", L""};
+    static const wchar_t* strings[] = {L"", L"a", L"b", L"ab", L"abc", L"aac", L"abbc", L"aa", L"bab", L"acbc", L"abcd", L"\x1234"};
+
+    for (int32_t p = 0; p < (int32_t)(sizeof(patterns) / sizeof(patterns[0])); ++p) {
+        AutomatonPtr automaton = WildcardTermEnum::toAutomaton(patterns[p]);
+        for (int32_t s = 0; s < (int32_t)(sizeof(strings) / sizeof(strings[0])); ++s) {
+            EXPECT_EQ(WildcardTermEnum::wildcardEquals(patterns[p], 0, strings[s], 0), automaton->run(strings[s]));
+        }
+    }
+
+    EXPECT_EQ(L"ab", WildcardTermEnum::toAutomaton(L"ab?d*")->getCommonPrefix());
+    EXPECT_EQ(L"", WildcardTermEnum::toAutomaton(L"*ab")->getCommonPrefix());
+}
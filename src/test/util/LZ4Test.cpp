@@ -0,0 +1,92 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "TestInc.h"
+#include "LuceneTestFixture.h"
+#include "LZ4.h"
+#include "Random.h"
+#include "MiscUtils.h"
+
+using namespace Lucene;
+
+typedef LuceneTestFixture LZ4Test;
+
+static int32_t checkRoundTrip(ByteArray data) {
+    ByteArray compressed(ByteArray::newInstance(LZ4::maxCompressedLength(data.size())));
+    int32_t compressedLength = LZ4::compress(data.get(), data.size(), compressed.get());
+    EXPECT_TRUE(compressedLength <= LZ4::maxCompressedLength(data.size()));
+
+    ByteArray decompressed(ByteArray::newInstance(data.size() + 1));
+    EXPECT_EQ(data.size(), LZ4::decompress(compressed.get(), compressedLength, decompressed.get(), data.size()));
+    EXPECT_EQ(0, std::memcmp(data.get(), decompressed.get(), data.size()));
+    return compressedLength;
+}
+
+TEST_F(LZ4Test, testEmpty) {
+    uint8_t compressed[16];
+    int32_t compressedLength = LZ4::compress(NULL, 0, compressed);
+    EXPECT_EQ(1, compressedLength);
+    EXPECT_EQ(0, LZ4::decompress(compressed, compressedLength, NULL, 0));
+}
+
+TEST_F(LZ4Test, testRepetitive) {
+    ByteArray data(ByteArray::newInstance(100000));
+    for (int32_t i = 0; i < data.size(); ++i) {
+        data[i] = (uint8_t)("stored fields "[i % 14]);
+    }
+    EXPECT_TRUE(checkRoundTrip(data) < data.size() / 50);
+
+    // long runs of one byte give overlapping matches
+    ByteArray run(ByteArray::newInstance(5000));
+    MiscUtils::arrayFill(run.get(), 0, run.size(), (uint8_t)'a');
+    EXPECT_TRUE(checkRoundTrip(run) < 50);
+}
+
+TEST_F(LZ4Test, testRandom) {
+    RandomPtr random = newLucene<Random>(17);
+    for (int32_t iter = 0; iter < 200; ++iter) {
+        ByteArray data(ByteArray::newInstance(1 + random->nextInt(70000)));
+        int32_t alphabet = 1 + random->nextInt(256);
+        for (int32_t i = 0; i < data.size(); ++i) {
+            // mix random bytes with copies of earlier data at random distances
+            if (i > 10 && random->nextInt(4) == 0) {
+                int32_t distance = 1 + random->nextInt(std::min(i, 70000));
+                int32_t length = std::min(1 + random->nextInt(300), data.size() - i);
+                for (int32_t j = 0; j < length; ++j, ++i) {
+                    data[i] = data[i - distance];
+                }
+                --i;
+            } else {
+                data[i] = (uint8_t)random->nextInt(alphabet);
+            }
+        }
+        checkRoundTrip(data);
+    }
+}
+
+TEST_F(LZ4Test, testCorrupt) {
+    ByteArray data(ByteArray::newInstance(1000));
+    for (int32_t i = 0; i < data.size(); ++i) {
+        data[i] = (uint8_t)(i % 10);
+    }
+    ByteArray compressed(ByteArray::newInstance(LZ4::maxCompressedLength(data.size())));
+    int32_t compressedLength = LZ4::compress(data.get(), data.size(), compressed.get());
+    ByteArray decompressed(ByteArray::newInstance(data.size()));
+
+    // truncated input either fails or decompresses to fewer bytes
+    try {
+        EXPECT_TRUE(LZ4::decompress(compressed.get(), compressedLength / 2, decompressed.get(), data.size()) < data.size());
+    } catch (CompressionException&) {
+    }
+    EXPECT_THROW(LZ4::decompress(compressed.get(), compressedLength - 1, decompressed.get(), data.size()), CompressionException);
+
+    // output buffer too small
+    EXPECT_THROW(LZ4::decompress(compressed.get(), compressedLength, decompressed.get(), data.size() - 1), CompressionException);
+
+    // match offset before the start of the output
+    uint8_t badOffset[] = {0x10, 'a', 0x10, 0x00, 0x00};
+    EXPECT_THROW(LZ4::decompress(badOffset, 5, decompressed.get(), data.size()), CompressionException);
+}
@@ -0,0 +1,77 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "TestInc.h"
+#include "LuceneTestFixture.h"
+#include "PackedInts.h"
+#include "Random.h"
+
+using namespace Lucene;
+
+typedef LuceneTestFixture PackedIntsTest;
+
+TEST_F(PackedIntsTest, testBitsRequired) {
+    EXPECT_EQ(0, PackedInts::bitsRequired(0));
+    EXPECT_EQ(1, PackedInts::bitsRequired(1));
+    EXPECT_EQ(2, PackedInts::bitsRequired(3));
+    EXPECT_EQ(3, PackedInts::bitsRequired(4));
+    EXPECT_EQ(31, PackedInts::bitsRequired(INT_MAX));
+    EXPECT_EQ(64, PackedInts::bitsRequired(~(uint64_t)0));
+}
+
+TEST_F(PackedIntsTest, testRandomValues) {
+    RandomPtr random = newLucene<Random>(7);
+    for (int32_t bitsPerValue = 0; bitsPerValue <= 64; ++bitsPerValue) {
+        int32_t valueCount = 1 + random->nextInt(300);
+        uint64_t mask = bitsPerValue == 64 ? ~(uint64_t)0 : (((uint64_t)1 << bitsPerValue) - 1);
+        PackedIntsPtr packed = newLucene<PackedInts>(valueCount, bitsPerValue);
+        EXPECT_EQ(valueCount, packed->size());
+        EXPECT_EQ(bitsPerValue, packed->getBitsPerValue());
+        Collection<int64_t> values = Collection<int64_t>::newInstance(valueCount);
+        for (int32_t i = 0; i < valueCount; ++i) {
+            EXPECT_EQ(0, packed->get(i));
+            uint64_t value = ((uint64_t)random->nextInt() << 33) ^ ((uint64_t)random->nextInt() << 2) ^ (uint64_t)random->nextInt();
+            values[i] = (int64_t)(value & mask);
+            packed->set(i, values[i]);
+        }
+        for (int32_t i = 0; i < valueCount; ++i) {
+            EXPECT_EQ(values[i], packed->get(i));
+        }
+
+        // overwriting a value leaves its neighbours intact
+        if (valueCount > 2) {
+            packed->set(1, (int64_t)mask);
+            EXPECT_EQ(values[0], packed->get(0));
+            EXPECT_EQ((int64_t)mask, packed->get(1));
+            EXPECT_EQ(values[2], packed->get(2));
+        }
+    }
+}
+
+TEST_F(PackedIntsTest, testRange) {
+    PackedIntsPtr packed = PackedInts::forRange(100, -50, 49);
+    EXPECT_EQ(7, packed->getBitsPerValue());
+    EXPECT_EQ(-50, packed->getMinValue());
+    for (int32_t i = 0; i < 100; ++i) {
+        packed->set(i, i - 50);
+    }
+    for (int32_t i = 0; i < 100; ++i) {
+        EXPECT_EQ(i - 50, packed->get(i));
+    }
+
+    packed = PackedInts::forRange(3, LLONG_MIN, LLONG_MAX);
+    EXPECT_EQ(64, packed->getBitsPerValue());
+    packed->set(0, LLONG_MIN);
+    packed->set(1, LLONG_MAX);
+    packed->set(2, -1);
+    EXPECT_EQ(LLONG_MIN, packed->get(0));
+    EXPECT_EQ(LLONG_MAX, packed->get(1));
+    EXPECT_EQ(-1, packed->get(2));
+
+    packed = PackedInts::forRange(10, 42, 42);
+    EXPECT_EQ(0, packed->getBitsPerValue());
+    EXPECT_EQ(42, packed->get(9));
+}
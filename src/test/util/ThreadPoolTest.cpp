@@ -0,0 +1,80 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2009-2014 Alan Wright. All rights reserved.
+// Distributable under the terms of either the Apache License (Version 2.0)
+// or the GNU Lesser General Public License.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "TestInc.h"
+#include <boost/bind/protect.hpp>
+#include "LuceneTestFixture.h"
+#include "ThreadPool.h"
+
+using namespace Lucene;
+
+typedef LuceneTestFixture ThreadPoolTest;
+
+static int32_t square(int32_t value) {
+    return value * value;
+}
+
+static int32_t throwIllegalArgument() {
+    boost::throw_exception(IllegalArgumentException(L"task failed"));
+    return 0;
+}
+
+/// Schedules a child task on the same pool and waits for it from within the pool
+static int32_t sumOfSquares(ThreadPool* threadPool, int32_t count) {
+    Collection<FuturePtr> futures(Collection<FuturePtr>::newInstance(count));
+    for (int32_t i = 0; i < count; ++i) {
+        futures[i] = threadPool->scheduleTask(boost::protect(boost::bind<int32_t>(square, i)));
+    }
+    int32_t sum = 0;
+    for (int32_t i = 0; i < count; ++i) {
+        sum += futures[i]->get<int32_t>();
+    }
+    return sum;
+}
+
+TEST_F(ThreadPoolTest, testThreadCount) {
+    EXPECT_EQ(3, newLucene<ThreadPool>(3)->getThreadCount());
+    EXPECT_TRUE(newLucene<ThreadPool>()->getThreadCount() > 0);
+    EXPECT_THROW(newLucene<ThreadPool>(-1), IllegalArgumentException);
+}
+
+TEST_F(ThreadPoolTest, testScheduleTasks) {
+    ThreadPoolPtr threadPool = newLucene<ThreadPool>(4);
+    Collection<FuturePtr> futures(Collection<FuturePtr>::newInstance(100));
+    for (int32_t i = 0; i < futures.size(); ++i) {
+        futures[i] = threadPool->scheduleTask(boost::protect(boost::bind<int32_t>(square, i)));
+    }
+    for (int32_t i = 0; i < futures.size(); ++i) {
+        EXPECT_EQ(i * i, futures[i]->get<int32_t>());
+        EXPECT_TRUE(futures[i]->isDone());
+    }
+}
+
+TEST_F(ThreadPoolTest, testExceptionPropagation) {
+    ThreadPoolPtr threadPool = newLucene<ThreadPool>(2);
+    FuturePtr future = threadPool->scheduleTask(boost::protect(boost::bind<int32_t>(throwIllegalArgument)));
+    try {
+        future->get<int32_t>();
+        FAIL() << "Expected IllegalArgumentException";
+    } catch (IllegalArgumentException& e) {
+        EXPECT_EQ(L"task failed", e.getError());
+    }
+
+    // the pool is still usable
+    EXPECT_EQ(49, threadPool->scheduleTask(boost::protect(boost::bind<int32_t>(square, 7)))->get<int32_t>());
+}
+
+TEST_F(ThreadPoolTest, testNestedTasks) {
+    // a single thread must run the child tasks itself while waiting for them
+    ThreadPoolPtr threadPool = newLucene<ThreadPool>(1);
+    Collection<FuturePtr> futures(Collection<FuturePtr>::newInstance(4));
+    for (int32_t i = 0; i < futures.size(); ++i) {
+        futures[i] = threadPool->scheduleTask(boost::protect(boost::bind<int32_t>(sumOfSquares, threadPool.get(), 10)));
+    }
+    for (int32_t i = 0; i < futures.size(); ++i) {
+        EXPECT_EQ(285, futures[i]->get<int32_t>());
+    }
+}